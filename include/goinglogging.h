@@ -3,7 +3,7 @@
  *
  * \section section_description Description
  *
- * \e goinglogging is an open source, lightweight, multiplatform, single header
+ * \e goinglogging is an open source, lightweight, multiplatform, header only
  * C++11 library that logs information to command line or file. This is useful
  * when debugging realtime systems where compiling with debug symbols and/or a
  * low optimization level will slow down the program too much. This library is
@@ -62,7 +62,24 @@
  * \sa l_mat()
  *
  * \subsection section_custom_objects Custom objects
- * Can output any object with an overloaded << operator.
+ * Can output any object with an overloaded << operator. Or declare its
+ * fields in its namespace, to write them with the same formatters as
+ * variables, also in JSON and CBOR:
+ * \code
+ * struct Point {
+ *     int              x;
+ *     std::vector<int> v;
+ * };
+ * GL_REFLECT(Point, x, v)
+ *
+ * Point p = {1, {2, 3}};
+ * l(p);
+ * \endcode
+ * Which outputs:
+ * \code
+ * p = {x = 1, v = {2, 3}}
+ * \endcode
+ * \sa GL_REFLECT()
  *
  * \subsection section_prefixes Prefixes
  * Output file, line, and other information by using:
@@ -104,1849 +121,297 @@
  * \endcode
  * \sa set_color_enabled()
  *
- */
-
-/** \file
- *
- * \brief Lightweight logging library.
- *
- */
-
-#ifndef INCLUDE_GOINGLOGGING_H_
-#define INCLUDE_GOINGLOGGING_H_
-
-#include <array>
-#include <chrono>
-#include <codecvt>
-#include <complex>
-#include <cstring>
-#include <ctime>
-#include <deque>
-#include <forward_list>
-#include <iomanip>
-#include <ios>
-#include <iostream>
-#include <list>
-#include <map>
-#include <memory>
-#include <ostream>
-#include <queue>
-#include <ratio>
-#include <set>
-#include <sstream>
-#include <stack>
-#include <string>
-#include <thread>
-#include <unordered_map>
-#include <unordered_set>
-#include <valarray>
-#include <vector>
-
-#ifdef __GNUC__
-#include <cxxabi.h>
-#endif // __GNUC__
-
-/**
- * \brief Log variables.
- *
- * Use as:
+ * \subsection section_histograms Histograms and counters
+ * Summarize values and count events per call site, instead of logging each
+ * of them:
  * \code
- * int i = 1;
- * l(i);
- * std::string s("s");
- * l(i, s);
+ * l_hist(latency);
+ * l_count(packet_received);
+ * gl::report();
  * \endcode
- * Which outputs:
+ * Which outputs one line per call site:
  * \code
- * i = 1, s = "s"
+ * my_file:12: latency: count = 1000, min = 1, max = 98, mean = 10.3, p50 = 8,
+ * p90 = 22, p99 = 71, p999 = 98
+ * my_file:13: packet_received: count = 1200, rate = 400/s
  * \endcode
- *
- * \note Supports up to 16 variables as parameters.
- * \note Uses prefix information set with \ref set_prefixes().
- *
- * \sa l_arr() \sa l_mat() \sa set_prefixes()
- *
- */
-#define l(...)                                                                 \
-    do {                                                                       \
-        if (::gl::internal::outputEnabled) {                                   \
-            std::cout << gl::internal::color_start                             \
-                      << gl::internal::PrefixFormatter(                        \
-                             __FILE__, __LINE__, __func__)                     \
-                      << GL_INTERNAL_L_DISPATCH(__VA_ARGS__, GL_INTERNAL_L16,  \
-                             GL_INTERNAL_L15, GL_INTERNAL_L14,                 \
-                             GL_INTERNAL_L13, GL_INTERNAL_L12,                 \
-                             GL_INTERNAL_L11, GL_INTERNAL_L10, GL_INTERNAL_L9, \
-                             GL_INTERNAL_L8, GL_INTERNAL_L7, GL_INTERNAL_L6,   \
-                             GL_INTERNAL_L5, GL_INTERNAL_L4, GL_INTERNAL_L3,   \
-                             GL_INTERNAL_L2, GL_INTERNAL_L1, )(__VA_ARGS__)    \
-                      << gl::internal::color_end << (GL_NEWLINE);              \
-        }                                                                      \
-    } while (false)
-
-/**
- * \brief Log array.
- *
- * \param v   Array to print [\p len].
- * \param len Number of elements.
- *
- * Used as:
+ * Report periodically in a background thread with:
  * \code
- * int a[] = {0, 1, 2};
- * l_arr(a, 3);
+ * gl::start_reporter(std::chrono::seconds(1));
  * \endcode
+ * \sa l_hist() \sa l_count() \sa report() \sa start_reporter()
  *
- * Which outputs:
+ * \subsection section_profile Profile
+ * Measure the cost of logging per call site:
  * \code
- * a = {0, 1, 2}
+ * #define GL_PROFILE
+ * #include "goinglogging.h"
  * \endcode
- *
- * \note Uses prefix information set with \ref set_prefixes().
- * \note Unlike \ref l(), this does not support multiple varaibles as
- * parameters.
- *
- * \warning Behaviour is undefined if \p len is larger than the
- * allocated array.
- *
- * \sa l() \sa l_mat() \sa set_prefixes()
- *
- */
-#define l_arr(v, len)                                                       \
-    do {                                                                    \
-        std::cout << ::gl::internal::make_array((#v), (v), (len),           \
-            ::gl::internal::PrefixFormatter(__FILE__, __LINE__, __func__)); \
-    } while (false)
-
-/**
- * \brief Log matrix.
- *
- * \param m    Matrix to print [\p rows x \p cols].
- * \param cols Number of columns in matrix.
- * \param rows Number of rows in matrix.
- *
- * Used as:
+ * The profile is written to std::cerr at program exit, and on demand with:
  * \code
- * int m[][] = {{11, 12}, {21, 22}};
- * l_mat(m, 2, 2);
+ * gl::print_profile(std::cout);
  * \endcode
- *
- * Which outputs:
+ * Which outputs the most expensive call sites first:
  * \code
- * m: [0,0] = 11, [0,1] = 12, [1,0] = 21, [1,1] = 22
+ * goinglogging profile, sorted by total time:
+ * main.cpp:12, main(): calls = 100, suppressed = 0, bytes = 1100, total =
+ * 310021 ns, max = 20110 ns
  * \endcode
+ * \sa GL_PROFILE \sa print_profile()
  *
- * \note Uses prefix information set with \ref set_prefixes().
- * \note Unlike \ref l(), this does not support multiple variables
- * as parameters.
- *
- * \warning Behaviour is undefined if \p c or \p r is larger than
- * the allocated matrix.
- *
- * \sa l() \sa l_arr() \sa set_prefixes()
- *
- */
-#define l_mat(m, cols, rows)                                                \
-    do {                                                                    \
-        std::cout << ::gl::internal::make_matrix((#m), (m), (cols), (rows), \
-            ::gl::internal::PrefixFormatter(__FILE__, __LINE__, __func__)); \
-    } while (false)
-
-#ifndef GL_NEWLINE
-/**
- * \brief Newline character to use after each logging message.
- *
- * May e.g. be changed to std::endl to enable flush after each
- * logging message:
+ * \subsection section_timers Timers
+ * Measure the time until the end of the current scope:
  * \code
- * #define GL_NEWLINE std::endl
- * #include "goinglogging.h"
+ * void work() {
+ *     l_time_scope(work);
+ *     ...
+ * }
  * \endcode
+ * Durations are reported per call site by \ref report(), as for
+ * \ref l_hist(). Use \ref l_time_scope_log() to also log each duration.
+ * \sa l_time_scope() \sa l_time_scope_log()
+ *
+ * \subsection section_sites Enable call sites
+ * Disable or rate limit call sites of \ref l(), \ref l_arr() and
+ * \ref l_mat() by glob pattern, matched against "file:line" and function
+ * name:
+ * \code
+ * gl::set_sites_enabled("*", false);
+ * gl::set_sites_enabled("network.cpp:*", true);
+ * gl::set_rate_limit("process_packet", 100);
+ * \endcode
+ * To change this and other settings in a running program, start a control
+ * thread which reads commands from a named FIFO or a Unix domain socket:
+ * \code
+ * #include "goinglogging/control.h"
  *
- * \note Defaults to \\n, i.e. no flushing.
- *
- * \sa l() \sa l_arr() \sa l_mat()
- *
- */
-#define GL_NEWLINE '\n'
-#endif // GL_NEWLINE
-
-/**
- * \brief goinglogging namespace. */
-namespace gl {
-
-/**
- * \brief Prefix of logging output.
+ * gl::start_control("/tmp/my_program.ctl");
+ * \endcode
+ * And from a shell:
+ * \code
+ * echo "prefixes FILE|LINE|TIME" > /tmp/my_program.ctl
+ * \endcode
+ * Define \ref GL_STATIC_KEYS to compile each call site to a jump, which
+ * disabling the site rewrites to a no-op instruction.
+ * \sa set_sites_enabled() \sa set_rate_limit() \sa GL_STATIC_KEYS
  *
- * Use bitwise \c or for multiple prefixes at the same time:
+ * \subsection section_formats JSON and CBOR
+ * Log one JSON object per line, or a sequence of CBOR maps, instead of text:
  * \code
+ * gl::set_format(gl::format::JSON);
  * gl::set_prefixes(gl::prefix::FILE | gl::prefix::LINE);
+ * std::vector<int> v = {1, 2};
+ * l(i, v);
  * \endcode
- * Bitwise \c and as well as \c xor are also supported.
- *
- * \sa set_prefixes() \sa get_prefixes()
- *
- */
-enum class prefix : uint32_t {
-    NONE = 0,          /**< No prefix. */
-    FILE = 1 << 0,     /**< File name. For example 'main.cpp'. */
-    LINE = 1 << 1,     /**< Line number in file. For example 'Line:
-                          16'. */
-    FUNCTION = 1 << 2, /**< Function name. For example 'calculate()'. */
-    TIME     = 1 << 3, /**< Current local time as
-                        * hour:minute:second.millisecond.
-                        *  For example '10:02:13.057'. */
-    THREAD = 1 << 4,   /**< ID of current thread. For example
-                          'TID:   12'. */
-    TYPE_NAME = 1 << 5 /**< Name of type. For example 'int'. */
-};
-
-/**
- * \brief Bitwise \c and of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c and of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix operator&(prefix lhs, prefix rhs) noexcept {
-    return static_cast<prefix>(
-        static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs));
-}
-
-/**
- * \brief Bitwise \c and of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c and of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix& operator&=(prefix& lhs, prefix rhs) noexcept {
-    return lhs = lhs & rhs;
-}
-
-/**
- * \brief Bitwise \c or of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c or of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix operator|(prefix lhs, prefix rhs) noexcept {
-    return static_cast<prefix>(
-        static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
-}
-
-/**
- * \brief Bitwise \c or of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c or of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix& operator|=(prefix& lhs, prefix rhs) noexcept {
-    return lhs = lhs | rhs;
-}
-
-/**
- * \brief Bitwise \c xor of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c xor of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix operator^(prefix lhs, prefix rhs) noexcept {
-    return static_cast<prefix>(
-        static_cast<uint32_t>(lhs) ^ static_cast<uint32_t>(rhs));
-}
-
-/**
- * \brief Bitwise \c xor of logging prefix settings.
- *
- * \param lhs First element.
- * \param rhs Second element.
- * \return Bitwise \c xor of \p lhs and \p rhs.
- *
- * \sa prefix \sa set_prefixes()
- *
- */
-inline prefix& operator^=(prefix& lhs, prefix rhs) noexcept {
-    return lhs = lhs ^ rhs;
-}
-
-/**
- * \brief Hide this section from doxygen */
-#ifndef DOXYGEN_HIDDEN
-
-/**
- * \brief Functionality in this namespace is for internal use
- */
-namespace internal {
-
-#ifdef __GNUC__
-/**
- * \brief Demangler of variable type names.
- */
-class Demangler {
-  public:
-    /**
-     * \brief Constructor.
-     */
-    Demangler() : m_buf(nullptr), m_buf_len(0) {
-    }
-
-    /**
-     * \brief Destructor. Free any allocated memory.
-     */
-    ~Demangler() {
-        // OK even if buf = nullptr
-        free(m_buf);
-    }
-
-    /**
-     * \brief Demangle type name.
-     *
-     * \param type_name Mangled type name.
-     * \return Demangled type name.
-     */
-    const char* demangle(const char* type_name) {
-        // Demangle name
-        int status = 0;
-        m_buf      = abi::__cxa_demangle(type_name, m_buf, &m_buf_len, &status);
-
-        // Check success
-        switch (status) {
-        case 0:
-            // Success. Do nothing.
-            break;
-        case -1: {
-            m_buf     = nullptr;
-            m_buf_len = 0;
-            std::stringstream ss;
-            ss << "Demangle: Invalid type name '" << type_name << '\'';
-            throw std::runtime_error(ss.str());
-            break;
-        }
-        case -2:
-            m_buf     = nullptr;
-            m_buf_len = 0;
-            throw std::runtime_error("Demangle: Memory allocation failure");
-            break;
-        case -3:
-            m_buf     = nullptr;
-            m_buf_len = 0;
-            throw std::runtime_error("Demangle: Invalid argument");
-            break;
-        default:
-            m_buf     = nullptr;
-            m_buf_len = 0;
-            throw std::runtime_error("Demangle: Unknown error");
-            break;
-        }
-
-        return m_buf;
-    }
-
-  private:
-    char*  m_buf;     /**< Demangle name buffer. Allocated with malloc. */
-    size_t m_buf_len; /**< Demangle name buffer length. */
-};
-#endif // __GNUC__
-
-/** Current prefixes */
-static prefix curPrefixes = prefix::FILE | prefix::LINE;
-/** \c true if output is enabled */
-static bool outputEnabled = true;
-/** \c true if colored output is enabled */
-static bool colorEnabled = false;
-#ifdef __GNUC__
-static Demangler demangler;
-#endif // __GNUC__
-
-/**
- * \brief Prefix formatter. */
-class PrefixFormatter {
-  public:
-    /**
-     * \brief Constructor.
-     *
-     * \param file_path File path including name.
-     * \param file_line Line number in file.
-     * \param func      Function name.
-     *
-     */
-    PrefixFormatter(
-        const char* file_path, long file_line, const char* func) noexcept :
-        m_file_path(file_path),
-        m_file_line(file_line), m_func(func) {
-    }
-
-    friend std::ostream& operator<<(
-        std::ostream& os, const PrefixFormatter& p) noexcept;
-
-    /**
-     * \return File path including name.
-     */
-    const char* get_file_path() const noexcept {
-        return m_file_path;
-    }
-
-    /**
-     * \return Line number in file.
-     */
-    long get_file_line_number() const noexcept {
-        return m_file_line;
-    }
-
-    /**
-     * \return Function name.
-     */
-    const char* get_function_name() const noexcept {
-        return m_func;
-    }
-
-  private:
-    const char* m_file_path; /**< File path including name. */
-    const long  m_file_line; /**< Line number in file. */
-    const char* m_func;      /**< Function name. */
-};
-
-/**
- * \brief Write to stream.
- *
- * \param os Output stream.
- * \param p  PrefixFormatter to output.
- * \return Output stream.
- *
- */
-std::ostream& operator<<(std::ostream& os, const PrefixFormatter& p) noexcept {
-    /** Number of prefixes written */
-    uint32_t cnt = 0;
-
-    // FILE
-    if ((curPrefixes & prefix::FILE) != prefix::NONE) {
-        /** Platform dependent path separator */
-        const char sep =
-#ifdef _WIN32
-            '\\';
-#else
-            '/';
-#endif // _WIN32
-
-        /** File path */
-        const char* path = p.get_file_path();
-
-        // Get index of last file path separator
-        /** Length of string */
-        size_t str_len = std::strlen(path);
-        /** File path separator index */
-        size_t sep_idx = std::numeric_limits<size_t>::max();
-        // No need to check for str_len = 0 here, since that
-        // will stop the for loop anyway
-        for (size_t i = str_len - 1; i != std::numeric_limits<size_t>::max();
-             --i) {
-            if (path[i] == sep) {
-                sep_idx = i;
-                break;
-            }
-        }
-
-        // Output
-        os << (sep_idx == std::numeric_limits<size_t>::max() ?
-                   path :
-                   path + sep_idx + 1);
-
-        ++cnt;
-    }
-
-    // LINE
-    if ((curPrefixes & prefix::LINE) != prefix::NONE) {
-        // Output 'Line' prefix only if file name has not been
-        // output
-        if (cnt == 0) {
-            os << "Line: ";
-        } else {
-            os << ":";
-        }
-        os << p.get_file_line_number();
-
-        ++cnt;
-    }
-
-    // FUNCTION
-    if ((curPrefixes & prefix::FUNCTION) != prefix::NONE) {
-        if (cnt != 0) {
-            os << ", ";
-        }
-        os << p.get_function_name() << "()";
-        ++cnt;
-    }
-
-    // TIME
-    if ((curPrefixes & prefix::TIME) != prefix::NONE) {
-        // Get time
-        auto now = std::chrono::system_clock::now();
-
-        // Convert
-        std::time_t sinceEpoch = std::chrono::system_clock::to_time_t(now);
-        auto        ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                      now.time_since_epoch()) %
-                  1000;
-        std::tm* local = std::localtime(&sinceEpoch);
-
-        if (local != nullptr) {
-            if (cnt != 0) {
-                os << ", ";
-            }
-            // Format and output
-            os << std::put_time(local, "%H:%M:%S") << '.' << std::setfill('0')
-               << std::setw(3) << ms.count();
-            ++cnt;
-        }
-    }
-
-    // THREAD
-    if ((curPrefixes & prefix::THREAD) != prefix::NONE) {
-        if (cnt != 0) {
-            os << ", ";
-        }
-        os << "TID: " << std::this_thread::get_id();
-        ++cnt;
-    }
-
-    // Final separator, if any
-    if (cnt != 0) {
-        os << ": ";
-    }
-
-    return os;
-}
-
-/**
- * \brief Variable value formatter.
- *
- * \tparam T Value type.
- *
- */
-template<class T>
-class ValueFormatter {
-  public:
-    /**
-     * \brief Constructor.
-     *
-     * \param val Value.
-     *
-     */
-    explicit ValueFormatter(T& val) noexcept : m_val(val) {
-    }
-
-    // Container value helper functions.
-    std::ostream& sequence(std::ostream& os) const noexcept;
-    std::ostream& map(std::ostream& os) const noexcept;
-    std::ostream& stack(std::ostream& os) const noexcept;
-    std::ostream& queue(std::ostream& os) const noexcept;
-
-    template<class U>
-    friend std::ostream& operator<<(
-        std::ostream& os, const ValueFormatter<U>& f) noexcept;
-
-    /**
-     * \return Value to format.
-     */
-    T& get_value() const {
-        return m_val;
-    }
-
-  private:
-    T& m_val; /**< Value to format. Use non-const reference in case operator<<
-                 isn't const. */
-};
-
-/**
- * \brief Create ValueFormatter with the right template type.
- *  This solves the error "cannot refer to class template
- * 'ValueFormatter' without a template argument list".
- *
- * \tparam T Value type.
- * \param val Value.
- * \return New ValueFormatter.
- */
-template<class T>
-ValueFormatter<T> format_value(T& val) {
-    return ValueFormatter<T>(val);
-};
-
-/**
- * \brief Write a sequence, defined by begin() and end(), to stream.
- *
- * \tparam T Value type.
- * \param os Output stream.
- * \return Output stream.
- *
- */
-template<class T>
-std::ostream& ValueFormatter<T>::sequence(std::ostream& os) const noexcept {
-    os << '{';
-    // Print first object without comma
-    auto it = std::begin(m_val);
-    if (it != std::end(m_val)) {
-        os << format_value(*it);
-        ++it;
-    }
-    // Print the rest
-    for (; it != std::end(m_val); ++it) {
-        os << ", " << format_value(*it);
-    }
-    os << '}';
-
-    return os;
-}
-
-/**
- * \brief Write a map, defined by begin() and end(), to stream.
- *
- * \tparam T Value type.
- * \param os Output stream.
- * \return Output stream.
- *
- */
-template<class T>
-std::ostream& ValueFormatter<T>::map(std::ostream& os) const noexcept {
-    os << '{';
-    // Print first object without comma
-    auto it = m_val.begin();
-    if (it != m_val.end()) {
-        os << format_value(it->first) << ": " << format_value(it->second);
-        ++it;
-    }
-    // Print the rest
-    for (; it != m_val.end(); ++it) {
-        os << ", " << format_value(it->first) << ": "
-           << format_value(it->second);
-    }
-    os << '}';
-
-    return os;
-}
-
-/**
- * \brief Write a stack, defined by top(), to stream.
- *
- * \tparam T Value type.
- * \param os Output stream.
- * \return Output stream.
- *
- */
-template<class T>
-std::ostream& ValueFormatter<T>::stack(std::ostream& os) const noexcept {
-    // Only print first element, if available
-    os << '{';
-    if (m_val.size() == 1) {
-        os << format_value(m_val.top());
-    } else if (!m_val.empty()) {
-        os << format_value(m_val.top()) << ", ...";
-    }
-    os << '}';
-
-    return os;
-}
-
-/**
- * \brief Write a queue, defined by front() and back(), to stream.
- *
- * \tparam T Value type.
- * \param os Output stream.
- * \return Output stream.
- *
- */
-template<class T>
-std::ostream& ValueFormatter<T>::queue(std::ostream& os) const noexcept {
-    // Only print first element, if available
-    os << '{';
-    if (m_val.size() == 1) {
-        os << format_value(m_val.front());
-    } else if (m_val.size() == 2) {
-        os << format_value(m_val.front()) << ", " << format_value(m_val.back());
-    } else if (!m_val.empty() != 0) {
-        os << format_value(m_val.front()) << ", ..., "
-           << format_value(m_val.back());
-    }
-    os << '}';
-
-    return os;
-}
-
-/**
- * \brief General value formatter.
- *
- * \tparam T Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class T>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<T>& f) noexcept {
-    return os << f.m_val;
-}
-
-/**
- * \brief Format std::pair.
- *
- * \tparam U First type of pair.
- * \tparam V Second type of pair.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::pair<U, V>>& f) noexcept {
-    return os << '{' << format_value(f.get_value().first) << ", "
-              << format_value(f.get_value().second) << '}';
-}
-
-/**
- * \brief Format std::tuple.
- *
- * \tparam U First type of tuple.
- * \tparam V Second type of tuple.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::tuple<U, V>>& f) noexcept {
-    return os << '{' << format_value(std::get<0>(f.get_value())) << ", "
-              << format_value(std::get<1>(f.get_value())) << '}';
-}
-
-/**
- * \brief Format std::unique_ptr.
- *
- * \tparam U Pointer type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::unique_ptr<U>>& f) noexcept {
-    return os << f.get_value().get();
-}
-
-/**
- * \brief Format std::shared_ptr.
- *
- * \tparam U Pointer type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::shared_ptr<U>>& f) noexcept {
-    return os << f.get_value().get();
-}
-
-/**
- * \brief Format std::weak_ptr.
- *
- * \tparam U Pointer type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::weak_ptr<U>>& f) noexcept {
-    // Convert to temporary shared_ptr in order to get value.
-    std::shared_ptr<U> tmp = f.get_value().lock();
-    return os << tmp.get();
-}
-
-/**
- * \brief Format std::complex.
- *
- * \tparam U Pointer type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::complex<U>>& f) noexcept {
-    os << f.get_value().real();
-    if (f.get_value().imag() >= 0) {
-        os << " + " << f.get_value().imag();
-    } else {
-        os << " - " << -f.get_value().imag();
-    }
-    return os << 'i';
-}
-
-/**
- * \brief Format std::valarray.
- *
- * \tparam U Element type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::valarray<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format bool.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<bool>& f) noexcept {
-    return os << (f.m_val ? "true" : "false");
-}
-
-// 3.9.1 in C++ standard: Plain char, signed char, and unsigned
-// char are three distinct types
-
-/**
- * \brief Format char.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<char>& f) noexcept {
-    return os << '\'' << f.m_val << '\'';
-}
-
-/**
- * \brief Format unsigned char.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<unsigned char>& f) noexcept {
-    return os << '\'' << f.m_val << '\'';
-}
-
-/**
- * \brief Format signed char.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<signed char>& f) noexcept {
-    return os << '\'' << f.m_val << '\'';
-}
-
-/**
- * \brief Format char*.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<char*>& f) noexcept {
-    return os << '\"' << f.m_val << '\"';
-}
-
-/**
- * \brief Format const char*.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<const char*>& f) noexcept {
-    return os << '\"' << f.m_val << '\"';
-}
-
-/**
- * \brief Format std::tm.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::tm>& f) noexcept {
-    // Format as "YYYY-MM-DD HH:MM:SS", including null pointer
-    char buf[20];
-    if (std::strftime(buf, sizeof(buf), "%F %T", &f.m_val) == 0) {
-        os << "std::tm format error";
-    } else {
-        os << buf;
-    }
-    return os;
-}
-
-/**
- * \brief Format std::div_t.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::div_t>& f) noexcept {
-    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
-}
-
-/**
- * \brief Format std::ldiv_t.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::ldiv_t>& f) noexcept {
-    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
-}
-
-/**
- * \brief Format std::lldiv_t.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::lldiv_t>& f) noexcept {
-    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
-}
-
-/**
- * \brief Format std::ratio.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<std::intmax_t U, std::intmax_t V>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::ratio<U, V>>& f) noexcept {
-    return os << f.get_value().num << " / " << f.get_value().den;
-}
-
-/**
- * \brief Format std::stringbuf.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::stringbuf>& f) noexcept {
-    return os << '\"' << f.m_val.str() << '\"';
-}
-
-/**
- * \brief Format std::wstringbuf.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::wstringbuf>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val.str()) << '\"';
-}
-
-/**
- * \brief Format std::ostringstream.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::ostringstream>& f) noexcept {
-    return os << '\"' << f.m_val.str() << '\"';
-}
-
-/**
- * \brief Format std::wostringstream.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::wostringstream>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val.str()) << '\"';
-}
-
-/**
- * \brief Format std::stringstream.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::stringstream>& f) noexcept {
-    return os << '\"' << f.m_val.str() << '\"';
-}
-
-/**
- * \brief Format std::wstringstream.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::wstringstream>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val.str()) << '\"';
-}
-
-/**
- * \brief Format std::locale.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::locale>& f) noexcept {
-    return os << '"' << f.m_val.name() << '"';
-}
-
-/**
- * \brief Format std::string.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::string>& f) noexcept {
-    return os << '\"' << f.m_val << '\"';
-}
-
-/**
- * \brief Format std::u16string.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::u16string>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<char16_t>, char16_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val) << '\"';
-}
-
-/**
- * \brief Format std::u32string.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::u32string>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val) << '\"';
-}
-
-/**
- * \brief Format std::wstring.
- *
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::wstring>& f) noexcept {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
-    return os << '\"' << converter.to_bytes(f.m_val) << '\"';
-}
-
-/**
- * \brief Format std::array.
- *
- * \tparam U Value type.
- * \tparam N Number of elements.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, size_t N>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::array<U, N>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::vector.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::vector<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::deque.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::deque<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::forward_list.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::forward_list<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::list.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::list<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::set.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::set<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::map.
- *
- * \tparam U Key type.
- * \tparam V Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::map<U, V>>& f) noexcept {
-    return f.map(os);
-}
-
-/**
- * \brief Format std::multiset.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::multiset<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::multimap.
- *
- * \tparam U Key type.
- * \tparam V Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::multimap<U, V>>& f) noexcept {
-    return f.map(os);
-}
-
-/**
- * \brief Format std::unordered_set.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::unordered_set<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::unordered_map.
- *
- * \tparam U Key type.
- * \tparam V Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(std::ostream&              os,
-    const ValueFormatter<std::unordered_map<U, V>>& f) noexcept {
-    return f.map(os);
-}
-
-/**
- * \brief Format std::unordered_multiset.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(std::ostream&                os,
-    const ValueFormatter<std::unordered_multiset<U>>& f) noexcept {
-    return f.sequence(os);
-}
-
-/**
- * \brief Format std::unordered_multimap.
- *
- * \tparam U Key type.
- * \tparam V Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U, class V>
-std::ostream& operator<<(std::ostream&                   os,
-    const ValueFormatter<std::unordered_multimap<U, V>>& f) noexcept {
-    return f.map(os);
-}
-
-/**
- * \brief Format std::stack.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::stack<U>>& f) noexcept {
-    return f.stack(os);
-}
-
-/**
- * \brief Format std::queue.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(
-    std::ostream& os, const ValueFormatter<std::queue<U>>& f) noexcept {
-    return f.queue(os);
-}
-
-/**
- * \brief Format std::priority_queue.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param f  ValueFormatter.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(std::ostream&            os,
-    const ValueFormatter<std::priority_queue<U>>& f) noexcept {
-    return f.stack(os);
-}
-
-/**
- * \brief Write ANSI color start code to stream, if color is enabled.
- *
- * \param os Output stream.
- * \return Output stream.
- *
- */
-std::ostream& color_start(std::ostream& os) noexcept {
-    if (colorEnabled) {
-        // Red
-        os << "\033[0;31m";
-    }
-    return os;
-}
-
-/**
- * \brief Write ANSI color end code to stream, if color is enabled.
- *
- * \param os Output stream.
- * \return Output stream.
- *
- */
-std::ostream& color_end(std::ostream& os) noexcept {
-    if (colorEnabled) {
-        os << "\033[0m";
-    }
-    return os;
-}
-
-/**
- * \brief Variable type formatter.
- *
- * \tparam T Variable type.
- * \param os Output stream.
- * \return Output stream.
- */
-template<class T>
-std::ostream& type_name(std::ostream& os) {
-    if ((curPrefixes & prefix::TYPE_NAME) == prefix::TYPE_NAME) {
-        const char* tn     = typeid(T).name();
-        const char* output = nullptr;
-#ifndef __GNUC__
-        output = tn;
-#else
-        output = demangler.demangle(tn);
-#endif // __GNUC__
-
-        os << output << ' ';
-    }
-    return os;
-}
-
-/**
- * \brief Array.
- *
- * \tparam T Value type.
- *
- */
-template<class T>
-class Array {
-  public:
-    /**
-     * \brief Constructor.
-     *
-     * \param name      Name.
-     * \param val       Values [\p len].
-     * \param len       Number of values.
-     * \param prefixFmt PrefixFormatter.
-     *
-     */
-    explicit Array(const char* name, T& val, size_t len,
-        const PrefixFormatter& prefixFmt) noexcept :
-        m_name(name),
-        m_val(val), m_len(len), m_prefixFmt(prefixFmt) {
-    }
-
-    template<class U>
-    friend std::ostream& operator<<(
-        std::ostream& os, const Array<U>& a) noexcept;
-
-    /**
-     * \return Name.
-     */
-    const char* get_name() const noexcept {
-        return m_name;
-    }
-
-    /**
-     * \return Values.
-     */
-    T& get_values() const noexcept {
-        return m_val;
-    }
-
-    /**
-     * \return Number of values.
-     */
-    size_t get_number_of_values() const noexcept {
-        return m_len;
-    }
-
-    /**
-     * \return PrefixFormatter.
-     */
-    const PrefixFormatter& get_prefix_formatter() const noexcept {
-        return m_prefixFmt;
-    }
-
-  private:
-    const char*            m_name;      /**< Name. */
-    T&                     m_val;       /**< Values. */
-    const size_t           m_len;       /**< Number of values. */
-    const PrefixFormatter& m_prefixFmt; /**< PrefixFormatter. */
-};
-
-/**
- * \brief Write Array to stream.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param a  Array.
- * \return Output stream.
- *
- */
-template<class U>
-std::ostream& operator<<(std::ostream& os, const Array<U>& a) noexcept {
-    if (outputEnabled) {
-        os << color_start << a.get_prefix_formatter()
-           << type_name<U> << a.get_name() << " = {";
-        // Print first object without comma
-        if (a.get_number_of_values() > 0) {
-            os << format_value(a.get_values()[0]);
-        }
-        // Print the rest
-        for (size_t i = 1; i < a.get_number_of_values(); ++i) {
-            os << ", " << format_value(a.get_values()[i]);
-        }
-        os << '}' << color_end << GL_NEWLINE;
-    }
-
-    return os;
-}
-
-/**
- * \brief Create array.
- *  This solves the error "cannot refer to class template 'Array' without a
- * template argument list".
- *
- * \tparam T Value type.
- * \param name      Name.
- * \param val       Values.
- * \param len       Number of values.
- * \param prefixFmt PrefixFormatter.
- * \return Array.
- *
- */
-template<class T>
-Array<T> make_array(
-    const char* name, T& val, size_t len, const PrefixFormatter& prefixFmt) {
-    return Array<T>(name, val, len, prefixFmt);
-};
-
-/**
- * \brief Matrix.
- *
- * \tparam T Value type.
- *
- */
-template<class T>
-class Matrix {
-  public:
-    /**
-     * \brief Constructor.
-     *
-     * \param name      Name.
-     * \param val       Values [\p cols x \p rows].
-     * \param cols      Number of columns.
-     * \param rows      Number of rows.
-     * \param prefixFmt PrefixFormatter.
-     *
-     */
-    explicit Matrix(const char* name, T& val, size_t cols, size_t rows,
-        const PrefixFormatter& prefixFmt) noexcept :
-        m_name(name),
-        m_val(val), m_cols(cols), m_rows(rows), m_prefixFmt(prefixFmt) {
-    }
-
-    template<class U>
-    friend std::ostream& operator<<(
-        std::ostream& os, const Matrix<U>& a) noexcept;
-
-    /**
-     * \return Name.
-     */
-    const char* get_name() const noexcept {
-        return m_name;
-    }
-
-    /**
-     * \return Values.
-     */
-    T& get_values() const noexcept {
-        return m_val;
-    }
-
-    /**
-     * \return Number of columns.
-     */
-    size_t get_number_of_columns() const noexcept {
-        return m_cols;
-    }
-
-    /**
-     * \return Number of rows.
-     */
-    size_t get_number_of_rows() const noexcept {
-        return m_rows;
-    }
-
-    /**
-     * \return PrefixFormatter.
-     */
-    const PrefixFormatter& get_prefix_formatter() const noexcept {
-        return m_prefixFmt;
-    }
-
-  private:
-    const char*            m_name;      /**< Name. */
-    T&                     m_val;       /**< Values. */
-    const size_t           m_cols;      /**< Number of columns. */
-    const size_t           m_rows;      /**< Number of rows. */
-    const PrefixFormatter& m_prefixFmt; /**< PrefixFormatter. */
-};
-
-/**
- * \brief Write Matrix to stream.
- *
- * \tparam U Value type.
- * \param os Output stream.
- * \param m  Matrix.
- * \return Output stream.
+ * Which outputs:
+ * \code
+ * {"file":"main.cpp","line":12,"values":{"i":1,"v":[1,2]}}
+ * \endcode
+ * Prefixes are fields, containers are arrays and maps are objects. Files which
+ * only include the core include goinglogging/structured.h to set the format.
+ * \sa set_format()
  *
- */
-template<class U>
-std::ostream& operator<<(std::ostream& os, const Matrix<U>& m) noexcept {
-    if (outputEnabled) {
-        os << color_start << m.get_prefix_formatter()
-           << type_name<U> << m.get_name() << ": ";
-        if (m.get_number_of_columns() <= 0 || m.get_number_of_rows() <= 0) {
-            os << "{}";
-        } else {
-            os << "[0,0] = " << format_value(m.get_values()[0][0]);
-            for (size_t j = 1; j < m.get_number_of_columns(); ++j) {
-                os << ", "
-                   << "[0," << j
-                   << "] = " << format_value(m.get_values()[0][j]);
-            }
-            for (size_t i = 1; i < m.get_number_of_rows(); ++i) {
-                for (size_t j = 0; j < m.get_number_of_columns(); ++j) {
-                    os << ", "
-                       << "[" << i << ',' << j
-                       << "] = " << format_value(m.get_values()[i][j]);
-                }
-            }
-        }
-        os << color_end << GL_NEWLINE;
-    }
-
-    return os;
-}
-
-/**
- * \brief Create matrix.
- *  This solves the error "cannot refer to class template 'Matrix' without a
- * template argument list".
+ * \subsection section_capture Capture
+ * Store the numbers logged by \ref l() as compressed columns per call site,
+ * instead of writing them:
+ * \code
+ * #include "goinglogging/capture.h"
  *
- * \tparam T Value type.
- * \param name      Name.
- * \param val       Values.
- * \param cols      Number of columns.
- * \param rows      Number of rows.
- * \param prefixFmt PrefixFormatter.
+ * gl::set_capture_enabled(true);
+ * ...
+ * gl::write_capture("capture.bin");
+ * \endcode
+ * Timestamps and integers are delta-of-delta encoded, and floating point
+ * numbers XOR encoded, as in Facebook's Gorilla. Export the columns to CSV
+ * with the gl_capture tool, or with export_capture_csv() in
+ * goinglogging/capture.h.
+ * \sa set_capture_enabled() \sa write_capture()
+ *
+ * \subsection section_shm_bus Shared memory log bus
+ * Log from several processes to one ring buffer in shared memory, without
+ * system calls or locks when logging:
+ * \code
+ * #include "goinglogging/shm_bus.h"
  *
- * \return New matrix.
+ * gl::start_shm_bus("/my_system");
+ * \endcode
+ * And read it, live or after a crash, with the gl_tail tool:
+ * \code
+ * gl_tail -f /my_system
+ * \endcode
+ * If the ring is full, the oldest messages are overwritten and gl_tail
+ * reports the overrun.
  *
- */
-template<class T>
-Matrix<T> make_matrix(const char* name, T& val, size_t cols, size_t rows,
-    const PrefixFormatter& prefixFmt) {
-    return Matrix<T>(name, val, cols, rows, prefixFmt);
-};
-
-} // namespace internal
-
-#endif // DOXYGEN_HIDDEN
-
-/**
+ * \subsection section_flight_recorder Flight recorder
+ * Keep the most recent messages of each thread in memory, and write them to
+ * stderr only when the program crashes:
+ * \code
+ * #include "goinglogging/flight_recorder.h"
  *
- * \return Bitwise \c or of prefix settings.
+ * gl::start_flight_recorder();
+ * \endcode
+ * The messages are written on SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT and
+ * std::terminate(), oldest first, and also by dump_recent().
  *
- * \sa prefix \sa set_prefixes()
+ * \subsection section_batch_sink Batched writing
+ * Write to a file descriptor from a background thread, with one system call
+ * per batch of messages instead of one per message:
+ * \code
+ * #include "goinglogging/batch_sink.h"
  *
- */
-prefix get_prefixes() noexcept {
-    return internal::curPrefixes;
-}
-
-/**
- * \brief Set prefixes of logging output.
+ * gl::start_batch_sink(fd, 256, std::chrono::milliseconds(5));
+ * \endcode
+ * A batch is written when it has 256 messages, or when its first message has
+ * waited 5 ms. Batches are written with io_uring on Linux if available, and
+ * otherwise with writev(). Either way takes one system call per batch.
  *
- * Alters the output of \ref l(), \ref l_arr(), and \ref l_mat().
+ * \subsection section_lz4_sink LZ4 compression
+ * Compress logging in the LZ4 frame format on a background thread, without
+ * any library:
+ * \code
+ * #include "goinglogging/lz4_sink.h"
  *
- * \param p Bitwise \c or of prefix settings.
+ * std::ofstream f("log.txt.lz4", std::ios::binary);
+ * gl::start_lz4_sink(f);
+ * \endcode
+ * Read the file with <tt>lz4 -dc log.txt.lz4</tt>. Compression ratio and
+ * throughput are available from lz4_sink_stats().
  *
- * Used as:
+ * \subsection section_compile_time Faster compilation
+ * goinglogging.h includes the formatters of all standard containers. Files
+ * may instead include the core, which includes no containers, threads,
+ * mutexes or clocks, and the formatters of the container families they log:
  * \code
- * gl::set_prefixes(gl::prefix::FILE | gl::prefix::LINE);
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/sequence.h"
  * \endcode
- * to also log current file and line number.
- *
- * \note Defaults to prefix::FILE | prefix::LINE.
- *
- * \sa prefix \sa get_prefixes()
- *
- */
-void set_prefixes(prefix p) noexcept {
-    internal::curPrefixes = p;
-}
-
-/**
- *
- * \return \c true if output is enabled.
- *
- * \sa set_output_enabled()
+ * The families are sequence.h, associative.h, adaptor.h, utility.h,
+ * numeric.h and unicode.h. The JSON and CBOR formats are in structured.h,
+ * l_hist() and the other reports in report.h, gl::set_sites_enabled() and
+ * gl::set_rate_limit() in sites.h, and gl::print_profile() in profile.h.
+ * Build src/goinglogging.cpp as a library, and define \ref GL_PRECOMPILED
+ * in all files which log, to instantiate the formatting of common types once
+ * instead of in every file.
+ *
+ * Each call site of \ref l() inlines only the check if it is enabled, which
+ * is about 55 bytes of code with -O2. The formatting is in cold code out of
+ * line, so that it does not take space in the instruction cache.
+ *
+ * \subsection section_escape Escape and truncate strings
+ * Write control characters, '"' and '\\' in strings as C escape sequences,
+ * so that each message is one line, and cut strings longer than 16 bytes:
+ * \code
+ * gl::set_escape_enabled(true);
+ * gl::set_max_string_length(16);
+ * \endcode
+ * Which outputs for example:
+ * \code
+ * s = "line 1\nline 2\x01ab...(+1000 bytes)"
+ * \endcode
+ * \sa set_escape_enabled() \sa set_max_string_length()
  *
- */
-bool is_output_enabled() noexcept {
-    return internal::outputEnabled;
-}
-
-/**
- * \brief Enable or disable output.
+ * \subsection section_adaptors Container adaptors
+ * All elements of std::stack, std::queue and std::priority_queue are
+ * written, from their underlying containers and without copying. Priority
+ * queues are written in heap order, or with:
+ * \code
+ * gl::set_priority_queue_sorted(3);
+ * \endcode
+ * the 3 elements with the highest priority in sorted order:
+ * \code
+ * q = {5, 4, 3, ...}
+ * \endcode
+ * \sa set_priority_queue_sorted()
  *
- * \param e \c true if output shall be enabled.
+ * \subsection section_signal_safe Logging from signal handlers
+ * \ref l() is not async-signal-safe. From signal handlers, use:
+ * \code
+ * #include "goinglogging/signal_safe.h"
  *
- * \note Defaults to enabled.
+ * void on_signal(int sig) {
+ *     l_signal_safe(sig);
+ * }
+ * \endcode
+ * Which formats on the stack and writes with one call to write(), to the
+ * file descriptor set by \ref set_signal_safe_fd(). Only integers, enums,
+ * bools, characters, pointers and C strings can be logged.
+ * \sa l_signal_safe()
+ *
+ * \subsection section_npy Dump to NumPy files
+ * Large arrays and matrices can be dumped to NumPy .npy files instead of
+ * logging every element:
+ * \code
+ * #include "goinglogging/npy.h"
  *
- * \sa is_output_enabled()
+ * double m[1000][1000];
+ * l_npy_mat(m, 1000, 1000);
+ * \endcode
+ * Which writes the raw elements to a file named after the variable, call
+ * site and a sequence number, and logs only:
+ * \code
+ * m: npy = "m.main.cpp.12.0.npy", dtype = <f8, shape = (1000, 1000)
+ * \endcode
+ * \sa l_npy() \sa l_npy_mat() \sa set_npy_directory()
  *
- */
-void set_output_enabled(bool e) noexcept {
-    internal::outputEnabled = e;
-}
-
-/**
- * \brief Enable or disable ANSI color output.
+ * \subsection section_backtrace Backtraces
+ * To log variables with the call path that led to them:
+ * \code
+ * #include "goinglogging/backtrace.h"
  *
- * \param e \c true if output shall be colored.
+ * l_backtrace(i);
+ * \endcode
+ * Which outputs:
+ * \code
+ * i = 1, backtrace = {"parse(int)+0x2d", "load()+0x12", "main+0x3a"}
+ * \endcode
+ * l_backtrace() logs the call path alone. Only return addresses are captured
+ * at the call site. They are translated to names when the message is
+ * written, and the names are cached.
+ * \sa l_backtrace()
+ *
+ * \subsection section_log_index Indexed log files
+ * To write std::cout to a log file, with an index of its time ranges and call
+ * sites:
+ * \code
+ * #include "goinglogging/log_index.h"
  *
- * \note Defaults to disabled.
+ * gl::start_indexed_file("app.log");
+ * \endcode
+ * The gl_query tool reads the index, and then only the chunks of the log
+ * file with lines of a time range or call site.
+ * \sa gl::start_indexed_file() \sa gl::LogIndex
  *
- * \sa is_color_enabled()
+ * \subsection section_usdt Tracing with USDT probes
+ * Define \ref GL_USDT to make each call site a USDT probe goinglogging:log,
+ * which bpftrace, perf and SystemTap attach to while output stays disabled:
+ * \code
+ * bpftrace -e 'usdt:./app:goinglogging:log { printf("%s\n", str(arg3)); }'
+ * \endcode
+ * The message is only formatted while a tracer is attached.
+ * \sa GL_USDT
  *
  */
-void set_color_enabled(bool e) noexcept {
-    internal::colorEnabled = e;
-}
 
-/**
- *
- * \return \c true if ANSI color output is enabled.
+/** \file
  *
- * \sa set_color_enabled()
+ * \brief Lightweight logging library. Includes the core and the formatters
+ * of all container families.
  *
  */
-bool is_color_enabled() noexcept {
-    return internal::colorEnabled;
-}
-
-#ifndef DOXYGEN_HIDDEN
-
-/**
- * \brief Helper function for l(). Dispatch to the right macro depending on
- * number of arguments.
- *
- */
-#define GL_INTERNAL_L_DISPATCH(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, \
-    _12, _13, _14, _15, _16, NAME, ...)                                      \
-    NAME
-
-/**
- * \brief Output variable name and value. */
-#define GL_INTERNAL_LX(v)                                 \
-    gl::internal::type_name<decltype(v)> << (#v) << " = " \
-                                         << ::gl::internal::format_value((v))
-
-#define GL_INTERNAL_L1(v1) GL_INTERNAL_LX(v1)
-
-#define GL_INTERNAL_L2(v1, v2) GL_INTERNAL_L1(v1) << ", " << GL_INTERNAL_LX(v2)
-
-#define GL_INTERNAL_L3(v1, v2, v3) \
-    GL_INTERNAL_L2(v1, v2) << ", " << GL_INTERNAL_LX(v3)
-
-#define GL_INTERNAL_L4(v1, v2, v3, v4) \
-    GL_INTERNAL_L3(v1, v2, v3) << ", " << GL_INTERNAL_LX(v4)
 
-#define GL_INTERNAL_L5(v1, v2, v3, v4, v5) \
-    GL_INTERNAL_L4(v1, v2, v3, v4) << ", " << GL_INTERNAL_LX(v5)
-
-#define GL_INTERNAL_L6(v1, v2, v3, v4, v5, v6) \
-    GL_INTERNAL_L5(v1, v2, v3, v4, v5) << ", " << GL_INTERNAL_LX(v6)
-
-#define GL_INTERNAL_L7(v1, v2, v3, v4, v5, v6, v7) \
-    GL_INTERNAL_L6(v1, v2, v3, v4, v5, v6) << ", " << GL_INTERNAL_LX(v7)
-
-#define GL_INTERNAL_L8(v1, v2, v3, v4, v5, v6, v7, v8) \
-    GL_INTERNAL_L7(v1, v2, v3, v4, v5, v6, v7) << ", " << GL_INTERNAL_LX(v8)
-
-#define GL_INTERNAL_L9(v1, v2, v3, v4, v5, v6, v7, v8, v9) \
-    GL_INTERNAL_L8(v1, v2, v3, v4, v5, v6, v7, v8) << ", " << GL_INTERNAL_LX(v9)
-
-#define GL_INTERNAL_L10(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10) \
-    GL_INTERNAL_L9(v1, v2, v3, v4, v5, v6, v7, v8, v9)           \
-        << ", " << GL_INTERNAL_LX(v10)
-
-#define GL_INTERNAL_L11(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11) \
-    GL_INTERNAL_L10(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10)          \
-        << ", " << GL_INTERNAL_LX(v11)
-
-#define GL_INTERNAL_L12(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12) \
-    GL_INTERNAL_L11(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11)          \
-        << ", " << GL_INTERNAL_LX(v12)
-
-#define GL_INTERNAL_L13(                                               \
-    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13)            \
-    GL_INTERNAL_L12(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12) \
-        << ", " << GL_INTERNAL_LX(v13)
-
-#define GL_INTERNAL_L14(                                                    \
-    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14)            \
-    GL_INTERNAL_L13(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13) \
-        << ", " << GL_INTERNAL_LX(v14)
-
-#define GL_INTERNAL_L15(                                              \
-    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) \
-    GL_INTERNAL_L14(                                                  \
-        v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14)  \
-        << ", " << GL_INTERNAL_LX(v15)
-
-#define GL_INTERNAL_L16(                                                   \
-    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16) \
-    GL_INTERNAL_L15(                                                       \
-        v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15)  \
-        << ", " << GL_INTERNAL_LX(v16)
-
-#endif // DOXYGEN_HIDDEN
+#ifndef INCLUDE_GOINGLOGGING_H_
+#define INCLUDE_GOINGLOGGING_H_
 
-} // namespace gl
+#include "goinglogging/adaptor.h"
+#include "goinglogging/associative.h"
+#include "goinglogging/core.h"
+#include "goinglogging/numeric.h"
+#include "goinglogging/profile.h"
+#include "goinglogging/report.h"
+#include "goinglogging/sequence.h"
+#include "goinglogging/sites.h"
+#include "goinglogging/structured.h"
+#include "goinglogging/unicode.h"
+#include "goinglogging/utility.h"
 
 #endif // INCLUDE_GOINGLOGGING_H_
@@ -0,0 +1,198 @@
+/** \file
+ *
+ * \brief Formatters of container adaptors: std::stack, std::queue and
+ * std::priority_queue.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/adaptor.h"
+ *
+ * std::stack<int> s;
+ * s.push(1);
+ * l(s);
+ * \endcode
+ *
+ * All elements are written, from the underlying container and without
+ * copying: stacks from the top, queues from the front, and priority queues
+ * in heap order or sorted, see set_priority_queue_sorted().
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_ADAPTOR_H_
+#define INCLUDE_GOINGLOGGING_ADAPTOR_H_
+
+#include "core.h"
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <queue>
+#include <stack>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Access to the protected members of a container adaptor.
+ *
+ * \tparam A Adaptor type.
+ */
+template<class A>
+struct AdaptorAccess : A {
+    /**
+     * \param a Adaptor.
+     * \return Underlying container of \p a.
+     */
+    static typename A::container_type& container(A& a) noexcept {
+        return a.*(&AdaptorAccess::c);
+    }
+
+    /**
+     * \tparam Cmp Comparator type.
+     * \param a Priority queue.
+     * \return Comparator of \p a.
+     */
+    template<class Cmp>
+    static const Cmp& compare(const A& a) noexcept {
+        return a.*(&AdaptorAccess::comp);
+    }
+};
+
+/**
+ * \brief Write elements as array.
+ *
+ * \tparam It Iterator type.
+ * \param os    Output stream.
+ * \param first First element.
+ * \param last  End of elements.
+ * \return Output stream.
+ */
+template<class It>
+std::ostream& write_elements(std::ostream& os, It first, It last) noexcept {
+    begin_array(os);
+    for (It it = first; it != last; ++it) {
+        if (it != first) {
+            os << separator;
+        }
+        os << format_value(*it);
+    }
+    return end_array(os);
+}
+
+/**
+ * \brief Format std::stack. Top first.
+ *
+ * \tparam U Value type.
+ * \tparam C Container type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class C>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::stack<U, C>>& f) noexcept {
+    C& c = AdaptorAccess<std::stack<U, C>>::container(f.get_value());
+    return write_elements(os, c.rbegin(), c.rend());
+}
+
+/**
+ * \brief Format std::queue. Front first.
+ *
+ * \tparam U Value type.
+ * \tparam C Container type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class C>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::queue<U, C>>& f) noexcept {
+    C& c = AdaptorAccess<std::queue<U, C>>::container(f.get_value());
+    return write_elements(os, c.begin(), c.end());
+}
+
+/**
+ * \brief Write the elements with the highest priority in sorted order,
+ * followed by "..." in text if there are more.
+ *
+ * Keeps pointers to the \p n highest elements in a min-heap while scanning,
+ * which takes O(size * log(n)) time.
+ *
+ * \tparam C   Container type.
+ * \tparam Cmp Comparator type.
+ * \param os   Output stream.
+ * \param c    Elements.
+ * \param comp Comparator. comp(a, b) is \c true if a has lower priority.
+ * \param n    Number of elements to write.
+ * \return Output stream.
+ */
+template<class C, class Cmp>
+std::ostream& write_sorted(
+    std::ostream& os, C& c, const Cmp& comp, size_t n) noexcept {
+    typedef typename C::value_type* Pointer;
+    // Lowest priority first in heap, highest priority first when sorted
+    auto higher = [&comp](Pointer a, Pointer b) { return comp(*b, *a); };
+    std::vector<Pointer> top;
+    top.reserve(std::min(n, c.size()));
+    for (auto& v : c) {
+        if (top.size() < n) {
+            top.push_back(&v);
+            std::push_heap(top.begin(), top.end(), higher);
+        } else if (comp(*top.front(), v)) {
+            std::pop_heap(top.begin(), top.end(), higher);
+            top.back() = &v;
+            std::push_heap(top.begin(), top.end(), higher);
+        }
+    }
+    std::sort_heap(top.begin(), top.end(), higher);
+
+    begin_array(os);
+    for (size_t i = 0; i < top.size(); ++i) {
+        if (i != 0) {
+            os << separator;
+        }
+        os << format_value(*top[i]);
+    }
+    if (top.size() < c.size() && is_text(os)) {
+        os << (top.empty() ? "..." : ", ...");
+    }
+    return end_array(os);
+}
+
+/**
+ * \brief Format std::priority_queue. In heap order with the top first, or
+ * sorted as set by set_priority_queue_sorted().
+ *
+ * \tparam U   Value type.
+ * \tparam C   Container type.
+ * \tparam Cmp Comparator type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class C, class Cmp>
+std::ostream& operator<<(std::ostream&                 os,
+    const ValueFormatter<std::priority_queue<U, C, Cmp>>& f) noexcept {
+    typedef AdaptorAccess<std::priority_queue<U, C, Cmp>> Access;
+    C&           c = Access::container(f.get_value());
+    const size_t n = heapSorted.load(std::memory_order_relaxed);
+    if (n == 0) {
+        return write_elements(os, c.begin(), c.end());
+    }
+    return write_sorted(
+        os, c, Access::template compare<Cmp>(f.get_value()), n);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_ADAPTOR_H_
@@ -0,0 +1,162 @@
+/** \file
+ *
+ * \brief Formatters of associative containers: std::set, std::map,
+ * std::multiset, std::multimap and their unordered variants.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/associative.h"
+ *
+ * std::map<std::string, int> m{{"a", 1}};
+ * l(m);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_ASSOCIATIVE_H_
+#define INCLUDE_GOINGLOGGING_ASSOCIATIVE_H_
+
+#include "core.h"
+#include <map>
+#include <ostream>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Format std::set.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::set<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::map.
+ *
+ * \tparam U Key type.
+ * \tparam V Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::map<U, V>>& f) noexcept {
+    return f.map(os);
+}
+
+/**
+ * \brief Format std::multiset.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::multiset<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::multimap.
+ *
+ * \tparam U Key type.
+ * \tparam V Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::multimap<U, V>>& f) noexcept {
+    return f.map(os);
+}
+
+/**
+ * \brief Format std::unordered_set.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::unordered_set<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::unordered_map.
+ *
+ * \tparam U Key type.
+ * \tparam V Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(std::ostream&              os,
+    const ValueFormatter<std::unordered_map<U, V>>& f) noexcept {
+    return f.map(os);
+}
+
+/**
+ * \brief Format std::unordered_multiset.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(std::ostream&                os,
+    const ValueFormatter<std::unordered_multiset<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::unordered_multimap.
+ *
+ * \tparam U Key type.
+ * \tparam V Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(std::ostream&                   os,
+    const ValueFormatter<std::unordered_multimap<U, V>>& f) noexcept {
+    return f.map(os);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_ASSOCIATIVE_H_
@@ -0,0 +1,372 @@
+/** \file
+ *
+ * \brief Log variables with the call path that led to them, with
+ * l_backtrace().
+ *
+ * Optional, and only for systems with the Itanium C++ ABI and dladdr(), e.g.
+ * Linux and macOS. Include after goinglogging.h, and link with
+ * <tt>${CMAKE_DL_LIBS}</tt>:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/backtrace.h"
+ *
+ * l_backtrace(i);
+ * \endcode
+ *
+ * The call site only captures return addresses, with _Unwind_Backtrace(),
+ * into an array on the stack. The addresses are translated to function
+ * names when the message is written, with dladdr() and the demangler, and
+ * each translation is cached, so that a call path which is logged again
+ * costs a hash lookup per frame.
+ *
+ * Functions of the executable are only named if it is linked with
+ * <tt>-rdynamic</tt>, e.g. with the CMake target property ENABLE_EXPORTS.
+ * Otherwise they are written as module and offset, e.g. "app+0x1f3a", which
+ * <tt>addr2line -e app 0x1f3a</tt> translates. So is the function which
+ * logs if the compiler moved the logging into its cold part, e.g. with -O2,
+ * since cold parts are not exported.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_BACKTRACE_H_
+#define INCLUDE_GOINGLOGGING_BACKTRACE_H_
+
+#include "core.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <unwind.h>
+
+/**
+ * \brief Log variables, and the return addresses of the calls that led
+ * here.
+ *
+ * Use as:
+ * \code
+ * void parse(int i) {
+ *     l_backtrace(i);
+ *     l_backtrace();
+ * }
+ * \endcode
+ * Which outputs:
+ * \code
+ * i = 1, backtrace = {"parse(int)+0x2d", "load()+0x12", "main+0x3a"}
+ * backtrace = {"parse(int)+0x4b", "load()+0x12", "main+0x3a"}
+ * \endcode
+ *
+ * \note Supports up to 16 variables as parameters, or none.
+ * \note Uses prefix information set with \ref set_prefixes().
+ * \note Writes at most 32 frames, from the innermost.
+ * \note Captured while the call site writes its message, so only when it
+ * is enabled or traced. Frames of the library are skipped.
+ *
+ * \sa l()
+ *
+ */
+#define l_backtrace(...)                                                   \
+    do {                                                                   \
+        char gl_internal_frame = 0;                                        \
+        GL_INTERNAL_EMIT(gl::internal::log_start                           \
+                         << gl_internal_log_site.prefix()                  \
+                         << GL_INTERNAL_L_DISPATCH(__VA_ARGS__,            \
+                                GL_INTERNAL_L16, GL_INTERNAL_L15,          \
+                                GL_INTERNAL_L14, GL_INTERNAL_L13,          \
+                                GL_INTERNAL_L12, GL_INTERNAL_L11,          \
+                                GL_INTERNAL_L10, GL_INTERNAL_L9,           \
+                                GL_INTERNAL_L8, GL_INTERNAL_L7,            \
+                                GL_INTERNAL_L6, GL_INTERNAL_L5,            \
+                                GL_INTERNAL_L4, GL_INTERNAL_L3,            \
+                                GL_INTERNAL_L2, GL_INTERNAL_BACKTRACE_L1,  \
+                                )(__VA_ARGS__)                             \
+                         << ::gl::internal::Backtrace(                     \
+                                &gl_internal_frame, sizeof(#__VA_ARGS__) > 1) \
+                         << ::gl::internal::MessageEnd() << (GL_NEWLINE)); \
+    } while (false)
+
+#ifndef DOXYGEN_HIDDEN
+/**
+ * \brief First variable of l_backtrace(), or nothing if it has none.
+ */
+#define GL_INTERNAL_BACKTRACE_L1(v1) \
+    ::gl::internal::OptionalVariable{(#v1)}(v1)
+#endif // DOXYGEN_HIDDEN
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Names of return addresses, translated once each.
+ */
+class SymbolCache {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    SymbolCache() : m_mutex(), m_names() {}
+
+    SymbolCache(const SymbolCache&) = delete;
+    SymbolCache& operator=(const SymbolCache&) = delete;
+
+    /**
+     * \brief Get name of return address, translating it if not cached.
+     *
+     * \param addr Return address.
+     * \return Function and offset, module and offset, or address. Valid
+     * for the life of the cache, since names are never removed.
+     */
+    const std::string& name(uintptr_t addr) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto                        it = m_names.find(addr);
+            if (it != m_names.end()) {
+                return it->second;
+            }
+        }
+        std::string n = translate(addr);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_names.emplace(addr, std::move(n)).first->second;
+    }
+
+  private:
+    /**
+     * \brief Translate return address with dladdr() and the demangler.
+     *
+     * \param addr Return address.
+     * \return Function and offset, module and offset, or address.
+     */
+    static std::string translate(uintptr_t addr) {
+        char    off[24];
+        Dl_info info;
+        // The call may be the last instruction of the function, so look up
+        // the address before the return address
+        if (dladdr(reinterpret_cast<void*>(addr - 1), &info) == 0) {
+            std::snprintf(off, sizeof(off), "0x%llx",
+                static_cast<unsigned long long>(addr));
+            return off;
+        }
+        if (info.dli_sname != nullptr) {
+            std::snprintf(off, sizeof(off), "+0x%llx",
+                static_cast<unsigned long long>(
+                    addr - reinterpret_cast<uintptr_t>(info.dli_saddr)));
+            int   status    = 0;
+            char* demangled = abi::__cxa_demangle(
+                info.dli_sname, nullptr, nullptr, &status);
+            std::string n(status == 0 ? demangled : info.dli_sname);
+            std::free(demangled);
+            return n + off;
+        }
+        std::snprintf(off, sizeof(off), "+0x%llx",
+            static_cast<unsigned long long>(
+                addr - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+        return std::string(file_name(info.dli_fname)) + off;
+    }
+
+    std::mutex                                 m_mutex; /**< Guards names. */
+    std::unordered_map<uintptr_t, std::string> m_names; /**< Names. */
+};
+
+/**
+ * \return Names of return addresses.
+ */
+inline SymbolCache& symbol_cache() {
+    static SymbolCache cache;
+    return cache;
+}
+
+/**
+ * \brief Return addresses of the calls that led to a call site.
+ */
+class Backtrace {
+  public:
+    /** Maximum number of frames. */
+    static const size_t kMaxFrames = 32;
+
+    /**
+     * \brief Constructor. Capture return addresses of the caller and its
+     * callers. Not inlined, so that its own frame is skipped.
+     *
+     * \param frame           Address in the frame of the function which logs,
+     *                        to also skip the frames which it called, or
+     *                        \c nullptr.
+     * \param after_variables \c true to write a separator first.
+     */
+    GL_INTERNAL_NOINLINE explicit Backtrace(
+        const void* frame = nullptr, bool after_variables = false) noexcept :
+        m_addrs(),
+        m_len(0), m_after_variables(after_variables) {
+        Capture c = {this, true, reinterpret_cast<uintptr_t>(frame), 0};
+        _Unwind_Backtrace(&Backtrace::add, &c);
+    }
+
+    /**
+     * \return Return addresses [\p size()], from the innermost.
+     */
+    const uintptr_t* addresses() const noexcept {
+        return m_addrs;
+    }
+
+    /**
+     * \return Number of return addresses.
+     */
+    size_t size() const noexcept {
+        return m_len;
+    }
+
+    /**
+     * \return \c true if written after variables.
+     */
+    bool after_variables() const noexcept {
+        return m_after_variables;
+    }
+
+  private:
+    /**
+     * \brief State of capture.
+     */
+    struct Capture {
+        Backtrace* bt;      /**< Backtrace to add to. */
+        bool       skip;    /**< \c true until the constructor is skipped. */
+        uintptr_t  frame;   /**< Address in the frame which logs, or 0. */
+        uintptr_t  pending; /**< Address of the last skipped frame. */
+    };
+
+    /**
+     * \brief Add return address of frame.
+     *
+     * \param ctx Unwind context.
+     * \param arg Capture.
+     * \return _URC_NO_REASON to continue, or _URC_END_OF_STACK if full.
+     */
+    static _Unwind_Reason_Code add(_Unwind_Context* ctx, void* arg) noexcept {
+        Capture*        c  = static_cast<Capture*>(arg);
+        const uintptr_t ip = _Unwind_GetIP(ctx);
+        if (c->skip) {
+            c->skip = false;
+            return _URC_NO_REASON;
+        }
+        // The canonical frame address of a context is the stack pointer of
+        // its frame, which is below the frame which logs for the frames it
+        // called and for itself. The first context above it is the caller,
+        // so the frame which logs is the last one skipped.
+        if (c->frame != 0) {
+            if (_Unwind_GetCFA(ctx) <= c->frame) {
+                c->pending = ip;
+                return _URC_NO_REASON;
+            }
+            c->frame = 0;
+            if (c->pending != 0 && append(c->bt, c->pending)) {
+                return _URC_END_OF_STACK;
+            }
+        }
+        if (ip == 0) {
+            return _URC_END_OF_STACK;
+        }
+        return append(c->bt, ip) ? _URC_END_OF_STACK : _URC_NO_REASON;
+    }
+
+    /**
+     * \brief Append return address.
+     *
+     * \param bt   Backtrace.
+     * \param addr Return address.
+     * \return \c true if full.
+     */
+    static bool append(Backtrace* bt, uintptr_t addr) noexcept {
+        bt->m_addrs[bt->m_len++] = addr;
+        return bt->m_len == kMaxFrames;
+    }
+
+    uintptr_t m_addrs[kMaxFrames]; /**< Return addresses. */
+    size_t    m_len;               /**< Number of return addresses. */
+    bool      m_after_variables;   /**< \c true if after variables. */
+};
+
+/**
+ * \brief No variable, written as nothing.
+ */
+struct NoVariable {};
+
+/**
+ * \brief Write nothing.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& operator<<(std::ostream& os, NoVariable) noexcept {
+    return os;
+}
+
+/**
+ * \brief Maker of the variable of an argument which may be empty.
+ */
+struct OptionalVariable {
+    const char* name; /**< Name of variable. */
+
+    /**
+     * \brief Create variable.
+     *
+     * \tparam T Value type.
+     * \param val Value.
+     * \return Variable.
+     */
+    template<class T>
+    Variable<T> operator()(T& val) const noexcept {
+        return make_variable(name, val);
+    }
+
+    /**
+     * \return No variable, for an empty argument.
+     */
+    NoVariable operator()() const noexcept {
+        return NoVariable();
+    }
+};
+
+/**
+ * \brief Write backtrace, translating its return addresses. Preceded by a
+ * separator if it follows variables. Nothing while capturing.
+ *
+ * \param os Output stream.
+ * \param bt Backtrace.
+ * \return Output stream.
+ */
+inline std::ostream& operator<<(
+    std::ostream& os, const Backtrace& bt) noexcept {
+    if (is_capture(os)) {
+        return os;
+    }
+    if (bt.after_variables()) {
+        os << separator;
+    }
+    if (is_text(os)) {
+        os << "backtrace = ";
+    } else {
+        encode_key(os, "backtrace");
+    }
+    begin_array(os);
+    for (size_t i = 0; i < bt.size(); ++i) {
+        if (i != 0) {
+            os << separator;
+        }
+        const std::string& n = symbol_cache().name(bt.addresses()[i]);
+        encode_string(os, n.data(), n.size());
+    }
+    return end_array(os);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_BACKTRACE_H_
@@ -0,0 +1,612 @@
+/** \file
+ *
+ * \brief Sink which writes messages to a file descriptor in batches, with
+ * one system call per batch.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/batch_sink.h"
+ *
+ * gl::start_batch_sink(fd);
+ * \endcode
+ *
+ * Logging threads only append their messages to blocks in memory. A
+ * background thread submits all filled blocks with one writev() when a batch
+ * of messages is complete, or when the oldest message has waited for the
+ * latency bound. On Linux the blocks are submitted with io_uring instead,
+ * without any library, when the kernel supports it. Otherwise, e.g. when
+ * io_uring is disabled by a seccomp filter, writev() is used.
+ *
+ * io_uring does not reduce the number of system calls below writev(): each
+ * batch is submitted and waited for with one io_uring_enter(), since the
+ * blocks are reused as soon as the batch is written, and writes at the
+ * current file position must not overlap. The saving is the batching.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_BATCH_SINK_H_
+#define INCLUDE_GOINGLOGGING_BATCH_SINK_H_
+
+#include "core.h"
+#include "sink.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef DOXYGEN_HIDDEN
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define GL_INTERNAL_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+#endif // DOXYGEN_HIDDEN
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Bytes per block of messages. Longer messages get a block of their own. */
+static const size_t kBatchBlockSize = 64 * 1024;
+/** Bytes of messages not written yet, before logging threads wait. */
+static const size_t kBatchMaxPending = 64 * kBatchBlockSize;
+
+#ifdef GL_INTERNAL_IO_URING
+/**
+ * \brief Minimal io_uring, with one write in flight at a time. Makes one
+ * system call per write, as writev() does.
+ */
+class IoUring {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    IoUring() noexcept :
+        m_fd(-1), m_sq(MAP_FAILED), m_sq_size(0), m_cq(MAP_FAILED),
+        m_cq_size(0), m_sqes(MAP_FAILED), m_sqes_size(0), m_off() {
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * \brief Destructor.
+     */
+    ~IoUring() {
+        close();
+    }
+
+    /**
+     * \brief Set up ring.
+     *
+     * \return \c false if io_uring is not available, or cannot write at the
+     *         current file position.
+     */
+    bool open() noexcept {
+        close();
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, 4, &p));
+        if (m_fd < 0 || (p.features & IORING_FEAT_RW_CUR_POS) == 0) {
+            close();
+            return false;
+        }
+        m_sq_size   = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cq_size   = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        m_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        m_sq        = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_cq        = ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        m_sqes      = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (m_sq == MAP_FAILED || m_cq == MAP_FAILED || m_sqes == MAP_FAILED) {
+            close();
+            return false;
+        }
+        m_off = p;
+        return true;
+    }
+
+    /**
+     * \brief Release ring.
+     */
+    void close() noexcept {
+        if (m_sq != MAP_FAILED) {
+            ::munmap(m_sq, m_sq_size);
+            m_sq = MAP_FAILED;
+        }
+        if (m_cq != MAP_FAILED) {
+            ::munmap(m_cq, m_cq_size);
+            m_cq = MAP_FAILED;
+        }
+        if (m_sqes != MAP_FAILED) {
+            ::munmap(m_sqes, m_sqes_size);
+            m_sqes = MAP_FAILED;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    /**
+     * \return \c true if set up.
+     */
+    bool is_open() const noexcept {
+        return m_fd >= 0;
+    }
+
+    /**
+     * \brief Write at current file position, as writev(), and wait for the
+     * result. Submits and waits with one system call.
+     *
+     * \param fd  File descriptor.
+     * \param iov Buffers [\p n].
+     * \param n   Number of buffers.
+     * \return Number of bytes written, or -errno.
+     */
+    long writev(int fd, const iovec* iov, int n) noexcept {
+        // Submission
+        unsigned      tail = load(m_sq, m_off.sq_off.tail);
+        unsigned      mask = load(m_sq, m_off.sq_off.ring_mask);
+        unsigned      i    = tail & mask;
+        io_uring_sqe& sqe  = static_cast<io_uring_sqe*>(m_sqes)[i];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITEV;
+        sqe.fd     = fd;
+        sqe.off    = ~uint64_t(0);
+        sqe.addr   = reinterpret_cast<uintptr_t>(iov);
+        sqe.len    = static_cast<unsigned>(n);
+        at<unsigned>(m_sq, m_off.sq_off.array)[i] = i;
+        store(m_sq, m_off.sq_off.tail, tail + 1);
+
+        // Submit and wait
+        while (true) {
+            long r = syscall(__NR_io_uring_enter, m_fd, 1, 1,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r >= 0) {
+                break;
+            }
+            if (errno != EINTR) {
+                return -errno;
+            }
+        }
+
+        // Completion
+        unsigned head = load(m_cq, m_off.cq_off.head);
+        if (head == load(m_cq, m_off.cq_off.tail)) {
+            return -EIO;
+        }
+        unsigned      cmask = load(m_cq, m_off.cq_off.ring_mask);
+        io_uring_cqe* cqes  = at<io_uring_cqe>(m_cq, m_off.cq_off.cqes);
+        long          res   = cqes[head & cmask].res;
+        store(m_cq, m_off.cq_off.head, head + 1);
+        return res;
+    }
+
+  private:
+    /**
+     * \brief Get field of ring.
+     *
+     * \tparam T Field type.
+     * \param ring   Mapped ring.
+     * \param offset Offset of field.
+     * \return Field.
+     */
+    template<class T>
+    static T* at(void* ring, unsigned offset) noexcept {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    /**
+     * \brief Read index shared with the kernel.
+     *
+     * \param ring   Mapped ring.
+     * \param offset Offset of index.
+     * \return Index.
+     */
+    static unsigned load(void* ring, unsigned offset) noexcept {
+        return __atomic_load_n(at<unsigned>(ring, offset), __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * \brief Write index shared with the kernel.
+     *
+     * \param ring   Mapped ring.
+     * \param offset Offset of index.
+     * \param v      Index.
+     */
+    static void store(void* ring, unsigned offset, unsigned v) noexcept {
+        __atomic_store_n(at<unsigned>(ring, offset), v, __ATOMIC_RELEASE);
+    }
+
+    int             m_fd;        /**< File descriptor of ring. */
+    void*           m_sq;        /**< Submission ring. */
+    size_t          m_sq_size;   /**< Bytes of submission ring. */
+    void*           m_cq;        /**< Completion ring. */
+    size_t          m_cq_size;   /**< Bytes of completion ring. */
+    void*           m_sqes;      /**< Submission entries. */
+    size_t          m_sqes_size; /**< Bytes of submission entries. */
+    io_uring_params m_off;       /**< Offsets of fields in rings. */
+};
+#endif // GL_INTERNAL_IO_URING
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stream buffer which writes lines to a file descriptor in batches
+ * from a background thread.
+ *
+ * Lines are never split or interleaved, also when written by several
+ * threads. Use start_batch_sink() to redirect std::cout to it.
+ *
+ * \sa start_batch_sink()
+ */
+class BatchStreambuf : public internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    BatchStreambuf() :
+        m_fd(-1), m_batch(0), m_latency(0), m_mutex(), m_ready(),
+        m_space(), m_pending(), m_free(), m_lines(0), m_bytes(0),
+        m_stop(false), m_thread(), m_messages(0), m_calls(0)
+#ifdef GL_INTERNAL_IO_URING
+        ,
+        m_ring()
+#endif
+    {
+    }
+
+    BatchStreambuf(const BatchStreambuf&) = delete;
+    BatchStreambuf& operator=(const BatchStreambuf&) = delete;
+
+    /**
+     * \brief Destructor. Write remaining lines.
+     */
+    ~BatchStreambuf() override {
+        close();
+    }
+
+    /**
+     * \brief Start writing to file descriptor.
+     *
+     * \param fd       File descriptor, which is not closed.
+     * \param batch    Number of messages which are written together.
+     * \param latency  Longest time before a message is written.
+     * \param io_uring \c true to write with io_uring when available.
+     * \return \c true if success.
+     */
+    bool open(int fd, size_t batch = 256,
+        std::chrono::microseconds latency = std::chrono::milliseconds(5),
+        bool io_uring = true) {
+        close();
+        if (fd < 0 || batch == 0) {
+            return false;
+        }
+        m_fd      = fd;
+        m_batch   = batch;
+        m_latency = latency;
+        m_stop    = false;
+#ifdef GL_INTERNAL_IO_URING
+        if (io_uring) {
+            m_ring.open();
+        }
+#else
+        static_cast<void>(io_uring);
+#endif
+        m_thread = std::thread(&BatchStreambuf::run, this);
+        return true;
+    }
+
+    /**
+     * \brief Write remaining lines and stop. No thread may write to the
+     * stream buffer meanwhile.
+     */
+    void close() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_one();
+        m_thread.join();
+#ifdef GL_INTERNAL_IO_URING
+        m_ring.close();
+#endif
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fd = -1;
+    }
+
+    /**
+     * \return \c true if open.
+     */
+    bool is_open() const noexcept {
+        return m_thread.joinable();
+    }
+
+    /**
+     * \return \c true if writing with io_uring.
+     */
+    bool uses_io_uring() const noexcept {
+#ifdef GL_INTERNAL_IO_URING
+        return m_ring.is_open();
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * \return Number of messages written since created.
+     */
+    uint64_t messages() const noexcept {
+        return m_messages.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \return Number of system calls which wrote messages since created.
+     */
+    uint64_t system_calls() const noexcept {
+        return m_calls.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    /**
+     * \brief Append line and newline.
+     *
+     * \param s Line [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) override {
+        append(s, n, true);
+    }
+
+    /**
+     * \brief Append CBOR message.
+     *
+     * \param s Message [\p n].
+     * \param n Number of bytes.
+     */
+    void write_message(const char* s, size_t n) override {
+        append(s, n, false);
+    }
+
+  private:
+    /**
+     * \brief Append message to the last block. Wake the background thread
+     * when a batch is complete.
+     *
+     * \param s       Message [\p n].
+     * \param n       Number of characters.
+     * \param newline \c true to append a newline.
+     */
+    void append(const char* s, size_t n, bool newline) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return;
+        }
+        m_space.wait(lock, [this]() {
+            return m_bytes < internal::kBatchMaxPending || m_stop;
+        });
+        const size_t size = n + (newline ? 1 : 0);
+        if (m_pending.empty() ||
+            m_pending.back().size() + size > internal::kBatchBlockSize) {
+            m_pending.emplace_back();
+            if (!m_free.empty()) {
+                m_pending.back().swap(m_free.back());
+                m_free.pop_back();
+            }
+            m_pending.back().reserve(internal::kBatchBlockSize);
+        }
+        m_pending.back().append(s, n);
+        if (newline) {
+            m_pending.back().push_back('\n');
+        }
+        m_bytes += size;
+        // Only the first notification of a batch may need a system call
+        if (++m_lines == m_batch) {
+            m_ready.notify_one();
+        }
+    }
+
+    /**
+     * \brief Write batches until stopped.
+     */
+    void run() {
+        std::vector<std::string> writing;
+        std::vector<iovec>       iov;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_ready.wait_for(lock, m_latency,
+                [this]() { return m_lines >= m_batch || m_stop; });
+            if (m_lines == 0) {
+                if (m_stop) {
+                    break;
+                }
+                continue;
+            }
+            writing.swap(m_pending);
+            uint64_t lines = m_lines;
+            m_lines        = 0;
+            m_bytes        = 0;
+            lock.unlock();
+            m_space.notify_all();
+
+            iov.clear();
+            for (std::string& b : writing) {
+                iov.push_back({&b[0], b.size()});
+            }
+            submit(iov);
+            m_messages.fetch_add(lines, std::memory_order_relaxed);
+
+            lock.lock();
+            for (std::string& b : writing) {
+                b.clear();
+                m_free.push_back(std::move(b));
+            }
+            writing.clear();
+        }
+    }
+
+    /**
+     * \brief Write all buffers, with one system call unless interrupted or
+     * only partly written.
+     *
+     * \param iov Buffers. Modified.
+     */
+    void submit(std::vector<iovec>& iov) {
+        size_t first = 0;
+        while (first < iov.size()) {
+            int  n = static_cast<int>(std::min<size_t>(
+                iov.size() - first, static_cast<size_t>(IOV_MAX)));
+            long w = 0;
+#ifdef GL_INTERNAL_IO_URING
+            if (m_ring.is_open()) {
+                w = m_ring.writev(m_fd, &iov[first], n);
+                if (w == -EINVAL || w == -EOPNOTSUPP) {
+                    // E.g. an old kernel without IORING_OP_WRITEV
+                    m_ring.close();
+                    continue;
+                }
+                if (w < 0) {
+                    errno = static_cast<int>(-w);
+                    w     = -1;
+                }
+            } else
+#endif
+            {
+                w = static_cast<long>(::writev(m_fd, &iov[first], n));
+            }
+            m_calls.fetch_add(1, std::memory_order_relaxed);
+            if (w < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                return;
+            }
+            // Skip what was written
+            size_t done = static_cast<size_t>(w);
+            while (first < iov.size() && done >= iov[first].iov_len) {
+                done -= iov[first].iov_len;
+                ++first;
+            }
+            if (first < iov.size()) {
+                iov[first].iov_base =
+                    static_cast<char*>(iov[first].iov_base) + done;
+                iov[first].iov_len -= done;
+            }
+        }
+    }
+
+    int                       m_fd;      /**< File descriptor. */
+    size_t                    m_batch;   /**< Messages per batch. */
+    std::chrono::microseconds m_latency; /**< Longest wait of message. */
+    std::mutex                m_mutex;   /**< Guards all below but atomics. */
+    std::condition_variable   m_ready;   /**< Signals complete batch. */
+    std::condition_variable   m_space;   /**< Signals written batch. */
+    std::vector<std::string>  m_pending; /**< Blocks not written yet. */
+    std::vector<std::string>  m_free;    /**< Written blocks, for reuse. */
+    size_t                    m_lines;   /**< Messages in m_pending. */
+    size_t                    m_bytes;   /**< Bytes in m_pending. */
+    bool                      m_stop;    /**< \c true when closing. */
+    std::thread               m_thread;  /**< Background thread. */
+    std::atomic<uint64_t>     m_messages; /**< Messages written. */
+    std::atomic<uint64_t>     m_calls;    /**< System calls which wrote. */
+#ifdef GL_INTERNAL_IO_URING
+    internal::IoUring m_ring; /**< io_uring, if available. */
+#endif
+};
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Batch sink which std::cout is redirected to by start_batch_sink().
+ */
+typedef CoutRedirect<BatchStreambuf> BatchSink;
+
+/**
+ * \return Sink of start_batch_sink().
+ */
+inline BatchSink& batch_sink() {
+    static BatchSink sink;
+    return sink;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stop writing std::cout in batches, write remaining messages and
+ * restore its previous stream buffer.
+ *
+ * \sa start_batch_sink()
+ *
+ */
+inline void stop_batch_sink() {
+    internal::BatchSink& sink = internal::batch_sink();
+    if (sink.buf.is_open()) {
+        std::cout.flush();
+        sink.restore();
+        sink.buf.close();
+    }
+}
+
+/**
+ * \brief Write std::cout, and thereby all logging, to a file descriptor in
+ * batches, with one system call per batch.
+ *
+ * Used as:
+ * \code
+ * int fd = open("log.txt", O_WRONLY | O_CREAT | O_APPEND, 0644);
+ * gl::start_batch_sink(fd);
+ * \endcode
+ *
+ * \param fd       File descriptor, which is not closed.
+ * \param batch    Number of messages which are written together.
+ * \param latency  Longest time before a message is written.
+ * \param io_uring \c true to write with io_uring when available, and
+ *                 otherwise with writev().
+ * \return \c true if started.
+ *
+ * \note Must not be called while other threads log.
+ *
+ * \sa stop_batch_sink() \sa BatchStreambuf
+ *
+ */
+inline bool start_batch_sink(int fd, size_t batch = 256,
+    std::chrono::microseconds latency = std::chrono::milliseconds(5),
+    bool io_uring = true) {
+    stop_batch_sink();
+    internal::BatchSink& sink = internal::batch_sink();
+    if (!sink.buf.open(fd, batch, latency, io_uring)) {
+        return false;
+    }
+    sink.redirect();
+    return true;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_BATCH_SINK_H_
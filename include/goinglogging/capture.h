@@ -0,0 +1,1054 @@
+/** \file
+ *
+ * \brief Columnar capture of numbers logged by l(), and reader of the files
+ * written by gl::write_capture().
+ *
+ * Optional. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/capture.h"
+ *
+ * gl::set_capture_enabled(true);
+ * l(i, d);
+ * gl::write_capture("capture.bin");
+ *
+ * std::ifstream is("capture.bin", std::ios::binary);
+ * gl::export_capture_csv(is, std::cout);
+ * \endcode
+ *
+ * File format, with little endian integers and strings prefixed by their
+ * 32 bit length:
+ * - "GLCAPT01"
+ * - For each call site: file path, 64 bit line number, function name,
+ *   64 bit number of rows and 32 bit number of columns. The first column is
+ *   the time in nanoseconds since epoch.
+ * - For each column: name, 8 bit kind (signed, unsigned or floating point),
+ *   64 bit number of bits, and the bits in 64 bit words, compressed as
+ *   described in gl::internal::CaptureColumn.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_CAPTURE_H_
+#define INCLUDE_GOINGLOGGING_CAPTURE_H_
+
+#include "core.h"
+#include "sites.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Start of capture files. */
+static const char kCaptureMagic[] = "GLCAPT01";
+
+
+/**
+ * \brief Count leading zero bits.
+ *
+ * \param v Value, not 0.
+ * \return Number of leading zero bits.
+ */
+inline unsigned count_leading_zeros(uint64_t v) noexcept {
+#ifdef __GNUC__
+    return static_cast<unsigned>(__builtin_clzll(v));
+#else
+    unsigned n = 0;
+    for (; (v >> 63) == 0; v <<= 1) {
+        ++n;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * \brief Count trailing zero bits.
+ *
+ * \param v Value, not 0.
+ * \return Number of trailing zero bits.
+ */
+inline unsigned count_trailing_zeros(uint64_t v) noexcept {
+#ifdef __GNUC__
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#else
+    unsigned n = 0;
+    for (; (v & 1) == 0; v >>= 1) {
+        ++n;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * \brief Stream of bits, written from the most significant bit of each word.
+ */
+class BitWriter {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    BitWriter() : m_words(), m_bits(0) {
+    }
+
+    /**
+     * \brief Write bits.
+     *
+     * \param v Value, of which the lowest \p n bits are written.
+     * \param n Number of bits [1, 64].
+     */
+    void write(uint64_t v, unsigned n) {
+        if (n < 64) {
+            v &= (uint64_t(1) << n) - 1;
+        }
+        unsigned used = static_cast<unsigned>(m_bits % 64);
+        if (used == 0) {
+            m_words.push_back(0);
+        }
+        unsigned left = 64 - used;
+        if (n <= left) {
+            m_words.back() |= v << (left - n);
+        } else {
+            m_words.back() |= v >> (n - left);
+            m_words.push_back(v << (64 - (n - left)));
+        }
+        m_bits += n;
+    }
+
+    /**
+     * \return Words.
+     */
+    const std::vector<uint64_t>& get_words() const noexcept {
+        return m_words;
+    }
+
+    /**
+     * \return Number of bits.
+     */
+    uint64_t get_bits() const noexcept {
+        return m_bits;
+    }
+
+  private:
+    std::vector<uint64_t> m_words; /**< Bits. */
+    uint64_t              m_bits;  /**< Number of bits. */
+};
+
+/**
+ * \brief Column of captured values, compressed as in Facebook's Gorilla.
+ *
+ * Integers are written as the difference between consecutive differences,
+ * which is 0 for regular timestamps and counters, in buckets of 1, 10, 19,
+ * 36 and 68 bits. Floating point numbers are written as the XOR with the
+ * previous value, storing only the bits between the leading and trailing
+ * zeros, and reusing the previous window of bits if the XOR fits in it.
+ *
+ * \sa read_capture()
+ */
+class CaptureColumn {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name Name.
+     * \param kind Kind of values.
+     */
+    CaptureColumn(const char* name, capture_kind kind) :
+        m_name(name), m_kind(kind), m_out(), m_count(0), m_prev(0),
+        m_delta(0), m_lead(0), m_sig(0) {
+    }
+
+    CaptureColumn(const CaptureColumn&) = default;
+    CaptureColumn& operator=(const CaptureColumn&) = delete;
+
+    /**
+     * \brief Append value.
+     *
+     * \param bits Value. Two's complement for signed integers, and bits of
+     * double for floating point numbers.
+     */
+    void append(uint64_t bits) {
+        if (m_count++ == 0) {
+            m_out.write(bits, 64);
+        } else if (m_kind == capture_kind::FLOAT) {
+            append_xor(bits ^ m_prev);
+        } else {
+            append_delta(bits - m_prev);
+        }
+        m_prev = bits;
+    }
+
+    /**
+     * \return Name.
+     */
+    const char* get_name() const noexcept {
+        return m_name;
+    }
+
+    /**
+     * \return Kind of values.
+     */
+    capture_kind get_kind() const noexcept {
+        return m_kind;
+    }
+
+    /**
+     * \return Compressed values.
+     */
+    const BitWriter& get_bits() const noexcept {
+        return m_out;
+    }
+
+  private:
+    /**
+     * \brief Append difference from previous difference.
+     *
+     * \param delta Difference from previous value.
+     */
+    void append_delta(uint64_t delta) {
+        uint64_t dod = delta - m_delta;
+        m_delta      = delta;
+        // Zigzag, so that small negative values have few bits
+        uint64_t z = (dod << 1) ^ (0 - (dod >> 63));
+        if (z == 0) {
+            m_out.write(0, 1);
+        } else if (z < (uint64_t(1) << 8)) {
+            m_out.write(0x2, 2);
+            m_out.write(z, 8);
+        } else if (z < (uint64_t(1) << 16)) {
+            m_out.write(0x6, 3);
+            m_out.write(z, 16);
+        } else if (z < (uint64_t(1) << 32)) {
+            m_out.write(0xe, 4);
+            m_out.write(z, 32);
+        } else {
+            m_out.write(0xf, 4);
+            m_out.write(z, 64);
+        }
+    }
+
+    /**
+     * \brief Append XOR with previous value.
+     *
+     * \param x XOR with previous value.
+     */
+    void append_xor(uint64_t x) {
+        if (x == 0) {
+            m_out.write(0, 1);
+            return;
+        }
+        unsigned lead  = std::min(count_leading_zeros(x), 31u);
+        unsigned trail = count_trailing_zeros(x);
+        if (m_sig != 0 && lead >= m_lead && trail >= 64 - m_lead - m_sig) {
+            // Within previous window
+            m_out.write(0x2, 2);
+            m_out.write(x >> (64 - m_lead - m_sig), m_sig);
+        } else {
+            m_lead = lead;
+            m_sig  = 64 - lead - trail;
+            m_out.write(0x3, 2);
+            m_out.write(m_lead, 5);
+            m_out.write(m_sig - 1, 6);
+            m_out.write(x >> trail, m_sig);
+        }
+    }
+
+    const char*        m_name;  /**< Name. */
+    const capture_kind m_kind;  /**< Kind of values. */
+    BitWriter          m_out;   /**< Compressed values. */
+    uint64_t           m_count; /**< Number of values. */
+    uint64_t           m_prev;  /**< Previous value. */
+    uint64_t           m_delta; /**< Previous difference. */
+    unsigned           m_lead;  /**< Leading zeros of XOR window. */
+    unsigned           m_sig;   /**< Bits in XOR window, 0 if none. */
+};
+
+/**
+ * \brief Captured values of a call site of l().
+ */
+class CaptureSite {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    CaptureSite(const char* file_path, long file_line, const char* func) :
+        m_mutex(), m_file_path(file_path), m_file_line(file_line),
+        m_func(func), m_rows(0), m_columns() {
+    }
+
+    CaptureSite(const CaptureSite&) = delete;
+    CaptureSite& operator=(const CaptureSite&) = delete;
+
+    /**
+     * \brief Append row.
+     *
+     * \param time   Time in nanoseconds since epoch.
+     * \param values Values [\p n].
+     * \param n      Number of values.
+     */
+    void append(int64_t time, const CaptureValue* values, size_t n) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_rows == 0) {
+            m_columns.clear();
+            m_columns.emplace_back("time", capture_kind::SIGNED);
+            for (size_t i = 0; i < n; ++i) {
+                m_columns.emplace_back(values[i].name, values[i].kind);
+            }
+        } else if (n + 1 != m_columns.size()) {
+            return;
+        }
+        m_columns[0].append(static_cast<uint64_t>(time));
+        for (size_t i = 0; i < n; ++i) {
+            m_columns[i + 1].append(values[i].bits);
+        }
+        ++m_rows;
+    }
+
+    /**
+     * \brief Remove all rows.
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rows = 0;
+        m_columns.clear();
+    }
+
+    /**
+     * \brief Write site and columns, if any rows.
+     *
+     * \param os Output stream.
+     */
+    void write(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_rows == 0) {
+            return;
+        }
+        write_string(os, m_file_path);
+        write_uint(os, static_cast<uint64_t>(m_file_line), 8);
+        write_string(os, m_func);
+        write_uint(os, m_rows, 8);
+        write_uint(os, m_columns.size(), 4);
+        for (const CaptureColumn& c : m_columns) {
+            write_string(os, c.get_name());
+            write_uint(os, static_cast<uint64_t>(c.get_kind()), 1);
+            write_uint(os, c.get_bits().get_bits(), 8);
+            for (uint64_t w : c.get_bits().get_words()) {
+                write_uint(os, w, 8);
+            }
+        }
+    }
+
+    /**
+     * \return File path including name.
+     */
+    const char* get_file_path() const noexcept {
+        return m_file_path;
+    }
+
+    /**
+     * \return Line number in file.
+     */
+    long get_file_line_number() const noexcept {
+        return m_file_line;
+    }
+
+    /**
+     * \brief Write little endian unsigned integer.
+     *
+     * \param os    Output stream.
+     * \param v     Value.
+     * \param bytes Number of bytes.
+     */
+    static void write_uint(std::ostream& os, uint64_t v, size_t bytes) {
+        char buf[8];
+        for (size_t i = 0; i < bytes; ++i) {
+            buf[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+        }
+        os.write(buf, static_cast<std::streamsize>(bytes));
+    }
+
+    /**
+     * \brief Write string with its length.
+     *
+     * \param os Output stream.
+     * \param s  String.
+     */
+    static void write_string(std::ostream& os, const char* s) {
+        size_t n = std::strlen(s);
+        write_uint(os, n, 4);
+        os.write(s, static_cast<std::streamsize>(n));
+    }
+
+  private:
+    std::mutex                 m_mutex;     /**< Guards rows and columns. */
+    const char*                m_file_path; /**< File path including name. */
+    const long                 m_file_line; /**< Line number in file. */
+    const char*                m_func;      /**< Function name. */
+    uint64_t                   m_rows;      /**< Number of rows. */
+    std::vector<CaptureColumn> m_columns;   /**< Time, then values. */
+};
+
+/**
+ * \brief All call sites of l() which have captured values.
+ */
+class CaptureSites {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CaptureSites() : m_mutex(), m_sites() {
+    }
+
+    /**
+     * \brief Get call site, and add it if new.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \return Call site. Never removed.
+     */
+    CaptureSite& get(const char* file_path, long file_line, const char* func) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unique_ptr<CaptureSite>& s =
+            m_sites[std::make_pair(file_path, file_line)];
+        if (!s) {
+            s.reset(new CaptureSite(file_path, file_line, func));
+        }
+        return *s;
+    }
+
+    /**
+     * \brief Write all call sites to file.
+     *
+     * \param path File path.
+     * \return \c true if written.
+     */
+    bool write(const std::string& path) {
+        std::ofstream os(path, std::ios::binary);
+        os.write(kCaptureMagic, sizeof(kCaptureMagic) - 1);
+        std::vector<CaptureSite*> sites;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& s : m_sites) {
+                sites.push_back(s.second.get());
+            }
+        }
+        // Sort by file and line, instead of address of file name
+        std::sort(sites.begin(), sites.end(),
+            [](const CaptureSite* a, const CaptureSite* b) {
+                int c = std::strcmp(a->get_file_path(), b->get_file_path());
+                return c != 0 ? c < 0 :
+                                a->get_file_line_number() <
+                                    b->get_file_line_number();
+            });
+        for (CaptureSite* s : sites) {
+            s->write(os);
+        }
+        return static_cast<bool>(os.flush());
+    }
+
+    /**
+     * \brief Remove all captured rows.
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& s : m_sites) {
+            s.second->clear();
+        }
+    }
+
+  private:
+    std::mutex m_mutex; /**< Guards sites. */
+    /** Call sites by file name and line. */
+    std::map<std::pair<const char*, long>, std::unique_ptr<CaptureSite>>
+        m_sites;
+};
+
+/**
+ * \return Capturing call sites.
+ */
+inline CaptureSites& capture_sites() {
+    static CaptureSites sites;
+    return sites;
+}
+
+/**
+ * \brief Append captured record to its call site. The sink of CaptureRecord
+ * while capture is enabled.
+ *
+ * \param file_path File path including name.
+ * \param file_line Line number in file.
+ * \param func      Function name.
+ * \param time      Nanoseconds since epoch.
+ * \param values    Values [\p n].
+ * \param n         Number of values.
+ */
+inline void append_capture(const char* file_path, long file_line,
+    const char* func, int64_t time, const CaptureValue* values, size_t n) {
+    /** Previous call site of this thread */
+    static thread_local CaptureSite* site = nullptr;
+    if (site == nullptr || site->get_file_path() != file_path ||
+        site->get_file_line_number() != file_line) {
+        site = &capture_sites().get(file_path, file_line, func);
+    }
+    site->append(time, values, n);
+}
+
+/**
+ * \brief Values of the message which is currently captured by this thread.
+ */
+class CaptureRecord {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CaptureRecord() noexcept :
+        m_file_path(nullptr), m_file_line(0), m_func(nullptr), m_time(0),
+        m_values(), m_size(0) {
+    }
+
+    CaptureRecord(const CaptureRecord&) = delete;
+    CaptureRecord& operator=(const CaptureRecord&) = delete;
+
+    /**
+     * \brief Start record and take timestamp.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    void begin(
+        const char* file_path, long file_line, const char* func) noexcept {
+        m_file_path = file_path;
+        m_file_line = file_line;
+        m_func      = func;
+        m_time      = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+        m_size = 0;
+    }
+
+    /**
+     * \brief Add number.
+     *
+     * \param v Value.
+     */
+    void add(const CaptureValue& v) noexcept {
+        if (m_size < kMaxValues) {
+            m_values[m_size++] = v;
+        }
+    }
+
+    /**
+     * \brief Append record to its call site.
+     */
+    void commit() {
+        append_capture(
+            m_file_path, m_file_line, m_func, m_time, m_values, m_size);
+    }
+
+  private:
+    /** Maximum number of values, as of l(). */
+    static const size_t kMaxValues = 16;
+
+    const char*  m_file_path;          /**< File path including name. */
+    long         m_file_line;          /**< Line number in file. */
+    const char*  m_func;               /**< Function name. */
+    int64_t      m_time;               /**< Nanoseconds since epoch. */
+    CaptureValue m_values[kMaxValues]; /**< Values. */
+    size_t       m_size;               /**< Number of values. */
+};
+
+/**
+ * \brief Stream buffer which discards everything.
+ */
+class NullStreambuf : public std::streambuf {
+  protected:
+    /**
+     * \brief Discard character.
+     *
+     * \param c Character.
+     * \return Not end of file.
+     */
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+};
+
+/**
+ * \brief Stream which l() writes to while capturing. Writes nothing.
+ */
+class CaptureStream : public std::ostream {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CaptureStream() : std::ostream(nullptr), m_buf() {
+        rdbuf(&m_buf);
+    }
+
+  private:
+    NullStreambuf m_buf; /**< Discarding buffer. */
+};
+
+/**
+ * \brief Capture sink which appends the records of each thread to the
+ * columns of their call sites.
+ */
+class ColumnCaptureSink : public CaptureSink {
+  public:
+    /**
+     * \return Capture stream of this thread.
+     */
+    std::ostream& stream() noexcept override {
+        static thread_local CaptureStream os;
+        return os;
+    }
+
+    /**
+     * \brief Start record of this thread and take timestamp.
+     */
+    void begin(const char* file_path, long file_line,
+        const char* func) noexcept override {
+        record().begin(file_path, file_line, func);
+    }
+
+    /**
+     * \brief Add number to record of this thread.
+     */
+    void add(const CaptureValue& v) noexcept override {
+        record().add(v);
+    }
+
+    /**
+     * \brief Append record of this thread to its call site.
+     */
+    void commit() override {
+        record().commit();
+    }
+
+  private:
+    /**
+     * \return Record of this thread.
+     */
+    static CaptureRecord& record() noexcept {
+        static thread_local CaptureRecord r;
+        return r;
+    }
+};
+
+/**
+ * \return Capture sink of columns. Never destroyed, so that static
+ * destructors may still log.
+ */
+inline CaptureSink& column_capture_sink() {
+    static CaptureSink* sink = new ColumnCaptureSink();
+    return *sink;
+}
+
+/**
+ * \brief Reader of bits written by BitWriter.
+ */
+class BitReader {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param words Words.
+     * \param bits  Number of bits.
+     */
+    BitReader(const std::vector<uint64_t>& words, uint64_t bits) noexcept :
+        m_words(words), m_bits(bits), m_pos(0) {
+    }
+
+    BitReader(const BitReader&) = delete;
+    BitReader& operator=(const BitReader&) = delete;
+
+    /**
+     * \brief Read bits.
+     *
+     * \param n Number of bits [1, 64].
+     * \param v Value read.
+     * \return \c false if there are not enough bits.
+     */
+    bool read(unsigned n, uint64_t& v) noexcept {
+        if (m_bits - m_pos < n) {
+            return false;
+        }
+        size_t   i    = static_cast<size_t>(m_pos / 64);
+        unsigned used = static_cast<unsigned>(m_pos % 64);
+        unsigned left = 64 - used;
+        uint64_t mask = n < 64 ? (uint64_t(1) << n) - 1 : ~uint64_t(0);
+        if (n <= left) {
+            v = (m_words[i] >> (left - n)) & mask;
+        } else {
+            v = ((m_words[i] << (n - left)) |
+                    (m_words[i + 1] >> (64 - (n - left)))) &
+                mask;
+        }
+        m_pos += n;
+        return true;
+    }
+
+  private:
+    const std::vector<uint64_t>& m_words; /**< Bits. */
+    const uint64_t               m_bits;  /**< Number of bits. */
+    uint64_t                     m_pos;   /**< Number of bits read. */
+};
+
+/**
+ * \brief Decoded column.
+ */
+struct CaptureColumnData {
+    /**
+     * \brief Constructor.
+     */
+    CaptureColumnData() : name(), kind(capture_kind::SIGNED), values() {
+    }
+
+    std::string           name;   /**< Name. */
+    capture_kind          kind;   /**< Kind of values. */
+    std::vector<uint64_t> values; /**< Values, as in CaptureColumn. */
+};
+
+/**
+ * \brief Decoded call site.
+ */
+struct CaptureSiteData {
+    /**
+     * \brief Constructor.
+     */
+    CaptureSiteData() : file_path(), file_line(0), func(), columns() {
+    }
+
+    std::string                    file_path; /**< File path. */
+    long                           file_line; /**< Line number in file. */
+    std::string                    func;      /**< Function name. */
+    std::vector<CaptureColumnData> columns;   /**< Time, then values. */
+};
+
+/**
+ * \brief Decode values of column. Inverse of CaptureColumn::append().
+ *
+ * \param words Compressed values.
+ * \param bits  Number of bits.
+ * \param rows  Number of values.
+ * \param c     Column to decode into.
+ * \return \c false if the values are truncated.
+ */
+inline bool decode_column(const std::vector<uint64_t>& words, uint64_t bits,
+    uint64_t rows, CaptureColumnData& c) {
+    BitReader in(words, bits);
+    uint64_t  prev  = 0;
+    uint64_t  delta = 0;
+    unsigned  lead  = 0;
+    unsigned  sig   = 0;
+    uint64_t  b     = 0;
+    for (uint64_t row = 0; row < rows; ++row) {
+        if (row == 0) {
+            if (!in.read(64, prev)) {
+                return false;
+            }
+        } else if (c.kind == capture_kind::FLOAT) {
+            if (!in.read(1, b)) {
+                return false;
+            }
+            if (b != 0) {
+                if (!in.read(1, b)) {
+                    return false;
+                }
+                if (b != 0) {
+                    // New window
+                    uint64_t l5 = 0;
+                    uint64_t s6 = 0;
+                    if (!in.read(5, l5) || !in.read(6, s6)) {
+                        return false;
+                    }
+                    lead = static_cast<unsigned>(l5);
+                    sig  = static_cast<unsigned>(s6) + 1;
+                    if (lead + sig > 64) {
+                        return false;
+                    }
+                } else if (sig == 0) {
+                    return false;
+                }
+                uint64_t x = 0;
+                if (!in.read(sig, x)) {
+                    return false;
+                }
+                prev ^= x << (64 - lead - sig);
+            }
+        } else {
+            // Number of bits after prefix 0, 10, 110, 1110 or 1111
+            static const unsigned widths[] = {0, 8, 16, 32, 64};
+            size_t                bucket   = 0;
+            while (bucket < 4) {
+                if (!in.read(1, b)) {
+                    return false;
+                }
+                if (b == 0) {
+                    break;
+                }
+                ++bucket;
+            }
+            uint64_t z = 0;
+            if (bucket != 0 && !in.read(widths[bucket], z)) {
+                return false;
+            }
+            delta += (z >> 1) ^ (0 - (z & 1));
+            prev += delta;
+        }
+        c.values.push_back(prev);
+    }
+    return true;
+}
+
+/**
+ * \brief Read little endian unsigned integer.
+ *
+ * \param is    Input stream.
+ * \param bytes Number of bytes.
+ * \param v     Value read.
+ * \return \c false if the stream ended.
+ */
+inline bool read_uint(std::istream& is, size_t bytes, uint64_t& v) {
+    unsigned char buf[8];
+    if (!is.read(reinterpret_cast<char*>(buf),
+            static_cast<std::streamsize>(bytes))) {
+        return false;
+    }
+    v = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        v |= static_cast<uint64_t>(buf[i]) << (8 * i);
+    }
+    return true;
+}
+
+/**
+ * \brief Read string prefixed by its length.
+ *
+ * \param is Input stream.
+ * \param s  String read.
+ * \return \c false if the stream ended.
+ */
+inline bool read_string(std::istream& is, std::string& s) {
+    uint64_t n = 0;
+    if (!read_uint(is, 4, n)) {
+        return false;
+    }
+    s.resize(static_cast<size_t>(n));
+    return n == 0 || is.read(&s[0], static_cast<std::streamsize>(n));
+}
+
+/**
+ * \brief Read and decode capture file.
+ *
+ * \param is    Input stream of file written by gl::write_capture().
+ * \param sites Call sites read.
+ * \return \c false if the file is invalid.
+ */
+inline bool read_capture(
+    std::istream& is, std::vector<CaptureSiteData>& sites) {
+    char magic[sizeof(kCaptureMagic) - 1];
+    if (!is.read(magic, sizeof(magic)) ||
+        std::string(magic, sizeof(magic)) != kCaptureMagic) {
+        return false;
+    }
+    while (is.peek() != std::char_traits<char>::eof()) {
+        CaptureSiteData s;
+        uint64_t        line    = 0;
+        uint64_t        rows    = 0;
+        uint64_t        columns = 0;
+        if (!read_string(is, s.file_path) || !read_uint(is, 8, line) ||
+            !read_string(is, s.func) || !read_uint(is, 8, rows) ||
+            !read_uint(is, 4, columns)) {
+            return false;
+        }
+        s.file_line = static_cast<long>(line);
+        for (uint64_t i = 0; i < columns; ++i) {
+            CaptureColumnData     c;
+            uint64_t              kind = 0;
+            uint64_t              bits = 0;
+            std::vector<uint64_t> words;
+            if (!read_string(is, c.name) || !read_uint(is, 1, kind) ||
+                !read_uint(is, 8, bits) ||
+                kind > static_cast<uint64_t>(capture_kind::FLOAT)) {
+                return false;
+            }
+            c.kind = static_cast<capture_kind>(kind);
+            words.resize(static_cast<size_t>((bits + 63) / 64));
+            for (uint64_t& w : words) {
+                if (!read_uint(is, 8, w)) {
+                    return false;
+                }
+            }
+            if (!decode_column(words, bits, rows, c)) {
+                return false;
+            }
+            s.columns.push_back(std::move(c));
+        }
+        sites.push_back(std::move(s));
+    }
+    return true;
+}
+
+/**
+ * \brief Write captured value as text.
+ *
+ * \param os   Output stream.
+ * \param kind Kind of value.
+ * \param v    Value, as in CaptureColumn.
+ */
+inline void write_capture_value(
+    std::ostream& os, capture_kind kind, uint64_t v) {
+    char buf[32];
+    switch (kind) {
+        case capture_kind::SIGNED: os << static_cast<int64_t>(v); break;
+        case capture_kind::UNSIGNED: os << v; break;
+        case capture_kind::FLOAT: {
+            double d = 0.0;
+            std::memcpy(&d, &v, sizeof(d));
+            // Shortest of 15 and 17 digits which reads back the same
+            std::snprintf(buf, sizeof(buf), "%.15g", d);
+            if (std::strtod(buf, nullptr) != d) {
+                std::snprintf(buf, sizeof(buf), "%.17g", d);
+            }
+            os << buf;
+            break;
+        }
+    }
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Enable or disable capture of numbers logged by \ref l().
+ *
+ * While enabled, \ref l() writes nothing. Instead, the numbers among its
+ * variables are appended to compressed columns of its call site, together
+ * with a timestamp. Other variables are skipped.
+ *
+ * \param e \c true if numbers shall be captured.
+ *
+ * \note Defaults to disabled.
+ *
+ * \sa is_capture_enabled() \sa write_capture() \sa clear_capture()
+ *
+ */
+inline void set_capture_enabled(bool e) noexcept {
+    internal::capture_sink().store(
+        &internal::column_capture_sink(), std::memory_order_release);
+    internal::captureEnabled.store(e, std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return \c true if numbers logged by \ref l() are captured.
+ *
+ * \sa set_capture_enabled()
+ *
+ */
+inline bool is_capture_enabled() noexcept {
+    return internal::captureEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Write captured columns of all call sites to file.
+ *
+ * Read the file with the gl_capture tool, or export_capture_csv().
+ *
+ * \param path File path.
+ * \return \c true if written.
+ *
+ * \sa set_capture_enabled() \sa clear_capture()
+ *
+ */
+inline bool write_capture(const std::string& path) {
+    return internal::capture_sites().write(path);
+}
+
+/**
+ * \brief Remove captured columns of all call sites.
+ *
+ * \sa set_capture_enabled() \sa write_capture()
+ *
+ */
+inline void clear_capture() {
+    internal::capture_sites().clear();
+}
+
+/**
+ * \brief Export capture file as CSV.
+ *
+ * Each call site is written as a comment with its location, a header with
+ * its column names, and one row per call, followed by an empty line. The
+ * first column is the time in nanoseconds since epoch.
+ *
+ * \param is      Input stream of file written by write_capture().
+ * \param os      Output stream.
+ * \param pattern Glob pattern of call sites to export, matched against
+ *                "file:line" and function name.
+ * \return \c false if the file is invalid.
+ *
+ * \sa write_capture()
+ *
+ */
+inline bool export_capture_csv(
+    std::istream& is, std::ostream& os, const std::string& pattern = "*") {
+    std::vector<internal::CaptureSiteData> sites;
+    if (!internal::read_capture(is, sites)) {
+        return false;
+    }
+    for (const internal::CaptureSiteData& s : sites) {
+        std::string location =
+            std::string(internal::file_name(s.file_path.c_str())) + ':' +
+            std::to_string(s.file_line);
+        if (!internal::glob_match(pattern.c_str(), location.c_str()) &&
+            !internal::glob_match(pattern.c_str(), s.func.c_str())) {
+            continue;
+        }
+        os << "# " << location << ", " << s.func << "()\n";
+        for (size_t i = 0; i < s.columns.size(); ++i) {
+            os << (i == 0 ? "" : ",") << s.columns[i].name;
+        }
+        os << '\n';
+        size_t rows = s.columns.empty() ? 0 : s.columns[0].values.size();
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t i = 0; i < s.columns.size(); ++i) {
+                if (i != 0) {
+                    os << ',';
+                }
+                internal::write_capture_value(
+                    os, s.columns[i].kind, s.columns[i].values[r]);
+            }
+            os << '\n';
+        }
+        os << '\n';
+    }
+    return static_cast<bool>(os);
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_CAPTURE_H_
@@ -0,0 +1,522 @@
+/** \file
+ *
+ * \brief Runtime control of goinglogging through a named FIFO or a Unix
+ * domain socket.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/control.h"
+ *
+ * gl::start_control("/tmp/my_program.ctl");
+ * \endcode
+ * Then, from a shell:
+ * \code
+ * echo "disable *" > /tmp/my_program.ctl
+ * echo "enable network.cpp:*" > /tmp/my_program.ctl
+ * echo "prefixes FILE|LINE|TIME" > /tmp/my_program.ctl
+ * \endcode
+ *
+ * Commands, one per line:
+ * - <tt>enable <pattern></tt> Enable call sites, see set_sites_enabled()
+ * - <tt>disable <pattern></tt> Disable call sites
+ * - <tt>rate <pattern> <lines per second></tt> Rate limit call sites, 0 for
+ *   no limit, see set_rate_limit()
+ * - <tt>prefixes <names></tt> Set prefixes, e.g. <tt>FILE|LINE</tt> or
+ *   <tt>NONE</tt>, see set_prefixes()
+ * - <tt>output on|off</tt> Enable or disable output
+ * - <tt>color on|off</tt> Enable or disable color
+ * - <tt>format text|json|cbor</tt> Set output format, see set_format()
+ * - <tt>escape on|off</tt> Enable or disable escaping of strings, see
+ *   set_escape_enabled()
+ * - <tt>truncate <bytes></tt> Set maximum length of strings, 0 for no limit,
+ *   see set_max_string_length()
+ * - <tt>flush</tt> Flush output
+ *
+ * Each command is applied with atomic stores, so that logging threads never
+ * wait for the control thread.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_CONTROL_H_
+#define INCLUDE_GOINGLOGGING_CONTROL_H_
+
+#include "core.h"
+#include "sites.h"
+#include "structured.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace gl {
+
+/**
+ * \brief Kind of control channel.
+ *
+ * \sa start_control()
+ */
+enum class control_channel {
+    FIFO,  /**< Named FIFO. Commands are not answered. */
+    SOCKET /**< Unix domain stream socket. Each command is answered. */
+};
+
+inline std::string execute_command(const std::string& command);
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Parse prefix names.
+ *
+ * \param names Names separated by '|', e.g. "FILE|LINE".
+ * \param p     Parsed prefixes.
+ * \return \c true if all names are valid.
+ */
+inline bool parse_prefixes(const std::string& names, prefix& p) {
+    static const std::pair<const char*, prefix> table[] = {
+        {"NONE", prefix::NONE}, {"FILE", prefix::FILE},
+        {"LINE", prefix::LINE}, {"FUNCTION", prefix::FUNCTION},
+        {"TIME", prefix::TIME}, {"THREAD", prefix::THREAD},
+        {"TYPE_NAME", prefix::TYPE_NAME}};
+    p            = prefix::NONE;
+    size_t begin = 0;
+    while (begin <= names.size()) {
+        size_t end = std::min(names.find('|', begin), names.size());
+        bool   found = false;
+        for (const auto& t : table) {
+            if (names.compare(begin, end - begin, t.first) == 0) {
+                p     = p | t.second;
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+/**
+ * \brief Parse "on" or "off".
+ *
+ * \param s Text.
+ * \param b Parsed value.
+ * \return \c true if valid.
+ */
+inline bool parse_on_off(const std::string& s, bool& b) {
+    if (s == "on" || s == "off") {
+        b = s == "on";
+        return true;
+    }
+    return false;
+}
+
+/**
+ * \brief Background thread which reads commands from a FIFO or socket.
+ */
+class Control {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    Control() :
+        m_mutex(), m_thread(), m_running(false), m_path(),
+        m_channel(control_channel::FIFO) {}
+
+    Control(const Control&) = delete;
+    Control& operator=(const Control&) = delete;
+
+    /**
+     * \brief Destructor. Stop thread.
+     */
+    ~Control() {
+        stop();
+    }
+
+    /**
+     * \brief Create FIFO or socket and start thread. Stops previous thread,
+     * if any.
+     *
+     * \param path    File path of FIFO or socket.
+     * \param channel Kind of channel.
+     * \return \c true if success.
+     */
+    bool start(const std::string& path, control_channel channel) {
+        stop();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<int>            fds;
+        const mode_t type =
+            channel == control_channel::FIFO ? S_IFIFO : S_IFSOCK;
+        if (!is_absent_or(path, type)) {
+            return false;
+        }
+        if (channel == control_channel::FIFO) {
+            if (mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
+                return false;
+            }
+            // Keep a writer open, so that the FIFO never reports end of file.
+            // Check what was opened, in case the path was replaced meanwhile
+            int rd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW);
+            struct stat st;
+            if (rd < 0 || fstat(rd, &st) != 0 || !S_ISFIFO(st.st_mode)) {
+                close_all({rd});
+                return false;
+            }
+            int wr = open(path.c_str(), O_WRONLY | O_NONBLOCK | O_NOFOLLOW);
+            if (wr < 0) {
+                close_all({rd});
+                return false;
+            }
+            fds = {rd, wr};
+        } else {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(addr.sun_path)) {
+                return false;
+            }
+            std::memcpy(addr.sun_path, path.c_str(), path.size());
+            // A stale socket of an earlier run, since checked above
+            unlink(path.c_str());
+            // Only the owner may connect. Restricted before listening, so
+            // that no client connects meanwhile.
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 ||
+                bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+                    0 ||
+                chmod(path.c_str(), 0600) != 0 || listen(fd, 4) != 0) {
+                close_all({fd});
+                return false;
+            }
+            fds = {fd};
+        }
+        m_path    = path;
+        m_channel = channel;
+        m_running.store(true, std::memory_order_relaxed);
+        m_thread = std::thread([this, fds]() { run(fds); });
+        return true;
+    }
+
+    /**
+     * \brief Stop thread and remove FIFO or socket, if started.
+     */
+    void stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            return;
+        }
+        m_running.store(false, std::memory_order_relaxed);
+        m_thread.join();
+        const mode_t type =
+            m_channel == control_channel::FIFO ? S_IFIFO : S_IFSOCK;
+        if (is_absent_or(m_path, type)) {
+            unlink(m_path.c_str());
+        }
+    }
+
+  private:
+    /** Milliseconds between checks whether to stop. */
+    static const int kPollMs = 50;
+    /** Maximum length of a command line. */
+    static const size_t kMaxLineLength = 4096;
+#ifdef MSG_NOSIGNAL
+    /** Do not raise SIGPIPE when a client disconnects before a reply. */
+    static const int kSendFlags = MSG_NOSIGNAL;
+#else
+    static const int kSendFlags = 0;
+#endif // MSG_NOSIGNAL
+
+    /**
+     * \brief Check that nothing but a FIFO or socket is at path, so that no
+     * other file is read or removed.
+     *
+     * \param path File path.
+     * \param type S_IFIFO or S_IFSOCK.
+     * \return \c true if nothing, or a file of \p type, is at \p path.
+     */
+    static bool is_absent_or(const std::string& path, mode_t type) {
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) {
+            return errno == ENOENT;
+        }
+        return (st.st_mode & S_IFMT) == type;
+    }
+
+    /**
+     * \brief Close file descriptors.
+     *
+     * \param fds File descriptors. Negative ones are ignored.
+     */
+    static void close_all(const std::vector<int>& fds) {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    /**
+     * \brief Execute complete lines in buffer and remove them.
+     *
+     * \param buf   Received characters.
+     * \param reply File descriptor to write replies to, or -1 if none.
+     */
+    static void execute_lines(std::string& buf, int reply) {
+        size_t nl = 0;
+        while ((nl = buf.find('\n')) != std::string::npos) {
+            std::string command = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            if (!command.empty() && command.back() == '\r') {
+                command.pop_back();
+            }
+            if (command.empty()) {
+                continue;
+            }
+            std::string r = execute_command(command);
+            if (reply >= 0) {
+                r += '\n';
+                if (send(reply, r.data(), r.size(), kSendFlags) < 0) {
+                    return;
+                }
+            } else if (r != "ok") {
+                std::cerr << "goinglogging: " << r << " in '" << command
+                          << "'" << std::endl;
+            }
+        }
+    }
+
+    /**
+     * \brief Thread function. Read and execute commands until stopped.
+     *
+     * \param fds FIFO reader and writer, or listening socket.
+     */
+    void run(std::vector<int> fds) {
+        const bool               fifo = m_channel == control_channel::FIFO;
+        std::vector<std::string> bufs(1); // Per file descriptor polled
+        std::vector<pollfd>      polled = {{fds[0], POLLIN, 0}};
+        char                     chunk[512];
+        bool skip = false; // Skip rest of too long line of FIFO
+        while (m_running.load(std::memory_order_relaxed)) {
+            if (poll(polled.data(), polled.size(), kPollMs) <= 0) {
+                continue;
+            }
+            for (size_t i = 0; i < polled.size(); ++i) {
+                if (polled[i].revents == 0) {
+                    continue;
+                }
+                if (!fifo && i == 0) {
+                    // Accept client
+                    int c = accept(polled[0].fd, nullptr, nullptr);
+                    if (c >= 0) {
+                        polled.push_back({c, POLLIN, 0});
+                        bufs.emplace_back();
+                    }
+                    continue;
+                }
+                ssize_t n = read(polled[i].fd, chunk, sizeof(chunk));
+                if (n > 0) {
+                    const char* data = chunk;
+                    size_t      len  = static_cast<size_t>(n);
+                    if (skip) {
+                        const char* nl = static_cast<const char*>(
+                            std::memchr(data, '\n', len));
+                        if (nl == nullptr) {
+                            continue;
+                        }
+                        len -= static_cast<size_t>(nl + 1 - data);
+                        data = nl + 1;
+                        skip = false;
+                    }
+                    bufs[i].append(data, len);
+                    execute_lines(bufs[i], fifo ? -1 : polled[i].fd);
+                    if (bufs[i].size() <= kMaxLineLength) {
+                        continue;
+                    }
+                    static const char error[] = "error: line too long\n";
+                    if (fifo) {
+                        std::cerr << "goinglogging: " << error << std::flush;
+                        bufs[i].clear();
+                        skip = true;
+                        continue;
+                    }
+                    // Reply, and drop client
+                    send(polled[i].fd, error, sizeof(error) - 1, kSendFlags);
+                    close(polled[i].fd);
+                    polled.erase(polled.begin() + static_cast<long>(i));
+                    bufs.erase(bufs.begin() + static_cast<long>(i));
+                    --i;
+                } else if (!fifo && (n == 0 || errno != EINTR)) {
+                    // Client disconnected
+                    close(polled[i].fd);
+                    polled.erase(polled.begin() + static_cast<long>(i));
+                    bufs.erase(bufs.begin() + static_cast<long>(i));
+                    --i;
+                }
+            }
+        }
+        for (size_t i = 1; i < polled.size(); ++i) {
+            close(polled[i].fd);
+        }
+        close_all(fds);
+    }
+
+    std::mutex        m_mutex;   /**< Guards start and stop. */
+    std::thread       m_thread;  /**< Control thread. */
+    std::atomic<bool> m_running; /**< \c true until stopped. */
+    std::string       m_path;    /**< File path of FIFO or socket. */
+    control_channel   m_channel; /**< Kind of channel. */
+};
+
+/**
+ * \return Control thread.
+ */
+inline Control& control() {
+    static Control c;
+    return c;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Execute control command.
+ *
+ * \param command Command, as listed in goinglogging/control.h.
+ * \return "ok", or "error: " followed by the reason.
+ *
+ * Used as:
+ * \code
+ * gl::execute_command("rate network.cpp:* 100");
+ * \endcode
+ *
+ * \sa start_control()
+ *
+ */
+inline std::string execute_command(const std::string& command) {
+    std::istringstream       ss(command);
+    std::vector<std::string> args;
+    std::string              arg;
+    while (ss >> arg) {
+        args.push_back(arg);
+    }
+    if (args.empty()) {
+        return "error: empty command";
+    }
+    const std::string& name = args[0];
+    const size_t       n    = args.size() - 1;
+    if (name == "enable" || name == "disable") {
+        if (n != 1) {
+            return "error: expected pattern";
+        }
+        set_sites_enabled(args[1], name == "enable");
+    } else if (name == "rate") {
+        char*         end   = nullptr;
+        unsigned long limit = n == 2 ?
+                                  std::strtoul(args[2].c_str(), &end, 10) :
+                                  0;
+        if (n != 2 || *end != '\0' || limit > UINT32_MAX) {
+            return "error: expected pattern and lines per second";
+        }
+        set_rate_limit(args[1], static_cast<uint32_t>(limit));
+    } else if (name == "prefixes") {
+        prefix p = prefix::NONE;
+        if (n != 1 || !internal::parse_prefixes(args[1], p)) {
+            return "error: expected prefixes";
+        }
+        set_prefixes(p);
+    } else if (name == "output" || name == "color" || name == "escape") {
+        bool e = false;
+        if (n != 1 || !internal::parse_on_off(args[1], e)) {
+            return "error: expected on or off";
+        }
+        if (name == "output") {
+            set_output_enabled(e);
+        } else if (name == "color") {
+            set_color_enabled(e);
+        } else {
+            set_escape_enabled(e);
+        }
+    } else if (name == "truncate") {
+        char*              end = nullptr;
+        unsigned long long max = n == 1 ?
+                                     std::strtoull(args[1].c_str(), &end, 10) :
+                                     0;
+        if (n != 1 || *end != '\0' || args[1][0] == '-') {
+            return "error: expected bytes";
+        }
+        set_max_string_length(static_cast<size_t>(max));
+    } else if (name == "format") {
+        static const std::pair<const char*, format> formats[] = {
+            {"text", format::TEXT}, {"json", format::JSON},
+            {"cbor", format::CBOR}};
+        for (const auto& f : formats) {
+            if (n == 1 && args[1] == f.first) {
+                set_format(f.second);
+                return "ok";
+            }
+        }
+        return "error: expected text, json or cbor";
+    } else if (name == "flush") {
+        if (n != 0) {
+            return "error: too many arguments";
+        }
+        std::cout.flush();
+    } else {
+        return "error: unknown command";
+    }
+    return "ok";
+}
+
+/**
+ * \brief Start reading control commands from a named FIFO or a Unix domain
+ * socket in a background thread.
+ *
+ * \param path    File path of FIFO or socket. Created, and removed when
+ *                stopped. An existing FIFO or socket is reused.
+ * \param channel Kind of channel.
+ * \return \c true if started, \c false e.g. if another kind of file is at
+ * \p path.
+ *
+ * \note Stops any previously started control thread. The thread is also
+ * stopped at program exit.
+ * \note The FIFO or socket is only accessible by the owner. Lines longer
+ * than 4096 characters are dropped from a FIFO, and a socket client which
+ * sends one is answered with an error and disconnected.
+ *
+ * \sa stop_control() \sa execute_command()
+ *
+ */
+inline bool start_control(const std::string& path,
+    control_channel channel = control_channel::FIFO) {
+    return internal::control().start(path, channel);
+}
+
+/**
+ * \brief Stop reading control commands.
+ *
+ * \sa start_control()
+ *
+ */
+inline void stop_control() {
+    internal::control().stop();
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_CONTROL_H_
@@ -0,0 +1,3998 @@
+/** \file
+ *
+ * \brief Core of the lightweight logging library: the logging macros,
+ * settings, and formatters of fundamental types and strings, written as text.
+ *
+ * Includes no standard containers. Include the formatters of the container
+ * families which are logged, or goinglogging.h for all of them:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/sequence.h"
+ * \endcode
+ * The JSON and CBOR formats are in goinglogging/structured.h, histograms,
+ * counters and timers in goinglogging/report.h, capture in
+ * goinglogging/capture.h, the per-site rules in goinglogging/sites.h, and
+ * the printing of profiles in goinglogging/profile.h.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_CORE_H_
+#define INCLUDE_GOINGLOGGING_CORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <ios>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif // __GNUC__
+#ifdef _WIN32
+#include <thread>
+#else
+#include <pthread.h>
+#endif // _WIN32
+
+#ifndef DOXYGEN_HIDDEN
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/** Defined if SSE2 is available. */
+#define GL_INTERNAL_SSE2
+#endif
+#if defined(GL_STATIC_KEYS) && !defined(GL_PROFILE) && defined(__GNUC__) && \
+    defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) &&  \
+    !(defined(__PIC__) && !defined(__PIE__))
+/** Defined if call sites are patchable jumps. */
+#define GL_INTERNAL_STATIC_KEYS
+#endif
+#if defined(GL_USDT) && defined(__GNUC__) && defined(__linux__) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+/** Defined if call sites are USDT probes. */
+#define GL_INTERNAL_USDT
+#endif
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Log variables.
+ *
+ * Use as:
+ * \code
+ * int i = 1;
+ * l(i);
+ * std::string s("s");
+ * l(i, s);
+ * \endcode
+ * Which outputs:
+ * \code
+ * i = 1, s = "s"
+ * \endcode
+ *
+ * \note Supports up to 16 variables as parameters.
+ * \note Uses prefix information set with \ref set_prefixes().
+ *
+ * \sa l_arr() \sa l_mat() \sa set_prefixes()
+ *
+ */
+#define l(...)                                                             \
+    GL_INTERNAL_EMIT(                                                      \
+        gl::internal::log_start                                            \
+        << gl_internal_log_site.prefix()                                   \
+        << GL_INTERNAL_L_DISPATCH(__VA_ARGS__, GL_INTERNAL_L16,            \
+               GL_INTERNAL_L15, GL_INTERNAL_L14, GL_INTERNAL_L13,          \
+               GL_INTERNAL_L12, GL_INTERNAL_L11, GL_INTERNAL_L10,          \
+               GL_INTERNAL_L9, GL_INTERNAL_L8, GL_INTERNAL_L7,             \
+               GL_INTERNAL_L6, GL_INTERNAL_L5, GL_INTERNAL_L4,             \
+               GL_INTERNAL_L3, GL_INTERNAL_L2, GL_INTERNAL_L1, )(__VA_ARGS__) \
+        << gl::internal::MessageEnd() << (GL_NEWLINE))
+
+/**
+ * \brief Log array.
+ *
+ * \param v   Array to print [\p len].
+ * \param len Number of elements.
+ *
+ * Used as:
+ * \code
+ * int a[] = {0, 1, 2};
+ * l_arr(a, 3);
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * a = {0, 1, 2}
+ * \endcode
+ *
+ * \note Uses prefix information set with \ref set_prefixes().
+ * \note Unlike \ref l(), this does not support multiple varaibles as
+ * parameters.
+ *
+ * \warning Behaviour is undefined if \p len is larger than the
+ * allocated array.
+ *
+ * \sa l() \sa l_mat() \sa set_prefixes()
+ *
+ */
+#define l_arr(v, len)                                             \
+    GL_INTERNAL_EMIT(::gl::internal::make_array(                  \
+        (#v), (v), (len), gl_internal_log_site.prefix()))
+
+/**
+ * \brief Log matrix.
+ *
+ * \param m    Matrix to print [\p rows x \p cols].
+ * \param cols Number of columns in matrix.
+ * \param rows Number of rows in matrix.
+ *
+ * Used as:
+ * \code
+ * int m[][] = {{11, 12}, {21, 22}};
+ * l_mat(m, 2, 2);
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * m: [0,0] = 11, [0,1] = 12, [1,0] = 21, [1,1] = 22
+ * \endcode
+ *
+ * \note Uses prefix information set with \ref set_prefixes().
+ * \note Unlike \ref l(), this does not support multiple variables
+ * as parameters.
+ *
+ * \warning Behaviour is undefined if \p c or \p r is larger than
+ * the allocated matrix.
+ *
+ * \sa l() \sa l_arr() \sa set_prefixes()
+ *
+ */
+#define l_mat(m, cols, rows)                                      \
+    GL_INTERNAL_EMIT(::gl::internal::make_matrix(                 \
+        (#m), (m), (cols), (rows), gl_internal_log_site.prefix()))
+
+/**
+ * \brief Declare the fields of a struct or class, so that \ref l() writes
+ * them without an overloaded stream insertion operator.
+ *
+ * \param Type Type, without template arguments.
+ * \param ...  Public fields, up to 16.
+ *
+ * Used in the namespace of the type:
+ * \code
+ * namespace geo {
+ * struct Point {
+ *     int                 x;
+ *     int                 y;
+ *     std::vector<double> weights;
+ * };
+ * GL_REFLECT(Point, x, y, weights)
+ * } // namespace geo
+ *
+ * geo::Point p = {1, 2, {0.5}};
+ * l(p);
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * p = {x = 1, y = 2, weights = {0.5}}
+ * \endcode
+ *
+ * \note Fields are written with the same formatters as variables, so they
+ * may be containers or other reflected types. In JSON and CBOR, the type is
+ * written as a map from field name to value.
+ * \note Takes precedence over an overloaded stream insertion operator.
+ *
+ * \sa l()
+ *
+ */
+#define GL_REFLECT(Type, ...)                                              \
+    template<class GlVisitor>                                              \
+    inline void gl_reflect_fields(GlVisitor& gl_visitor, Type& gl_object) { \
+        GL_INTERNAL_L_DISPATCH(__VA_ARGS__, GL_INTERNAL_R16,               \
+            GL_INTERNAL_R15, GL_INTERNAL_R14, GL_INTERNAL_R13,             \
+            GL_INTERNAL_R12, GL_INTERNAL_R11, GL_INTERNAL_R10,             \
+            GL_INTERNAL_R9, GL_INTERNAL_R8, GL_INTERNAL_R7, GL_INTERNAL_R6, \
+            GL_INTERNAL_R5, GL_INTERNAL_R4, GL_INTERNAL_R3, GL_INTERNAL_R2, \
+            GL_INTERNAL_R1, )(__VA_ARGS__)                                 \
+    }
+
+#ifndef GL_NEWLINE
+/**
+ * \brief Newline character to use after each logging message.
+ *
+ * May e.g. be changed to std::endl to enable flush after each
+ * logging message:
+ * \code
+ * #define GL_NEWLINE std::endl
+ * #include "goinglogging.h"
+ * \endcode
+ *
+ * \note Defaults to \\n, i.e. no flushing.
+ *
+ * \sa l() \sa l_arr() \sa l_mat()
+ *
+ */
+#define GL_NEWLINE '\n'
+#endif // GL_NEWLINE
+
+#ifdef DOXYGEN_HIDDEN
+/**
+ * \brief Define to measure the cost of logging, per call site.
+ *
+ * Records the number of calls, calls suppressed since output is disabled,
+ * bytes written, and total and maximum time spent formatting and writing,
+ * for each call site of \ref l(), \ref l_arr() and \ref l_mat():
+ * \code
+ * #define GL_PROFILE
+ * #include "goinglogging.h"
+ * \endcode
+ *
+ * \note Not defined by default, which adds no overhead.
+ * \note The profile is written to std::cerr at program exit.
+ *
+ * \sa print_profile()
+ *
+ */
+#define GL_PROFILE
+
+/**
+ * \brief Define to compile each call site to a jump, which disabling the
+ * call site rewrites to a no-op instruction.
+ *
+ * A disabled call site then costs a no-op, instead of an atomic load and a
+ * branch:
+ * \code
+ * #define GL_STATIC_KEYS
+ * #include "goinglogging.h"
+ *
+ * gl::set_sites_enabled("*", false);
+ * \endcode
+ * Enabled call sites take the jump, and then check as usual.
+ *
+ * \note Not defined by default, which adds no overhead.
+ * \note Only for x86-64 and AArch64 Linux, with GCC or Clang. Else, and in
+ * shared libraries and with \ref GL_PROFILE, has no effect.
+ * \note Call sites of \ref l(), \ref l_arr() and \ref l_mat() are patched.
+ * \note Patching temporarily makes a page of code writable. If not allowed,
+ * call sites are checked as usual.
+ * \note On x86-64, threads which run a call site while it is patched wait
+ * in a SIGTRAP handler, which is installed when first patching, and passes
+ * other traps on to the previous handler. Needs membarrier(), since Linux
+ * 4.16, or call sites are checked as usual.
+ *
+ * \sa set_sites_enabled()
+ *
+ */
+#define GL_STATIC_KEYS
+
+/**
+ * \brief Define to make each call site a USDT probe, which tracers such as
+ * bpftrace, perf and SystemTap attach to.
+ *
+ * Each call site of \ref l(), \ref l_arr() and \ref l_mat() gets a probe
+ * goinglogging:log, described in the ELF section .note.stapsdt:
+ * \code
+ * #define GL_USDT
+ * #include "goinglogging.h"
+ * \endcode
+ * The arguments of the probe are the file path, line number and function
+ * name of the call site, and the message as text and its length, without
+ * newline. E.g. with bpftrace:
+ * \code
+ * bpftrace -e 'usdt:./app:goinglogging:log { printf("%s\n", str(arg3)); }'
+ * \endcode
+ * The message is only formatted while a tracer is attached, which the
+ * tracer signals through the semaphore of the probe.
+ *
+ * \note Not defined by default, which adds no overhead.
+ * \note Only for x86-64 and AArch64 Linux, with GCC or Clang. Else, has no
+ * effect.
+ * \note The probe fires even if output or the call site is disabled. The
+ * message is then formatted once, for both the probe and output.
+ *
+ */
+#define GL_USDT
+
+/**
+ * \brief Define when linking to the precompiled library, to not instantiate
+ * the formatting of common types in each file which logs.
+ *
+ * The library instantiates the formatting of arithmetic types, std::string,
+ * and vectors of int, double and std::string, once. The CMake target
+ * \c goinglogging defines it for everything linked to it. Else:
+ * \code
+ * #define GL_PRECOMPILED
+ * #include "goinglogging.h"
+ * \endcode
+ *
+ * \note Not defined by default, which requires no library.
+ *
+ */
+#define GL_PRECOMPILED
+#endif // DOXYGEN_HIDDEN
+
+#ifndef DOXYGEN_HIDDEN
+#if defined(__GNUC__)
+/** \brief Never inline function. */
+#define GL_INTERNAL_NOINLINE __attribute__((noinline))
+/** \brief Never inline function, and place it away from hot code. */
+#define GL_INTERNAL_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define GL_INTERNAL_NOINLINE __declspec(noinline)
+#define GL_INTERNAL_COLD __declspec(noinline)
+#else
+#define GL_INTERNAL_NOINLINE
+#define GL_INTERNAL_COLD
+#endif // __GNUC__
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief goinglogging namespace. */
+namespace gl {
+
+/**
+ * \brief Prefix of logging output.
+ *
+ * Use bitwise \c or for multiple prefixes at the same time:
+ * \code
+ * gl::set_prefixes(gl::prefix::FILE | gl::prefix::LINE);
+ * \endcode
+ * Bitwise \c and as well as \c xor are also supported.
+ *
+ * \sa set_prefixes() \sa get_prefixes()
+ *
+ */
+enum class prefix : uint32_t {
+    NONE = 0,          /**< No prefix. */
+    FILE = 1 << 0,     /**< File name. For example 'main.cpp'. */
+    LINE = 1 << 1,     /**< Line number in file. For example 'Line:
+                          16'. */
+    FUNCTION = 1 << 2, /**< Function name. For example 'calculate()'. */
+    TIME     = 1 << 3, /**< Current local time as
+                        * hour:minute:second.millisecond.
+                        *  For example '10:02:13.057'. */
+    THREAD = 1 << 4,   /**< ID of current thread. For example
+                          'TID:   12'. */
+    TYPE_NAME = 1 << 5 /**< Name of type. For example 'int'. */
+};
+
+/**
+ * \brief Bitwise \c and of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c and of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+constexpr prefix operator&(prefix lhs, prefix rhs) noexcept {
+    return static_cast<prefix>(
+        static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs));
+}
+
+/**
+ * \brief Bitwise \c and of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c and of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+inline prefix& operator&=(prefix& lhs, prefix rhs) noexcept {
+    return lhs = lhs & rhs;
+}
+
+/**
+ * \brief Bitwise \c or of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c or of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+constexpr prefix operator|(prefix lhs, prefix rhs) noexcept {
+    return static_cast<prefix>(
+        static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+/**
+ * \brief Bitwise \c or of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c or of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+inline prefix& operator|=(prefix& lhs, prefix rhs) noexcept {
+    return lhs = lhs | rhs;
+}
+
+/**
+ * \brief Bitwise \c xor of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c xor of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+constexpr prefix operator^(prefix lhs, prefix rhs) noexcept {
+    return static_cast<prefix>(
+        static_cast<uint32_t>(lhs) ^ static_cast<uint32_t>(rhs));
+}
+
+/**
+ * \brief Bitwise \c xor of logging prefix settings.
+ *
+ * \param lhs First element.
+ * \param rhs Second element.
+ * \return Bitwise \c xor of \p lhs and \p rhs.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+inline prefix& operator^=(prefix& lhs, prefix rhs) noexcept {
+    return lhs = lhs ^ rhs;
+}
+
+/**
+ * \brief Format of logging output.
+ *
+ * \sa set_format() \sa get_format()
+ *
+ */
+enum class format : uint32_t {
+    TEXT, /**< Human readable text. For example 'main.cpp:12: i = 1'. */
+    JSON, /**< One JSON object per line, with prefixes and variables as
+             fields. For example
+             '{"file":"main.cpp","line":12,"values":{"i":1}}'. */
+    CBOR  /**< Sequence of CBOR maps, with the same structure as JSON. */
+};
+
+/**
+ * \brief Hide this section from doxygen */
+#ifndef DOXYGEN_HIDDEN
+
+/**
+ * \brief Functionality in this namespace is for internal use
+ */
+namespace internal {
+
+#ifdef __GNUC__
+/**
+ * \brief Demangler of variable type names.
+ */
+class Demangler {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    Demangler() : m_buf(nullptr), m_buf_len(0) {
+    }
+
+    /**
+     * \brief Destructor. Free any allocated memory.
+     */
+    ~Demangler() {
+        // OK even if buf = nullptr
+        free(m_buf);
+    }
+
+    /**
+     * \brief Demangle type name.
+     *
+     * \param type_name Mangled type name.
+     * \return Demangled type name, or \p type_name if it cannot be
+     * demangled.
+     */
+    const char* demangle(const char* type_name) noexcept {
+        int   status = 0;
+        char* buf = abi::__cxa_demangle(type_name, m_buf, &m_buf_len, &status);
+        if (status != 0) {
+            // The buffer is unchanged on failure
+            return type_name;
+        }
+        m_buf = buf;
+        return m_buf;
+    }
+
+  private:
+    char*  m_buf;     /**< Demangle name buffer. Allocated with malloc. */
+    size_t m_buf_len; /**< Demangle name buffer length. */
+};
+#endif // __GNUC__
+
+/**
+ * \brief Settings, shared by all translation units. Static data members of a
+ * class template may be defined in a header, which C++11 does not allow for
+ * plain variables.
+ *
+ * \tparam Unused Unused.
+ */
+template<class Unused = void>
+struct Settings {
+    static std::atomic<prefix>   curPrefixes;      /**< Prefixes */
+    static std::atomic<uint32_t> prefixGeneration; /**< Generation */
+    static std::atomic<bool>     outputEnabled;    /**< Output */
+    static std::atomic<bool>     colorEnabled;     /**< Color */
+    static std::atomic<format>   curFormat;        /**< Format */
+    static std::atomic<bool>     captureEnabled;   /**< Capture */
+    static std::atomic<bool>     escapeEnabled;    /**< Escape */
+    static std::atomic<size_t>   maxStringLength;  /**< Truncation */
+    static std::atomic<size_t>   heapSorted;       /**< Heap order */
+};
+
+template<class Unused>
+std::atomic<prefix> Settings<Unused>::curPrefixes(prefix::FILE | prefix::LINE);
+template<class Unused>
+std::atomic<uint32_t> Settings<Unused>::prefixGeneration(1);
+template<class Unused>
+std::atomic<bool> Settings<Unused>::outputEnabled(true);
+template<class Unused>
+std::atomic<bool> Settings<Unused>::colorEnabled(false);
+template<class Unused>
+std::atomic<format> Settings<Unused>::curFormat(format::TEXT);
+template<class Unused>
+std::atomic<bool> Settings<Unused>::captureEnabled(false);
+template<class Unused>
+std::atomic<bool> Settings<Unused>::escapeEnabled(false);
+template<class Unused>
+std::atomic<size_t> Settings<Unused>::maxStringLength(0);
+template<class Unused>
+std::atomic<size_t> Settings<Unused>::heapSorted(0);
+
+/** Current prefixes */
+static std::atomic<prefix>& curPrefixes = Settings<>::curPrefixes;
+/** Incremented when prefixes or color change, to invalidate PrefixCache. */
+static std::atomic<uint32_t>& prefixGeneration = Settings<>::prefixGeneration;
+/** \c true if output is enabled */
+static std::atomic<bool>& outputEnabled = Settings<>::outputEnabled;
+/** \c true if colored output is enabled */
+static std::atomic<bool>& colorEnabled = Settings<>::colorEnabled;
+/** Current output format */
+static std::atomic<format>& curFormat = Settings<>::curFormat;
+/** \c true if l() captures numbers instead of writing them */
+static std::atomic<bool>& captureEnabled = Settings<>::captureEnabled;
+/** \c true if strings are escaped in text */
+static std::atomic<bool>& escapeEnabled = Settings<>::escapeEnabled;
+/** Maximum number of bytes of a string, or 0 for no limit */
+static std::atomic<size_t>& maxStringLength = Settings<>::maxStringLength;
+/** Number of elements of priority queues written in sorted order, or 0 */
+static std::atomic<size_t>& heapSorted = Settings<>::heapSorted;
+#ifdef __GNUC__
+static Demangler demangler;
+#endif // __GNUC__
+
+/** Format word while capturing. Not a format, so nothing is written. */
+static const uint32_t kCaptureFormat = 3;
+
+/**
+ * \return Format of the message which this thread currently writes, or
+ * kCaptureFormat while capturing. Held per thread rather than in the shared
+ * stream, so that a message is written in one format even if the format is
+ * changed concurrently.
+ */
+inline uint32_t& message_format() noexcept {
+    static thread_local uint32_t f = static_cast<uint32_t>(format::TEXT);
+    return f;
+}
+
+/**
+ * \brief Get format of the message currently written to stream.
+ *
+ * \return Format. format::TEXT unless a message is written with another
+ * format.
+ */
+inline format stream_format(std::ostream&) noexcept {
+    return static_cast<format>(message_format());
+}
+
+/**
+ * \brief Check if stream is written as text.
+ *
+ * \param os Output stream.
+ * \return \c true if text.
+ */
+inline bool is_text(std::ostream& os) noexcept {
+    return stream_format(os) == format::TEXT;
+}
+
+/**
+ * \brief Count trailing zero bits.
+ *
+ * \param v Value, not 0.
+ * \return Number of trailing zero bits.
+ */
+inline unsigned count_trailing_zeros(unsigned v) noexcept {
+#ifdef __GNUC__
+    return static_cast<unsigned>(__builtin_ctz(v));
+#else
+    unsigned n = 0;
+    for (; (v & 1) == 0; v >>= 1) {
+        ++n;
+    }
+    return n;
+#endif // __GNUC__
+}
+
+/**
+ * \brief Find first character which may need escaping: a control character,
+ * '"' or '\\'. Scans 16 characters at a time with SSE2 if available.
+ *
+ * \param s Characters [\p n].
+ * \param n Number of characters.
+ * \return Index of character, or \p n if none.
+ */
+inline size_t find_escape(const char* s, size_t n) noexcept {
+    size_t i = 0;
+#ifdef GL_INTERNAL_SSE2
+    const __m128i control = _mm_set1_epi8(0x1f);
+    const __m128i quote   = _mm_set1_epi8('"');
+    const __m128i slash   = _mm_set1_epi8('\\');
+    const __m128i del     = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_max_epu8(v, control), control),
+                _mm_cmpeq_epi8(v, del)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+        if (mask != 0) {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+#endif // GL_INTERNAL_SSE2
+    for (; i < n; ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c < 0x20 || c == '"' || c == '\\' || c == 0x7f) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * \brief Write characters with C escape sequences for control characters,
+ * '"' and '\\'.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n].
+ * \param n  Number of characters.
+ */
+inline void c_escape(std::ostream& os, const char* s, size_t n) noexcept {
+    static const char hex[] = "0123456789abcdef";
+    size_t            run   = 0; // Start of characters not needing escape
+    for (size_t i = find_escape(s, n); i < n;
+         i += 1 + find_escape(s + i + 1, n - i - 1)) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        os.write(s + run, static_cast<std::streamsize>(i - run));
+        run = i + 1;
+        switch (c) {
+            case '"': os.write("\\\"", 2); break;
+            case '\\': os.write("\\\\", 2); break;
+            case '\n': os.write("\\n", 2); break;
+            case '\r': os.write("\\r", 2); break;
+            case '\t': os.write("\\t", 2); break;
+            default: {
+                char x[] = {'\\', 'x', hex[c >> 4], hex[c & 0xf]};
+                os.write(x, sizeof(x));
+            }
+        }
+    }
+    os.write(s + run, static_cast<std::streamsize>(n - run));
+}
+
+/**
+ * \brief Function which writes a value as text to a stream.
+ */
+typedef void (*TextWriter)(std::ostream& os, const void* value);
+
+/**
+ * \brief Encoder of a structured format, JSON or CBOR. Text is written by the
+ * formatters themselves.
+ *
+ * The encoders are defined in goinglogging/structured.h, and registered by
+ * gl::set_format() there, which is the only way to select them. Files which
+ * only include the core thus write text, or call the encoders registered
+ * by another file.
+ */
+class Encoder {
+  public:
+    /**
+     * \brief Destructor.
+     */
+    virtual ~Encoder() = default;
+
+    /**
+     * \brief Write start of array.
+     *
+     * \param os Output stream.
+     */
+    virtual void begin_array(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write end of array.
+     *
+     * \param os Output stream.
+     */
+    virtual void end_array(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write start of map.
+     *
+     * \param os Output stream.
+     */
+    virtual void begin_map(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write end of map.
+     *
+     * \param os Output stream.
+     */
+    virtual void end_map(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write separator between elements or variables.
+     *
+     * \param os Output stream.
+     */
+    virtual void separator(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write map key.
+     *
+     * \param os  Output stream.
+     * \param key Characters of key [\p n].
+     * \param n   Number of characters.
+     */
+    virtual void key(
+        std::ostream& os, const char* key, size_t n) const noexcept = 0;
+
+    /**
+     * \brief Write string, followed by characters which need no escaping,
+     * such as the marker of a truncated string.
+     *
+     * \param os     Output stream.
+     * \param s      Characters [\p n]. UTF-8.
+     * \param n      Number of characters.
+     * \param tail   Characters to append [\p tail_n].
+     * \param tail_n Number of characters to append.
+     */
+    virtual void string(std::ostream& os, const char* s, size_t n,
+        const char* tail, size_t tail_n) const noexcept = 0;
+
+    /**
+     * \brief Write start of string of unknown length, which is written in
+     * chunks.
+     *
+     * \param os Output stream.
+     */
+    virtual void begin_string(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write chunk of string.
+     *
+     * \param os Output stream.
+     * \param s  Characters [\p n]. Complete UTF-8 sequences.
+     * \param n  Number of characters.
+     */
+    virtual void string_chunk(
+        std::ostream& os, const char* s, size_t n) const noexcept = 0;
+
+    /**
+     * \brief Write end of string written in chunks.
+     *
+     * \param os Output stream.
+     */
+    virtual void end_string(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write null.
+     *
+     * \param os Output stream.
+     */
+    virtual void null(std::ostream& os) const noexcept = 0;
+
+    /**
+     * \brief Write bool.
+     *
+     * \param os Output stream.
+     * \param b  Value.
+     */
+    virtual void boolean(std::ostream& os, bool b) const noexcept = 0;
+
+    /**
+     * \brief Write unsigned integer.
+     *
+     * \param os Output stream.
+     * \param v  Value.
+     */
+    virtual void unsigned_int(std::ostream& os, uint64_t v) const noexcept = 0;
+
+    /**
+     * \brief Write signed integer.
+     *
+     * \param os Output stream.
+     * \param v  Value.
+     */
+    virtual void signed_int(std::ostream& os, int64_t v) const noexcept = 0;
+
+    /**
+     * \brief Write floating point number.
+     *
+     * \param os     Output stream.
+     * \param v      Value.
+     * \param single \c true if the value has single precision.
+     */
+    virtual void floating(
+        std::ostream& os, double v, bool single) const noexcept = 0;
+
+    /**
+     * \brief Write value as string of the text which \p write writes, e.g.
+     * with its operator<<. For values without a structured representation.
+     *
+     * \param os    Output stream.
+     * \param write Writer of value, to a stream with the flags of \p os.
+     * \param value Value.
+     */
+    virtual void text(std::ostream& os, TextWriter write,
+        const void* value) const noexcept = 0;
+
+    /**
+     * \brief End message, after the end of its map.
+     *
+     * \param os Output stream.
+     */
+    virtual void end_message(std::ostream& os) const noexcept = 0;
+};
+
+/**
+ * \brief Get registered encoder of format.
+ *
+ * \param f Format, format::JSON or format::CBOR.
+ * \return Encoder, \c nullptr until registered by gl::set_format().
+ */
+inline std::atomic<const Encoder*>& encoder_of(format f) noexcept {
+    static std::atomic<const Encoder*> encoders[2];
+    return encoders[static_cast<uint32_t>(f) - 1];
+}
+
+/**
+ * \return Encoder of the message which this thread currently writes, which
+ * is not written as text.
+ */
+inline const Encoder& encoder() noexcept {
+    return *encoder_of(static_cast<format>(message_format()))
+                .load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Write start of array. '{' in text.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& begin_array(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << '{';
+    }
+    encoder().begin_array(os);
+    return os;
+}
+
+/**
+ * \brief Write end of array. '}' in text.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& end_array(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << '}';
+    }
+    encoder().end_array(os);
+    return os;
+}
+
+/**
+ * \brief Write start of map. '{' in text.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& begin_map(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << '{';
+    }
+    encoder().begin_map(os);
+    return os;
+}
+
+/**
+ * \brief Write end of map. '}' in text.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& end_map(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << '}';
+    }
+    encoder().end_map(os);
+    return os;
+}
+
+/**
+ * \brief Write separator between elements or variables. ", " in text, and
+ * nothing between captured variables.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& separator(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << ", ";
+    }
+    if (message_format() != kCaptureFormat) {
+        encoder().separator(os);
+    }
+    return os;
+}
+
+/**
+ * \brief Write start of string of unknown length. '"' in text.
+ *
+ * \param os Output stream.
+ */
+inline void begin_string(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        os << '"';
+    } else {
+        encoder().begin_string(os);
+    }
+}
+
+/**
+ * \brief Write chunk of string, escaped as in the format. Escaped in text
+ * if enabled.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n]. Complete UTF-8 sequences for JSON and CBOR.
+ * \param n  Number of characters.
+ */
+inline void string_chunk(std::ostream& os, const char* s, size_t n) noexcept {
+    if (!is_text(os)) {
+        encoder().string_chunk(os, s, n);
+    } else if (escapeEnabled.load(std::memory_order_relaxed)) {
+        c_escape(os, s, n);
+    } else {
+        os.write(s, static_cast<std::streamsize>(n));
+    }
+}
+
+/**
+ * \brief Write end of string of unknown length. '"' in text.
+ *
+ * \param os Output stream.
+ */
+inline void end_string(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        os << '"';
+    } else {
+        encoder().end_string(os);
+    }
+}
+
+/**
+ * \brief Check if character is a continuation byte of a UTF-8 sequence.
+ *
+ * \param c Character.
+ * \return \c true if continuation byte.
+ */
+inline bool is_utf8_continuation(char c) noexcept {
+    return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+}
+
+/**
+ * \brief Write first bytes of string, followed by "...(+N bytes)".
+ *
+ * Cut before an incomplete UTF-8 sequence.
+ *
+ * \param os  Output stream.
+ * \param s   Characters [\p n].
+ * \param n   Number of characters.
+ * \param max Maximum number of characters to write, less than \p n.
+ * \return Output stream.
+ */
+GL_INTERNAL_COLD inline std::ostream& encode_truncated_string(
+    std::ostream& os, const char* s, size_t n, size_t max) noexcept {
+    size_t keep = max;
+    for (int i = 0; i < 3 && keep > 0 && is_utf8_continuation(s[keep]); ++i) {
+        --keep;
+    }
+    if (is_utf8_continuation(s[keep])) {
+        keep = max;
+    }
+    char   marker[32];
+    int    m    = std::snprintf(marker, sizeof(marker), "...(+%llu bytes)",
+        static_cast<unsigned long long>(n - keep));
+    size_t tail = m < 0 ? 0 : static_cast<size_t>(m);
+    if (!is_text(os)) {
+        encoder().string(os, s, keep, marker, tail);
+        return os;
+    }
+    os << '"';
+    string_chunk(os, s, keep);
+    os.write(marker, static_cast<std::streamsize>(tail));
+    return os << '"';
+}
+
+/**
+ * \brief Write string. Quoted in text, and escaped if enabled.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n]. UTF-8 for JSON and CBOR.
+ * \param n  Number of characters.
+ * \return Output stream.
+ */
+inline std::ostream& encode_string(
+    std::ostream& os, const char* s, size_t n) noexcept {
+    if (!is_text(os)) {
+        encoder().string(os, s, n, nullptr, 0);
+        return os;
+    }
+    os << '"';
+    string_chunk(os, s, n);
+    return os << '"';
+}
+
+/**
+ * \brief Write string.
+ *
+ * \param os Output stream.
+ * \param s  Null terminated string.
+ * \return Output stream.
+ */
+inline std::ostream& encode_string(std::ostream& os, const char* s) noexcept {
+    return encode_string(os, s, std::strlen(s));
+}
+
+/**
+ * \brief Write string value. As encode_string(), but truncated to the maximum
+ * string length. Keys and prefixes are not truncated.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n]. UTF-8 for JSON and CBOR.
+ * \param n  Number of characters.
+ * \return Output stream.
+ */
+inline std::ostream& encode_value_string(
+    std::ostream& os, const char* s, size_t n) noexcept {
+    const size_t max = maxStringLength.load(std::memory_order_relaxed);
+    if (max != 0 && n > max) {
+        return encode_truncated_string(os, s, n, max);
+    }
+    return encode_string(os, s, n);
+}
+
+/**
+ * \brief Write string value.
+ *
+ * \param os Output stream.
+ * \param s  Null terminated string.
+ * \return Output stream.
+ */
+inline std::ostream& encode_value_string(
+    std::ostream& os, const char* s) noexcept {
+    return encode_value_string(os, s, std::strlen(s));
+}
+
+/**
+ * \brief Write map key. Followed by ": " in text.
+ *
+ * \param os  Output stream.
+ * \param key Characters of key [\p n].
+ * \param n   Number of characters.
+ * \return Output stream.
+ */
+inline std::ostream& encode_key(
+    std::ostream& os, const char* key, size_t n) noexcept {
+    if (is_text(os)) {
+        return os.write(key, static_cast<std::streamsize>(n)) << ": ";
+    }
+    encoder().key(os, key, n);
+    return os;
+}
+
+/**
+ * \brief Write map key. Followed by ": " in text.
+ *
+ * \param os  Output stream.
+ * \param key Null terminated key.
+ * \return Output stream.
+ */
+inline std::ostream& encode_key(std::ostream& os, const char* key) noexcept {
+    return encode_key(os, key, std::strlen(key));
+}
+
+/**
+ * \brief Write null. "nullptr" in text.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& encode_null(std::ostream& os) noexcept {
+    if (is_text(os)) {
+        return os << "nullptr";
+    }
+    encoder().null(os);
+    return os;
+}
+
+/**
+ * \brief Write bool.
+ *
+ * \param os Output stream.
+ * \param b  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_bool(std::ostream& os, bool b) noexcept {
+    if (is_text(os)) {
+        return os << (b ? "true" : "false");
+    }
+    encoder().boolean(os, b);
+    return os;
+}
+
+/**
+ * \brief Write unsigned integer, in decimal regardless of stream flags
+ * except in text.
+ *
+ * \param os Output stream.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_uint(std::ostream& os, uint64_t v) noexcept {
+    if (is_text(os)) {
+        return os << v;
+    }
+    encoder().unsigned_int(os, v);
+    return os;
+}
+
+/**
+ * \brief Write signed integer, in decimal regardless of stream flags except
+ * in text.
+ *
+ * \param os Output stream.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_int(std::ostream& os, int64_t v) noexcept {
+    if (is_text(os)) {
+        return os << v;
+    }
+    encoder().signed_int(os, v);
+    return os;
+}
+
+/**
+ * \brief Write floating point number. Not a number and infinities are
+ * written as null in JSON.
+ *
+ * \param os     Output stream.
+ * \param v      Value.
+ * \param single \c true to write as single precision in CBOR.
+ * \return Output stream.
+ */
+inline std::ostream& encode_float(
+    std::ostream& os, double v, bool single = false) noexcept {
+    if (is_text(os)) {
+        return os << v;
+    }
+    encoder().floating(os, v, single);
+    return os;
+}
+
+/**
+ * \brief Write value as text, using its operator<<.
+ *
+ * \tparam T Value type.
+ * \param os    Output stream.
+ * \param value Value of type \p T.
+ */
+template<class T>
+void write_text(std::ostream& os, const void* value) {
+    os << *static_cast<T*>(const_cast<void*>(value));
+}
+
+/**
+ * \brief Write value as string, using its operator<<.
+ *
+ * \tparam T Value type.
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+std::ostream& encode_as_string(std::ostream& os, T& v) noexcept {
+    encoder().text(os, &write_text<T>, &v);
+    return os;
+}
+
+/**
+ * \brief Write bool.
+ *
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_scalar(std::ostream& os, bool v) noexcept {
+    return encode_bool(os, v);
+}
+
+/**
+ * \brief Write character as string of one character.
+ *
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_scalar(std::ostream& os, char v) noexcept {
+    return encode_string(os, &v, 1);
+}
+
+/**
+ * \brief Write character as string of one character.
+ *
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_scalar(std::ostream& os, signed char v) noexcept {
+    return encode_scalar(os, static_cast<char>(v));
+}
+
+/**
+ * \brief Write character as string of one character.
+ *
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+inline std::ostream& encode_scalar(
+    std::ostream& os, unsigned char v) noexcept {
+    return encode_scalar(os, static_cast<char>(v));
+}
+
+/**
+ * \brief Write signed integer.
+ *
+ * \tparam T Value type.
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+typename std::enable_if<
+    std::is_integral<T>::value && std::is_signed<T>::value,
+    std::ostream&>::type
+encode_scalar(std::ostream& os, T v) noexcept {
+    return encode_int(os, static_cast<int64_t>(v));
+}
+
+/**
+ * \brief Write unsigned integer.
+ *
+ * \tparam T Value type.
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+typename std::enable_if<
+    std::is_integral<T>::value && std::is_unsigned<T>::value,
+    std::ostream&>::type
+encode_scalar(std::ostream& os, T v) noexcept {
+    return encode_uint(os, static_cast<uint64_t>(v));
+}
+
+/**
+ * \brief Write floating point number.
+ *
+ * \tparam T Value type.
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, std::ostream&>::type
+encode_scalar(std::ostream& os, T v) noexcept {
+    return encode_float(os, static_cast<double>(v), sizeof(T) <= 4);
+}
+
+/**
+ * \brief Write other value, e.g. a class or pointer, as string using its
+ * operator<<.
+ *
+ * \tparam T Value type.
+ * \param os Output stream, not text.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+typename std::enable_if<!std::is_arithmetic<T>::value, std::ostream&>::type
+encode_scalar(std::ostream& os, T& v) noexcept {
+    return encode_as_string(os, v);
+}
+
+/**
+ * \brief Write pointer. Null in JSON and CBOR if \c nullptr, else the
+ * address as string.
+ *
+ * \tparam U Pointed to type.
+ * \param os Output stream.
+ * \param p  Pointer.
+ * \return Output stream.
+ */
+template<class U>
+std::ostream& encode_pointer(std::ostream& os, U* p) noexcept {
+    if (is_text(os)) {
+        return os << p;
+    }
+    const void* v = p;
+    return v == nullptr ? encode_null(os) : encode_as_string(os, v);
+}
+
+/**
+ * \brief Write quotient and remainder as map.
+ *
+ * \param os   Output stream, not text.
+ * \param quot Quotient.
+ * \param rem  Remainder.
+ * \return Output stream.
+ */
+inline std::ostream& encode_quot_rem(
+    std::ostream& os, long long quot, long long rem) noexcept {
+    begin_map(os);
+    encode_key(os, "quot");
+    encode_int(os, quot) << separator;
+    encode_key(os, "rem");
+    encode_int(os, rem);
+    return end_map(os);
+}
+
+/**
+ * \brief Check if type is written as a string in JSON.
+ *
+ * \tparam T Type.
+ */
+template<class T>
+struct is_string_like : std::false_type {};
+template<>
+struct is_string_like<std::string> : std::true_type {};
+template<>
+struct is_string_like<std::wstring> : std::true_type {};
+template<>
+struct is_string_like<std::u16string> : std::true_type {};
+template<>
+struct is_string_like<std::u32string> : std::true_type {};
+template<>
+struct is_string_like<char*> : std::true_type {};
+template<>
+struct is_string_like<const char*> : std::true_type {};
+template<>
+struct is_string_like<char> : std::true_type {};
+
+/**
+ * \brief Check if stream is the capture stream of l().
+ *
+ * \return \c true if capture stream.
+ */
+inline bool is_capture(std::ostream&) noexcept {
+    return message_format() == kCaptureFormat;
+}
+
+/**
+ * \brief Kind of captured column.
+ */
+enum class capture_kind : uint8_t {
+    SIGNED,   /**< Signed integer. */
+    UNSIGNED, /**< Unsigned integer or bool. */
+    FLOAT     /**< Floating point number, stored as double. */
+};
+
+/**
+ * \brief Captured value.
+ */
+struct CaptureValue {
+    const char*  name; /**< Name. */
+    capture_kind kind; /**< Kind. */
+    uint64_t     bits; /**< Value, as in CaptureColumn::append() of
+                            goinglogging/capture.h. */
+};
+
+/**
+ * \brief Check if type is captured as a number. Characters are not.
+ *
+ * \tparam T Type, without const and volatile.
+ */
+template<class T>
+struct is_capturable
+    : std::integral_constant<bool,
+          std::is_arithmetic<T>::value && !std::is_same<T, char>::value &&
+              !std::is_same<T, wchar_t>::value &&
+              !std::is_same<T, char16_t>::value &&
+              !std::is_same<T, char32_t>::value> {};
+
+/**
+ * \brief Convert floating point number to captured value.
+ *
+ * \tparam T Value type.
+ * \param v Value.
+ * \return Captured value.
+ */
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, CaptureValue>::type
+to_capture_value(T v) noexcept {
+    double   d    = static_cast<double>(v);
+    uint64_t bits = 0;
+    std::memcpy(&bits, &d, sizeof(d));
+    return CaptureValue{nullptr, capture_kind::FLOAT, bits};
+}
+
+/**
+ * \brief Convert integer to captured value.
+ *
+ * \tparam T Value type.
+ * \param v Value.
+ * \return Captured value.
+ */
+template<class T>
+typename std::enable_if<std::is_integral<T>::value, CaptureValue>::type
+to_capture_value(T v) noexcept {
+    return std::is_signed<T>::value ?
+               CaptureValue{nullptr, capture_kind::SIGNED,
+                   static_cast<uint64_t>(static_cast<int64_t>(v))} :
+               CaptureValue{nullptr, capture_kind::UNSIGNED,
+                   static_cast<uint64_t>(v)};
+}
+
+/**
+ * \brief Receiver of the numbers of l() while capture is enabled, instead of
+ * output. Defined in goinglogging/capture.h, and set by
+ * gl::set_capture_enabled() there, so that only programs which capture
+ * include the columns and their compression.
+ */
+class CaptureSink {
+  public:
+    /**
+     * \brief Destructor.
+     */
+    virtual ~CaptureSink() = default;
+
+    /**
+     * \return Stream which l() writes to while capturing, of this thread.
+     * Writes nothing.
+     */
+    virtual std::ostream& stream() noexcept = 0;
+
+    /**
+     * \brief Start record of this thread and take timestamp.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    virtual void begin(
+        const char* file_path, long file_line, const char* func) noexcept = 0;
+
+    /**
+     * \brief Add number to record of this thread.
+     *
+     * \param v Value.
+     */
+    virtual void add(const CaptureValue& v) noexcept = 0;
+
+    /**
+     * \brief Append record of this thread to its call site.
+     */
+    virtual void commit() = 0;
+};
+
+/**
+ * \return Sink of captured records, \c nullptr until set by
+ * gl::set_capture_enabled().
+ */
+inline std::atomic<CaptureSink*>& capture_sink() noexcept {
+    static std::atomic<CaptureSink*> sink(nullptr);
+    return sink;
+}
+
+/**
+ * \brief Add variable to the captured record, as it is a number.
+ *
+ * \tparam T Value type.
+ * \param name Name.
+ * \param v    Value.
+ */
+template<class T>
+typename std::enable_if<
+    is_capturable<typename std::remove_cv<T>::type>::value>::type
+capture_variable(const char* name, T& v) noexcept {
+    CaptureValue c = to_capture_value(v);
+    c.name         = name;
+    capture_sink().load(std::memory_order_relaxed)->add(c);
+}
+
+/**
+ * \brief Skip variable which is not a number.
+ *
+ * \tparam T Value type.
+ */
+template<class T>
+typename std::enable_if<
+    !is_capturable<typename std::remove_cv<T>::type>::value>::type
+capture_variable(const char*, T&) noexcept {
+}
+
+/**
+ * \brief Output of static prefix to a fixed buffer.
+ */
+class PrefixBuffer {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param buf Buffer [\p cap].
+     * \param cap Capacity.
+     */
+    PrefixBuffer(char* buf, size_t cap) noexcept :
+        m_buf(buf), m_cap(cap), m_len(0), m_overflow(false) {
+    }
+
+    PrefixBuffer(const PrefixBuffer&) = delete;
+    PrefixBuffer& operator=(const PrefixBuffer&) = delete;
+
+    /**
+     * \brief Append characters, unless they do not fit.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     */
+    void append(const char* s, size_t n) noexcept {
+        if (n > m_cap - m_len) {
+            m_overflow = true;
+            return;
+        }
+        std::memcpy(m_buf + m_len, s, n);
+        m_len += n;
+    }
+
+    /**
+     * \return Number of characters.
+     */
+    size_t size() const noexcept {
+        return m_len;
+    }
+
+    /**
+     * \return \c true if some characters did not fit.
+     */
+    bool overflow() const noexcept {
+        return m_overflow;
+    }
+
+  private:
+    char*  m_buf;      /**< Buffer. */
+    size_t m_cap;      /**< Capacity. */
+    size_t m_len;      /**< Number of characters. */
+    bool   m_overflow; /**< \c true if some characters did not fit. */
+};
+
+/**
+ * \brief Output of static prefix directly to a stream.
+ */
+class PrefixStream {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param os Output stream.
+     */
+    explicit PrefixStream(std::ostream& os) noexcept : m_os(os) {
+    }
+
+    PrefixStream(const PrefixStream&) = delete;
+    PrefixStream& operator=(const PrefixStream&) = delete;
+
+    /**
+     * \brief Append characters.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     */
+    void append(const char* s, size_t n) {
+        m_os.write(s, static_cast<std::streamsize>(n));
+    }
+
+  private:
+    std::ostream& m_os; /**< Output stream. */
+};
+
+/**
+ * \brief Get file name from file path.
+ *
+ * \param path File path including name.
+ * \return File name, without directories.
+ */
+inline const char* file_name(const char* path) noexcept {
+    /** Platform dependent path separator */
+    const char sep =
+#ifdef _WIN32
+        '\\';
+#else
+        '/';
+#endif // _WIN32
+
+    // Get index of last file path separator
+    /** Length of string */
+    size_t str_len = std::strlen(path);
+    /** File path separator index */
+    size_t sep_idx = static_cast<size_t>(-1);
+    // No need to check for str_len = 0 here, since that
+    // will stop the for loop anyway
+    for (size_t i = str_len - 1; i != static_cast<size_t>(-1); --i) {
+        if (path[i] == sep) {
+            sep_idx = i;
+            break;
+        }
+    }
+
+    return sep_idx == static_cast<size_t>(-1) ? path : path + sep_idx + 1;
+}
+
+/**
+ * \brief Format current local time as "HH:MM:SS.mmm".
+ *
+ * \param buf Buffer of at least 16 bytes.
+ * \return Length of formatted time, or 0 if it is unknown.
+ */
+inline size_t format_time(char* buf) noexcept {
+    timespec ts;
+    if (timespec_get(&ts, TIME_UTC) == 0) {
+        return 0;
+    }
+    std::time_t sinceEpoch = ts.tv_sec;
+    std::tm*    local      = std::localtime(&sinceEpoch);
+    size_t      n =
+        local == nullptr ? 0 : std::strftime(buf, 16, "%H:%M:%S", local);
+    if (n != 0) {
+        n += static_cast<size_t>(std::snprintf(
+            buf + n, 16 - n, ".%03d", static_cast<int>(ts.tv_nsec / 1000000)));
+    }
+    return n;
+}
+
+/**
+ * \return Identifier of current thread, written like std::thread::id.
+ */
+#ifdef _WIN32
+inline std::thread::id thread_id() noexcept {
+    return std::this_thread::get_id();
+}
+#else
+inline pthread_t thread_id() noexcept {
+    return pthread_self();
+}
+#endif // _WIN32
+
+/**
+ * \brief Write the parts of a text prefix which never change for a call
+ * site: color start, FILE, LINE and FUNCTION. Ends with ": " if there are no
+ * TIME or THREAD parts to follow.
+ *
+ * \tparam Out PrefixBuffer or PrefixStream.
+ * \param out       Output.
+ * \param file_path File path including name.
+ * \param file_line Line number in file.
+ * \param func      Function name.
+ * \param cur       Prefixes.
+ * \param color     \c true if color is enabled.
+ * \return \c true if any of FILE, LINE and FUNCTION was written.
+ */
+template<class Out>
+bool write_static_prefix(Out& out, const char* file_path, long file_line,
+    const char* func, prefix cur, bool color) {
+    /** Number of prefixes written */
+    uint32_t cnt = 0;
+    if (color) {
+        // Red
+        out.append("\033[0;31m", 7);
+    }
+
+    // FILE
+    if ((cur & prefix::FILE) != prefix::NONE) {
+        const char* name = file_name(file_path);
+        out.append(name, std::strlen(name));
+        ++cnt;
+    }
+
+    // LINE
+    if ((cur & prefix::LINE) != prefix::NONE) {
+        // Output 'Line' prefix only if file name has not been
+        // output
+        if (cnt == 0) {
+            out.append("Line: ", 6);
+        } else {
+            out.append(":", 1);
+        }
+        char buf[24];
+        int  n = std::snprintf(buf, sizeof(buf), "%ld", file_line);
+        out.append(buf, static_cast<size_t>(n));
+        ++cnt;
+    }
+
+    // FUNCTION
+    if ((cur & prefix::FUNCTION) != prefix::NONE) {
+        if (cnt != 0) {
+            out.append(", ", 2);
+        }
+        out.append(func, std::strlen(func));
+        out.append("()", 2);
+        ++cnt;
+    }
+
+    // Final separator, if nothing follows
+    if (cnt != 0 && (cur & (prefix::TIME | prefix::THREAD)) == prefix::NONE) {
+        out.append(": ", 2);
+    }
+    return cnt != 0;
+}
+
+/**
+ * \brief Write the parts of a text prefix which change for every message:
+ * TIME and THREAD, followed by ": ".
+ *
+ * \param os          Output stream.
+ * \param cur         Prefixes.
+ * \param has_static  \c true if any of FILE, LINE and FUNCTION was written.
+ * \return Output stream.
+ */
+inline std::ostream& write_dynamic_prefix(
+    std::ostream& os, prefix cur, bool has_static) {
+    /** Number of prefixes written */
+    uint32_t cnt = has_static ? 1 : 0;
+
+    // TIME
+    if ((cur & prefix::TIME) != prefix::NONE) {
+        char buf[16];
+        if (format_time(buf) != 0) {
+            if (cnt != 0) {
+                os << ", ";
+            }
+            os << buf;
+            ++cnt;
+        }
+    }
+
+    // THREAD
+    if ((cur & prefix::THREAD) != prefix::NONE) {
+        if (cnt != 0) {
+            os << ", ";
+        }
+        os << "TID: " << thread_id();
+        ++cnt;
+    }
+
+    // Final separator, if any
+    if (cnt != 0) {
+        os << ": ";
+    }
+
+    return os;
+}
+
+/**
+ * \brief Rendered static text prefix of one call site, valid for one
+ * generation of the prefix and color settings.
+ *
+ * Guarded by a sequence lock: the sequence is twice the generation when
+ * valid, and odd while being rendered. The text is kept in atomic words, so
+ * that concurrent reads and renders are well defined. Has a constexpr
+ * constructor, so that it can be part of a static LogSite.
+ */
+class PrefixCache {
+  public:
+    /** Bytes of text that can be cached. Longer prefixes are not cached. */
+    static const size_t kBytes = 128;
+
+    /**
+     * \brief Constructor.
+     */
+    constexpr PrefixCache() noexcept : m_seq(0), m_info(0), m_words{} {
+    }
+
+    PrefixCache(const PrefixCache&) = delete;
+    PrefixCache& operator=(const PrefixCache&) = delete;
+
+    /**
+     * \brief Write text prefix, from the cache if valid and otherwise
+     * rendered and cached.
+     *
+     * \param os        Output stream.
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \return Output stream.
+     */
+    std::ostream& write(std::ostream& os, const char* file_path,
+        long file_line, const char* func) {
+        uint32_t gen = prefixGeneration.load(std::memory_order_acquire);
+        uint32_t seq = m_seq.load(std::memory_order_acquire);
+        if (seq == 2 * gen) {
+            // Read, and check that it was not rendered meanwhile
+            char     buf[kBytes];
+            uint32_t info = m_info.load(std::memory_order_relaxed);
+            size_t   len  = info & kLengthMask;
+            for (size_t i = 0; i < (len + 7) / 8; ++i) {
+                uint64_t w = m_words[i].load(std::memory_order_relaxed);
+                std::memcpy(buf + 8 * i, &w, 8);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == seq &&
+                (info & kTooLong) == 0) {
+                if (len != 0) {
+                    os.write(buf, static_cast<std::streamsize>(len));
+                }
+                return write_dynamic(os, info);
+            }
+        }
+        return render(os, gen, seq, file_path, file_line, func);
+    }
+
+  private:
+    /** Bits of info which hold the length of the text. */
+    static const uint32_t kLengthMask = 0xFF;
+    /** Info bit set if any of FILE, LINE and FUNCTION is in the text. */
+    static const uint32_t kHasStatic = 1 << 8;
+    /** Info bit set if the text did not fit. */
+    static const uint32_t kTooLong = 1 << 9;
+    /** Info bits which hold the prefixes, at and above this bit. */
+    static const uint32_t kPrefixShift = 16;
+
+    /**
+     * \brief Write TIME and THREAD.
+     *
+     * \param os   Output stream.
+     * \param info Info of cached text.
+     * \return Output stream.
+     */
+    static std::ostream& write_dynamic(std::ostream& os, uint32_t info) {
+        prefix cur = static_cast<prefix>(info >> kPrefixShift);
+        if ((cur & (prefix::TIME | prefix::THREAD)) == prefix::NONE) {
+            return os;
+        }
+        return write_dynamic_prefix(os, cur, (info & kHasStatic) != 0);
+    }
+
+    /**
+     * \brief Render text prefix and write it. Cache it, unless another
+     * thread renders it meanwhile.
+     *
+     * \param os        Output stream.
+     * \param gen       Generation of settings.
+     * \param seq       Sequence which was read.
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \return Output stream.
+     */
+    std::ostream& render(std::ostream& os, uint32_t gen, uint32_t seq,
+        const char* file_path, long file_line, const char* func) {
+        const prefix cur   = curPrefixes.load(std::memory_order_relaxed);
+        const bool   color = colorEnabled.load(std::memory_order_relaxed);
+        char         buf[kBytes];
+        PrefixBuffer out(buf, sizeof(buf));
+        bool has_static =
+            write_static_prefix(out, file_path, file_line, func, cur, color);
+        uint32_t info = static_cast<uint32_t>(out.size()) |
+                        (has_static ? kHasStatic : 0) |
+                        (out.overflow() ? kTooLong : 0) |
+                        static_cast<uint32_t>(cur) << kPrefixShift;
+        if ((seq & 1) == 0 && m_seq.compare_exchange_strong(seq, 2 * gen - 1,
+                                  std::memory_order_relaxed)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            m_info.store(info, std::memory_order_relaxed);
+            for (size_t i = 0; i < (out.size() + 7) / 8; ++i) {
+                uint64_t w = 0;
+                size_t left = out.size() - 8 * i;
+                std::memcpy(&w, buf + 8 * i, left < 8 ? left : 8);
+                m_words[i].store(w, std::memory_order_relaxed);
+            }
+            m_seq.store(2 * gen, std::memory_order_release);
+        }
+        if (out.overflow()) {
+            PrefixStream direct(os);
+            write_static_prefix(
+                direct, file_path, file_line, func, cur, color);
+        } else {
+            os.write(buf, static_cast<std::streamsize>(out.size()));
+        }
+        return write_dynamic(os, info);
+    }
+
+    std::atomic<uint32_t> m_seq;  /**< Sequence, twice the generation. */
+    std::atomic<uint32_t> m_info; /**< Length, flags and prefixes. */
+    std::atomic<uint64_t> m_words[kBytes / 8]; /**< Text. */
+};
+
+/**
+ * \brief Call site of the message which a thread is writing, for stream
+ * buffers which attribute lines to call sites.
+ */
+struct MessageSite {
+    const char* file_path; /**< File path, or \c nullptr if none. */
+    long        file_line; /**< Line number in file. */
+    const char* func;      /**< Function name. */
+};
+
+/**
+ * \return Call site of the message which this thread is writing. Set when
+ * its prefix is written, and cleared by whoever consumes it.
+ */
+inline MessageSite& message_site() noexcept {
+    static thread_local MessageSite site = {nullptr, 0, nullptr};
+    return site;
+}
+
+/**
+ * \brief Prefix formatter. */
+class PrefixFormatter {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \param cache     Cache of rendered prefix of call site, if any.
+     *
+     */
+    PrefixFormatter(const char* file_path, long file_line, const char* func,
+        PrefixCache* cache = nullptr) noexcept :
+        m_file_path(file_path),
+        m_file_line(file_line), m_func(func), m_cache(cache) {
+    }
+
+    friend std::ostream& operator<<(
+        std::ostream& os, const PrefixFormatter& p) noexcept;
+
+    /**
+     * \return File path including name.
+     */
+    const char* get_file_path() const noexcept {
+        return m_file_path;
+    }
+
+    /**
+     * \return Line number in file.
+     */
+    long get_file_line_number() const noexcept {
+        return m_file_line;
+    }
+
+    /**
+     * \return Function name.
+     */
+    const char* get_function_name() const noexcept {
+        return m_func;
+    }
+
+    /**
+     * \return Cache of rendered prefix of call site, or \c nullptr.
+     */
+    PrefixCache* get_cache() const noexcept {
+        return m_cache;
+    }
+
+  private:
+    const char*  m_file_path; /**< File path including name. */
+    const long   m_file_line; /**< Line number in file. */
+    const char*  m_func;      /**< Function name. */
+    PrefixCache* m_cache;     /**< Cache of rendered prefix, or nullptr. */
+};
+
+/**
+ * \brief Write prefixes as fields of a JSON or CBOR message, followed by the
+ * key of the values and start of their map.
+ *
+ * \param os  Output stream, not text.
+ * \param p   PrefixFormatter to output.
+ * \param cur Prefixes to write.
+ * \return Output stream.
+ *
+ */
+inline std::ostream& encode_prefixes(
+    std::ostream& os, const PrefixFormatter& p, prefix cur) noexcept {
+    if ((cur & prefix::FILE) != prefix::NONE) {
+        encode_key(os, "file");
+        encode_string(os, file_name(p.get_file_path())) << separator;
+    }
+    if ((cur & prefix::LINE) != prefix::NONE) {
+        encode_key(os, "line");
+        encode_int(os, p.get_file_line_number()) << separator;
+    }
+    if ((cur & prefix::FUNCTION) != prefix::NONE) {
+        encode_key(os, "function");
+        encode_string(os, p.get_function_name()) << separator;
+    }
+    if ((cur & prefix::TIME) != prefix::NONE) {
+        char buf[16];
+        if (format_time(buf) != 0) {
+            encode_key(os, "time");
+            encode_string(os, buf) << separator;
+        }
+    }
+    if ((cur & prefix::THREAD) != prefix::NONE) {
+        auto id = thread_id();
+        encode_key(os, "thread");
+        encode_as_string(os, id) << separator;
+    }
+    encode_key(os, "values");
+    return begin_map(os);
+}
+
+/**
+ * \brief Write to stream.
+ *
+ * \param os Output stream.
+ * \param p  PrefixFormatter to output.
+ * \return Output stream.
+ *
+ */
+inline std::ostream& operator<<(
+    std::ostream& os, const PrefixFormatter& p) noexcept {
+    MessageSite& site = message_site();
+    site.file_path    = p.get_file_path();
+    site.file_line    = p.get_file_line_number();
+    site.func         = p.get_function_name();
+    if (is_capture(os)) {
+        capture_sink().load(std::memory_order_relaxed)->begin(
+            p.get_file_path(), p.get_file_line_number(),
+            p.get_function_name());
+        return os;
+    }
+    if (!is_text(os)) {
+        return encode_prefixes(
+            os, p, curPrefixes.load(std::memory_order_relaxed));
+    }
+    if (p.get_cache() != nullptr) {
+        return p.get_cache()->write(os, p.get_file_path(),
+            p.get_file_line_number(), p.get_function_name());
+    }
+
+    /** Prefixes to write */
+    const prefix cur = curPrefixes.load(std::memory_order_relaxed);
+    PrefixStream out(os);
+    bool         has_static = write_static_prefix(out, p.get_file_path(),
+        p.get_file_line_number(), p.get_function_name(), cur,
+        colorEnabled.load(std::memory_order_relaxed));
+    if ((cur & (prefix::TIME | prefix::THREAD)) == prefix::NONE) {
+        return os;
+    }
+    return write_dynamic_prefix(os, cur, has_static);
+}
+
+/**
+ * \brief Variable value formatter.
+ *
+ * \tparam T Value type.
+ *
+ */
+template<class T>
+class ValueFormatter {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param val Value.
+     *
+     */
+    explicit ValueFormatter(T& val) noexcept : m_val(val) {
+    }
+
+    // Container value helper functions.
+    std::ostream& sequence(std::ostream& os) const noexcept;
+    std::ostream& map(std::ostream& os) const noexcept;
+
+    template<class U>
+    friend std::ostream& operator<<(
+        std::ostream& os, const ValueFormatter<U>& f) noexcept;
+
+    /**
+     * \return Value to format.
+     */
+    T& get_value() const {
+        return m_val;
+    }
+
+  private:
+    T& m_val; /**< Value to format. Use non-const reference in case operator<<
+                 isn't const. */
+};
+
+/**
+ * \brief Create ValueFormatter with the right template type.
+ *  This solves the error "cannot refer to class template
+ * 'ValueFormatter' without a template argument list".
+ *
+ * \tparam T Value type.
+ * \param val Value.
+ * \return New ValueFormatter.
+ */
+template<class T>
+ValueFormatter<T> format_value(T& val) {
+    return ValueFormatter<T>(val);
+};
+
+/**
+ * \brief Write value with its formatter, in the format of the message.
+ *
+ * \tparam T Value type.
+ * \param os    Output stream.
+ * \param value Value of type \p T.
+ */
+template<class T>
+void write_value(std::ostream& os, const void* value) {
+    os << format_value(*static_cast<T*>(const_cast<void*>(value)));
+}
+
+/**
+ * \brief Write key of map element, followed by ": " in text. JSON keys which
+ * are not strings are written as strings of their text.
+ *
+ * \tparam K Key type.
+ * \param os  Output stream.
+ * \param key Key.
+ * \return Output stream.
+ */
+template<class K>
+std::ostream& encode_map_key(std::ostream& os, K& key) noexcept {
+    switch (stream_format(os)) {
+        case format::TEXT: return os << format_value(key) << ": ";
+        case format::JSON:
+            if (is_string_like<typename std::remove_cv<K>::type>::value) {
+                os << format_value(key);
+            } else {
+                encoder().text(os, &write_value<K>, &key);
+            }
+            return os << ':';
+        case format::CBOR: return os << format_value(key);
+    }
+    return os;
+}
+
+/**
+ * \brief Write a sequence, defined by begin() and end(), to stream.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \return Output stream.
+ *
+ */
+template<class T>
+std::ostream& ValueFormatter<T>::sequence(std::ostream& os) const noexcept {
+    // Unqualified, to also find begin() and end() of containers declared
+    // after this, such as std::valarray
+    using std::begin;
+    using std::end;
+    begin_array(os);
+    // Print first object without comma
+    auto it = begin(m_val);
+    if (it != end(m_val)) {
+        os << format_value(*it);
+        ++it;
+    }
+    // Print the rest
+    for (; it != end(m_val); ++it) {
+        os << separator << format_value(*it);
+    }
+    end_array(os);
+
+    return os;
+}
+
+/**
+ * \brief Write a map, defined by begin() and end(), to stream.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \return Output stream.
+ *
+ */
+template<class T>
+std::ostream& ValueFormatter<T>::map(std::ostream& os) const noexcept {
+    begin_map(os);
+    // Print first object without comma
+    auto it = m_val.begin();
+    if (it != m_val.end()) {
+        encode_map_key(os, it->first) << format_value(it->second);
+        ++it;
+    }
+    // Print the rest
+    for (; it != m_val.end(); ++it) {
+        os << separator;
+        encode_map_key(os, it->first) << format_value(it->second);
+    }
+    end_map(os);
+
+    return os;
+}
+
+/**
+ * \brief Writer of the fields of a type declared with \ref GL_REFLECT.
+ */
+class FieldWriter {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param os Output stream.
+     */
+    explicit FieldWriter(std::ostream& os) noexcept : m_os(os), m_first(true) {
+    }
+
+    /**
+     * \brief Write field name and value. "name = value" in text.
+     *
+     * \tparam F Field type.
+     * \param name Characters of field name [\p n].
+     * \param n    Number of characters, known at compile time.
+     * \param v    Field value.
+     */
+    template<class F>
+    void operator()(const char* name, size_t n, F& v) noexcept {
+        if (!m_first) {
+            m_os << separator;
+        }
+        m_first = false;
+        if (is_text(m_os)) {
+            m_os.write(name, static_cast<std::streamsize>(n)) << " = ";
+        } else {
+            encode_key(m_os, name, n);
+        }
+        m_os << format_value(v);
+    }
+
+  private:
+    std::ostream& m_os;    /**< Output stream. */
+    bool          m_first; /**< \c true until the first field is written. */
+};
+
+/**
+ * \brief Check if type is declared with \ref GL_REFLECT, which is found by
+ * argument dependent lookup in the namespace of the type.
+ *
+ * \tparam T Type.
+ */
+template<class T>
+class is_reflected {
+    template<class U>
+    static auto test(U* u) -> decltype(
+        gl_reflect_fields(std::declval<FieldWriter&>(), *u), std::true_type());
+
+    template<class U>
+    static std::false_type test(...);
+
+  public:
+    /** \c true if reflected. */
+    static const bool value =
+        decltype(test<typename std::remove_cv<T>::type>(nullptr))::value;
+};
+
+/**
+ * \brief Write value with its stream insertion operator in text, and as a
+ * scalar in JSON and CBOR.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+std::ostream& encode_general(
+    std::ostream& os, T& v, std::false_type /* reflected */) noexcept {
+    if (is_text(os)) {
+        return os << v;
+    }
+    return encode_scalar(os, v);
+}
+
+/**
+ * \brief Write fields of value declared with \ref GL_REFLECT.
+ * "{name = value, ...}" in text, and a map in JSON and CBOR.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \param v  Value.
+ * \return Output stream.
+ */
+template<class T>
+std::ostream& encode_general(
+    std::ostream& os, T& v, std::true_type /* reflected */) noexcept {
+    // Fields of const values are formatted as non-const, since formatters
+    // of containers only take non-const values, and do not modify them
+    FieldWriter writer(os);
+    begin_map(os);
+    gl_reflect_fields(
+        writer, const_cast<typename std::remove_cv<T>::type&>(v));
+    return end_map(os);
+}
+
+/**
+ * \brief General value formatter.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class T>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<T>& f) noexcept {
+    return encode_general(os, f.m_val,
+        std::integral_constant<bool, is_reflected<T>::value>());
+}
+
+/**
+ * \brief Format bool.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<bool>& f) noexcept {
+    return encode_bool(os, f.m_val);
+}
+
+// 3.9.1 in C++ standard: Plain char, signed char, and unsigned
+// char are three distinct types
+
+/**
+ * \brief Format char.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<char>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_scalar(os, f.m_val);
+    }
+    return os << '\'' << f.m_val << '\'';
+}
+
+/**
+ * \brief Format unsigned char.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<unsigned char>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_scalar(os, f.m_val);
+    }
+    return os << '\'' << f.m_val << '\'';
+}
+
+/**
+ * \brief Format signed char.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<signed char>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_scalar(os, f.m_val);
+    }
+    return os << '\'' << f.m_val << '\'';
+}
+
+/**
+ * \brief Format char*.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<char*>& f) noexcept {
+    if (f.m_val == nullptr) {
+        return is_text(os) ? os << "nullptr" : encode_null(os);
+    }
+    return encode_value_string(os, f.m_val);
+}
+
+/**
+ * \brief Format const char*.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<const char*>& f) noexcept {
+    if (f.m_val == nullptr) {
+        return is_text(os) ? os << "nullptr" : encode_null(os);
+    }
+    return encode_value_string(os, f.m_val);
+}
+
+/**
+ * \brief Format char* const, such as keys of maps.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<char* const>& f) noexcept {
+    if (f.m_val == nullptr) {
+        return is_text(os) ? os << "nullptr" : encode_null(os);
+    }
+    return encode_value_string(os, f.m_val);
+}
+
+/**
+ * \brief Format const char* const, such as keys of maps.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<const char* const>& f) noexcept {
+    if (f.m_val == nullptr) {
+        return is_text(os) ? os << "nullptr" : encode_null(os);
+    }
+    return encode_value_string(os, f.m_val);
+}
+
+/**
+ * \brief Format std::tm.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::tm>& f) noexcept {
+    // Format as "YYYY-MM-DD HH:MM:SS", including null pointer
+    char buf[20];
+    if (std::strftime(buf, sizeof(buf), "%F %T", &f.m_val) == 0) {
+        if (!is_text(os)) {
+            return encode_null(os);
+        }
+        os << "std::tm format error";
+    } else if (!is_text(os)) {
+        encode_string(os, buf);
+    } else {
+        os << buf;
+    }
+    return os;
+}
+
+/**
+ * \brief Format std::div_t.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::div_t>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_quot_rem(os, f.m_val.quot, f.m_val.rem);
+    }
+    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
+}
+
+/**
+ * \brief Format std::ldiv_t.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::ldiv_t>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_quot_rem(os, f.m_val.quot, f.m_val.rem);
+    }
+    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
+}
+
+/**
+ * \brief Format std::lldiv_t.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::lldiv_t>& f) noexcept {
+    if (!is_text(os)) {
+        return encode_quot_rem(os, f.m_val.quot, f.m_val.rem);
+    }
+    return os << "{quot = " << f.m_val.quot << ", rem = " << f.m_val.rem << '}';
+}
+
+/**
+ * \brief Format std::string.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::string>& f) noexcept {
+    return encode_value_string(os, f.m_val.data(), f.m_val.size());
+}
+
+/**
+ * \brief Write ANSI color end code to stream, if color is enabled.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ *
+ */
+inline std::ostream& color_end(std::ostream& os) noexcept {
+    if (colorEnabled.load(std::memory_order_relaxed)) {
+        os << "\033[0m";
+    }
+    return os;
+}
+
+/**
+ * \brief Get name of type.
+ *
+ * \tparam T Type.
+ * \return Demangled name, if supported.
+ */
+template<class T>
+const char* get_type_name() {
+    const char* tn = typeid(T).name();
+#ifndef __GNUC__
+    return tn;
+#else
+    return demangler.demangle(tn);
+#endif // __GNUC__
+}
+
+/**
+ * \return \c true if type names shall be written.
+ */
+inline bool is_type_name_enabled() noexcept {
+    return (curPrefixes.load(std::memory_order_relaxed) & prefix::TYPE_NAME) ==
+           prefix::TYPE_NAME;
+}
+
+/**
+ * \brief Variable type formatter.
+ *
+ * \tparam T Variable type.
+ * \param os Output stream.
+ * \return Output stream.
+ */
+template<class T>
+std::ostream& type_name(std::ostream& os) {
+    if (is_type_name_enabled()) {
+        os << get_type_name<T>() << ' ';
+    }
+    return os;
+}
+
+/**
+ * \brief Start message in the current format. Start of map in JSON and CBOR.
+ * Always followed by a PrefixFormatter, which starts the color in text.
+ *
+ * The format is loaded once per message, so that the message is written in
+ * one format even if the format is changed concurrently.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+inline std::ostream& message_start(std::ostream& os) noexcept {
+    format f          = curFormat.load(std::memory_order_acquire);
+    message_format() = static_cast<uint32_t>(f);
+    return f == format::TEXT ? os : begin_map(os);
+}
+
+/**
+ * \brief Start message of l(). Switch to the capture stream if capturing.
+ *
+ * \param os Output stream.
+ * \return Output stream, or capture stream.
+ */
+inline std::ostream& log_start(std::ostream& os) noexcept {
+    if (captureEnabled.load(std::memory_order_relaxed)) {
+        CaptureSink* sink = capture_sink().load(std::memory_order_acquire);
+        if (sink != nullptr) {
+            message_format() = kCaptureFormat;
+            return sink->stream();
+        }
+    }
+    return message_start(os);
+}
+
+/**
+ * \brief Stream after end of message. Writes the newline which follows, except
+ * in CBOR where messages are not separated.
+ */
+class MessageEndStream {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param os Output stream.
+     */
+    explicit MessageEndStream(std::ostream& os) noexcept : m_os(os) {
+    }
+
+    /**
+     * \brief Write newline, except in CBOR.
+     *
+     * \tparam T Newline type, e.g. char.
+     * \param nl Newline.
+     * \return Output stream.
+     */
+    template<class T>
+    std::ostream& operator<<(const T& nl) noexcept {
+        if (stream_format(m_os) != format::CBOR) {
+            m_os << nl;
+        }
+        return m_os;
+    }
+
+    /**
+     * \brief Apply newline manipulator, e.g. std::endl. Only flush in CBOR.
+     *
+     * \param nl Newline manipulator.
+     * \return Output stream.
+     */
+    std::ostream& operator<<(std::ostream& (*nl)(std::ostream&)) noexcept {
+        if (stream_format(m_os) != format::CBOR) {
+            return nl(m_os);
+        }
+        return m_os.flush();
+    }
+
+  private:
+    std::ostream& m_os; /**< Output stream. */
+};
+
+/**
+ * \brief End of message.
+ */
+struct MessageEnd {};
+
+/**
+ * \brief End message. Color end in text, and end of values and message maps
+ * in JSON and CBOR. Captured values are appended to their call site.
+ *
+ * \param os Output stream.
+ * \return Stream to write newline to.
+ */
+inline MessageEndStream operator<<(std::ostream& os, MessageEnd) {
+    if (is_capture(os)) {
+        capture_sink().load(std::memory_order_relaxed)->commit();
+    } else if (is_text(os)) {
+        color_end(os);
+    } else {
+        end_map(os);
+        end_map(os);
+        encoder().end_message(os);
+    }
+    return MessageEndStream(os);
+}
+
+/**
+ * \brief Start of variable in message. "name = " in text, with type name if
+ * enabled. In JSON and CBOR, a key, and the start of a map with the type
+ * name if enabled.
+ *
+ * \tparam T Variable type.
+ * \param os   Output stream.
+ * \param name Variable name.
+ * \return \c true if the variable shall be ended with end_variable().
+ */
+template<class T>
+bool begin_variable(std::ostream& os, const char* name) noexcept {
+    if (is_text(os)) {
+        os << type_name<T> << name << " = ";
+        return false;
+    }
+    encode_key(os, name);
+    if (!is_type_name_enabled()) {
+        return false;
+    }
+    begin_map(os);
+    encode_key(os, "type");
+    encode_string(os, get_type_name<T>()) << separator;
+    encode_key(os, "value");
+    return true;
+}
+
+/**
+ * \brief End of variable in message.
+ *
+ * \param os    Output stream.
+ * \param typed Return value of begin_variable().
+ */
+inline void end_variable(std::ostream& os, bool typed) noexcept {
+    if (typed) {
+        end_map(os);
+    }
+}
+
+/**
+ * \brief Variable of l().
+ *
+ * \tparam T Value type.
+ *
+ */
+template<class T>
+class Variable {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name Name.
+     * \param val  Value.
+     *
+     */
+    Variable(const char* name, T& val) noexcept : m_name(name), m_val(val) {
+    }
+
+    /**
+     * \return Name.
+     */
+    const char* get_name() const noexcept {
+        return m_name;
+    }
+
+    /**
+     * \return Value.
+     */
+    T& get_value() const noexcept {
+        return m_val;
+    }
+
+  private:
+    const char* m_name; /**< Name. */
+    T&          m_val;  /**< Value. */
+};
+
+/**
+ * \brief Write variable name and value to stream.
+ *
+ * \tparam T Value type.
+ * \param os Output stream.
+ * \param v  Variable.
+ * \return Output stream.
+ *
+ */
+template<class T>
+std::ostream& operator<<(std::ostream& os, const Variable<T>& v) noexcept {
+    if (is_capture(os)) {
+        capture_variable(v.get_name(), v.get_value());
+        return os;
+    }
+    bool typed = begin_variable<T>(os, v.get_name());
+    os << format_value(v.get_value());
+    end_variable(os, typed);
+    return os;
+}
+
+/**
+ * \brief Create Variable with the right template type.
+ *
+ * \tparam T Value type.
+ * \param name Name.
+ * \param val  Value.
+ * \return Variable.
+ */
+template<class T>
+Variable<T> make_variable(const char* name, T& val) noexcept {
+    return Variable<T>(name, val);
+}
+
+/**
+ * \brief Array.
+ *
+ * \tparam T Value type.
+ *
+ */
+template<class T>
+class Array {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name      Name.
+     * \param val       Values [\p len].
+     * \param len       Number of values.
+     * \param prefixFmt PrefixFormatter.
+     *
+     */
+    explicit Array(const char* name, T& val, size_t len,
+        const PrefixFormatter& prefixFmt) noexcept :
+        m_name(name),
+        m_val(val), m_len(len), m_prefixFmt(prefixFmt) {
+    }
+
+    template<class U>
+    friend std::ostream& operator<<(
+        std::ostream& os, const Array<U>& a) noexcept;
+
+    /**
+     * \return Name.
+     */
+    const char* get_name() const noexcept {
+        return m_name;
+    }
+
+    /**
+     * \return Values.
+     */
+    T& get_values() const noexcept {
+        return m_val;
+    }
+
+    /**
+     * \return Number of values.
+     */
+    size_t get_number_of_values() const noexcept {
+        return m_len;
+    }
+
+    /**
+     * \return PrefixFormatter.
+     */
+    const PrefixFormatter& get_prefix_formatter() const noexcept {
+        return m_prefixFmt;
+    }
+
+  private:
+    const char*            m_name;      /**< Name. */
+    T&                     m_val;       /**< Values. */
+    const size_t           m_len;       /**< Number of values. */
+    const PrefixFormatter& m_prefixFmt; /**< PrefixFormatter. */
+};
+
+/**
+ * \brief Write Array to stream.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param a  Array.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(std::ostream& os, const Array<U>& a) noexcept {
+    if (outputEnabled.load(std::memory_order_relaxed)) {
+        os << message_start << a.get_prefix_formatter();
+        bool typed = begin_variable<U>(os, a.get_name());
+        begin_array(os);
+        // Print first object without comma
+        if (a.get_number_of_values() > 0) {
+            os << format_value(a.get_values()[0]);
+        }
+        // Print the rest
+        for (size_t i = 1; i < a.get_number_of_values(); ++i) {
+            os << separator << format_value(a.get_values()[i]);
+        }
+        end_array(os);
+        end_variable(os, typed);
+        os << MessageEnd() << GL_NEWLINE;
+    }
+
+    return os;
+}
+
+/**
+ * \brief Create array.
+ *  This solves the error "cannot refer to class template 'Array' without a
+ * template argument list".
+ *
+ * \tparam T Value type.
+ * \param name      Name.
+ * \param val       Values.
+ * \param len       Number of values.
+ * \param prefixFmt PrefixFormatter.
+ * \return Array.
+ *
+ */
+template<class T>
+Array<T> make_array(
+    const char* name, T& val, size_t len, const PrefixFormatter& prefixFmt) {
+    return Array<T>(name, val, len, prefixFmt);
+};
+
+/**
+ * \brief Matrix.
+ *
+ * \tparam T Value type.
+ *
+ */
+template<class T>
+class Matrix {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name      Name.
+     * \param val       Values [\p cols x \p rows].
+     * \param cols      Number of columns.
+     * \param rows      Number of rows.
+     * \param prefixFmt PrefixFormatter.
+     *
+     */
+    explicit Matrix(const char* name, T& val, size_t cols, size_t rows,
+        const PrefixFormatter& prefixFmt) noexcept :
+        m_name(name),
+        m_val(val), m_cols(cols), m_rows(rows), m_prefixFmt(prefixFmt) {
+    }
+
+    template<class U>
+    friend std::ostream& operator<<(
+        std::ostream& os, const Matrix<U>& a) noexcept;
+
+    /**
+     * \return Name.
+     */
+    const char* get_name() const noexcept {
+        return m_name;
+    }
+
+    /**
+     * \return Values.
+     */
+    T& get_values() const noexcept {
+        return m_val;
+    }
+
+    /**
+     * \return Number of columns.
+     */
+    size_t get_number_of_columns() const noexcept {
+        return m_cols;
+    }
+
+    /**
+     * \return Number of rows.
+     */
+    size_t get_number_of_rows() const noexcept {
+        return m_rows;
+    }
+
+    /**
+     * \return PrefixFormatter.
+     */
+    const PrefixFormatter& get_prefix_formatter() const noexcept {
+        return m_prefixFmt;
+    }
+
+  private:
+    const char*            m_name;      /**< Name. */
+    T&                     m_val;       /**< Values. */
+    const size_t           m_cols;      /**< Number of columns. */
+    const size_t           m_rows;      /**< Number of rows. */
+    const PrefixFormatter& m_prefixFmt; /**< PrefixFormatter. */
+};
+
+/**
+ * \brief Write Matrix to stream.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param m  Matrix.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(std::ostream& os, const Matrix<U>& m) noexcept {
+    if (outputEnabled.load(std::memory_order_relaxed)) {
+        os << message_start << m.get_prefix_formatter();
+        if (!is_text(os)) {
+            // Array of rows
+            bool typed = begin_variable<U>(os, m.get_name());
+            begin_array(os);
+            for (size_t i = 0; i < m.get_number_of_rows(); ++i) {
+                if (i != 0) {
+                    os << separator;
+                }
+                begin_array(os);
+                for (size_t j = 0; j < m.get_number_of_columns(); ++j) {
+                    if (j != 0) {
+                        os << separator;
+                    }
+                    os << format_value(m.get_values()[i][j]);
+                }
+                end_array(os);
+            }
+            end_array(os);
+            end_variable(os, typed);
+            os << MessageEnd() << GL_NEWLINE;
+            return os;
+        }
+        os << type_name<U> << m.get_name() << ": ";
+        if (m.get_number_of_columns() <= 0 || m.get_number_of_rows() <= 0) {
+            os << "{}";
+        } else {
+            os << "[0,0] = " << format_value(m.get_values()[0][0]);
+            for (size_t j = 1; j < m.get_number_of_columns(); ++j) {
+                os << ", "
+                   << "[0," << j
+                   << "] = " << format_value(m.get_values()[0][j]);
+            }
+            for (size_t i = 1; i < m.get_number_of_rows(); ++i) {
+                for (size_t j = 0; j < m.get_number_of_columns(); ++j) {
+                    os << ", "
+                       << "[" << i << ',' << j
+                       << "] = " << format_value(m.get_values()[i][j]);
+                }
+            }
+        }
+        os << color_end << GL_NEWLINE;
+    }
+
+    return os;
+}
+
+/**
+ * \brief Create matrix.
+ *  This solves the error "cannot refer to class template 'Matrix' without a
+ * template argument list".
+ *
+ * \tparam T Value type.
+ * \param name      Name.
+ * \param val       Values.
+ * \param cols      Number of columns.
+ * \param rows      Number of rows.
+ * \param prefixFmt PrefixFormatter.
+ *
+ * \return New matrix.
+ *
+ */
+template<class T>
+Matrix<T> make_matrix(const char* name, T& val, size_t cols, size_t rows,
+    const PrefixFormatter& prefixFmt) {
+    return Matrix<T>(name, val, cols, rows, prefixFmt);
+};
+
+/**
+ * \brief Call site of l(), l_arr() and l_mat(), which may be disabled or
+ * rate limited at runtime.
+ *
+ * Has a constexpr constructor, so that a static instance is initialized
+ * without a guard. Registers itself on first use. After that, checking
+ * whether to log takes two relaxed atomic loads, and a clock read if rate
+ * limited.
+ */
+class LogSite {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    constexpr LogSite(
+        const char* file_path, long file_line, const char* func) noexcept :
+        m_file_path(file_path),
+        m_file_line(file_line), m_func(func), m_state(kUnregistered),
+        m_limit(0), m_window(0), m_count(0), m_next(nullptr), m_prefix() {}
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    /**
+     * \return \c true if the call site is enabled and not rate limited.
+     */
+    bool should_log() noexcept {
+        // Inlined in every call site, so only the common case is checked here
+        if (m_state.load(std::memory_order_relaxed) == kEnabled &&
+            m_limit.load(std::memory_order_relaxed) == 0) {
+            return true;
+        }
+        return should_log_slow();
+    }
+
+    /**
+     * \return File path including name.
+     */
+    const char* get_file_path() const noexcept {
+        return m_file_path;
+    }
+
+    /**
+     * \return Line number in file.
+     */
+    long get_file_line_number() const noexcept {
+        return m_file_line;
+    }
+
+    /**
+     * \return Function name.
+     */
+    const char* get_function_name() const noexcept {
+        return m_func;
+    }
+
+    /**
+     * \return Next registered site, or \c nullptr if none.
+     */
+    LogSite* get_next() const noexcept {
+        return m_next;
+    }
+
+    /**
+     * \brief Enable or disable registered site.
+     *
+     * \param enabled \c true to enable.
+     */
+    void set_enabled(bool enabled) noexcept {
+        m_state.store(
+            enabled ? kEnabled : kDisabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Set rate limit.
+     *
+     * \param limit Maximum number of lines per second, 0 for no limit.
+     */
+    void set_rate_limit(uint32_t limit) noexcept {
+        m_limit.store(limit, std::memory_order_relaxed);
+    }
+
+    /**
+     * \return Cache of rendered prefix.
+     */
+    PrefixCache& prefix_cache() noexcept {
+        return m_prefix;
+    }
+
+    /**
+     * \return Prefix formatter of call site, using its cache.
+     */
+    PrefixFormatter prefix() noexcept {
+        return PrefixFormatter(m_file_path, m_file_line, m_func, &m_prefix);
+    }
+
+  private:
+    friend class LogSites;
+
+    /** Site not registered yet. */
+    static const uint8_t kUnregistered = 0;
+    /** Site enabled. */
+    static const uint8_t kEnabled = 1;
+    /** Site disabled. */
+    static const uint8_t kDisabled = 2;
+
+    uint8_t register_site();
+
+    /**
+     * \brief Check a call site which is unregistered, disabled or rate
+     * limited. Out of line, to keep call sites small.
+     *
+     * \return \c true if the call site is enabled and not rate limited.
+     */
+    GL_INTERNAL_NOINLINE bool should_log_slow() noexcept {
+        uint8_t state = m_state.load(std::memory_order_relaxed);
+        if (state == kUnregistered) {
+            state = register_site();
+        }
+        if (state == kDisabled) {
+            return false;
+        }
+        uint32_t limit = m_limit.load(std::memory_order_relaxed);
+        return limit == 0 || admit(limit);
+    }
+
+    /**
+     * \brief Count line against rate limit of current second.
+     *
+     * \param limit Maximum number of lines per second.
+     * \return \c true if the line is within limit.
+     */
+    bool admit(uint32_t limit) noexcept {
+        int64_t now    = static_cast<int64_t>(std::time(nullptr));
+        int64_t window = m_window.load(std::memory_order_relaxed);
+        if (window != now &&
+            m_window.compare_exchange_strong(
+                window, now, std::memory_order_relaxed)) {
+            m_count.store(0, std::memory_order_relaxed);
+        }
+        return m_count.fetch_add(1, std::memory_order_relaxed) < limit;
+    }
+
+    const char* const    m_file_path; /**< File path including name. */
+    const long           m_file_line; /**< Line number in file. */
+    const char* const    m_func;      /**< Function name. */
+    std::atomic<uint8_t> m_state;     /**< Registration and enabled state. */
+    std::atomic<uint32_t> m_limit;  /**< Lines per second, 0 if unlimited. */
+    std::atomic<int64_t>  m_window; /**< Second of current rate window. */
+    std::atomic<uint32_t> m_count;  /**< Lines in current rate window. */
+    LogSite*              m_next;   /**< Next registered site. */
+    PrefixCache           m_prefix; /**< Cache of rendered prefix. */
+};
+
+/**
+ * \brief All used call sites of l(), l_arr() and l_mat(). The rules of
+ * gl::set_sites_enabled() and gl::set_rate_limit() in goinglogging/sites.h,
+ * if any, are applied to each site when it is used first.
+ *
+ * Guarded by a spin lock, which is only taken when a site is used first and
+ * while the rules change. Has a constexpr constructor, so that a static
+ * instance is initialized before, and never destroyed before, any call site.
+ */
+class LogSites {
+  public:
+    /**
+     * \brief Function which applies the rules to a site used first.
+     */
+    typedef void (*Rules)(LogSite& site);
+
+    /**
+     * \brief Constructor.
+     */
+    constexpr LogSites() noexcept :
+        m_locked(false), m_head(nullptr), m_rules(nullptr) {}
+
+    LogSites(const LogSites&) = delete;
+    LogSites& operator=(const LogSites&) = delete;
+
+    /**
+     * \brief Register site and apply rules to it, unless already registered.
+     *
+     * \param site Call site.
+     * \return State of site.
+     */
+    uint8_t add(LogSite& site) {
+        Lock lock(m_locked);
+        uint8_t state = site.m_state.load(std::memory_order_relaxed);
+        if (state != LogSite::kUnregistered) {
+            return state;
+        }
+        site.m_next = m_head;
+        m_head      = &site;
+        site.m_state.store(LogSite::kEnabled, std::memory_order_relaxed);
+        if (m_rules != nullptr) {
+            m_rules(site);
+        }
+        return site.m_state.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Unregister site before it is destroyed, if registered. For
+     * sites which are not function-local statics of a call site.
+     *
+     * \param site Call site.
+     */
+    void remove(LogSite& site) {
+        Lock lock(m_locked);
+        for (LogSite** p = &m_head; *p != nullptr; p = &(*p)->m_next) {
+            if (*p == &site) {
+                *p          = site.m_next;
+                site.m_next = nullptr;
+                return;
+            }
+        }
+    }
+
+    /**
+     * \brief Set rules, and change the registered sites, while no site is
+     * registered.
+     *
+     * \tparam F Function object, called with the most recently registered
+     *           site, or \c nullptr if none.
+     * \param rules Rules to apply to sites registered later.
+     * \param f     Function object.
+     */
+    template<class F>
+    void update(Rules rules, F f) {
+        Lock lock(m_locked);
+        m_rules = rules;
+        f(m_head);
+    }
+
+  private:
+    /**
+     * \brief Holder of the spin lock.
+     */
+    class Lock {
+      public:
+        /**
+         * \brief Constructor. Lock.
+         *
+         * \param locked Lock word.
+         */
+        explicit Lock(std::atomic<bool>& locked) noexcept : m_locked(locked) {
+            while (m_locked.exchange(true, std::memory_order_acquire)) {
+                while (m_locked.load(std::memory_order_relaxed)) {
+                }
+            }
+        }
+
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+        /**
+         * \brief Destructor. Unlock.
+         */
+        ~Lock() {
+            m_locked.store(false, std::memory_order_release);
+        }
+
+      private:
+        std::atomic<bool>& m_locked; /**< Lock word. */
+    };
+
+    std::atomic<bool> m_locked; /**< \c true while locked. */
+    LogSite*          m_head;   /**< Most recently registered site. */
+    Rules             m_rules;  /**< Rules, or \c nullptr if none. */
+};
+
+/**
+ * \return All used call sites of l(), l_arr() and l_mat().
+ */
+inline LogSites& log_sites() noexcept {
+    static LogSites sites;
+    return sites;
+}
+
+/**
+ * \brief Register site and apply rules to it.
+ *
+ * \return State of site.
+ */
+inline uint8_t LogSite::register_site() {
+    return log_sites().add(*this);
+}
+
+/**
+ * \brief Function which writes the message of a call site to a stream.
+ */
+typedef void (*MessageWriter)(std::ostream& os, const void* message);
+
+/**
+ * \brief Write message of a call site to stream.
+ *
+ * \tparam F Function object which writes the message.
+ * \param os      Output stream.
+ * \param message Function object of type \p F.
+ */
+template<class F>
+GL_INTERNAL_COLD void write_message(
+    std::ostream& os, const void* message) noexcept {
+    (*static_cast<const F*>(message))(os);
+}
+
+/**
+ * \brief Get writer of message, which erases its type.
+ *
+ * \tparam F Function object which writes the message.
+ * \return Function which calls a function object of type \p F.
+ */
+template<class F>
+MessageWriter message_writer(const F& /*unused*/) noexcept {
+    return &write_message<F>;
+}
+
+/**
+ * \brief Write message of an enabled call site to output. Out of line and
+ * cold, so that call sites only inline the check if they are enabled, and
+ * the call.
+ *
+ * \param write   Writer of message.
+ * \param message Message.
+ */
+GL_INTERNAL_COLD inline void emit(
+    MessageWriter write, const void* message) noexcept {
+    write(std::cout, message);
+}
+
+#ifndef GL_INTERNAL_USDT
+/**
+ * \brief Check if a tracer is attached. Never, since not USDT probes.
+ */
+#define GL_INTERNAL_USDT_ATTACHED() false
+
+/**
+ * \brief Fire probe of call site. Nothing, since not USDT probes.
+ */
+#define GL_INTERNAL_USDT_SITE(message, output) static_cast<void>(0)
+#endif // GL_INTERNAL_USDT
+
+/**
+ * \brief Explicit instantiation of the formatting of a variable in messages of
+ * l(). Definition if \p spec is empty, and declaration if \p spec is
+ * \c extern.
+ */
+#define GL_INTERNAL_INSTANTIATE_VARIABLE(spec, ...)                        \
+    spec template std::ostream& operator<<(                                \
+        std::ostream&, const Variable<__VA_ARGS__>&) noexcept;
+
+/**
+ * \brief Explicit instantiation of the formatting of a value, both in
+ * messages of l() and as element of containers.
+ */
+#define GL_INTERNAL_INSTANTIATE_VALUE(spec, ...)                           \
+    GL_INTERNAL_INSTANTIATE_VARIABLE(spec, __VA_ARGS__)                    \
+    spec template std::ostream& operator<<(                                \
+        std::ostream&, const ValueFormatter<__VA_ARGS__>&) noexcept;
+
+/**
+ * \brief Explicit instantiation of the formatting of a number and a constant
+ * number.
+ */
+#define GL_INTERNAL_INSTANTIATE_NUMBER(spec, T)                            \
+    GL_INTERNAL_INSTANTIATE_VALUE(spec, T)                                 \
+    GL_INTERNAL_INSTANTIATE_VALUE(spec, const T)
+
+/**
+ * \brief Explicit instantiations of the core, in the precompiled library.
+ * Values which have their own formatter, such as std::string, only need
+ * their variables instantiated.
+ */
+#define GL_INTERNAL_INSTANTIATE_CORE(spec)                                 \
+    GL_INTERNAL_INSTANTIATE_VARIABLE(spec, bool)                           \
+    GL_INTERNAL_INSTANTIATE_VARIABLE(spec, char)                           \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, short)                            \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, unsigned short)                   \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, int)                              \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, unsigned int)                     \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, long)                             \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, unsigned long)                    \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, long long)                        \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, unsigned long long)               \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, float)                            \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, double)                           \
+    GL_INTERNAL_INSTANTIATE_NUMBER(spec, long double)                      \
+    GL_INTERNAL_INSTANTIATE_VARIABLE(spec, std::string)                    \
+    GL_INTERNAL_INSTANTIATE_VARIABLE(spec, const std::string)
+
+#ifdef GL_PRECOMPILED
+GL_INTERNAL_INSTANTIATE_CORE(extern)
+#endif // GL_PRECOMPILED
+
+} // namespace internal
+
+#endif // DOXYGEN_HIDDEN
+
+/**
+ *
+ * \return Bitwise \c or of prefix settings.
+ *
+ * \sa prefix \sa set_prefixes()
+ *
+ */
+inline prefix get_prefixes() noexcept {
+    return internal::curPrefixes.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Set prefixes of logging output.
+ *
+ * Alters the output of \ref l(), \ref l_arr(), and \ref l_mat().
+ *
+ * \param p Bitwise \c or of prefix settings.
+ *
+ * Used as:
+ * \code
+ * gl::set_prefixes(gl::prefix::FILE | gl::prefix::LINE);
+ * \endcode
+ * to also log current file and line number.
+ *
+ * \note Defaults to prefix::FILE | prefix::LINE.
+ * \note Each call site caches its rendered FILE, LINE and FUNCTION prefixes,
+ * which are rendered again after a change.
+ *
+ * \sa prefix \sa get_prefixes()
+ *
+ */
+inline void set_prefixes(prefix p) noexcept {
+    if (internal::curPrefixes.exchange(p, std::memory_order_relaxed) != p) {
+        internal::prefixGeneration.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/**
+ *
+ * \return \c true if output is enabled.
+ *
+ * \sa set_output_enabled()
+ *
+ */
+inline bool is_output_enabled() noexcept {
+    return internal::outputEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Enable or disable output.
+ *
+ * \param e \c true if output shall be enabled.
+ *
+ * \note Defaults to enabled.
+ *
+ * \sa is_output_enabled()
+ *
+ */
+inline void set_output_enabled(bool e) noexcept {
+    internal::outputEnabled.store(e, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Enable or disable ANSI color output.
+ *
+ * \param e \c true if output shall be colored.
+ *
+ * \note Defaults to disabled.
+ *
+ * \sa is_color_enabled()
+ *
+ */
+inline void set_color_enabled(bool e) noexcept {
+    if (internal::colorEnabled.exchange(e, std::memory_order_relaxed) != e) {
+        internal::prefixGeneration.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/**
+ *
+ * \return \c true if ANSI color output is enabled.
+ *
+ * \sa set_color_enabled()
+ *
+ */
+inline bool is_color_enabled() noexcept {
+    return internal::colorEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return Output format.
+ *
+ * \sa set_format()
+ *
+ */
+inline format get_format() noexcept {
+    return internal::curFormat.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Enable or disable escaping of strings in text.
+ *
+ * While enabled, control characters, '"' and '\\' in strings are written as
+ * C escape sequences, such as \\n, \\t and \\x01, so that each message is
+ * one line. JSON is always escaped.
+ *
+ * \param e \c true if strings shall be escaped.
+ *
+ * \note Defaults to disabled.
+ *
+ * \sa is_escape_enabled()
+ *
+ */
+inline void set_escape_enabled(bool e) noexcept {
+    internal::escapeEnabled.store(e, std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return \c true if strings are escaped in text.
+ *
+ * \sa set_escape_enabled()
+ *
+ */
+inline bool is_escape_enabled() noexcept {
+    return internal::escapeEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Set maximum number of bytes written of each string.
+ *
+ * Longer strings are cut, and followed by the number of bytes not written:
+ * \code
+ * gl::set_max_string_length(4);
+ * std::string s("abcdef");
+ * l(s);
+ * \endcode
+ * Outputs:
+ * \code
+ * s = "abcd...(+2 bytes)"
+ * \endcode
+ * Strings are not cut inside a UTF-8 sequence.
+ *
+ * \param n Maximum number of bytes, or 0 for no limit.
+ *
+ * \note Defaults to 0.
+ *
+ * \sa get_max_string_length()
+ *
+ */
+inline void set_max_string_length(size_t n) noexcept {
+    internal::maxStringLength.store(n, std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return Maximum number of bytes written of each string, or 0 for no limit.
+ *
+ * \sa set_max_string_length()
+ *
+ */
+inline size_t get_max_string_length() noexcept {
+    return internal::maxStringLength.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Write elements of std::priority_queue in sorted order.
+ *
+ * By default, all elements of a std::priority_queue are written in the order
+ * of its heap, with the top first. While set, only the \p n elements with
+ * the highest priority are written, in order of priority, followed by
+ * "..." if there are more:
+ * \code
+ * gl::set_priority_queue_sorted(2);
+ * std::priority_queue<int> q;
+ * q.push(1);
+ * q.push(3);
+ * q.push(2);
+ * l(q);
+ * \endcode
+ * Outputs:
+ * \code
+ * q = {3, 2, ...}
+ * \endcode
+ * Sorting takes O(size * log(n)) time, and does not copy the elements.
+ *
+ * \param n Number of elements to sort, or 0 for heap order.
+ *
+ * \note Defaults to 0.
+ *
+ * \sa get_priority_queue_sorted()
+ *
+ */
+inline void set_priority_queue_sorted(size_t n) noexcept {
+    internal::heapSorted.store(n, std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return Number of elements of std::priority_queue written in sorted order,
+ * or 0 for heap order.
+ *
+ * \sa set_priority_queue_sorted()
+ *
+ */
+inline size_t get_priority_queue_sorted() noexcept {
+    return internal::heapSorted.load(std::memory_order_relaxed);
+}
+
+
+#ifndef DOXYGEN_HIDDEN
+
+#ifdef GL_PROFILE
+/**
+ * \brief Write to output, if call site is enabled, and record the cost in the
+ * profile of the call site. The output may use gl_internal_log_site.
+ */
+#define GL_INTERNAL_EMIT(...)                                             \
+    do {                                                                  \
+        static const ::gl::internal::ProfileSite gl_internal_profile_site( \
+            __FILE__, __LINE__, __func__);                                \
+        static ::gl::internal::LogSite gl_internal_log_site(              \
+            __FILE__, __LINE__, __func__);                                \
+        auto gl_internal_message = [&](std::ostream& gl_internal_os) {    \
+            gl_internal_os << __VA_ARGS__;                                \
+        };                                                                \
+        const bool gl_internal_output =                                   \
+            ::gl::internal::outputEnabled.load(                           \
+                std::memory_order_relaxed) &&                             \
+            gl_internal_log_site.should_log();                            \
+        if (GL_INTERNAL_USDT_ATTACHED()) {                                \
+            GL_INTERNAL_USDT_SITE(gl_internal_message, gl_internal_output); \
+        } else if (gl_internal_output) {                                  \
+            ::gl::internal::emit(gl_internal_profile_site,                \
+                ::gl::internal::message_writer(gl_internal_message),      \
+                &gl_internal_message);                                    \
+        } else {                                                          \
+            gl_internal_profile_site.suppress();                          \
+        }                                                                 \
+    } while (false)
+#elif defined(GL_INTERNAL_STATIC_KEYS)
+/**
+ * \brief Write to output, if call site is enabled. The output may use
+ * gl_internal_log_site. Starts with a jump to the check, which is patched to
+ * a no-op while the call site is disabled.
+ */
+#define GL_INTERNAL_EMIT(...)                                   \
+    GL_INTERNAL_STATIC_EMIT(                                    \
+        GL_INTERNAL_CONCAT(gl_internal_site_enabled_, __COUNTER__), \
+        __VA_ARGS__)
+
+/**
+ * \brief Write to output, if the jump to label is taken and call site is
+ * enabled. An attached tracer is checked before the jump, so that its probe
+ * also fires while the call site is disabled.
+ */
+#define GL_INTERNAL_STATIC_EMIT(label, ...)                               \
+    do {                                                                  \
+        static ::gl::internal::LogSite gl_internal_log_site(              \
+            __FILE__, __LINE__, __func__);                                \
+        auto gl_internal_message = [&](std::ostream& gl_internal_os) {    \
+            gl_internal_os << __VA_ARGS__;                                \
+        };                                                                \
+        if (GL_INTERNAL_USDT_ATTACHED()) {                                \
+            GL_INTERNAL_USDT_SITE(gl_internal_message,                    \
+                ::gl::internal::outputEnabled.load(                       \
+                    std::memory_order_relaxed) &&                         \
+                    gl_internal_log_site.should_log());                   \
+            break;                                                        \
+        }                                                                 \
+        GL_INTERNAL_STATIC_JUMP(gl_internal_log_site, label);             \
+        break;                                                            \
+    label:                                                                \
+        if (::gl::internal::outputEnabled.load(                           \
+                std::memory_order_relaxed) &&                             \
+            gl_internal_log_site.should_log()) {                          \
+            ::gl::internal::emit(                                         \
+                ::gl::internal::message_writer(gl_internal_message),      \
+                &gl_internal_message);                                    \
+        }                                                                 \
+    } while (false)
+#else
+/**
+ * \brief Write to output, if call site is enabled. The output may use
+ * gl_internal_log_site. Only the check is inlined. The output is written by
+ * a lambda, which is called through the cold emitter.
+ */
+#define GL_INTERNAL_EMIT(...)                                             \
+    do {                                                                  \
+        static ::gl::internal::LogSite gl_internal_log_site(              \
+            __FILE__, __LINE__, __func__);                                \
+        auto gl_internal_message = [&](std::ostream& gl_internal_os) {    \
+            gl_internal_os << __VA_ARGS__;                                \
+        };                                                                \
+        const bool gl_internal_output =                                   \
+            ::gl::internal::outputEnabled.load(                           \
+                std::memory_order_relaxed) &&                             \
+            gl_internal_log_site.should_log();                            \
+        if (GL_INTERNAL_USDT_ATTACHED()) {                                \
+            GL_INTERNAL_USDT_SITE(gl_internal_message, gl_internal_output); \
+        } else if (gl_internal_output) {                                  \
+            ::gl::internal::emit(                                         \
+                ::gl::internal::message_writer(gl_internal_message),      \
+                &gl_internal_message);                                    \
+        }                                                                 \
+    } while (false)
+#endif // GL_PROFILE
+
+/**
+ * \brief Concatenate tokens, after expanding them. */
+#define GL_INTERNAL_CONCAT(a, b) GL_INTERNAL_CONCAT_IMPL(a, b)
+#define GL_INTERNAL_CONCAT_IMPL(a, b) a##b
+
+/**
+ * \brief Helper function for l(). Dispatch to the right macro depending on
+ * number of arguments.
+ *
+ */
+#define GL_INTERNAL_L_DISPATCH(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, \
+    _12, _13, _14, _15, _16, NAME, ...)                                      \
+    NAME
+
+/**
+ * \brief Output variable name and value. */
+#define GL_INTERNAL_LX(v) ::gl::internal::make_variable((#v), (v))
+
+#define GL_INTERNAL_L1(v1) GL_INTERNAL_LX(v1)
+
+#define GL_INTERNAL_L2(v1, v2) \
+    GL_INTERNAL_L1(v1)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v2)
+
+#define GL_INTERNAL_L3(v1, v2, v3) \
+    GL_INTERNAL_L2(v1, v2)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v3)
+
+#define GL_INTERNAL_L4(v1, v2, v3, v4) \
+    GL_INTERNAL_L3(v1, v2, v3)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v4)
+
+#define GL_INTERNAL_L5(v1, v2, v3, v4, v5) \
+    GL_INTERNAL_L4(v1, v2, v3, v4)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v5)
+
+#define GL_INTERNAL_L6(v1, v2, v3, v4, v5, v6) \
+    GL_INTERNAL_L5(v1, v2, v3, v4, v5)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v6)
+
+#define GL_INTERNAL_L7(v1, v2, v3, v4, v5, v6, v7) \
+    GL_INTERNAL_L6(v1, v2, v3, v4, v5, v6)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v7)
+
+#define GL_INTERNAL_L8(v1, v2, v3, v4, v5, v6, v7, v8) \
+    GL_INTERNAL_L7(v1, v2, v3, v4, v5, v6, v7)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v8)
+
+#define GL_INTERNAL_L9(v1, v2, v3, v4, v5, v6, v7, v8, v9) \
+    GL_INTERNAL_L8(v1, v2, v3, v4, v5, v6, v7, v8)         \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v9)
+
+#define GL_INTERNAL_L10(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10) \
+    GL_INTERNAL_L9(v1, v2, v3, v4, v5, v6, v7, v8, v9)           \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v10)
+
+#define GL_INTERNAL_L11(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11) \
+    GL_INTERNAL_L10(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10)          \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v11)
+
+#define GL_INTERNAL_L12(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12) \
+    GL_INTERNAL_L11(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11)          \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v12)
+
+#define GL_INTERNAL_L13(                                               \
+    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13)            \
+    GL_INTERNAL_L12(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12) \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v13)
+
+#define GL_INTERNAL_L14(                                                    \
+    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14)            \
+    GL_INTERNAL_L13(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13) \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v14)
+
+#define GL_INTERNAL_L15(                                              \
+    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) \
+    GL_INTERNAL_L14(                                                  \
+        v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14)  \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v15)
+
+#define GL_INTERNAL_L16(                                                   \
+    v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16) \
+    GL_INTERNAL_L15(                                                       \
+        v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15)  \
+        << ::gl::internal::separator << GL_INTERNAL_LX(v16)
+
+/**
+ * \brief Visit field name and value, for GL_REFLECT(). */
+#define GL_INTERNAL_RX(f) gl_visitor((#f), sizeof(#f) - 1, gl_object.f);
+
+#define GL_INTERNAL_R1(f1) GL_INTERNAL_RX(f1)
+
+#define GL_INTERNAL_R2(f1, f2) \
+    GL_INTERNAL_R1(f1) GL_INTERNAL_RX(f2)
+
+#define GL_INTERNAL_R3(f1, f2, f3) \
+    GL_INTERNAL_R2(f1, f2) GL_INTERNAL_RX(f3)
+
+#define GL_INTERNAL_R4(f1, f2, f3, f4) \
+    GL_INTERNAL_R3(f1, f2, f3) GL_INTERNAL_RX(f4)
+
+#define GL_INTERNAL_R5(f1, f2, f3, f4, f5) \
+    GL_INTERNAL_R4(f1, f2, f3, f4) GL_INTERNAL_RX(f5)
+
+#define GL_INTERNAL_R6(f1, f2, f3, f4, f5, f6) \
+    GL_INTERNAL_R5(f1, f2, f3, f4, f5) GL_INTERNAL_RX(f6)
+
+#define GL_INTERNAL_R7(f1, f2, f3, f4, f5, f6, f7) \
+    GL_INTERNAL_R6(f1, f2, f3, f4, f5, f6) GL_INTERNAL_RX(f7)
+
+#define GL_INTERNAL_R8(f1, f2, f3, f4, f5, f6, f7, f8) \
+    GL_INTERNAL_R7(f1, f2, f3, f4, f5, f6, f7) GL_INTERNAL_RX(f8)
+
+#define GL_INTERNAL_R9(f1, f2, f3, f4, f5, f6, f7, f8, f9) \
+    GL_INTERNAL_R8(f1, f2, f3, f4, f5, f6, f7, f8) GL_INTERNAL_RX(f9)
+
+#define GL_INTERNAL_R10(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10) \
+    GL_INTERNAL_R9(f1, f2, f3, f4, f5, f6, f7, f8, f9) GL_INTERNAL_RX(f10)
+
+#define GL_INTERNAL_R11(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11) \
+    GL_INTERNAL_R10(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10) GL_INTERNAL_RX(f11)
+
+#define GL_INTERNAL_R12(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12) \
+    GL_INTERNAL_R11(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11)          \
+    GL_INTERNAL_RX(f12)
+
+#define GL_INTERNAL_R13(                                               \
+    f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13)            \
+    GL_INTERNAL_R12(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12) \
+    GL_INTERNAL_RX(f13)
+
+#define GL_INTERNAL_R14(                                                    \
+    f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14)            \
+    GL_INTERNAL_R13(f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13) \
+    GL_INTERNAL_RX(f14)
+
+#define GL_INTERNAL_R15(                                              \
+    f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15) \
+    GL_INTERNAL_R14(                                                  \
+        f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14)  \
+    GL_INTERNAL_RX(f15)
+
+#define GL_INTERNAL_R16(                                                   \
+    f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16) \
+    GL_INTERNAL_R15(                                                       \
+        f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15)  \
+    GL_INTERNAL_RX(f16)
+
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+// Call sites of l() compiled with these options expand to code of these
+#ifdef GL_PROFILE
+#include "profile.h"
+#endif // GL_PROFILE
+#ifdef GL_INTERNAL_STATIC_KEYS
+#include "static_keys.h"
+#endif // GL_INTERNAL_STATIC_KEYS
+#ifdef GL_INTERNAL_USDT
+#include "usdt.h"
+#endif // GL_INTERNAL_USDT
+
+#endif // INCLUDE_GOINGLOGGING_CORE_H_
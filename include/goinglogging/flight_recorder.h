@@ -0,0 +1,617 @@
+/** \file
+ *
+ * \brief Flight recorder, which keeps the most recent messages in memory and
+ * writes them only when the program crashes or on request.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/flight_recorder.h"
+ *
+ * gl::start_flight_recorder();
+ * \endcode
+ *
+ * Each thread writes its messages to a ring of fixed size slots of its own,
+ * without locks or system calls. Messages are numbered from one counter
+ * shared by all threads, so that the rings can be merged in the order the
+ * messages were written. The rings are written to a file descriptor, with
+ * async-signal-safe code only, on SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT
+ * and std::terminate(), and when dump_recent() is called. The previous
+ * signal and terminate handlers are called afterwards.
+ *
+ * Each ring starts with "GLFLIGHT" and keeps messages as plain text, so that
+ * they can be found in a core dump, e.g. with <tt>strings core</tt>. The
+ * ring of a thread which has exited is reused by the next new thread.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_FLIGHT_RECORDER_H_
+#define INCLUDE_GOINGLOGGING_FLIGHT_RECORDER_H_
+
+#include "core.h"
+#include "sink.h"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <streambuf>
+
+#include <signal.h>
+#include <unistd.h>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Start of each ring, to find it in core dumps. */
+static const char kFlightMagic[8] = {'G', 'L', 'F', 'L', 'I', 'G', 'H', 'T'};
+/** Bytes per slot, including its header. */
+static const size_t kFlightSlotSize = 128;
+/** Flag of first slot of message. */
+static const uint16_t kFlightFirst = 1;
+/** Flag of last slot of message. */
+static const uint16_t kFlightLast = 2;
+
+/**
+ * \brief Slot of flight recorder ring.
+ */
+struct FlightSlot {
+    /** Message number + 1 when written, 0 while being written. */
+    std::atomic<uint64_t> seq;
+    uint16_t              len;   /**< Bytes of data in slot. */
+    uint16_t              flags; /**< kFlightFirst and kFlightLast. */
+    uint32_t              reserved; /**< Unused. */
+    /** Data. */
+    char data[kFlightSlotSize - sizeof(std::atomic<uint64_t>) - 8];
+};
+
+static_assert(sizeof(FlightSlot) == kFlightSlotSize,
+    "Unexpected size of flight recorder slot");
+
+/**
+ * \brief Ring of slots, written by one thread at a time.
+ */
+struct FlightRing {
+    char                  magic[8]; /**< kFlightMagic. */
+    std::atomic<bool>     in_use;   /**< \c true while owned by a thread. */
+    uint32_t              slots;    /**< Number of slots. */
+    FlightRing*           next;     /**< Next ring in list. */
+    std::atomic<uint64_t> head;     /**< Number of slots written. */
+    uint64_t              cursor;   /**< Next slot to dump. */
+    FlightSlot            slot[1];  /**< Slots [slots]. */
+};
+
+/**
+ * \brief State of flight recorder.
+ */
+struct FlightState {
+    std::atomic<FlightRing*> rings;   /**< List of all rings. */
+    std::atomic<uint64_t>    seq;     /**< Next message number. */
+    std::atomic<uint32_t>    slots;   /**< Slots of new rings. */
+    std::atomic<int>         fd;      /**< File descriptor to dump to. */
+    std::atomic<bool>        dumping; /**< \c true while dumping. */
+    std::atomic<bool>        crashed; /**< \c true once dumped on crash. */
+    /** Signals to dump on. */
+    int signals[5];
+    /** Previous actions of signals. */
+    struct sigaction previous[5];
+    /** Previous terminate handler. */
+    std::terminate_handler previous_terminate;
+};
+
+/**
+ * \return State of flight recorder. Initialized before any thread starts.
+ */
+inline FlightState& flight_state() noexcept {
+    static FlightState state = {{nullptr}, {0}, {1024}, {STDERR_FILENO},
+        {false}, {false}, {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}, {},
+        nullptr};
+    return state;
+}
+
+/**
+ * \brief Owner of the ring of a thread. Releases it when the thread exits.
+ */
+struct FlightRingOwner {
+    /**
+     * \brief Constructor.
+     */
+    FlightRingOwner() noexcept : ring(nullptr) {
+    }
+
+    FlightRingOwner(const FlightRingOwner&) = delete;
+    FlightRingOwner& operator=(const FlightRingOwner&) = delete;
+
+    /**
+     * \brief Destructor. Release ring, keeping its messages.
+     */
+    ~FlightRingOwner() {
+        if (ring != nullptr) {
+            ring->in_use.store(false, std::memory_order_release);
+        }
+    }
+
+    FlightRing* ring; /**< Ring, or \c nullptr. */
+};
+
+/**
+ * \brief Alternate signal stack of a thread, so the signal handler can dump
+ * after a stack overflow. Removed and freed when the thread exits.
+ */
+struct FlightAltStack {
+    /**
+     * \brief Constructor. Installs stack, unless the thread already has one.
+     */
+    FlightAltStack() noexcept : stack(nullptr) {
+        stack_t old;
+        if (sigaltstack(nullptr, &old) != 0 || !(old.ss_flags & SS_DISABLE)) {
+            return;
+        }
+        const size_t size = std::max<size_t>(SIGSTKSZ, 65536);
+        stack             = std::malloc(size);
+        if (stack == nullptr) {
+            return;
+        }
+        stack_t ss;
+        ss.ss_sp    = stack;
+        ss.ss_size  = size;
+        ss.ss_flags = 0;
+        if (sigaltstack(&ss, nullptr) != 0) {
+            std::free(stack);
+            stack = nullptr;
+        }
+    }
+
+    FlightAltStack(const FlightAltStack&) = delete;
+    FlightAltStack& operator=(const FlightAltStack&) = delete;
+
+    /**
+     * \brief Destructor. Remove stack if still installed, and free it.
+     */
+    ~FlightAltStack() {
+        if (stack == nullptr) {
+            return;
+        }
+        stack_t old;
+        if (sigaltstack(nullptr, &old) == 0 && old.ss_sp == stack) {
+            stack_t ss;
+            std::memset(&ss, 0, sizeof(ss));
+            ss.ss_flags = SS_DISABLE;
+            sigaltstack(&ss, nullptr);
+        }
+        std::free(stack);
+    }
+
+    void* stack; /**< Stack, or \c nullptr if not installed by us. */
+};
+
+/**
+ * \brief Install alternate signal stack for this thread, once.
+ */
+inline void flight_alt_stack() noexcept {
+    static thread_local FlightAltStack stack;
+    (void)stack;
+}
+
+/**
+ * \brief Get ring of this thread. Reuses a released ring with the current
+ * number of slots, or allocates a new one.
+ *
+ * \return Ring.
+ */
+inline FlightRing& flight_ring() {
+    static thread_local FlightRingOwner owner;
+    FlightState&   state = flight_state();
+    const uint32_t slots = state.slots.load(std::memory_order_relaxed);
+    if (owner.ring != nullptr && owner.ring->slots == slots) {
+        return *owner.ring;
+    }
+    if (owner.ring != nullptr) {
+        owner.ring->in_use.store(false, std::memory_order_release);
+        owner.ring = nullptr;
+    }
+    flight_alt_stack();
+    for (FlightRing* r = state.rings.load(std::memory_order_acquire);
+         r != nullptr; r = r->next) {
+        bool expected = false;
+        if (r->slots == slots &&
+            r->in_use.compare_exchange_strong(expected, true)) {
+            owner.ring = r;
+            return *r;
+        }
+    }
+    // Never freed, since a dump may read it at any time
+    void* p = ::operator new(
+        offsetof(FlightRing, slot) + slots * sizeof(FlightSlot));
+    std::memset(p, 0, offsetof(FlightRing, slot) + slots * sizeof(FlightSlot));
+    FlightRing* r = static_cast<FlightRing*>(p);
+    std::memcpy(r->magic, kFlightMagic, sizeof(kFlightMagic));
+    r->in_use.store(true, std::memory_order_relaxed);
+    r->slots = slots;
+    r->next  = state.rings.load(std::memory_order_relaxed);
+    while (!state.rings.compare_exchange_weak(r->next, r,
+        std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    owner.ring = r;
+    return *r;
+}
+
+/**
+ * \brief Write message to ring of this thread. Truncated if longer than the
+ * ring.
+ *
+ * \param s Message [\p n].
+ * \param n Number of characters.
+ */
+inline void flight_record(const char* s, size_t n) {
+    FlightRing&    r       = flight_ring();
+    const size_t   payload = sizeof(r.slot[0].data);
+    uint64_t       k       = n == 0 ? 1 : (n + payload - 1) / payload;
+    const uint64_t head    = r.head.load(std::memory_order_relaxed);
+    if (k > r.slots) {
+        k = r.slots;
+        n = k * payload;
+    }
+    const uint64_t seq =
+        flight_state().seq.fetch_add(1, std::memory_order_relaxed);
+    for (uint64_t i = 0; i < k; ++i) {
+        FlightSlot& sl  = r.slot[(head + i) % r.slots];
+        size_t      len = std::min(payload, n - i * payload);
+        // Mark as incomplete before writing, as for a sequence lock
+        sl.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(sl.data, s + i * payload, len);
+        sl.len   = static_cast<uint16_t>(len);
+        sl.flags = static_cast<uint16_t>((i == 0 ? kFlightFirst : 0) |
+                                         (i + 1 == k ? kFlightLast : 0));
+        sl.seq.store(seq + 1, std::memory_order_release);
+    }
+    r.head.store(head + k, std::memory_order_release);
+}
+
+/**
+ * \brief Output buffer for dumping, which only uses write().
+ */
+class FlightWriter {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param fd File descriptor.
+     */
+    explicit FlightWriter(int fd) noexcept : m_fd(fd), m_buf(), m_len(0) {
+    }
+
+    FlightWriter(const FlightWriter&) = delete;
+    FlightWriter& operator=(const FlightWriter&) = delete;
+
+    /**
+     * \brief Destructor. Flush.
+     */
+    ~FlightWriter() {
+        flush();
+    }
+
+    /**
+     * \brief Append characters.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     */
+    void append(const char* s, size_t n) noexcept {
+        while (n > 0) {
+            if (m_len == sizeof(m_buf)) {
+                flush();
+            }
+            size_t c = std::min(n, sizeof(m_buf) - m_len);
+            std::memcpy(m_buf + m_len, s, c);
+            m_len += c;
+            s += c;
+            n -= c;
+        }
+    }
+
+    /**
+     * \brief Append null-terminated string.
+     *
+     * \param s String.
+     */
+    void append(const char* s) noexcept {
+        append(s, std::strlen(s));
+    }
+
+    /**
+     * \brief Append unsigned integer in decimal.
+     *
+     * \param v Value.
+     */
+    void append(uint64_t v) noexcept {
+        char  digits[20];
+        char* p = digits + sizeof(digits);
+        do {
+            *--p = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        append(p, static_cast<size_t>(digits + sizeof(digits) - p));
+    }
+
+    /**
+     * \brief Write buffered characters.
+     */
+    void flush() noexcept {
+        size_t done = 0;
+        while (done < m_len) {
+            ssize_t w = write(m_fd, m_buf + done, m_len - done);
+            if (w <= 0) {
+                break;
+            }
+            done += static_cast<size_t>(w);
+        }
+        m_len = 0;
+    }
+
+  private:
+    int    m_fd;        /**< File descriptor. */
+    char   m_buf[4096]; /**< Buffered characters. */
+    size_t m_len;       /**< Number of buffered characters. */
+};
+
+/**
+ * \brief Find the next complete message in ring from its dump cursor, and
+ * skip incomplete slots.
+ *
+ * \param r Ring.
+ * \return Message number + 1, or 0 if none.
+ */
+inline uint64_t flight_peek(FlightRing& r) noexcept {
+    const uint64_t head = r.head.load(std::memory_order_acquire);
+    if (head - r.cursor > r.slots) {
+        r.cursor = head - r.slots;
+    }
+    for (; r.cursor < head; ++r.cursor) {
+        FlightSlot& sl  = r.slot[r.cursor % r.slots];
+        uint64_t    seq = sl.seq.load(std::memory_order_acquire);
+        if (seq != 0 && (sl.flags & kFlightFirst) != 0) {
+            return seq;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief Write message at dump cursor of ring, and advance cursor.
+ *
+ * \param r   Ring.
+ * \param seq Message number + 1, as returned by flight_peek().
+ * \param out Output.
+ */
+inline void flight_dump_message(
+    FlightRing& r, uint64_t seq, FlightWriter& out) noexcept {
+    const uint64_t head = r.head.load(std::memory_order_acquire);
+    for (; r.cursor < head; ++r.cursor) {
+        FlightSlot& sl    = r.slot[r.cursor % r.slots];
+        uint16_t    flags = sl.flags;
+        size_t      len   = std::min<size_t>(sl.len, sizeof(sl.data));
+        if (sl.seq.load(std::memory_order_acquire) != seq) {
+            break;
+        }
+        out.append(sl.data, len);
+        if ((flags & kFlightLast) != 0) {
+            ++r.cursor;
+            break;
+        }
+    }
+    out.append("\n", 1);
+}
+
+/**
+ * \brief Write all rings in message order. Async-signal-safe. Does nothing
+ * if a dump is already in progress.
+ *
+ * \param fd     File descriptor.
+ * \param reason Reason, written in the header.
+ */
+inline void flight_dump(int fd, const char* reason) noexcept {
+    FlightState& state = flight_state();
+    if (state.dumping.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+    FlightWriter out(fd);
+    out.append("goinglogging flight recorder, ");
+    out.append(reason);
+    out.append(":\n");
+    FlightRing* rings = state.rings.load(std::memory_order_acquire);
+    for (FlightRing* r = rings; r != nullptr; r = r->next) {
+        r->cursor = 0;
+    }
+    uint64_t n = 0;
+    while (true) {
+        // Ring with the oldest message
+        FlightRing* oldest     = nullptr;
+        uint64_t    oldest_seq = 0;
+        for (FlightRing* r = rings; r != nullptr; r = r->next) {
+            uint64_t seq = flight_peek(*r);
+            if (seq != 0 && (oldest == nullptr || seq < oldest_seq)) {
+                oldest     = r;
+                oldest_seq = seq;
+            }
+        }
+        if (oldest == nullptr) {
+            break;
+        }
+        flight_dump_message(*oldest, oldest_seq, out);
+        ++n;
+    }
+    out.append("goinglogging flight recorder: ");
+    out.append(n);
+    out.append(" messages\n");
+    out.flush();
+    state.dumping.store(false, std::memory_order_release);
+}
+
+/**
+ * \brief Dump once on fatal signal, then call the previous handler.
+ *
+ * \param sig Signal.
+ */
+inline void flight_signal_handler(int sig) {
+    FlightState& state = flight_state();
+    for (size_t i = 0; i < sizeof(state.signals) / sizeof(int); ++i) {
+        if (state.signals[i] != sig) {
+            continue;
+        }
+        if (!state.crashed.exchange(true)) {
+            const char* names[] = {
+                "SIGSEGV", "SIGBUS", "SIGFPE", "SIGILL", "SIGABRT"};
+            flight_dump(state.fd.load(std::memory_order_relaxed), names[i]);
+        }
+        // Delivered to the previous action when returning
+        sigaction(sig, &state.previous[i], nullptr);
+        raise(sig);
+        return;
+    }
+}
+
+/**
+ * \brief Dump once on std::terminate(), then call the previous handler.
+ */
+inline void flight_terminate_handler() {
+    FlightState& state = flight_state();
+    if (!state.crashed.exchange(true)) {
+        flight_dump(state.fd.load(std::memory_order_relaxed),
+            "std::terminate()");
+    }
+    if (state.previous_terminate != nullptr) {
+        state.previous_terminate();
+    }
+    std::abort();
+}
+
+/**
+ * \brief Stream buffer which writes each line to the flight recorder.
+ */
+class FlightStreambuf : public LineStreambuf {
+  protected:
+    /**
+     * \brief Write line to ring of this thread.
+     *
+     * \param s Line [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) override {
+        flight_record(s, n);
+    }
+};
+
+/**
+ * \brief Flight recorder which std::cout is redirected to.
+ */
+typedef CoutRedirect<FlightStreambuf> FlightSink;
+
+/**
+ * \return Flight recorder sink.
+ */
+inline FlightSink& flight_sink() {
+    static FlightSink sink;
+    return sink;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Write the most recent messages of all threads to the file
+ * descriptor of the flight recorder, oldest first.
+ *
+ * Async-signal-safe, so it may be called from signal handlers.
+ *
+ * \sa start_flight_recorder()
+ *
+ */
+inline void dump_recent() noexcept {
+    internal::flight_dump(
+        internal::flight_state().fd.load(std::memory_order_relaxed),
+        "on request");
+}
+
+/**
+ * \brief Stop the flight recorder. Restore std::cout and the signal and
+ * terminate handlers. Recorded messages are kept.
+ *
+ * \sa start_flight_recorder()
+ *
+ */
+inline void stop_flight_recorder() {
+    internal::FlightSink&  sink  = internal::flight_sink();
+    internal::FlightState& state = internal::flight_state();
+    if (!sink.is_redirected()) {
+        return;
+    }
+    std::cout.flush();
+    sink.restore();
+    for (size_t i = 0; i < sizeof(state.signals) / sizeof(int); ++i) {
+        sigaction(state.signals[i], &state.previous[i], nullptr);
+    }
+    std::set_terminate(state.previous_terminate);
+}
+
+/**
+ * \brief Redirect std::cout, and thereby all logging, to the flight
+ * recorder. Messages are kept in memory, and only written on a crash or by
+ * dump_recent().
+ *
+ * Used as:
+ * \code
+ * gl::start_flight_recorder();
+ * \endcode
+ *
+ * \param fd    File descriptor to write to, e.g. of an opened file.
+ * \param slots Number of slots of 112 characters per thread. A message
+ *              takes one slot per 112 characters.
+ * \return \c true if started.
+ *
+ * \note Must not be called while other threads log.
+ *
+ * \note The handlers run on an alternate signal stack, installed for the
+ * calling thread and for each thread when it first logs, so a stack overflow
+ * is dumped too. A thread that has not logged yet uses its own stack.
+ *
+ * \sa dump_recent() \sa stop_flight_recorder()
+ *
+ */
+inline bool start_flight_recorder(
+    int fd = STDERR_FILENO, uint32_t slots = 1024) {
+    if (slots == 0) {
+        return false;
+    }
+    stop_flight_recorder();
+    internal::FlightSink&  sink  = internal::flight_sink();
+    internal::FlightState& state = internal::flight_state();
+    state.fd.store(fd, std::memory_order_relaxed);
+    state.slots.store(slots, std::memory_order_relaxed);
+    state.crashed.store(false, std::memory_order_relaxed);
+    internal::flight_alt_stack();
+    for (size_t i = 0; i < sizeof(state.signals) / sizeof(int); ++i) {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = internal::flight_signal_handler;
+        action.sa_flags   = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        sigaction(state.signals[i], &action, &state.previous[i]);
+    }
+    state.previous_terminate =
+        std::set_terminate(internal::flight_terminate_handler);
+    sink.redirect();
+    return true;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_FLIGHT_RECORDER_H_
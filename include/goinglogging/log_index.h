@@ -0,0 +1,796 @@
+/** \file
+ *
+ * \brief File sink which also writes a seekable index of the file, and a
+ * reader of the index, to find time ranges and call sites in large log
+ * files without reading all of them.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/log_index.h"
+ *
+ * gl::start_indexed_file("app.log");
+ * \endcode
+ *
+ * The log file is divided into chunks of whole lines. For each chunk, a
+ * checkpoint with its byte offset and size, the times of its first and last
+ * line, the number of lines of each call site, and the call site of each
+ * line is appended to the index file, named as the log file with ".idx"
+ * appended. A chunk ends when it
+ * reaches a number of bytes, or has lasted for an interval.
+ *
+ * The index is read with LogIndex, e.g. by the gl_query tool, which then
+ * only reads the chunks of a time range or call site, in parallel. Lines
+ * after the last checkpoint, e.g. after a crash, are not indexed.
+ *
+ * The index is written in the byte order of the writer, and is read on
+ * systems of the same byte order.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_LOG_INDEX_H_
+#define INCLUDE_GOINGLOGGING_LOG_INDEX_H_
+
+#include "core.h"
+#include "sink.h"
+#include "sites.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Start of index file, including format version. */
+static const char kIndexMagic[8] = {'G', 'L', 'I', 'N', 'D', 'E', 'X', '1'};
+/** Tag of record which defines a call site. */
+static const char kIndexSite = 'S';
+/** Tag of record of a chunk. */
+static const char kIndexCheckpoint = 'C';
+/** Bytes of lines which are buffered before they are written. */
+static const size_t kIndexWriteSize = 64 * 1024;
+
+/**
+ * \brief Append value to index record.
+ *
+ * \tparam T Value type.
+ * \param rec Record.
+ * \param v   Value.
+ */
+template<class T>
+void index_put(std::string& rec, T v) {
+    rec.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+/**
+ * \brief Read value of index record.
+ *
+ * \tparam T Value type.
+ * \param p   Position in index, advanced past the value.
+ * \param end End of index.
+ * \param v   Value.
+ * \return \c false if the index ends before the value.
+ */
+template<class T>
+bool index_get(const char*& p, const char* end, T& v) noexcept {
+    if (static_cast<size_t>(end - p) < sizeof(v)) {
+        return false;
+    }
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+/**
+ * \brief Write all bytes to file descriptor.
+ *
+ * \param fd File descriptor.
+ * \param s  Bytes [\p n].
+ * \param n  Number of bytes.
+ * \return \c true if success.
+ */
+inline bool write_all(int fd, const char* s, size_t n) noexcept {
+    while (n > 0) {
+        ssize_t w = ::write(fd, s, n);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        s += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+/**
+ * \brief Hash of call site, by file path and line.
+ */
+struct MessageSiteHash {
+    /**
+     * \param k File path and line.
+     * \return Hash.
+     */
+    size_t operator()(const std::pair<const char*, long>& k) const noexcept {
+        return std::hash<const char*>()(k.first) * 31 +
+               std::hash<long>()(k.second);
+    }
+};
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Call site of an index.
+ */
+struct IndexSite {
+    /**
+     * \brief Constructor.
+     */
+    IndexSite() : file(), line(0), func() {}
+
+    std::string file; /**< File name. */
+    long        line; /**< Line number in file. */
+    std::string func; /**< Function name. */
+};
+
+/**
+ * \brief Checkpoint of an index, which describes a chunk of the log file.
+ */
+struct IndexCheckpoint {
+    /**
+     * \brief Constructor.
+     */
+    IndexCheckpoint() :
+        offset(0), bytes(0), lines(0), first_ns(0), last_ns(0), counts(),
+        runs() {
+    }
+
+    uint64_t offset;   /**< Byte offset of chunk in log file. */
+    uint64_t bytes;    /**< Bytes of chunk. */
+    uint64_t lines;    /**< Lines of chunk. */
+    int64_t  first_ns; /**< Time of first line, ns since epoch. */
+    int64_t  last_ns;  /**< Time of last line, ns since epoch. */
+    /** Index of site and number of its lines, for each site in chunk. */
+    std::vector<std::pair<uint32_t, uint32_t>> counts;
+    /** Index of site of each line, as runs of index and number of lines. */
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+};
+
+/**
+ * \brief Stream buffer which writes lines to a file, and checkpoints of its
+ * chunks to an index file.
+ *
+ * Lines are attributed to the call site of the message which writes them.
+ * Lines written without l() and the other macros are counted as lines of no
+ * call site. Use start_indexed_file() to redirect std::cout to it.
+ *
+ * \sa start_indexed_file() \sa LogIndex
+ */
+class IndexedFileStreambuf : public internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    IndexedFileStreambuf() :
+        m_mutex(), m_fd(-1), m_index_fd(-1), m_chunk_size(0),
+        m_interval_ns(0), m_buf(), m_offset(0), m_bytes(0), m_lines(0),
+        m_first_ns(0), m_last_ns(0), m_ids(), m_counts(), m_touched(),
+        m_runs(), m_checkpoints(0) {
+    }
+
+    IndexedFileStreambuf(const IndexedFileStreambuf&) = delete;
+    IndexedFileStreambuf& operator=(const IndexedFileStreambuf&) = delete;
+
+    /**
+     * \brief Destructor. Write remaining lines and checkpoint.
+     */
+    ~IndexedFileStreambuf() override {
+        close();
+    }
+
+    /**
+     * \brief Create log file and index file, which are truncated if they
+     * exist.
+     *
+     * \param path       Path of log file. The index file has ".idx" appended.
+     * \param chunk_size Bytes of lines after which a chunk ends.
+     * \param interval   Time after which a chunk ends, when a line is
+     *                   written.
+     * \return \c true if success.
+     */
+    bool open(const std::string& path, size_t chunk_size = 1 << 20,
+        std::chrono::milliseconds interval = std::chrono::seconds(1)) {
+        close();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (chunk_size == 0) {
+            return false;
+        }
+        const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        m_fd            = ::open(path.c_str(), flags, 0644);
+        m_index_fd      = ::open((path + ".idx").c_str(), flags, 0644);
+        if (m_fd < 0 || m_index_fd < 0 ||
+            !internal::write_all(m_index_fd, internal::kIndexMagic,
+                sizeof(internal::kIndexMagic))) {
+            close_files();
+            return false;
+        }
+        m_chunk_size  = chunk_size;
+        m_interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            interval)
+                            .count();
+        m_offset = 0;
+        m_ids.clear();
+        m_counts.clear();
+        m_runs.clear();
+        m_checkpoints.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * \brief Write remaining lines and checkpoint, and close files. No
+     * thread may write to the stream buffer meanwhile.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fd >= 0) {
+            checkpoint();
+        }
+        close_files();
+    }
+
+    /**
+     * \return \c true if open.
+     */
+    bool is_open() const noexcept {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_fd >= 0;
+    }
+
+    /**
+     * \return Number of checkpoints written.
+     */
+    uint64_t checkpoints() const noexcept {
+        return m_checkpoints.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    /**
+     * \brief Buffer line and newline.
+     *
+     * \param s Line without newline [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) override {
+        append(s, n, true);
+    }
+
+    /**
+     * \brief Buffer CBOR message.
+     *
+     * \param s Message [\p n].
+     * \param n Number of bytes.
+     */
+    void write_message(const char* s, size_t n) override {
+        append(s, n, false);
+    }
+
+    /**
+     * \brief Write unfinished line of this thread, and buffered lines, to
+     * the log file. The checkpoint is not written until the chunk ends.
+     *
+     * \return 0.
+     */
+    int sync() override {
+        internal::LineStreambuf::sync();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fd >= 0) {
+            write_buffer();
+        }
+        return 0;
+    }
+
+  private:
+    /** Index of lines of no call site. */
+    static const uint32_t kNoSite = 0xffffffff;
+
+    /**
+     * \brief Buffer message, and count it in the current chunk.
+     *
+     * \param s       Message [\p n].
+     * \param n       Number of characters.
+     * \param newline \c true to append a newline.
+     */
+    void append(const char* s, size_t n, bool newline) {
+        internal::MessageSite& site = internal::message_site();
+        const int64_t          now =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fd < 0) {
+            return;
+        }
+        if (m_lines == 0) {
+            m_first_ns = now;
+        }
+        m_last_ns = now;
+        ++m_lines;
+        m_bytes += n + (newline ? 1 : 0);
+        count(site);
+        // Only the first line of a message is counted for its site
+        site.file_path = nullptr;
+        m_buf.append(s, n);
+        if (newline) {
+            m_buf.push_back('\n');
+        }
+        if (m_buf.size() >= internal::kIndexWriteSize) {
+            write_buffer();
+        }
+        if (m_bytes >= m_chunk_size || now - m_first_ns >= m_interval_ns) {
+            checkpoint();
+        }
+    }
+
+    /**
+     * \brief Count line of call site, and define the site in the index if
+     * new.
+     *
+     * \param site Call site, or none.
+     */
+    void count(const internal::MessageSite& site) {
+        uint32_t id = kNoSite;
+        if (site.file_path != nullptr) {
+            auto key = std::make_pair(site.file_path, site.file_line);
+            auto it  = m_ids.find(key);
+            if (it == m_ids.end()) {
+                it = m_ids.emplace(key, static_cast<uint32_t>(m_ids.size()))
+                         .first;
+                define(it->second, site);
+            }
+            id = it->second;
+        }
+        const size_t slot = id == kNoSite ? 0 : id + 1;
+        if (slot >= m_counts.size()) {
+            m_counts.resize(slot + 1, 0);
+        }
+        if (m_counts[slot]++ == 0) {
+            m_touched.push_back(id);
+        }
+        if (m_runs.empty() || m_runs.back().first != id) {
+            m_runs.emplace_back(id, 0);
+        }
+        ++m_runs.back().second;
+    }
+
+    /**
+     * \brief Append definition of call site to index.
+     *
+     * \param id   Index of site.
+     * \param site Call site.
+     */
+    void define(uint32_t id, const internal::MessageSite& site) {
+        const char* file = internal::file_name(site.file_path);
+        const char* func = site.func != nullptr ? site.func : "";
+        std::string rec(1, internal::kIndexSite);
+        internal::index_put(rec, id);
+        internal::index_put(rec, static_cast<int64_t>(site.file_line));
+        internal::index_put(rec, static_cast<uint32_t>(std::strlen(file)));
+        rec += file;
+        internal::index_put(rec, static_cast<uint32_t>(std::strlen(func)));
+        rec += func;
+        internal::write_all(m_index_fd, rec.data(), rec.size());
+    }
+
+    /**
+     * \brief Write buffered lines to log file.
+     */
+    void write_buffer() {
+        internal::write_all(m_fd, m_buf.data(), m_buf.size());
+        m_buf.clear();
+    }
+
+    /**
+     * \brief End chunk. Write its lines, and then its checkpoint, so that
+     * the index never describes lines which are not written.
+     */
+    void checkpoint() {
+        write_buffer();
+        if (m_lines == 0) {
+            return;
+        }
+        std::string rec(1, internal::kIndexCheckpoint);
+        internal::index_put(rec, m_offset);
+        internal::index_put(rec, m_bytes);
+        internal::index_put(rec, m_lines);
+        internal::index_put(rec, m_first_ns);
+        internal::index_put(rec, m_last_ns);
+        internal::index_put(rec, static_cast<uint32_t>(m_touched.size()));
+        for (uint32_t id : m_touched) {
+            uint32_t& c = m_counts[id == kNoSite ? 0 : id + 1];
+            internal::index_put(rec, id);
+            internal::index_put(rec, c);
+            c = 0;
+        }
+        internal::index_put(rec, static_cast<uint32_t>(m_runs.size()));
+        for (const auto& run : m_runs) {
+            internal::index_put(rec, run.first);
+            internal::index_put(rec, run.second);
+        }
+        internal::write_all(m_index_fd, rec.data(), rec.size());
+        m_touched.clear();
+        m_runs.clear();
+        m_offset += m_bytes;
+        m_bytes = 0;
+        m_lines = 0;
+        m_checkpoints.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Close log file and index file.
+     */
+    void close_files() noexcept {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        if (m_index_fd >= 0) {
+            ::close(m_index_fd);
+        }
+        m_fd       = -1;
+        m_index_fd = -1;
+    }
+
+    mutable std::mutex m_mutex;       /**< Guards all below but atomics. */
+    int                m_fd;          /**< Log file. */
+    int                m_index_fd;    /**< Index file. */
+    size_t             m_chunk_size;  /**< Bytes after which chunk ends. */
+    int64_t            m_interval_ns; /**< Time after which chunk ends. */
+    std::string        m_buf;         /**< Lines not written yet. */
+    uint64_t           m_offset;      /**< Offset of chunk. */
+    uint64_t           m_bytes;       /**< Bytes of chunk. */
+    uint64_t           m_lines;       /**< Lines of chunk. */
+    int64_t            m_first_ns;    /**< Time of first line of chunk. */
+    int64_t            m_last_ns;     /**< Time of last line of chunk. */
+    /** Index of each call site, by file path and line. */
+    std::unordered_map<std::pair<const char*, long>, uint32_t,
+        internal::MessageSiteHash>
+        m_ids;
+    std::vector<uint32_t> m_counts; /**< Lines of chunk, by index + 1. */
+    std::vector<uint32_t> m_touched;     /**< Sites of chunk. */
+    /** Index of site of each line of chunk, as runs of index and lines. */
+    std::vector<std::pair<uint32_t, uint32_t>> m_runs;
+    std::atomic<uint64_t> m_checkpoints; /**< Checkpoints written. */
+};
+
+/**
+ * \brief Reader of the index of a log file written by IndexedFileStreambuf.
+ *
+ * \sa IndexedFileStreambuf
+ */
+class LogIndex {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    LogIndex() : m_sites(), m_checkpoints() {}
+
+    /**
+     * \brief Read index, with mmap(). A record which is cut short, e.g.
+     * since the writer crashed, is ignored.
+     *
+     * \param path Path of index file.
+     * \return \c true if success.
+     */
+    bool open(const std::string& path) {
+        m_sites.clear();
+        m_checkpoints.clear();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 ||
+            st.st_size < static_cast<off_t>(sizeof(internal::kIndexMagic))) {
+            ::close(fd);
+            return false;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void*        map  = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        const char* p   = static_cast<const char*>(map);
+        const bool  ok  = std::memcmp(p, internal::kIndexMagic,
+                            sizeof(internal::kIndexMagic)) == 0;
+        if (ok) {
+            parse(p + sizeof(internal::kIndexMagic), p + size);
+        }
+        munmap(map, size);
+        return ok;
+    }
+
+    /**
+     * \return Call sites, by index.
+     */
+    const std::vector<IndexSite>& sites() const noexcept {
+        return m_sites;
+    }
+
+    /**
+     * \return Checkpoints, in file order.
+     */
+    const std::vector<IndexCheckpoint>& checkpoints() const noexcept {
+        return m_checkpoints;
+    }
+
+    /**
+     * \brief Get bytes of log file which are described by checkpoints.
+     *
+     * \return Offset after the last chunk.
+     */
+    uint64_t indexed_bytes() const noexcept {
+        return m_checkpoints.empty() ?
+                   0 :
+                   m_checkpoints.back().offset + m_checkpoints.back().bytes;
+    }
+
+    /**
+     * \brief Check if call site matches pattern.
+     *
+     * \param id      Index of site.
+     * \param pattern Glob pattern, matched against "file:line" and function
+     *                name.
+     * \return \c true if match.
+     */
+    bool matches(uint32_t id, const std::string& pattern) const {
+        if (id >= m_sites.size()) {
+            return false;
+        }
+        const IndexSite&  s        = m_sites[id];
+        const std::string location = s.file + ':' + std::to_string(s.line);
+        return internal::glob_match(pattern.c_str(), location.c_str()) ||
+               internal::glob_match(pattern.c_str(), s.func.c_str());
+    }
+
+    /**
+     * \brief Check which call sites match pattern.
+     *
+     * \param pattern Glob pattern, or empty to match all.
+     * \return Whether each site matches, by index.
+     */
+    std::vector<bool> matching(const std::string& pattern) const {
+        std::vector<bool> match(m_sites.size(), pattern.empty());
+        for (uint32_t id = 0; !pattern.empty() && id < m_sites.size(); ++id) {
+            match[id] = matches(id, pattern);
+        }
+        return match;
+    }
+
+    /**
+     * \brief Select chunks which may contain lines of a time range and call
+     * sites.
+     *
+     * \param from_ns First time, in ns since epoch.
+     * \param to_ns   Last time, in ns since epoch.
+     * \param pattern Glob pattern of call sites, or empty for all lines.
+     * \return Indices of checkpoints, in file order.
+     */
+    std::vector<size_t> select(
+        int64_t from_ns, int64_t to_ns, const std::string& pattern) const {
+        const std::vector<bool> match = matching(pattern);
+        std::vector<size_t>     chunks;
+        for (size_t i = 0; i < m_checkpoints.size(); ++i) {
+            const IndexCheckpoint& c = m_checkpoints[i];
+            if (c.last_ns < from_ns || c.first_ns > to_ns) {
+                continue;
+            }
+            bool any = pattern.empty();
+            for (size_t j = 0; !any && j < c.counts.size(); ++j) {
+                any = c.counts[j].first < match.size() &&
+                      match[c.counts[j].first];
+            }
+            if (any) {
+                chunks.push_back(i);
+            }
+        }
+        return chunks;
+    }
+
+    /**
+     * \brief Call function for each line of chunk, with its call site.
+     *
+     * \tparam F Function type.
+     * \param data Chunk [\p c.bytes], read from the log file at \p c.offset.
+     * \param c    Checkpoint of chunk.
+     * \param f    Function, called with line without newline, its number of
+     *             characters, and index of its call site. The index is not
+     *             of any site for lines of no call site.
+     */
+    template<class F>
+    static void for_each_line(
+        const char* data, const IndexCheckpoint& c, F f) {
+        const char* p    = data;
+        const char* end  = data + c.bytes;
+        size_t      run  = 0;
+        uint32_t    left = c.runs.empty() ? 0 : c.runs[0].second;
+        while (p != end) {
+            while (left == 0 && run + 1 < c.runs.size()) {
+                left = c.runs[++run].second;
+            }
+            uint32_t id = std::numeric_limits<uint32_t>::max();
+            if (left != 0) {
+                id = c.runs[run].first;
+                --left;
+            }
+            const char* nl = static_cast<const char*>(
+                std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* eol = nl == nullptr ? end : nl;
+            f(p, static_cast<size_t>(eol - p), id);
+            p = nl == nullptr ? end : nl + 1;
+        }
+    }
+
+  private:
+    /**
+     * \brief Parse records of index.
+     *
+     * \param p   First record.
+     * \param end End of index.
+     */
+    void parse(const char* p, const char* end) {
+        char tag = 0;
+        while (internal::index_get(p, end, tag)) {
+            if (tag == internal::kIndexSite) {
+                uint32_t  id  = 0;
+                int64_t   line = 0;
+                IndexSite s;
+                if (!internal::index_get(p, end, id) ||
+                    !internal::index_get(p, end, line) ||
+                    !get_string(p, end, s.file) ||
+                    !get_string(p, end, s.func)) {
+                    return;
+                }
+                s.line = static_cast<long>(line);
+                if (id >= m_sites.size()) {
+                    m_sites.resize(id + 1);
+                }
+                m_sites[id] = std::move(s);
+            } else if (tag == internal::kIndexCheckpoint) {
+                IndexCheckpoint c;
+                uint32_t        n = 0;
+                if (!internal::index_get(p, end, c.offset) ||
+                    !internal::index_get(p, end, c.bytes) ||
+                    !internal::index_get(p, end, c.lines) ||
+                    !internal::index_get(p, end, c.first_ns) ||
+                    !internal::index_get(p, end, c.last_ns) ||
+                    !internal::index_get(p, end, n) ||
+                    static_cast<size_t>(end - p) < n * size_t(8)) {
+                    return;
+                }
+                c.counts.resize(n);
+                for (auto& sc : c.counts) {
+                    internal::index_get(p, end, sc.first);
+                    internal::index_get(p, end, sc.second);
+                }
+                if (!internal::index_get(p, end, n) ||
+                    static_cast<size_t>(end - p) < n * size_t(8)) {
+                    return;
+                }
+                c.runs.resize(n);
+                for (auto& run : c.runs) {
+                    internal::index_get(p, end, run.first);
+                    internal::index_get(p, end, run.second);
+                }
+                m_checkpoints.push_back(std::move(c));
+            } else {
+                return;
+            }
+        }
+    }
+
+    /**
+     * \brief Read string of index record.
+     *
+     * \param p   Position in index, advanced past the string.
+     * \param end End of index.
+     * \param s   String.
+     * \return \c false if the index ends before the string.
+     */
+    static bool get_string(const char*& p, const char* end, std::string& s) {
+        uint32_t n = 0;
+        if (!internal::index_get(p, end, n) ||
+            static_cast<size_t>(end - p) < n) {
+            return false;
+        }
+        s.assign(p, n);
+        p += n;
+        return true;
+    }
+
+    std::vector<IndexSite>       m_sites;       /**< Sites, by index. */
+    std::vector<IndexCheckpoint> m_checkpoints; /**< Checkpoints. */
+};
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Indexed file sink which std::cout is redirected to.
+ */
+typedef CoutRedirect<IndexedFileStreambuf> IndexedFileSink;
+
+/**
+ * \return Indexed file sink.
+ */
+inline IndexedFileSink& indexed_file_sink() {
+    static IndexedFileSink sink;
+    return sink;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stop writing to the indexed file. Writes the remaining lines and
+ * checkpoint, and restores std::cout.
+ *
+ * \sa start_indexed_file()
+ *
+ */
+inline void stop_indexed_file() {
+    internal::IndexedFileSink& sink = internal::indexed_file_sink();
+    if (sink.buf.is_open()) {
+        std::cout.flush();
+        sink.restore();
+        sink.buf.close();
+    }
+}
+
+/**
+ * \brief Redirect std::cout to a log file, and write an index of it.
+ *
+ * \param path       Path of log file. The index file has ".idx" appended.
+ *                   Both are truncated if they exist.
+ * \param chunk_size Bytes of lines after which a chunk ends.
+ * \param interval   Time after which a chunk ends, when a line is written.
+ * \return \c true if success.
+ *
+ * \note Query the file with the gl_query tool, or with LogIndex.
+ *
+ * \sa stop_indexed_file() \sa IndexedFileStreambuf
+ *
+ */
+inline bool start_indexed_file(const std::string& path,
+    size_t                    chunk_size = 1 << 20,
+    std::chrono::milliseconds interval   = std::chrono::seconds(1)) {
+    stop_indexed_file();
+    internal::IndexedFileSink& sink = internal::indexed_file_sink();
+    if (!sink.buf.open(path, chunk_size, interval)) {
+        return false;
+    }
+    sink.redirect();
+    return true;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_LOG_INDEX_H_
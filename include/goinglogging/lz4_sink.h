@@ -0,0 +1,563 @@
+/** \file
+ *
+ * \brief Sink which compresses messages to the LZ4 frame format on a
+ * background thread.
+ *
+ * Optional. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/lz4_sink.h"
+ *
+ * std::ofstream f("log.txt.lz4", std::ios::binary);
+ * gl::start_lz4_sink(f);
+ * \endcode
+ *
+ * Messages are collected in blocks of 64 KiB, which are compressed
+ * independently of each other by a background thread. The compressor is
+ * built in, and greedy with a hash table of 4096 entries, as the fast mode
+ * of the LZ4 reference implementation. Read the output with the lz4 tool:
+ * \code
+ * lz4 -dc log.txt.lz4
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_LZ4_SINK_H_
+#define INCLUDE_GOINGLOGGING_LZ4_SINK_H_
+
+#include "core.h"
+#include "sink.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Largest number of uncompressed bytes per block. */
+static const size_t kLz4BlockSize = 64 * 1024;
+/** Number of full blocks waiting for compression, before logging waits. */
+static const size_t kLz4MaxQueued = 16;
+/** Bytes at end of block which are always literals. */
+static const size_t kLz4LastLiterals = 5;
+/** Bytes at end of block in which no match may start. */
+static const size_t kLz4MatchLimit = 12;
+/** Shortest match. */
+static const size_t kLz4MinMatch = 4;
+/** Number of bits of hash table index. */
+static const unsigned kLz4HashBits = 12;
+
+/**
+ * \brief Read 32 bit little endian integer.
+ *
+ * \param p Bytes.
+ * \return Integer.
+ */
+inline uint32_t read_le32(const unsigned char* p) noexcept {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+/**
+ * \brief Write 32 bit little endian integer.
+ *
+ * \param p Bytes [4].
+ * \param v Integer.
+ */
+inline void write_le32(unsigned char* p, uint32_t v) noexcept {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+/**
+ * \brief Calculate xxHash32, which checksums LZ4 frame descriptors.
+ *
+ * \param p    Bytes [\p n].
+ * \param n    Number of bytes.
+ * \param seed Seed.
+ * \return Hash.
+ */
+inline uint32_t xxh32(const unsigned char* p, size_t n, uint32_t seed) {
+    static const uint32_t prime1 = 2654435761U;
+    static const uint32_t prime2 = 2246822519U;
+    static const uint32_t prime3 = 3266489917U;
+    static const uint32_t prime4 = 668265263U;
+    static const uint32_t prime5 = 374761393U;
+    auto rotl = [](uint32_t x, int r) { return (x << r) | (x >> (32 - r)); };
+    const unsigned char* end = p + n;
+    uint32_t             h   = 0;
+    if (n >= 16) {
+        uint32_t v[4] = {seed + prime1 + prime2, seed + prime2, seed,
+            seed - prime1};
+        for (; end - p >= 16; p += 16) {
+            for (int i = 0; i < 4; ++i) {
+                v[i] = rotl(v[i] + read_le32(p + 4 * i) * prime2, 13) * prime1;
+            }
+        }
+        h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+    } else {
+        h = seed + prime5;
+    }
+    h += static_cast<uint32_t>(n);
+    for (; end - p >= 4; p += 4) {
+        h = rotl(h + read_le32(p) * prime3, 17) * prime4;
+    }
+    for (; p != end; ++p) {
+        h = rotl(h + *p * prime5, 11) * prime1;
+    }
+    h ^= h >> 15;
+    h *= prime2;
+    h ^= h >> 13;
+    h *= prime3;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * \brief Get largest size of compressed block.
+ *
+ * \param n Number of uncompressed bytes.
+ * \return Number of bytes.
+ */
+inline size_t lz4_bound(size_t n) noexcept {
+    return n + n / 255 + 16;
+}
+
+/**
+ * \brief Write length in the LZ4 way, as bytes of 255 and a final byte
+ * below 255.
+ *
+ * \param dst Output. Advanced.
+ * \param n   Length, less the 15 in the token.
+ */
+inline void lz4_write_length(unsigned char*& dst, size_t n) noexcept {
+    for (; n >= 255; n -= 255) {
+        *dst++ = 255;
+    }
+    *dst++ = static_cast<unsigned char>(n);
+}
+
+/**
+ * \brief Write sequence of literals and match.
+ *
+ * \param dst      Output. Advanced.
+ * \param literals Literals [\p n_lit].
+ * \param n_lit    Number of literals.
+ * \param offset   Distance back to match, or 0 if none, at end of block.
+ * \param n_match  Match length, at least kLz4MinMatch if \p offset != 0.
+ */
+inline void lz4_write_sequence(unsigned char*& dst,
+    const unsigned char* literals, size_t n_lit, size_t offset,
+    size_t n_match) noexcept {
+    size_t m = offset == 0 ? 0 : n_match - kLz4MinMatch;
+    *dst++   = static_cast<unsigned char>(
+        (n_lit < 15 ? n_lit : 15) << 4 | (m < 15 ? m : 15));
+    if (n_lit >= 15) {
+        lz4_write_length(dst, n_lit - 15);
+    }
+    std::memcpy(dst, literals, n_lit);
+    dst += n_lit;
+    if (offset == 0) {
+        return;
+    }
+    *dst++ = static_cast<unsigned char>(offset);
+    *dst++ = static_cast<unsigned char>(offset >> 8);
+    if (m >= 15) {
+        lz4_write_length(dst, m - 15);
+    }
+}
+
+/**
+ * \brief Compress block to the LZ4 block format.
+ *
+ * Finds matches greedily, with a hash table of the last position of each
+ * hash of 4 bytes. Skips faster through data without matches.
+ *
+ * \param src Uncompressed bytes [\p n].
+ * \param n   Number of bytes, at most kLz4BlockSize.
+ * \param dst Compressed bytes [lz4_bound(\p n)].
+ * \return Number of compressed bytes.
+ */
+inline size_t lz4_compress_block(
+    const unsigned char* src, size_t n, unsigned char* dst) noexcept {
+    // Positions + 1, so that 0 is empty
+    uint32_t       table[1 << kLz4HashBits] = {0};
+    unsigned char* out                      = dst;
+    size_t         anchor                   = 0;
+    size_t         pos                      = 0;
+    while (n > kLz4MatchLimit && pos < n - kLz4MatchLimit) {
+        uint32_t v   = read_le32(src + pos);
+        uint32_t h   = (v * 2654435761U) >> (32 - kLz4HashBits);
+        size_t   ref = table[h];
+        table[h]     = static_cast<uint32_t>(pos + 1);
+        if (ref == 0 || pos + 1 - ref > 65535 ||
+            read_le32(src + ref - 1) != v) {
+            // Step further the longer since the last match
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+        --ref;
+
+        // Extend match backwards and forwards
+        while (pos > anchor && ref > 0 && src[pos - 1] == src[ref - 1]) {
+            --pos;
+            --ref;
+        }
+        size_t len = kLz4MinMatch;
+        while (pos + len < n - kLz4LastLiterals &&
+               src[pos + len] == src[ref + len]) {
+            ++len;
+        }
+        lz4_write_sequence(out, src + anchor, pos - anchor, pos - ref, len);
+        pos += len;
+        anchor = pos;
+    }
+    lz4_write_sequence(out, src + anchor, n - anchor, 0, 0);
+    return static_cast<size_t>(out - dst);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stream buffer which compresses lines to an output stream in the
+ * LZ4 frame format, on a background thread.
+ *
+ * Lines are never split or interleaved, also when written by several
+ * threads. Use start_lz4_sink() to redirect std::cout to it.
+ *
+ * \sa start_lz4_sink()
+ */
+class Lz4Streambuf : public internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    Lz4Streambuf() :
+        m_os(nullptr), m_mutex(), m_ready(), m_space(), m_block(),
+        m_queue(), m_free(), m_stop(false), m_thread(), m_in(0), m_out(0),
+        m_ns(0) {
+    }
+
+    Lz4Streambuf(const Lz4Streambuf&) = delete;
+    Lz4Streambuf& operator=(const Lz4Streambuf&) = delete;
+
+    /**
+     * \brief Destructor. Compress remaining lines and end frame.
+     */
+    ~Lz4Streambuf() override {
+        close();
+    }
+
+    /**
+     * \brief Start frame.
+     *
+     * \param os Output stream, opened in binary mode. Must not be std::cout
+     *           while std::cout is redirected to this stream buffer.
+     * \return \c true if success.
+     */
+    bool open(std::ostream& os) {
+        close();
+        // Magic, independent blocks of at most 64 KiB, and descriptor hash
+        unsigned char header[7] = {0x04, 0x22, 0x4D, 0x18, 0x60, 0x40, 0};
+        header[6] = static_cast<unsigned char>(
+            internal::xxh32(header + 4, 2, 0) >> 8);
+        os.write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (!os) {
+            return false;
+        }
+        m_os   = &os;
+        m_stop = false;
+        m_out.fetch_add(sizeof(header), std::memory_order_relaxed);
+        m_thread = std::thread(&Lz4Streambuf::run, this);
+        return true;
+    }
+
+    /**
+     * \brief Compress remaining lines, end frame and stop. No thread may
+     * write to the stream buffer meanwhile.
+     */
+    void close() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_block.empty()) {
+                m_queue.push_back(std::move(m_block));
+                m_block.clear();
+            }
+            m_stop = true;
+        }
+        m_ready.notify_one();
+        m_thread.join();
+        unsigned char end[4] = {0, 0, 0, 0};
+        m_os->write(reinterpret_cast<const char*>(end), sizeof(end));
+        m_os->flush();
+        m_out.fetch_add(sizeof(end), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_os = nullptr;
+    }
+
+    /**
+     * \return \c true if open.
+     */
+    bool is_open() const noexcept {
+        return m_thread.joinable();
+    }
+
+    /**
+     * \return Number of uncompressed bytes compressed since created.
+     */
+    uint64_t input_bytes() const noexcept {
+        return m_in.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \return Number of bytes written since created, including frame
+     *         headers.
+     */
+    uint64_t output_bytes() const noexcept {
+        return m_out.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \return Uncompressed bytes per written byte, or 0 if nothing written.
+     */
+    double compression_ratio() const noexcept {
+        uint64_t out = output_bytes();
+        return out == 0 ? 0.0
+                        : static_cast<double>(input_bytes()) /
+                              static_cast<double>(out);
+    }
+
+    /**
+     * \return Uncompressed bytes compressed per second of compression, or 0
+     *         if nothing compressed.
+     */
+    double throughput() const noexcept {
+        uint64_t ns = m_ns.load(std::memory_order_relaxed);
+        return ns == 0 ? 0.0
+                       : static_cast<double>(input_bytes()) * 1e9 /
+                             static_cast<double>(ns);
+    }
+
+  protected:
+    /**
+     * \brief Append line and newline.
+     *
+     * \param s Line [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) override {
+        append(s, n, true);
+    }
+
+    /**
+     * \brief Append CBOR message.
+     *
+     * \param s Message [\p n].
+     * \param n Number of bytes.
+     */
+    void write_message(const char* s, size_t n) override {
+        append(s, n, false);
+    }
+
+  private:
+    /**
+     * \brief Append message to block. Queue the block for compression when
+     * full.
+     *
+     * \param s       Message [\p n].
+     * \param n       Number of characters.
+     * \param newline \c true to append a newline.
+     */
+    void append(const char* s, size_t n, bool newline) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_os == nullptr) {
+            return;
+        }
+        while (n > 0 || newline) {
+            if (m_block.capacity() < internal::kLz4BlockSize) {
+                m_block.reserve(internal::kLz4BlockSize);
+            }
+            size_t c = std::min(n, internal::kLz4BlockSize - m_block.size());
+            m_block.append(s, c);
+            s += c;
+            n -= c;
+            if (n == 0 && newline &&
+                m_block.size() < internal::kLz4BlockSize) {
+                m_block.push_back('\n');
+                newline = false;
+            }
+            if (m_block.size() == internal::kLz4BlockSize) {
+                m_space.wait(lock, [this]() {
+                    return m_queue.size() < internal::kLz4MaxQueued;
+                });
+                m_queue.push_back(std::move(m_block));
+                m_block.clear();
+                if (!m_free.empty()) {
+                    m_block.swap(m_free.back());
+                    m_free.pop_back();
+                }
+                m_ready.notify_one();
+            }
+        }
+    }
+
+    /**
+     * \brief Compress and write blocks until stopped.
+     */
+    void run() {
+        std::vector<unsigned char> out(
+            4 + internal::lz4_bound(internal::kLz4BlockSize));
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_ready.wait(lock, [this]() { return !m_queue.empty() || m_stop; });
+            if (m_queue.empty()) {
+                break;
+            }
+            std::string block = std::move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+            m_space.notify_one();
+
+            auto t0 = std::chrono::steady_clock::now();
+            const unsigned char* src =
+                reinterpret_cast<const unsigned char*>(block.data());
+            size_t n = internal::lz4_compress_block(
+                src, block.size(), out.data() + 4);
+            if (n >= block.size()) {
+                // Stored uncompressed, with the high bit of the size set
+                std::memcpy(out.data() + 4, src, block.size());
+                n = block.size();
+                internal::write_le32(
+                    out.data(), static_cast<uint32_t>(n) | 0x80000000U);
+            } else {
+                internal::write_le32(out.data(), static_cast<uint32_t>(n));
+            }
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0);
+            m_os->write(reinterpret_cast<const char*>(out.data()),
+                static_cast<std::streamsize>(4 + n));
+            m_in.fetch_add(block.size(), std::memory_order_relaxed);
+            m_out.fetch_add(4 + n, std::memory_order_relaxed);
+            m_ns.fetch_add(static_cast<uint64_t>(ns.count()),
+                std::memory_order_relaxed);
+
+            block.clear();
+            lock.lock();
+            m_free.push_back(std::move(block));
+        }
+    }
+
+    std::ostream*           m_os;     /**< Output, or nullptr if closed. */
+    std::mutex              m_mutex;  /**< Guards all below but atomics. */
+    std::condition_variable m_ready;  /**< Signals full block. */
+    std::condition_variable m_space;  /**< Signals compressed block. */
+    std::string             m_block;  /**< Block being filled. */
+    std::deque<std::string> m_queue;  /**< Full blocks to compress. */
+    std::vector<std::string> m_free;  /**< Compressed blocks, for reuse. */
+    bool                    m_stop;   /**< \c true when closing. */
+    std::thread             m_thread; /**< Background thread. */
+    std::atomic<uint64_t>   m_in;     /**< Uncompressed bytes. */
+    std::atomic<uint64_t>   m_out;    /**< Written bytes. */
+    std::atomic<uint64_t>   m_ns;     /**< Nanoseconds compressing. */
+};
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Sink which std::cout is redirected to by start_lz4_sink().
+ */
+typedef CoutRedirect<Lz4Streambuf> Lz4Sink;
+
+/**
+ * \return Sink of start_lz4_sink().
+ */
+inline Lz4Sink& lz4_sink() {
+    static Lz4Sink sink;
+    return sink;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stop compressing std::cout, end the LZ4 frame and restore the
+ * previous stream buffer of std::cout.
+ *
+ * \sa start_lz4_sink()
+ *
+ */
+inline void stop_lz4_sink() {
+    internal::Lz4Sink& sink = internal::lz4_sink();
+    if (sink.buf.is_open()) {
+        std::cout.flush();
+        sink.restore();
+        sink.buf.close();
+    }
+}
+
+/**
+ * \brief Compress std::cout, and thereby all logging, in the LZ4 frame
+ * format to an output stream.
+ *
+ * Used as:
+ * \code
+ * std::ofstream f("log.txt.lz4", std::ios::binary);
+ * gl::start_lz4_sink(f);
+ * \endcode
+ * Compression ratio and throughput are available from
+ * Lz4Streambuf::compression_ratio() and Lz4Streambuf::throughput() of
+ * lz4_sink_stats().
+ *
+ * \param os Output stream, opened in binary mode. Must outlive the sink.
+ * \return \c true if started.
+ *
+ * \note Must not be called while other threads log.
+ *
+ * \sa stop_lz4_sink() \sa Lz4Streambuf
+ *
+ */
+inline bool start_lz4_sink(std::ostream& os) {
+    stop_lz4_sink();
+    internal::Lz4Sink& sink = internal::lz4_sink();
+    if (!sink.buf.open(os)) {
+        return false;
+    }
+    sink.redirect();
+    return true;
+}
+
+/**
+ * \brief Get compression statistics of start_lz4_sink(), accumulated over
+ * all starts.
+ *
+ * \return Stream buffer of the sink.
+ *
+ * \sa start_lz4_sink()
+ *
+ */
+inline const Lz4Streambuf& lz4_sink_stats() {
+    return internal::lz4_sink().buf;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_LZ4_SINK_H_
@@ -0,0 +1,538 @@
+/** \file
+ *
+ * \brief Dump arrays and matrices to NumPy .npy files with l_npy() and
+ * l_npy_mat(), instead of logging every element.
+ *
+ * Optional. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/npy.h"
+ *
+ * double m[1000][1000];
+ * l_npy_mat(m, 1000, 1000);
+ * \endcode
+ *
+ * The elements are written as raw bytes, without any text formatting, to a
+ * file named after the variable, the call site and a sequence number. Only a
+ * one-line reference to the file is logged. Load it with
+ * <tt>numpy.load()</tt>.
+ *
+ * Elements must be of arithmetic type or std::complex. Elements which are
+ * adjacent in memory are written with one call.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_NPY_H_
+#define INCLUDE_GOINGLOGGING_NPY_H_
+
+#include "core.h"
+#include <atomic>
+#include <cerrno>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/**
+ * \brief Dump array to a NumPy .npy file, and log a reference to it.
+ *
+ * \param v   Array to dump [\p len].
+ * \param len Number of elements.
+ *
+ * Used as:
+ * \code
+ * double a[] = {0.5, 1.5, 2.5};
+ * l_npy(a, 3);
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * a: npy = "a.main.cpp.12.0.npy", dtype = <f8, shape = (3,)
+ * \endcode
+ *
+ * \note Uses prefix information set with \ref set_prefixes().
+ *
+ * \warning Behaviour is undefined if \p len is larger than the
+ * allocated array.
+ *
+ * \sa l_npy_mat() \sa l_arr() \sa set_npy_directory()
+ *
+ */
+#define l_npy(v, len)                                                      \
+    GL_INTERNAL_EMIT(::gl::internal::make_npy(::gl::internal::make_array(  \
+        (#v), (v), (len), gl_internal_log_site.prefix())))
+
+/**
+ * \brief Dump matrix to a NumPy .npy file, and log a reference to it.
+ *
+ * \param m    Matrix to dump [\p rows x \p cols].
+ * \param cols Number of columns in matrix.
+ * \param rows Number of rows in matrix.
+ *
+ * Used as:
+ * \code
+ * int m[2][3] = {{11, 12, 13}, {21, 22, 23}};
+ * l_npy_mat(m, 3, 2);
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * m: npy = "m.main.cpp.12.0.npy", dtype = <i4, shape = (2, 3)
+ * \endcode
+ *
+ * \note Uses prefix information set with \ref set_prefixes().
+ * \note Takes the number of columns before the number of rows, as
+ * \ref l_mat().
+ *
+ * \warning Behaviour is undefined if \p cols or \p rows is larger than
+ * the allocated matrix.
+ *
+ * \sa l_npy() \sa l_mat() \sa set_npy_directory()
+ *
+ */
+#define l_npy_mat(m, cols, rows)                                           \
+    GL_INTERNAL_EMIT(::gl::internal::make_npy(::gl::internal::make_matrix( \
+        (#m), (m), (cols), (rows), gl_internal_log_site.prefix())))
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Directory and sequence number of .npy files.
+ */
+struct NpyState {
+    /**
+     * \brief Constructor.
+     */
+    NpyState() : mutex(), directory(), sequence(0) {}
+
+    std::mutex            mutex;     /**< Guards directory. */
+    std::string           directory; /**< Directory, empty if current. */
+    std::atomic<uint64_t> sequence;  /**< Number of next file. */
+};
+
+/**
+ * \return Directory and sequence number of .npy files.
+ */
+inline NpyState& npy_state() {
+    static NpyState state;
+    return state;
+}
+
+/**
+ * \brief NumPy type character and size of element type.
+ *
+ * \tparam T Element type.
+ */
+template<class T, class Enable = void>
+struct NpyType {
+    static_assert(std::is_arithmetic<T>::value,
+        "l_npy() and l_npy_mat() only support elements of arithmetic types "
+        "and std::complex");
+};
+
+/**
+ * \brief NumPy type of bool.
+ */
+template<>
+struct NpyType<bool> {
+    static const char kind = 'b'; /**< Type character. */
+};
+
+/**
+ * \brief NumPy type of integer.
+ *
+ * \tparam T Integer type.
+ */
+template<class T>
+struct NpyType<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    /** Type character. */
+    static const char kind = std::is_signed<T>::value ? 'i' : 'u';
+};
+
+/**
+ * \brief NumPy type of floating point number.
+ *
+ * \tparam T Floating point type.
+ */
+template<class T>
+struct NpyType<T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static const char kind = 'f'; /**< Type character. */
+};
+
+/**
+ * \brief NumPy type of complex number.
+ *
+ * \tparam T Floating point type.
+ */
+template<class T>
+struct NpyType<std::complex<T>> {
+    static const char kind = 'c'; /**< Type character. */
+};
+
+/**
+ * \brief Get NumPy type description, e.g. "<f8".
+ *
+ * \tparam T Element type.
+ * \param buf Buffer for description.
+ * \return \p buf.
+ */
+template<class T>
+const char* npy_descr(char (&buf)[8]) noexcept {
+    const uint16_t one = 1;
+    char           first;
+    std::memcpy(&first, &one, 1);
+    buf[0] = sizeof(T) == 1 ? '|' : first == 1 ? '<' : '>';
+    std::snprintf(buf + 1, sizeof(buf) - 1, "%c%u", NpyType<T>::kind,
+        static_cast<unsigned>(sizeof(T)));
+    return buf;
+}
+
+/**
+ * \brief Write .npy file header.
+ *
+ * \param f     File.
+ * \param descr Type description.
+ * \param shape Shape, e.g. "(2, 3)".
+ * \return \c true if success.
+ */
+inline bool npy_write_header(
+    std::FILE* f, const char* descr, const std::string& shape) {
+    std::string dict = std::string("{'descr': '") + descr +
+                       "', 'fortran_order': False, 'shape': " + shape + ", }";
+    // Pad with spaces and newline, so that data is aligned to 64 bytes
+    const size_t kPreamble = 10;
+    dict.append(63 - (kPreamble + dict.size()) % 64, ' ');
+    dict += '\n';
+    const size_t n       = dict.size();
+    const char   pre[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+        static_cast<char>(n & 0xff), static_cast<char>(n >> 8)};
+    return std::fwrite(pre, 1, sizeof(pre), f) == sizeof(pre) &&
+           std::fwrite(dict.data(), 1, n, f) == n;
+}
+
+/**
+ * \brief Elements of an array or matrix, written to the data of a .npy file
+ * in runs of elements which are adjacent in memory.
+ *
+ * \tparam T Element type.
+ */
+template<class T>
+class NpyData {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param f File.
+     */
+    explicit NpyData(std::FILE* f) noexcept :
+        m_f(f), m_first(nullptr), m_len(0), m_ok(true) {}
+
+    /**
+     * \brief Add next element.
+     *
+     * \param v Element.
+     */
+    void add(const T& v) noexcept {
+        if (&v != m_first + m_len) {
+            flush();
+            m_first = &v;
+        }
+        ++m_len;
+    }
+
+    /**
+     * \brief Write remaining run.
+     *
+     * \return \c true if all elements were written.
+     */
+    bool flush() noexcept {
+        if (m_len != 0) {
+            m_ok = m_ok &&
+                   std::fwrite(m_first, sizeof(T), m_len, m_f) == m_len;
+            m_len = 0;
+        }
+        return m_ok;
+    }
+
+  private:
+    std::FILE* m_f;     /**< File. */
+    const T*   m_first; /**< First element of run. */
+    size_t     m_len;   /**< Number of elements in run. */
+    bool       m_ok;    /**< \c false if a write failed. */
+};
+
+/**
+ * \brief Array or matrix, to dump to a .npy file.
+ *
+ * \tparam A Array or Matrix.
+ */
+template<class A>
+class Npy {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param a Array or matrix.
+     */
+    explicit Npy(const A& a) noexcept : m_a(a) {}
+
+    /**
+     * \return Array or matrix.
+     */
+    const A& get() const noexcept {
+        return m_a;
+    }
+
+  private:
+    const A& m_a; /**< Array or matrix. */
+};
+
+/**
+ * \brief Create array or matrix to dump.
+ *
+ * \tparam A Array or Matrix.
+ * \param a Array or matrix.
+ * \return Array or matrix to dump.
+ */
+template<class A>
+Npy<A> make_npy(const A& a) noexcept {
+    return Npy<A>(a);
+}
+
+/**
+ * \brief Get path of next .npy file, named after variable, call site and
+ * sequence number.
+ *
+ * \param name Variable name.
+ * \param pf   Prefix formatter of call site.
+ * \return Path.
+ */
+inline std::string npy_path(const char* name, const PrefixFormatter& pf) {
+    NpyState&   state = npy_state();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        path = state.directory;
+    }
+    if (!path.empty() && path.back() != '/') {
+        path += '/';
+    }
+    // Only keep characters which are safe in file names
+    for (const char* c = name; *c != '\0'; ++c) {
+        const bool safe = (*c >= 'a' && *c <= 'z') ||
+                          (*c >= 'A' && *c <= 'Z') ||
+                          (*c >= '0' && *c <= '9') || *c == '_';
+        path += safe ? *c : '_';
+    }
+    path += '.';
+    path += file_name(pf.get_file_path());
+    path += '.';
+    path += std::to_string(pf.get_file_line_number());
+    path += '.';
+    path += std::to_string(
+        state.sequence.fetch_add(1, std::memory_order_relaxed));
+    path += ".npy";
+    return path;
+}
+
+/**
+ * \brief Write reference to .npy file.
+ *
+ * \param os    Output stream.
+ * \param pf    Prefix formatter.
+ * \param name  Variable name.
+ * \param path  Path of file.
+ * \param descr Type description.
+ * \param shape Shape [\p dims].
+ * \param dims  Number of dimensions.
+ * \param error Error message, or \c nullptr if success.
+ * \return Output stream.
+ */
+inline std::ostream& write_npy_reference(std::ostream& os,
+    const PrefixFormatter& pf, const char* name, const std::string& path,
+    const char* descr, const size_t* shape, size_t dims,
+    const char* error) noexcept {
+    os << message_start << pf;
+    if (!is_text(os)) {
+        encode_key(os, name);
+        begin_map(os);
+        encode_key(os, "npy");
+        encode_string(os, path.c_str(), path.size()) << separator;
+        encode_key(os, "dtype");
+        encode_string(os, descr) << separator;
+        encode_key(os, "shape");
+        begin_array(os);
+        for (size_t i = 0; i < dims; ++i) {
+            if (i != 0) {
+                os << separator;
+            }
+            encode_uint(os, shape[i]);
+        }
+        end_array(os);
+        if (error != nullptr) {
+            os << separator;
+            encode_key(os, "error");
+            encode_string(os, error);
+        }
+        end_map(os);
+        return os << MessageEnd() << GL_NEWLINE;
+    }
+    os << name << ": npy = ";
+    encode_string(os, path.c_str(), path.size());
+    os << ", dtype = " << descr << ", shape = (";
+    for (size_t i = 0; i < dims; ++i) {
+        os << (i != 0 ? ", " : "") << shape[i];
+    }
+    os << (dims == 1 ? ",)" : ")");
+    if (error != nullptr) {
+        os << ", error = ";
+        encode_string(os, error);
+    }
+    return os << MessageEnd() << GL_NEWLINE;
+}
+
+/**
+ * \brief Get shape in the syntax of Python tuples.
+ *
+ * \param shape Shape.
+ * \param dims  Number of dimensions.
+ * \return Shape, e.g. "(3,)" or "(2, 3)".
+ */
+inline std::string npy_shape(const size_t* shape, size_t dims) {
+    std::string s("(");
+    for (size_t i = 0; i < dims; ++i) {
+        s += (i != 0 ? ", " : "") + std::to_string(shape[i]);
+    }
+    return s + (dims == 1 ? ",)" : ")");
+}
+
+/**
+ * \brief Dump elements to .npy file, and write reference to it.
+ *
+ * \tparam T Element type.
+ * \tparam F Function which adds all elements to NpyData<T>.
+ * \param os    Output stream.
+ * \param pf    Prefix formatter.
+ * \param name  Variable name.
+ * \param shape Shape [\p dims].
+ * \param dims  Number of dimensions.
+ * \param add   Function which adds all elements.
+ * \return Output stream.
+ */
+template<class T, class F>
+std::ostream& write_npy(std::ostream& os, const PrefixFormatter& pf,
+    const char* name, const size_t* shape, size_t dims, F add) noexcept {
+    char              descr[8];
+    const std::string path  = npy_path(name, pf);
+    const char*       error = nullptr;
+    std::FILE*        f     = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        error = std::strerror(errno);
+    } else {
+        // Unbuffered, so that runs are written without copying
+        std::setvbuf(f, nullptr, _IONBF, 0);
+        NpyData<T> data(f);
+        bool       ok = npy_write_header(
+            f, npy_descr<T>(descr), npy_shape(shape, dims));
+        if (ok) {
+            add(data);
+        }
+        ok    = data.flush() && ok;
+        ok    = std::fclose(f) == 0 && ok;
+        error = ok ? nullptr : std::strerror(errno);
+    }
+    return write_npy_reference(
+        os, pf, name, path, npy_descr<T>(descr), shape, dims, error);
+}
+
+/**
+ * \brief Dump Array to .npy file, and write reference to it.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param n  Array to dump.
+ * \return Output stream.
+ */
+template<class U>
+std::ostream& operator<<(std::ostream& os, const Npy<Array<U>>& n) noexcept {
+    typedef typename std::remove_cv<typename std::remove_reference<decltype(
+        n.get().get_values()[0])>::type>::type T;
+    const Array<U>& a        = n.get();
+    const size_t    shape[1] = {a.get_number_of_values()};
+    return write_npy<T>(os, a.get_prefix_formatter(), a.get_name(), shape, 1,
+        [&a](NpyData<T>& data) {
+            for (size_t i = 0; i < a.get_number_of_values(); ++i) {
+                data.add(a.get_values()[i]);
+            }
+        });
+}
+
+/**
+ * \brief Dump Matrix to .npy file, and write reference to it.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param n  Matrix to dump.
+ * \return Output stream.
+ */
+template<class U>
+std::ostream& operator<<(std::ostream& os, const Npy<Matrix<U>>& n) noexcept {
+    typedef typename std::remove_cv<typename std::remove_reference<decltype(
+        n.get().get_values()[0][0])>::type>::type T;
+    const Matrix<U>& m        = n.get();
+    const size_t     shape[2] = {
+        m.get_number_of_rows(), m.get_number_of_columns()};
+    return write_npy<T>(os, m.get_prefix_formatter(), m.get_name(), shape, 2,
+        [&m](NpyData<T>& data) {
+            for (size_t i = 0; i < m.get_number_of_rows(); ++i) {
+                for (size_t j = 0; j < m.get_number_of_columns(); ++j) {
+                    data.add(m.get_values()[i][j]);
+                }
+            }
+        });
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Set directory which l_npy() and l_npy_mat() write files to.
+ *
+ * \param dir Directory, which must exist. Empty for the current directory.
+ *
+ * \note Defaults to the current directory.
+ *
+ * \sa get_npy_directory() \sa l_npy() \sa l_npy_mat()
+ *
+ */
+inline void set_npy_directory(const std::string& dir) {
+    internal::NpyState&         state = internal::npy_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.directory = dir;
+}
+
+/**
+ *
+ * \return Directory which l_npy() and l_npy_mat() write files to.
+ *
+ * \sa set_npy_directory()
+ *
+ */
+inline std::string get_npy_directory() {
+    internal::NpyState&         state = internal::npy_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.directory;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_NPY_H_
@@ -0,0 +1,103 @@
+/** \file
+ *
+ * \brief Formatters of std::complex, std::ratio and std::valarray.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/numeric.h"
+ *
+ * std::complex<double> c(1.0, 2.0);
+ * l(c);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_NUMERIC_H_
+#define INCLUDE_GOINGLOGGING_NUMERIC_H_
+
+#include "core.h"
+#include <complex>
+#include <cstdint>
+#include <ostream>
+#include <ratio>
+#include <valarray>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Format std::complex.
+ *
+ * \tparam U Pointer type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::complex<U>>& f) noexcept {
+    if (!is_text(os)) {
+        begin_map(os);
+        encode_key(os, "real");
+        encode_scalar(os, f.get_value().real()) << separator;
+        encode_key(os, "imag");
+        encode_scalar(os, f.get_value().imag());
+        return end_map(os);
+    }
+    os << f.get_value().real();
+    if (f.get_value().imag() >= 0) {
+        os << " + " << f.get_value().imag();
+    } else {
+        os << " - " << -f.get_value().imag();
+    }
+    return os << 'i';
+}
+
+/**
+ * \brief Format std::valarray.
+ *
+ * \tparam U Element type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::valarray<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::ratio.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<std::intmax_t U, std::intmax_t V>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::ratio<U, V>>& f) noexcept {
+    if (!is_text(os)) {
+        begin_map(os);
+        encode_key(os, "num");
+        encode_int(os, f.get_value().num) << separator;
+        encode_key(os, "den");
+        encode_int(os, f.get_value().den);
+        return end_map(os);
+    }
+    return os << f.get_value().num << " / " << f.get_value().den;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_NUMERIC_H_
@@ -0,0 +1,381 @@
+/** \file
+ *
+ * \brief Profile of the cost of logging per call site, of call sites
+ * compiled with \ref GL_PROFILE defined.
+ *
+ * Included by goinglogging.h, and by goinglogging/core.h if GL_PROFILE is
+ * defined. Files which only include goinglogging/core.h opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/profile.h"
+ *
+ * gl::print_profile(std::cout);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_PROFILE_H_
+#define INCLUDE_GOINGLOGGING_PROFILE_H_
+
+#include "core.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Cost of logging at a call site.
+ */
+struct ProfileRecord {
+    /**
+     * \brief Constructor.
+     *
+     * \param path File path including name.
+     * \param line Line number in file.
+     * \param fn   Function name.
+     */
+    ProfileRecord(const char* path, long line, const char* fn) noexcept :
+        file_path(path), file_line(line), func(fn), calls(0), suppressed(0),
+        bytes(0), total_ns(0), max_ns(0) {
+    }
+
+    const char*           file_path;  /**< File path including name. */
+    const long            file_line;  /**< Line number in file. */
+    const char*           func;       /**< Function name. */
+    std::atomic<uint64_t> calls;      /**< Number of calls with output. */
+    std::atomic<uint64_t> suppressed; /**< Calls while output disabled. */
+    std::atomic<uint64_t> bytes;      /**< Bytes written. */
+    std::atomic<uint64_t> total_ns;   /**< Total time spent. */
+    std::atomic<uint64_t> max_ns;     /**< Longest time of one call. */
+};
+
+/**
+ * \brief Profile of all call sites. Written to std::cerr at program exit,
+ * if any call site was profiled.
+ */
+class Profile {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    Profile() : m_mutex(), m_records() {
+    }
+
+    Profile(const Profile&) = delete;
+    Profile& operator=(const Profile&) = delete;
+
+    /**
+     * \brief Destructor. Write profile.
+     */
+    ~Profile() {
+        if (!m_records.empty()) {
+            print(std::cerr);
+        }
+    }
+
+    /**
+     * \brief Add call site.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \return Record of call site. Valid as long as the profile.
+     */
+    ProfileRecord& add(
+        const char* file_path, long file_line, const char* func) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_records.emplace_back(
+            new ProfileRecord(file_path, file_line, func));
+        return *m_records.back();
+    }
+
+    /**
+     * \brief Write one line per call site, most expensive first.
+     *
+     * \param os Output stream.
+     */
+    void print(std::ostream& os) {
+        std::vector<const ProfileRecord*> sorted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const std::unique_ptr<ProfileRecord>& r : m_records) {
+                sorted.push_back(r.get());
+            }
+        }
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [](const ProfileRecord* a, const ProfileRecord* b) {
+                return a->total_ns.load(std::memory_order_relaxed) >
+                       b->total_ns.load(std::memory_order_relaxed);
+            });
+
+        std::string s = "goinglogging profile, sorted by total time:\n";
+        for (const ProfileRecord* r : sorted) {
+            s += file_name(r->file_path);
+            s += ':' + std::to_string(r->file_line) + ", " + r->func +
+                 "(): calls = " +
+                 std::to_string(r->calls.load(std::memory_order_relaxed)) +
+                 ", suppressed = " +
+                 std::to_string(r->suppressed.load(std::memory_order_relaxed)) +
+                 ", bytes = " +
+                 std::to_string(r->bytes.load(std::memory_order_relaxed)) +
+                 ", total = " +
+                 std::to_string(r->total_ns.load(std::memory_order_relaxed)) +
+                 " ns, max = " +
+                 std::to_string(r->max_ns.load(std::memory_order_relaxed)) +
+                 " ns\n";
+        }
+        os << s << std::flush;
+    }
+
+  private:
+    std::mutex m_mutex; /**< Protects records. */
+    /** Records, allocated one by one for stable addresses. */
+    std::vector<std::unique_ptr<ProfileRecord>> m_records;
+};
+
+/**
+ * \return Profile shared by all translation units.
+ */
+inline Profile& profile() {
+    static Profile p;
+    return p;
+}
+
+/**
+ * \brief Call site with profiling. Only holds a reference to its record, so
+ * that destruction order at exit does not matter.
+ */
+class ProfileSite {
+  public:
+    /**
+     * \brief Constructor. Add record to profile.
+     *
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    ProfileSite(const char* file_path, long file_line, const char* func) :
+        m_record(profile().add(file_path, file_line, func)) {
+    }
+
+    /**
+     * \return Record of call site.
+     */
+    ProfileRecord& get_record() const noexcept {
+        return m_record;
+    }
+
+    /**
+     * \brief Count call while output is disabled.
+     */
+    void suppress() const noexcept {
+        m_record.suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+  private:
+    ProfileRecord& m_record; /**< Record of call site. */
+};
+
+/**
+ * \brief Stream buffer which counts and forwards all characters to another
+ * stream buffer.
+ */
+class CountingStreambuf : public std::streambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CountingStreambuf() noexcept : m_target(nullptr), m_count(0) {
+    }
+
+    CountingStreambuf(const CountingStreambuf&) = delete;
+    CountingStreambuf& operator=(const CountingStreambuf&) = delete;
+
+    /**
+     * \brief Set stream buffer to forward to.
+     *
+     * \param target Stream buffer.
+     */
+    void set_target(std::streambuf* target) noexcept {
+        m_target = target;
+    }
+
+    /**
+     * \return Number of characters written.
+     */
+    uint64_t get_count() const noexcept {
+        return m_count;
+    }
+
+  protected:
+    /**
+     * \brief Write character.
+     *
+     * \param c Character.
+     * \return Character, or EOF if failed.
+     */
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        if (m_target == nullptr) {
+            return traits_type::eof();
+        }
+        ++m_count;
+        return m_target->sputc(traits_type::to_char_type(c));
+    }
+
+    /**
+     * \brief Write characters.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     * \return Number of characters written.
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (m_target == nullptr) {
+            return 0;
+        }
+        std::streamsize w = m_target->sputn(s, n);
+        m_count += static_cast<uint64_t>(w);
+        return w;
+    }
+
+    /**
+     * \brief Flush.
+     *
+     * \return 0 if success.
+     */
+    int sync() override {
+        return m_target == nullptr ? 0 : m_target->pubsync();
+    }
+
+  private:
+    std::streambuf* m_target; /**< Stream buffer to forward to. */
+    uint64_t        m_count;  /**< Number of characters written. */
+};
+
+/**
+ * \brief Measures the time and bytes of one call of a profiled call site,
+ * from construction to destruction.
+ */
+class ProfileScope {
+  public:
+    /**
+     * \brief Constructor. Start measuring.
+     *
+     * \param site Call site.
+     */
+    explicit ProfileScope(const ProfileSite& site) :
+        m_record(site.get_record()), m_buf(buffer()), m_stream(stream(m_buf)),
+        m_bytes(m_buf.get_count()),
+        m_start(std::chrono::steady_clock::now()) {
+        m_buf.set_target(std::cout.rdbuf());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    /**
+     * \brief Destructor. Record measurements.
+     */
+    ~ProfileScope() {
+        uint64_t ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start)
+                .count());
+        m_record.calls.fetch_add(1, std::memory_order_relaxed);
+        m_record.bytes.fetch_add(
+            m_buf.get_count() - m_bytes, std::memory_order_relaxed);
+        m_record.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t cur = m_record.max_ns.load(std::memory_order_relaxed);
+        while (ns > cur && !m_record.max_ns.compare_exchange_weak(
+                               cur, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * \return Stream to write output to.
+     */
+    std::ostream& stream() noexcept {
+        return m_stream;
+    }
+
+  private:
+    /**
+     * \return Counting stream buffer of current thread.
+     */
+    static CountingStreambuf& buffer() {
+        thread_local CountingStreambuf buf;
+        return buf;
+    }
+
+    /**
+     * \param buf Counting stream buffer of current thread.
+     * \return Stream of current thread, writing to \p buf.
+     */
+    static std::ostream& stream(CountingStreambuf& buf) {
+        thread_local std::ostream os(&buf);
+        return os;
+    }
+
+    ProfileRecord&     m_record; /**< Record of call site. */
+    CountingStreambuf& m_buf;    /**< Counting stream buffer. */
+    std::ostream&      m_stream; /**< Stream writing to m_buf. */
+    const uint64_t     m_bytes;  /**< Bytes counted before the call. */
+    const std::chrono::steady_clock::time_point m_start; /**< Start time. */
+};
+
+/**
+ * \brief Write message of an enabled and profiled call site to output, and
+ * record the cost.
+ *
+ * \param site    Profiled call site.
+ * \param write   Writer of message.
+ * \param message Message.
+ */
+GL_INTERNAL_COLD inline void emit(const ProfileSite& site,
+    MessageWriter write, const void* message) noexcept {
+    ProfileScope scope(site);
+    write(scope.stream(), message);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Write the cost of logging per call site, most expensive first.
+ *
+ * \param os Output stream.
+ *
+ * Which outputs e.g.:
+ * \code
+ * goinglogging profile, sorted by total time:
+ * main.cpp:12, main(): calls = 100, suppressed = 0, bytes = 1100, total =
+ * 310021 ns, max = 20110 ns
+ * \endcode
+ *
+ * \note Only call sites compiled with \ref GL_PROFILE defined are profiled.
+ *
+ * \sa GL_PROFILE
+ *
+ */
+inline void print_profile(std::ostream& os = std::cout) {
+    internal::profile().print(os);
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_PROFILE_H_
@@ -0,0 +1,1017 @@
+/** \file
+ *
+ * \brief Histograms, counters and scoped timers: l_hist(), l_count(),
+ * l_time_scope() and l_time_scope_log(), reported by gl::report() or a
+ * background reporter.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/report.h"
+ *
+ * l_hist(latency);
+ * gl::report();
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_REPORT_H_
+#define INCLUDE_GOINGLOGGING_REPORT_H_
+
+#include "core.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Accumulate value into a histogram instead of logging it.
+ *
+ * \param v Arithmetic value to record.
+ *
+ * Used as:
+ * \code
+ * l_hist(latency);
+ * gl::report();
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * latency: count = 1000, min = 1, max = 98, mean = 10.3, p50 = 8, p90 = 22,
+ * p99 = 71, p999 = 98
+ * \endcode
+ *
+ * \note Each call site has its own histogram. Values are not logged until
+ * \ref report() is called or the reporter started with \ref start_reporter()
+ * runs.
+ * \note Percentiles are approximate. The relative error is at most 1/16 of
+ * the value.
+ *
+ * \sa l_count() \sa report() \sa start_reporter()
+ *
+ */
+#define l_hist(v)                                                           \
+    do {                                                                    \
+        static ::gl::internal::HistogramSite gl_internal_site(              \
+            (#v), __FILE__, __LINE__, __func__);                            \
+        if (::gl::internal::outputEnabled.load(                             \
+                std::memory_order_relaxed)) {                               \
+            gl_internal_site.record((v));                                   \
+        }                                                                   \
+    } while (false)
+
+/**
+ * \brief Count events instead of logging them.
+ *
+ * \param name Name of event.
+ *
+ * Used as:
+ * \code
+ * l_count(packet_received);
+ * gl::report();
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * packet_received: count = 1200, rate = 400/s
+ * \endcode
+ *
+ * \note The rate is the number of events per second since the previous
+ * report.
+ *
+ * \sa l_hist() \sa report() \sa start_reporter()
+ *
+ */
+#define l_count(name)                                                       \
+    do {                                                                    \
+        static ::gl::internal::CounterSite gl_internal_site(                \
+            (#name), __FILE__, __LINE__, __func__);                         \
+        if (::gl::internal::outputEnabled.load(                             \
+                std::memory_order_relaxed)) {                               \
+            gl_internal_site.increment();                                   \
+        }                                                                   \
+    } while (false)
+
+/**
+ * \brief Measure the time until the end of the current scope.
+ *
+ * \param name Name of timer.
+ *
+ * Used as:
+ * \code
+ * void work() {
+ *     l_time_scope(work);
+ *     ...
+ * }
+ * gl::report();
+ * \endcode
+ *
+ * Which outputs:
+ * \code
+ * work: count = 10, min = 1.2e+06 ns, max = 2.1e+06 ns, mean = 1.4e+06 ns,
+ * p50 = 1.3e+06 ns, p90 = 2.1e+06 ns, p99 = 2.1e+06 ns, p999 = 2.1e+06 ns
+ * \endcode
+ *
+ * \note Durations are recorded into a histogram per call site, and reported
+ * as for \ref l_hist().
+ * \note Uses std::chrono::steady_clock, which typically costs a few tens of
+ * nanoseconds per timestamp.
+ *
+ * \sa l_time_scope_log() \sa l_hist() \sa report()
+ *
+ */
+#define l_time_scope(name) GL_INTERNAL_TIME_SCOPE(name, false)
+
+/**
+ * \brief Measure the time until the end of the current scope, and also log
+ * each duration.
+ *
+ * \param name Name of timer.
+ *
+ * Which outputs, at the end of each scope:
+ * \code
+ * work = 1250110 ns
+ * \endcode
+ *
+ * \note Uses prefix information set with \ref set_prefixes().
+ *
+ * \sa l_time_scope()
+ *
+ */
+#define l_time_scope_log(name) GL_INTERNAL_TIME_SCOPE(name, true)
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Get shard index of current thread. Threads are assigned shards in
+ * round robin order, so that a few threads rarely share a shard.
+ *
+ * \param shards Number of shards.
+ * \return Shard index in [0, \p shards).
+ */
+inline size_t thread_shard(size_t shards) noexcept {
+    /** Index of next thread */
+    static std::atomic<size_t> next(0);
+    /** Index of this thread */
+    thread_local size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+    return idx % shards;
+}
+
+/**
+ * \brief Atomically add to floating point value.
+ *
+ * \param a Value to add to.
+ * \param v Value to add.
+ */
+inline void atomic_add(std::atomic<double>& a, double v) noexcept {
+    double cur = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * \brief Atomically set floating point value to minimum of itself and \p v.
+ *
+ * \param a Value to update.
+ * \param v Candidate value.
+ */
+inline void atomic_min(std::atomic<double>& a, double v) noexcept {
+    double cur = a.load(std::memory_order_relaxed);
+    while (v < cur &&
+           !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * \brief Atomically set floating point value to maximum of itself and \p v.
+ *
+ * \param a Value to update.
+ * \param v Candidate value.
+ */
+inline void atomic_max(std::atomic<double>& a, double v) noexcept {
+    double cur = a.load(std::memory_order_relaxed);
+    while (v > cur &&
+           !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * \brief Merged contents of a Histogram.
+ */
+class HistogramSnapshot {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param buckets Number of buckets.
+     */
+    explicit HistogramSnapshot(size_t buckets) :
+        m_buckets(buckets, 0), m_count(0),
+        m_min(std::numeric_limits<double>::infinity()),
+        m_max(-std::numeric_limits<double>::infinity()), m_sum(0.0) {
+    }
+
+    /**
+     * \return Number of samples.
+     */
+    uint64_t get_count() const noexcept {
+        return m_count;
+    }
+
+    /**
+     * \return Smallest sample.
+     */
+    double get_min() const noexcept {
+        return m_min;
+    }
+
+    /**
+     * \return Largest sample.
+     */
+    double get_max() const noexcept {
+        return m_max;
+    }
+
+    /**
+     * \return Mean of samples.
+     */
+    double get_mean() const noexcept {
+        return m_count == 0 ? 0.0 : m_sum / static_cast<double>(m_count);
+    }
+
+    double percentile(double q) const noexcept;
+
+  private:
+    friend class Histogram;
+
+    std::vector<uint64_t> m_buckets; /**< Number of samples per bucket. */
+    uint64_t              m_count;   /**< Number of samples. */
+    double                m_min;     /**< Smallest sample. */
+    double                m_max;     /**< Largest sample. */
+    double                m_sum;     /**< Sum of samples. */
+};
+
+/**
+ * \brief Log-linear histogram, in the style of HDR histograms.
+ *
+ * Each power of two is split into \ref kSubBuckets linear buckets, which
+ * bounds the relative error of a percentile to 1 / \ref kSubBuckets. Samples
+ * are recorded into one of \ref kShards shards, selected per thread, without
+ * taking any lock. Shards are allocated when first used.
+ */
+class Histogram {
+  public:
+    /** Number of mantissa bits that select a linear bucket. */
+    static const int kSubBucketBits = 4;
+    /** Number of linear buckets per power of two. */
+    static const size_t kSubBuckets = 1 << kSubBucketBits;
+    /** Exponent of smallest nonzero magnitude with full resolution. */
+    static const int kMinExponent = -24;
+    /** Exponent of largest magnitude with full resolution. */
+    static const int kMaxExponent = 40;
+    /** Number of buckets for each sign. */
+    static const size_t kHalf = (kMaxExponent - kMinExponent) * kSubBuckets;
+    /** Number of buckets: negative, zero and positive values. */
+    static const size_t kBuckets = 2 * kHalf + 1;
+    /** Number of shards. */
+    static const size_t kShards = 8;
+
+    /**
+     * \brief Constructor.
+     */
+    Histogram() noexcept {
+        for (std::atomic<Shard*>& s : m_shards) {
+            s.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    /**
+     * \brief Destructor. Free shards.
+     */
+    ~Histogram() {
+        for (std::atomic<Shard*>& s : m_shards) {
+            delete s.load(std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * \brief Record sample.
+     *
+     * \param v Sample. NaN is ignored.
+     */
+    void record(double v) {
+        if (std::isnan(v)) {
+            return;
+        }
+        Shard& s = shard();
+        s.buckets[bucket_index(v)].fetch_add(1, std::memory_order_relaxed);
+        atomic_add(s.sum, v);
+        atomic_min(s.min, v);
+        atomic_max(s.max, v);
+    }
+
+    /**
+     * \brief Merge all shards.
+     *
+     * \param reset \c true to also clear all samples.
+     * \return Merged contents.
+     */
+    HistogramSnapshot snapshot(bool reset) {
+        HistogramSnapshot snap(kBuckets);
+        for (std::atomic<Shard*>& a : m_shards) {
+            Shard* s = a.load(std::memory_order_acquire);
+            if (s == nullptr) {
+                continue;
+            }
+            for (size_t i = 0; i < kBuckets; ++i) {
+                uint64_t n =
+                    reset ?
+                        s->buckets[i].exchange(0, std::memory_order_relaxed) :
+                        s->buckets[i].load(std::memory_order_relaxed);
+                snap.m_buckets[i] += n;
+                snap.m_count += n;
+            }
+            const double inf = std::numeric_limits<double>::infinity();
+            if (reset) {
+                snap.m_sum += s->sum.exchange(0.0, std::memory_order_relaxed);
+                snap.m_min = std::min(snap.m_min,
+                    s->min.exchange(inf, std::memory_order_relaxed));
+                snap.m_max = std::max(snap.m_max,
+                    s->max.exchange(-inf, std::memory_order_relaxed));
+            } else {
+                snap.m_sum += s->sum.load(std::memory_order_relaxed);
+                snap.m_min = std::min(
+                    snap.m_min, s->min.load(std::memory_order_relaxed));
+                snap.m_max = std::max(
+                    snap.m_max, s->max.load(std::memory_order_relaxed));
+            }
+        }
+        return snap;
+    }
+
+    /**
+     * \brief Get bucket of value.
+     *
+     * \param v Value.
+     * \return Bucket index. Buckets are ordered by value.
+     */
+    static size_t bucket_index(double v) noexcept {
+        if (v == 0.0) {
+            return kHalf;
+        }
+        // Use exponent and highest mantissa bits of the IEEE 754
+        // representation directly
+        uint64_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(bits));
+        int    exp = static_cast<int>((bits >> 52) & 0x7FF) - 1023;
+        size_t sub = static_cast<size_t>(bits >> (52 - kSubBucketBits)) &
+                     (kSubBuckets - 1);
+        size_t mag = 0;
+        if (exp >= kMaxExponent) {
+            mag = kHalf - 1;
+        } else if (exp >= kMinExponent) {
+            mag = static_cast<size_t>(exp - kMinExponent) * kSubBuckets + sub;
+        }
+        return v < 0.0 ? kHalf - 1 - mag : kHalf + 1 + mag;
+    }
+
+    /**
+     * \brief Get value in the middle of bucket.
+     *
+     * \param idx Bucket index.
+     * \return Representative value of bucket.
+     */
+    static double bucket_value(size_t idx) noexcept {
+        if (idx == kHalf) {
+            return 0.0;
+        }
+        size_t mag = idx < kHalf ? kHalf - 1 - idx : idx - kHalf - 1;
+        int    exp = static_cast<int>(mag / kSubBuckets) + kMinExponent;
+        double sub = static_cast<double>(mag % kSubBuckets);
+        double v   = std::ldexp(
+            1.0 + (sub + 0.5) / static_cast<double>(kSubBuckets), exp);
+        return idx < kHalf ? -v : v;
+    }
+
+  private:
+    /**
+     * \brief Samples recorded by a subset of threads.
+     */
+    struct Shard {
+        std::atomic<uint64_t> buckets[kBuckets]; /**< Samples per bucket. */
+        std::atomic<double>   sum;               /**< Sum of samples. */
+        std::atomic<double>   min;               /**< Smallest sample. */
+        std::atomic<double>   max;               /**< Largest sample. */
+    };
+
+    /**
+     * \return Shard of current thread.
+     */
+    Shard& shard() {
+        std::atomic<Shard*>& slot = m_shards[thread_shard(kShards)];
+        Shard*               s    = slot.load(std::memory_order_acquire);
+        if (s != nullptr) {
+            return *s;
+        }
+
+        // Allocate. Another thread may be faster.
+        Shard* n = new Shard();
+        n->min.store(
+            std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        n->max.store(-std::numeric_limits<double>::infinity(),
+            std::memory_order_relaxed);
+        if (slot.compare_exchange_strong(s, n, std::memory_order_acq_rel)) {
+            return *n;
+        }
+        delete n;
+        return *s;
+    }
+
+    std::atomic<Shard*> m_shards[kShards]; /**< Shards. */
+};
+
+/**
+ * \brief Approximate percentile.
+ *
+ * \param q Quantile in [0, 1].
+ * \return Value of percentile, or 0 if empty.
+ */
+inline double HistogramSnapshot::percentile(double q) const noexcept {
+    if (m_count == 0) {
+        return 0.0;
+    }
+    uint64_t rank =
+        static_cast<uint64_t>(std::ceil(q * static_cast<double>(m_count)));
+    rank          = std::max<uint64_t>(rank, 1);
+    uint64_t cum  = 0;
+    for (size_t i = 0; i < m_buckets.size(); ++i) {
+        cum += m_buckets[i];
+        if (cum >= rank) {
+            // Bucket is wider than the samples at the ends
+            return std::min(
+                std::max(Histogram::bucket_value(i), m_min), m_max);
+        }
+    }
+    return m_max;
+}
+
+/**
+ * \brief Call site which is periodically reported, such as a site of
+ * l_hist() or l_count().
+ *
+ * The most derived class unregisters in its destructor, before its members
+ * are destroyed, so that the background reporter never reports a site which
+ * is partly destroyed.
+ */
+class ReportSite {
+  public:
+    ReportSite(const char* name, const char* file_path, long file_line,
+        const char* func);
+    ReportSite(const ReportSite&) = delete;
+    ReportSite& operator=(const ReportSite&) = delete;
+    virtual ~ReportSite();
+
+    /**
+     * \brief Write statistics since previous report.
+     *
+     * \param os      Output stream.
+     * \param seconds Seconds since previous report.
+     */
+    virtual void report(std::ostream& os, double seconds) = 0;
+
+    /**
+     * \return Name.
+     */
+    const char* get_name() const noexcept {
+        return m_name;
+    }
+
+    /**
+     * \return PrefixFormatter of call site.
+     */
+    PrefixFormatter get_prefix_formatter() const noexcept {
+        return PrefixFormatter(m_file_path, m_file_line, m_func);
+    }
+
+  private:
+    const char* m_name;      /**< Name. */
+    const char* m_file_path; /**< File path including name. */
+    const long  m_file_line; /**< Line number in file. */
+    const char* m_func;      /**< Function name. */
+};
+
+/**
+ * \brief All sites to report, and the background reporter.
+ *
+ * Sites register when constructed, which ensures that this object outlives
+ * them.
+ */
+class Reporting {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    Reporting() :
+        m_mutex(), m_sites(), m_last(std::chrono::steady_clock::now()),
+        m_reporter_mutex(), m_reporter(), m_cond(), m_running(false) {
+    }
+
+    Reporting(const Reporting&) = delete;
+    Reporting& operator=(const Reporting&) = delete;
+
+    /**
+     * \brief Destructor. Stop reporter.
+     */
+    ~Reporting() {
+        stop();
+    }
+
+    /**
+     * \brief Add site.
+     *
+     * \param s Site.
+     */
+    void add(ReportSite* s) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sites.push_back(s);
+    }
+
+    /**
+     * \brief Remove site.
+     *
+     * \param s Site.
+     */
+    void remove(ReportSite* s) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sites.erase(
+            std::remove(m_sites.begin(), m_sites.end(), s), m_sites.end());
+    }
+
+    /**
+     * \brief Report all sites in the order they were first used.
+     *
+     * \param os Output stream.
+     */
+    void report(std::ostream& os) {
+        std::ostringstream          ss;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        now = std::chrono::steady_clock::now();
+        double                      seconds =
+            std::chrono::duration<double>(now - m_last).count();
+        m_last = now;
+        for (ReportSite* s : m_sites) {
+            s->report(ss, seconds);
+        }
+        // Write all at once, to not interleave with other threads
+        os << ss.str() << std::flush;
+    }
+
+    /**
+     * \brief Start reporting periodically in a background thread.
+     *
+     * \param interval Time between reports.
+     */
+    void start(std::chrono::milliseconds interval) {
+        stop();
+        std::lock_guard<std::mutex> lock(m_reporter_mutex);
+        m_running  = true;
+        m_reporter = std::thread([this, interval]() {
+            std::unique_lock<std::mutex> wait_lock(m_reporter_mutex);
+            while (!m_cond.wait_for(
+                wait_lock, interval, [this]() { return !m_running; })) {
+                wait_lock.unlock();
+                if (outputEnabled.load(std::memory_order_relaxed)) {
+                    report(std::cout);
+                }
+                wait_lock.lock();
+            }
+        });
+    }
+
+    /**
+     * \brief Stop background reporting, if started.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_reporter_mutex);
+            m_running = false;
+        }
+        m_cond.notify_all();
+        if (m_reporter.joinable()) {
+            m_reporter.join();
+        }
+    }
+
+  private:
+    std::mutex                m_mutex; /**< Protects sites and time. */
+    std::vector<ReportSite*>  m_sites; /**< Sites in registration order. */
+    std::chrono::steady_clock::time_point m_last; /**< Time of last report. */
+    std::mutex              m_reporter_mutex;     /**< Protects m_running. */
+    std::thread             m_reporter;           /**< Background reporter. */
+    std::condition_variable m_cond;    /**< Signals reporter to stop. */
+    bool                    m_running; /**< \c true if reporter shall run. */
+};
+
+/**
+ * \return Sites to report and background reporter, shared by all
+ * translation units.
+ */
+inline Reporting& reporting() {
+    static Reporting r;
+    return r;
+}
+
+/**
+ * \brief Constructor. Register for reporting.
+ *
+ * \param name      Name.
+ * \param file_path File path including name.
+ * \param file_line Line number in file.
+ * \param func      Function name.
+ */
+inline ReportSite::ReportSite(
+    const char* name, const char* file_path, long file_line, const char* func) :
+    m_name(name),
+    m_file_path(file_path), m_file_line(file_line), m_func(func) {
+    reporting().add(this);
+}
+
+/**
+ * \brief Destructor. Unregister from reporting, if not yet unregistered by
+ * the most derived class.
+ */
+inline ReportSite::~ReportSite() {
+    reporting().remove(this);
+}
+
+/**
+ * \brief Call site of l_hist().
+ */
+class HistogramSite : public ReportSite {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name      Name.
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \param unit      Unit to append to values, such as " ns".
+     */
+    HistogramSite(const char* name, const char* file_path, long file_line,
+        const char* func, const char* unit = "") :
+        ReportSite(name, file_path, file_line, func),
+        m_hist(), m_unit(unit) {
+    }
+
+    HistogramSite(const HistogramSite&) = delete;
+    HistogramSite& operator=(const HistogramSite&) = delete;
+
+    /**
+     * \brief Destructor. Unregister from reporting.
+     */
+    ~HistogramSite() override {
+        reporting().remove(this);
+    }
+
+    /**
+     * \brief Record value.
+     *
+     * \tparam T Arithmetic value type.
+     * \param v Value.
+     */
+    template<class T>
+    void record(const T& v) {
+        m_hist.record(static_cast<double>(v));
+    }
+
+    /**
+     * \brief Write statistics since previous report, if any samples.
+     *
+     * \param os      Output stream.
+     * \param seconds Seconds since previous report.
+     */
+    void report(std::ostream& os, double seconds) override {
+        static_cast<void>(seconds);
+        HistogramSnapshot s = m_hist.snapshot(true);
+        if (s.get_count() == 0) {
+            return;
+        }
+        os << message_start << get_prefix_formatter();
+        if (!is_text(os)) {
+            encode_key(os, get_name());
+            begin_map(os);
+            encode_key(os, "count");
+            encode_uint(os, s.get_count()) << separator;
+            static const char* const names[] = {
+                "min", "max", "mean", "p50", "p90", "p99", "p999"};
+            const double values[] = {s.get_min(), s.get_max(), s.get_mean(),
+                s.percentile(0.5), s.percentile(0.9), s.percentile(0.99),
+                s.percentile(0.999)};
+            for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+                encode_key(os, names[i]);
+                encode_float(os, values[i]) << separator;
+            }
+            // Unit without leading space
+            const char* unit = m_unit;
+            while (*unit == ' ') {
+                ++unit;
+            }
+            encode_key(os, "unit");
+            encode_string(os, unit);
+            end_map(os);
+            os << MessageEnd() << GL_NEWLINE;
+            return;
+        }
+        os << get_name() << ": count = " << s.get_count()
+           << ", min = " << s.get_min() << m_unit
+           << ", max = " << s.get_max() << m_unit
+           << ", mean = " << s.get_mean() << m_unit
+           << ", p50 = " << s.percentile(0.5) << m_unit
+           << ", p90 = " << s.percentile(0.9) << m_unit
+           << ", p99 = " << s.percentile(0.99) << m_unit
+           << ", p999 = " << s.percentile(0.999) << m_unit << MessageEnd()
+           << GL_NEWLINE;
+    }
+
+  private:
+    Histogram   m_hist; /**< Samples since previous report. */
+    const char* m_unit; /**< Unit to append to values. */
+};
+
+/**
+ * \brief Call site of l_count().
+ */
+class CounterSite : public ReportSite {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name      Name.
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     */
+    CounterSite(const char* name, const char* file_path, long file_line,
+        const char* func) :
+        ReportSite(name, file_path, file_line, func),
+        m_counts() {
+        for (Counter& c : m_counts) {
+            c.n.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * \brief Destructor. Unregister from reporting.
+     */
+    ~CounterSite() override {
+        reporting().remove(this);
+    }
+
+    /**
+     * \brief Count one event.
+     */
+    void increment() noexcept {
+        m_counts[thread_shard(kShards)].n.fetch_add(
+            1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Write count and rate since previous report, if any events.
+     *
+     * \param os      Output stream.
+     * \param seconds Seconds since previous report.
+     */
+    void report(std::ostream& os, double seconds) override {
+        uint64_t n = 0;
+        for (Counter& c : m_counts) {
+            n += c.n.exchange(0, std::memory_order_relaxed);
+        }
+        if (n == 0) {
+            return;
+        }
+        const double rate =
+            seconds > 0.0 ? static_cast<double>(n) / seconds : 0.0;
+        os << message_start << get_prefix_formatter();
+        if (is_text(os)) {
+            os << get_name() << ": count = " << n << ", rate = " << rate
+               << "/s";
+        } else {
+            encode_key(os, get_name());
+            begin_map(os);
+            encode_key(os, "count");
+            encode_uint(os, n) << separator;
+            encode_key(os, "rate");
+            encode_float(os, rate);
+            end_map(os);
+        }
+        os << MessageEnd() << GL_NEWLINE;
+    }
+
+  private:
+    /** Number of shards. */
+    static const size_t kShards = 8;
+
+    /**
+     * \brief Counter on its own cache line.
+     */
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> n; /**< Number of events. */
+    };
+
+    Counter m_counts[kShards]; /**< Events since previous report. */
+};
+
+/**
+ * \brief Call site of l_time_scope() and l_time_scope_log().
+ */
+class TimerSite : public HistogramSite {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param name      Name.
+     * \param file_path File path including name.
+     * \param file_line Line number in file.
+     * \param func      Function name.
+     * \param log       \c true to also log each duration.
+     */
+    TimerSite(const char* name, const char* file_path, long file_line,
+        const char* func, bool log) :
+        HistogramSite(name, file_path, file_line, func, " ns"),
+        m_log(log), m_log_site(file_path, file_line, func) {
+    }
+
+    /**
+     * \brief Destructor. Unregister from reporting, and unregister the call
+     * site of logged durations, so that no rule is applied to it later.
+     */
+    ~TimerSite() override {
+        reporting().remove(this);
+        log_sites().remove(m_log_site);
+    }
+
+    /**
+     * \brief Record duration, and log it if enabled. Logged as by l(),
+     * through the call site, which may be disabled or rate limited, and the
+     * cold emitter.
+     *
+     * \param ns Duration in nanoseconds.
+     */
+    void record_duration(int64_t ns) {
+        record(ns);
+        if (m_log && outputEnabled.load(std::memory_order_relaxed) &&
+            m_log_site.should_log()) {
+            auto message = [this, ns](std::ostream& os) {
+                write_duration(os, ns);
+            };
+            emit(message_writer(message), &message);
+        }
+    }
+
+  private:
+    /**
+     * \brief Write message of duration.
+     *
+     * \param os Output stream.
+     * \param ns Duration in nanoseconds.
+     */
+    void write_duration(std::ostream& os, int64_t ns) {
+        os << message_start << m_log_site.prefix();
+        if (is_text(os)) {
+            os << get_name() << " = " << ns << " ns";
+        } else {
+            encode_key(os, get_name());
+            begin_map(os);
+            encode_key(os, "ns");
+            encode_int(os, ns);
+            end_map(os);
+        }
+        os << MessageEnd() << GL_NEWLINE;
+    }
+
+    const bool m_log;      /**< \c true to also log each duration. */
+    LogSite    m_log_site; /**< Call site of logged durations. */
+};
+
+/**
+ * \brief Measures the time from construction to destruction, and records it
+ * at a TimerSite.
+ */
+class ScopeTimer {
+  public:
+    /**
+     * \brief Constructor. Start timer, unless output is disabled.
+     *
+     * \param site Call site.
+     */
+    explicit ScopeTimer(TimerSite& site) noexcept :
+        m_site(site), m_active(outputEnabled.load(std::memory_order_relaxed)),
+        m_start(m_active ? std::chrono::steady_clock::now() :
+                           std::chrono::steady_clock::time_point()) {
+    }
+
+    ScopeTimer(const ScopeTimer&) = delete;
+    ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+    /**
+     * \brief Destructor. Stop timer and record duration.
+     */
+    ~ScopeTimer() {
+        if (m_active) {
+            m_site.record_duration(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_start)
+                    .count());
+        }
+    }
+
+  private:
+    TimerSite& m_site;   /**< Call site. */
+    const bool m_active; /**< \c true if timer started. */
+    const std::chrono::steady_clock::time_point m_start; /**< Start time. */
+};
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Log statistics of all sites of \ref l_hist() and \ref l_count()
+ * since previous report.
+ *
+ * Outputs one line per site with any samples or events, in the order the
+ * sites were first used. Statistics are reset afterwards.
+ *
+ * \sa l_hist() \sa l_count() \sa start_reporter()
+ *
+ */
+inline void report() {
+    if (internal::outputEnabled.load(std::memory_order_relaxed)) {
+        internal::reporting().report(std::cout);
+    }
+}
+
+/**
+ * \brief Start reporting periodically in a background thread.
+ *
+ * \param interval Time between reports.
+ *
+ * Used as:
+ * \code
+ * gl::start_reporter(std::chrono::seconds(1));
+ * \endcode
+ *
+ * \note Restarts the reporter if already started.
+ *
+ * \sa report() \sa stop_reporter()
+ *
+ */
+inline void start_reporter(std::chrono::milliseconds interval) {
+    internal::reporting().start(interval);
+}
+
+/**
+ * \brief Stop reporting periodically.
+ *
+ * \note The reporter is also stopped at program exit.
+ *
+ * \sa start_reporter()
+ *
+ */
+inline void stop_reporter() {
+    internal::reporting().stop();
+}
+
+#ifndef DOXYGEN_HIDDEN
+/**
+ * \brief Declare timer site and scope timer, with names unique to the line.
+ */
+#define GL_INTERNAL_TIME_SCOPE(name, log)                                  \
+    static ::gl::internal::TimerSite GL_INTERNAL_CONCAT(                   \
+        gl_internal_timer_site_, __LINE__)(                                \
+        (#name), __FILE__, __LINE__, __func__, (log));                     \
+    ::gl::internal::ScopeTimer GL_INTERNAL_CONCAT(                         \
+        gl_internal_scope_timer_, __LINE__)(                               \
+        GL_INTERNAL_CONCAT(gl_internal_timer_site_, __LINE__))
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_REPORT_H_
@@ -0,0 +1,128 @@
+/** \file
+ *
+ * \brief Formatters of sequence containers: std::array, std::vector,
+ * std::deque, std::forward_list and std::list.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/sequence.h"
+ *
+ * std::vector<int> v{1, 2, 3};
+ * l(v);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_SEQUENCE_H_
+#define INCLUDE_GOINGLOGGING_SEQUENCE_H_
+
+#include "core.h"
+#include <array>
+#include <deque>
+#include <forward_list>
+#include <list>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Format std::array.
+ *
+ * \tparam U Value type.
+ * \tparam N Number of elements.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, size_t N>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::array<U, N>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::vector.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::vector<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::deque.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::deque<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::forward_list.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::forward_list<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Format std::list.
+ *
+ * \tparam U Value type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::list<U>>& f) noexcept {
+    return f.sequence(os);
+}
+
+/**
+ * \brief Explicit instantiations of sequences, in the precompiled library.
+ */
+#define GL_INTERNAL_INSTANTIATE_SEQUENCE(spec)                             \
+    GL_INTERNAL_INSTANTIATE_VALUE(spec, std::vector<int>)                  \
+    GL_INTERNAL_INSTANTIATE_VALUE(spec, std::vector<double>)               \
+    GL_INTERNAL_INSTANTIATE_VALUE(spec, std::vector<std::string>)
+
+#ifdef GL_PRECOMPILED
+GL_INTERNAL_INSTANTIATE_SEQUENCE(extern)
+#endif // GL_PRECOMPILED
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_SEQUENCE_H_
@@ -0,0 +1,632 @@
+/** \file
+ *
+ * \brief Shared memory log bus, which several processes can log to at once.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/shm_bus.h"
+ *
+ * gl::start_shm_bus("/my_system");
+ * \endcode
+ * Then, from a shell:
+ * \code
+ * gl_tail -f /my_system
+ * \endcode
+ *
+ * Messages are written to a ring of fixed size slots in shared memory, in
+ * /dev/shm on Linux. A message longer than a slot takes several consecutive
+ * slots. Writers reserve slots with one atomic increment and never wait,
+ * neither for each other nor for readers, and make no system calls. If the
+ * ring is full, the oldest slots are overwritten, and readers report the
+ * overrun. Each slot holds a sequence number which is written last, so that
+ * readers detect slots which are incomplete, for example because the
+ * writing process crashed, or overwritten while being read.
+ *
+ * The shared memory remains after all processes have exited, so that it can
+ * be read after a crash. Remove it with shm_unlink() or from /dev/shm.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_SHM_BUS_H_
+#define INCLUDE_GOINGLOGGING_SHM_BUS_H_
+
+#include "core.h"
+#include "sink.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Start of shared memory log buses. */
+static const char kShmBusMagic[8] = {'G', 'L', 'B', 'U', 'S', '0', '1', 0};
+/** Bytes before the first slot. */
+static const size_t kShmBusHeaderSize = 128;
+/** Flag of first slot of message. */
+static const uint16_t kShmBusFirst = 1;
+/** Flag of last slot of message. */
+static const uint16_t kShmBusLast = 2;
+
+/**
+ * \brief Start of shared memory log bus.
+ */
+struct ShmBusHeader {
+    char                  magic[8];  /**< kShmBusMagic. */
+    std::atomic<uint32_t> ready;     /**< 1 when initialized. */
+    uint32_t              slots;     /**< Number of slots, a power of 2. */
+    uint32_t              slot_size; /**< Bytes per slot, a power of 2. */
+    uint32_t              reserved;  /**< Unused. */
+    /** Sequence number of next slot to write. */
+    alignas(64) std::atomic<uint64_t> head;
+};
+
+static_assert(sizeof(ShmBusHeader) <= kShmBusHeaderSize,
+    "Shared memory bus header too large");
+
+/**
+ * \brief Start of slot, followed by its data.
+ */
+struct ShmBusSlot {
+    /** Sequence number + 1 when written, 0 while being written. */
+    std::atomic<uint64_t> seq;
+    uint16_t              len;   /**< Bytes of data in slot. */
+    uint16_t              flags; /**< kShmBusFirst and kShmBusLast. */
+    uint32_t              pid;   /**< Process ID of writer. */
+};
+
+/**
+ * \return Cached process ID, which is updated after fork().
+ */
+inline std::atomic<uint32_t>& cached_pid() noexcept {
+    static std::atomic<uint32_t> pid(0);
+    return pid;
+}
+
+/**
+ * \brief Update cached process ID.
+ */
+inline void update_cached_pid() noexcept {
+    cached_pid().store(
+        static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+}
+
+/**
+ * \return Process ID, without a system call.
+ */
+inline uint32_t current_pid() noexcept {
+    static std::once_flag once;
+    uint32_t              pid = cached_pid().load(std::memory_order_relaxed);
+    if (pid == 0) {
+        std::call_once(once, []() {
+            pthread_atfork(nullptr, nullptr, update_cached_pid);
+            update_cached_pid();
+        });
+        pid = cached_pid().load(std::memory_order_relaxed);
+    }
+    return pid;
+}
+
+/**
+ * \brief Mapping of a shared memory log bus.
+ */
+class ShmBusMapping {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    ShmBusMapping() noexcept : m_base(nullptr), m_size(0) {
+    }
+
+    ShmBusMapping(const ShmBusMapping&) = delete;
+    ShmBusMapping& operator=(const ShmBusMapping&) = delete;
+
+    /**
+     * \brief Destructor. Unmap.
+     */
+    ~ShmBusMapping() {
+        unmap();
+    }
+
+    /**
+     * \brief Map bus, and create it if it does not exist and \p create is
+     * set. An existing bus keeps its number and size of slots.
+     *
+     * \param name      Name of shared memory object, e.g. "/my_system".
+     * \param create    \c true to create bus and map it writable.
+     * \param slots     Number of slots if created. A power of 2.
+     * \param slot_size Bytes per slot if created. A power of 2 in
+     *                  [64, 65536].
+     * \return \c true if success.
+     */
+    bool map(const std::string& name, bool create, uint32_t slots,
+        uint32_t slot_size) {
+        unmap();
+        int  fd      = -1;
+        bool created = false;
+        if (create) {
+            if (slots < 2 || (slots & (slots - 1)) != 0 || slot_size < 64 ||
+                slot_size > 65536 || (slot_size & (slot_size - 1)) != 0) {
+                return false;
+            }
+            fd      = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            created = fd >= 0;
+            if (!created && errno != EEXIST) {
+                return false;
+            }
+        }
+        if (fd < 0) {
+            fd = shm_open(name.c_str(), create ? O_RDWR : O_RDONLY, 0);
+            if (fd < 0) {
+                return false;
+            }
+        }
+        bool ok = created ? initialize(fd, slots, slot_size) :
+                            attach(fd, create);
+        close(fd);
+        return ok;
+    }
+
+    /**
+     * \brief Unmap, if mapped.
+     */
+    void unmap() noexcept {
+        if (m_base != nullptr) {
+            munmap(m_base, m_size);
+            m_base = nullptr;
+            m_size = 0;
+        }
+    }
+
+    /**
+     * \return \c true if mapped.
+     */
+    bool is_mapped() const noexcept {
+        return m_base != nullptr;
+    }
+
+    /**
+     * \return Header.
+     */
+    ShmBusHeader& header() const noexcept {
+        return *reinterpret_cast<ShmBusHeader*>(m_base);
+    }
+
+    /**
+     * \brief Get slot of sequence number.
+     *
+     * \param seq Sequence number.
+     * \return Slot.
+     */
+    ShmBusSlot& slot(uint64_t seq) const noexcept {
+        const ShmBusHeader& h = header();
+        return *reinterpret_cast<ShmBusSlot*>(static_cast<char*>(m_base) +
+                                              kShmBusHeaderSize +
+                                              (seq & (h.slots - 1)) *
+                                                  h.slot_size);
+    }
+
+    /**
+     * \brief Get data of slot.
+     *
+     * \param s Slot.
+     * \return Data [payload()].
+     */
+    static char* data(ShmBusSlot& s) noexcept {
+        return reinterpret_cast<char*>(&s) + sizeof(ShmBusSlot);
+    }
+
+    /**
+     * \return Bytes of data per slot.
+     */
+    size_t payload() const noexcept {
+        return header().slot_size - sizeof(ShmBusSlot);
+    }
+
+  private:
+    /**
+     * \brief Size and initialize new bus.
+     *
+     * \param fd        Shared memory file descriptor.
+     * \param slots     Number of slots.
+     * \param slot_size Bytes per slot.
+     * \return \c true if success.
+     */
+    bool initialize(int fd, uint32_t slots, uint32_t slot_size) {
+        size_t size = kShmBusHeaderSize + size_t(slots) * slot_size;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0 ||
+            !map_fd(fd, size, true)) {
+            return false;
+        }
+        ShmBusHeader* h = new (m_base) ShmBusHeader;
+        std::memcpy(h->magic, kShmBusMagic, sizeof(kShmBusMagic));
+        h->slots     = slots;
+        h->slot_size = slot_size;
+        h->reserved  = 0;
+        h->head.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < slots; ++i) {
+            new (&slot(i)) ShmBusSlot;
+            slot(i).seq.store(0, std::memory_order_relaxed);
+        }
+        h->ready.store(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * \brief Map existing bus, waiting up to a second for its creator to
+     * initialize it.
+     *
+     * \param fd       Shared memory file descriptor.
+     * \param writable \c true to map writable.
+     * \return \c true if success.
+     */
+    bool attach(int fd, bool writable) {
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (true) {
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                return false;
+            }
+            size_t size = static_cast<size_t>(st.st_size);
+            if (size >= kShmBusHeaderSize && map_fd(fd, size, writable)) {
+                const ShmBusHeader& h = header();
+                if (h.ready.load(std::memory_order_acquire) == 1) {
+                    return std::memcmp(h.magic, kShmBusMagic,
+                               sizeof(kShmBusMagic)) == 0 &&
+                           size == kShmBusHeaderSize +
+                                       size_t(h.slots) * h.slot_size;
+                }
+                unmap();
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    /**
+     * \brief Map file descriptor.
+     *
+     * \param fd       File descriptor.
+     * \param size     Bytes to map.
+     * \param writable \c true to map writable.
+     * \return \c true if success.
+     */
+    bool map_fd(int fd, size_t size, bool writable) noexcept {
+        void* p = mmap(nullptr, size,
+            writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        m_base = p;
+        m_size = size;
+        return true;
+    }
+
+    void*  m_base; /**< Mapped memory, or \c nullptr. */
+    size_t m_size; /**< Bytes mapped. */
+};
+
+/**
+ * \brief Write message to bus. Never waits.
+ *
+ * \param bus Writable mapping.
+ * \param s   Message [\p n]. Truncated if longer than the ring.
+ * \param n   Bytes of message.
+ */
+inline void shm_bus_publish(
+    const ShmBusMapping& bus, const char* s, size_t n) noexcept {
+    ShmBusHeader& h       = bus.header();
+    const size_t  payload = bus.payload();
+    uint64_t      k       = n == 0 ? 1 : (n + payload - 1) / payload;
+    if (k > h.slots) {
+        k = h.slots;
+        n = k * payload;
+    }
+    const uint32_t pid = current_pid();
+    const uint64_t seq = h.head.fetch_add(k, std::memory_order_relaxed);
+    for (uint64_t i = 0; i < k; ++i) {
+        ShmBusSlot& sl  = bus.slot(seq + i);
+        size_t      len = std::min(payload, n - i * payload);
+        // Mark as incomplete before writing, as for a sequence lock
+        sl.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(ShmBusMapping::data(sl), s + i * payload, len);
+        sl.len   = static_cast<uint16_t>(len);
+        sl.flags = static_cast<uint16_t>((i == 0 ? kShmBusFirst : 0) |
+                                         (i + 1 == k ? kShmBusLast : 0));
+        sl.pid   = pid;
+        sl.seq.store(seq + i + 1, std::memory_order_release);
+    }
+}
+
+/**
+ * \brief Reader of shared memory log bus, which follows the writers.
+ */
+class ShmBusReader {
+  public:
+    /**
+     * \brief Result of reading.
+     */
+    enum class result {
+        MESSAGE, /**< Message read. */
+        EMPTY,   /**< No more messages written. */
+        PENDING  /**< Next slot is being written, or its writer crashed. */
+    };
+
+    /**
+     * \brief Constructor.
+     */
+    ShmBusReader() :
+        m_bus(), m_next(0), m_lost(0), m_partial(), m_buf(), m_active(false) {
+    }
+
+    /**
+     * \brief Open existing bus, and start at its oldest message.
+     *
+     * \param name Name of shared memory object.
+     * \return \c true if success.
+     */
+    bool open(const std::string& name) {
+        if (!m_bus.map(name, false, 0, 0)) {
+            return false;
+        }
+        const ShmBusHeader& h    = m_bus.header();
+        uint64_t            head = h.head.load(std::memory_order_acquire);
+        m_next   = head > h.slots ? head - h.slots : 0;
+        m_lost   = 0;
+        m_active = false;
+        return true;
+    }
+
+    /**
+     * \brief Read next message.
+     *
+     * \param msg Message, if read.
+     * \param pid Process ID of writer, if read.
+     * \return Result.
+     */
+    result next(std::string& msg, uint32_t& pid) {
+        const ShmBusHeader& h = m_bus.header();
+        while (true) {
+            uint64_t head = h.head.load(std::memory_order_acquire);
+            if (head - m_next > h.slots) {
+                // Overrun, continue at oldest slot
+                m_lost += head - h.slots - m_next;
+                m_next   = head - h.slots;
+                m_active = false;
+            }
+            if (m_next >= head) {
+                return result::EMPTY;
+            }
+            ShmBusSlot& sl = m_bus.slot(m_next);
+            uint64_t    s1 = sl.seq.load(std::memory_order_acquire);
+            if (s1 != m_next + 1) {
+                if (s1 == 0 || s1 < m_next + 1) {
+                    return result::PENDING;
+                }
+                // Overwritten
+                skip();
+                continue;
+            }
+            size_t   len   = std::min<size_t>(sl.len, m_bus.payload());
+            uint16_t flags = sl.flags;
+            uint32_t p     = sl.pid;
+            m_buf.assign(ShmBusMapping::data(sl), len);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sl.seq.load(std::memory_order_relaxed) != s1) {
+                // Overwritten while read
+                skip();
+                continue;
+            }
+            ++m_next;
+            if ((flags & kShmBusFirst) != 0) {
+                m_partial = m_buf;
+                m_active  = true;
+            } else if (m_active) {
+                m_partial += m_buf;
+            } else {
+                // Rest of a lost message
+                continue;
+            }
+            if ((flags & kShmBusLast) != 0) {
+                m_active = false;
+                msg.swap(m_partial);
+                pid = p;
+                return result::MESSAGE;
+            }
+        }
+    }
+
+    /**
+     * \brief Skip next slot, for example if it stays pending since its
+     * writer crashed.
+     */
+    void skip() noexcept {
+        ++m_lost;
+        ++m_next;
+        m_active = false;
+    }
+
+    /**
+     * \return Number of slots lost since previous call.
+     */
+    uint64_t take_lost() noexcept {
+        uint64_t lost = m_lost;
+        m_lost        = 0;
+        return lost;
+    }
+
+  private:
+    ShmBusMapping m_bus;     /**< Mapping. */
+    uint64_t      m_next;    /**< Sequence number of next slot. */
+    uint64_t      m_lost;    /**< Slots lost since previous take_lost(). */
+    std::string   m_partial; /**< Message being read. */
+    std::string   m_buf;     /**< Data of slot being read. */
+    bool          m_active;  /**< \c true if reading a message. */
+};
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stream buffer which writes each line as a message to a shared
+ * memory log bus.
+ *
+ * May be written to by several threads at once, since each thread collects
+ * its line separately. A line is written when it ends or the stream is
+ * flushed.
+ *
+ * Used as:
+ * \code
+ * gl::ShmBusStreambuf bus;
+ * if (bus.open("/my_system")) {
+ *     std::cout.rdbuf(&bus);
+ * }
+ * \endcode
+ *
+ * \sa start_shm_bus()
+ */
+class ShmBusStreambuf : public internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    ShmBusStreambuf() : m_bus() {
+    }
+
+    /**
+     * \brief Open bus, and create it if it does not exist.
+     *
+     * \param name      Name of shared memory object, e.g. "/my_system".
+     * \param slots     Number of slots if created. A power of 2.
+     * \param slot_size Bytes per slot if created, including 16 bytes of
+     *                  header. A power of 2 in [64, 65536].
+     * \return \c true if success.
+     *
+     * \note Messages longer than all slots together are truncated.
+     */
+    bool open(const std::string& name, uint32_t slots = 65536,
+        uint32_t slot_size = 128) {
+        return m_bus.map(name, true, slots, slot_size);
+    }
+
+    /**
+     * \brief Close bus. No thread may write to the stream buffer meanwhile.
+     */
+    void close() noexcept {
+        m_bus.unmap();
+    }
+
+    /**
+     * \return \c true if open.
+     */
+    bool is_open() const noexcept {
+        return m_bus.is_mapped();
+    }
+
+  protected:
+    /**
+     * \brief Write line as message, if open.
+     *
+     * \param s Line [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) noexcept override {
+        if (m_bus.is_mapped()) {
+            internal::shm_bus_publish(m_bus, s, n);
+        }
+    }
+
+  private:
+    internal::ShmBusMapping m_bus; /**< Mapping. */
+};
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Bus which std::cout is redirected to by start_shm_bus().
+ */
+typedef CoutRedirect<ShmBusStreambuf> ShmBusSink;
+
+/**
+ * \return Bus of start_shm_bus().
+ */
+inline ShmBusSink& shm_bus_sink() {
+    static ShmBusSink sink;
+    return sink;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Stop writing std::cout to shared memory log bus, and restore its
+ * previous stream buffer.
+ *
+ * \sa start_shm_bus()
+ *
+ */
+inline void stop_shm_bus() {
+    internal::ShmBusSink& sink = internal::shm_bus_sink();
+    if (sink.buf.is_open()) {
+        std::cout.flush();
+        sink.restore();
+        sink.buf.close();
+    }
+}
+
+/**
+ * \brief Write std::cout, and thereby all logging, to a shared memory log
+ * bus. Creates the bus if it does not exist.
+ *
+ * Used as:
+ * \code
+ * gl::start_shm_bus("/my_system");
+ * \endcode
+ * Read the bus with the gl_tail tool.
+ *
+ * \param name      Name of shared memory object, e.g. "/my_system".
+ * \param slots     Number of slots if created. A power of 2.
+ * \param slot_size Bytes per slot if created. A power of 2 in [64, 65536].
+ * \return \c true if started.
+ *
+ * \note Must not be called while other threads log.
+ *
+ * \sa stop_shm_bus() \sa ShmBusStreambuf
+ *
+ */
+inline bool start_shm_bus(const std::string& name, uint32_t slots = 65536,
+    uint32_t slot_size = 128) {
+    stop_shm_bus();
+    internal::ShmBusSink& sink = internal::shm_bus_sink();
+    if (!sink.buf.open(name, slots, slot_size)) {
+        return false;
+    }
+    sink.redirect();
+    return true;
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_SHM_BUS_H_
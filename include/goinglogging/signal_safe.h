@@ -0,0 +1,405 @@
+/** \file
+ *
+ * \brief Async-signal-safe logging with l_signal_safe(), for signal handlers
+ * and watchdog callbacks.
+ *
+ * Optional, and only for POSIX systems. Include after goinglogging.h:
+ * \code
+ * #include "goinglogging.h"
+ * #include "goinglogging/signal_safe.h"
+ *
+ * void on_signal(int sig) {
+ *     l_signal_safe(sig);
+ * }
+ * \endcode
+ *
+ * Each message is formatted into a buffer on the stack, without locks,
+ * allocation, locales or streams, and written with one call to write() to
+ * the file descriptor set by set_signal_safe_fd(). Only integers, enums,
+ * bools, characters, pointers and C strings can be logged. Of the prefixes,
+ * only FILE, LINE and FUNCTION are written.
+ *
+ * Messages are at most 512 characters, so that they are written atomically
+ * to pipes, and are not interleaved with messages of other threads.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_SIGNAL_SAFE_H_
+#define INCLUDE_GOINGLOGGING_SIGNAL_SAFE_H_
+
+#include "core.h"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+
+#include <unistd.h>
+
+/**
+ * \brief Log variables from a signal handler. Async-signal-safe.
+ *
+ * Use as:
+ * \code
+ * void on_signal(int sig) {
+ *     const char* what = "watchdog";
+ *     l_signal_safe(sig, what);
+ * }
+ * \endcode
+ * Which outputs:
+ * \code
+ * sig = 10, what = "watchdog"
+ * \endcode
+ *
+ * \note Supports up to 16 variables of integer, enum, bool, character,
+ * pointer and C string types.
+ * \note Only writes the FILE, LINE and FUNCTION prefixes. Ignores the
+ * format and color settings, and the enabled call sites.
+ *
+ * \sa set_signal_safe_fd() \sa l()
+ *
+ */
+#define l_signal_safe(...)                                                 \
+    do {                                                                   \
+        if (::gl::is_output_enabled()) {                                   \
+            ::gl::internal::SignalSafeMessage gl_internal_message(         \
+                __FILE__, __LINE__, __func__);                             \
+            gl_internal_message << GL_INTERNAL_L_DISPATCH(__VA_ARGS__,     \
+                GL_INTERNAL_L16, GL_INTERNAL_L15, GL_INTERNAL_L14,         \
+                GL_INTERNAL_L13, GL_INTERNAL_L12, GL_INTERNAL_L11,         \
+                GL_INTERNAL_L10, GL_INTERNAL_L9, GL_INTERNAL_L8,           \
+                GL_INTERNAL_L7, GL_INTERNAL_L6, GL_INTERNAL_L5,            \
+                GL_INTERNAL_L4, GL_INTERNAL_L3, GL_INTERNAL_L2,            \
+                GL_INTERNAL_L1, )(__VA_ARGS__);                            \
+            gl_internal_message.write();                                   \
+        }                                                                  \
+    } while (false)
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \return File descriptor of l_signal_safe(). Constant initialized, so it is
+ * safe to read before main() and from signal handlers.
+ */
+inline std::atomic<int>& signal_safe_fd() noexcept {
+    static std::atomic<int> fd(STDERR_FILENO);
+    return fd;
+}
+
+/**
+ * \brief Message of l_signal_safe(), formatted on the stack and written
+ * with one call to write().
+ */
+class SignalSafeMessage {
+  public:
+    /** Maximum number of characters of a message, including newline. */
+    static const size_t kSize = 512;
+
+    /**
+     * \brief Constructor. Write prefixes.
+     *
+     * \param file_path File path.
+     * \param file_line Line number.
+     * \param func      Function name.
+     */
+    SignalSafeMessage(
+        const char* file_path, long file_line, const char* func) noexcept :
+        m_buf(), m_len(0), m_truncated(false) {
+        const prefix cur = curPrefixes.load(std::memory_order_relaxed);
+        bool         any = false;
+        if ((cur & prefix::FILE) != prefix::NONE) {
+            append(file_name(file_path));
+            any = true;
+        }
+        if ((cur & prefix::LINE) != prefix::NONE) {
+            append(any ? ":" : "Line: ");
+            append_integer(file_line, std::false_type());
+            any = true;
+        }
+        if ((cur & prefix::FUNCTION) != prefix::NONE) {
+            if (any) {
+                append(", ");
+            }
+            append(func);
+            append("()");
+            any = true;
+        }
+        if (any) {
+            append(": ");
+        }
+    }
+
+    SignalSafeMessage(const SignalSafeMessage&) = delete;
+    SignalSafeMessage& operator=(const SignalSafeMessage&) = delete;
+
+    /**
+     * \brief Append variable name and value.
+     *
+     * \tparam T Value type.
+     * \param v Variable.
+     * \return This.
+     */
+    template<class T>
+    SignalSafeMessage& operator<<(const Variable<T>& v) noexcept {
+        append(v.get_name());
+        append(" = ");
+        append_value(v.get_value());
+        return *this;
+    }
+
+    /**
+     * \brief Append separator between variables.
+     *
+     * \return This.
+     */
+    SignalSafeMessage& operator<<(
+        std::ostream& (*)(std::ostream&)) noexcept {
+        append(", ");
+        return *this;
+    }
+
+    /**
+     * \brief Write message and newline with one call to write(). Keeps
+     * errno, as signal handlers must.
+     */
+    void write() noexcept {
+        if (m_truncated) {
+            std::memcpy(m_buf + kSize - 4, "...", 3);
+        }
+        m_buf[m_len++] = '\n';
+        const int saved = errno;
+        const int fd    = signal_safe_fd().load(std::memory_order_relaxed);
+        while (::write(fd, m_buf, m_len) < 0 && errno == EINTR) {
+        }
+        errno = saved;
+    }
+
+  private:
+    /**
+     * \brief Append characters. Truncate if full, keeping space for newline.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     */
+    void append(const char* s, size_t n) noexcept {
+        if (n > kSize - 1 - m_len) {
+            n           = kSize - 1 - m_len;
+            m_truncated = true;
+        }
+        std::memcpy(m_buf + m_len, s, n);
+        m_len += n;
+    }
+
+    /**
+     * \brief Append null-terminated string.
+     *
+     * \param s String.
+     */
+    void append(const char* s) noexcept {
+        append(s, std::strlen(s));
+    }
+
+    /**
+     * \brief Append quoted string.
+     *
+     * \param s Characters [\p n].
+     * \param n Number of characters.
+     */
+    void append_string(const char* s, size_t n) noexcept {
+        append("\"", 1);
+        append(s, n);
+        append("\"", 1);
+    }
+
+    /**
+     * \brief Append unsigned integer.
+     *
+     * \param v    Value.
+     * \param base 10 or 16.
+     */
+    void append_unsigned(uintmax_t v, unsigned base) noexcept {
+        static const char digits[] = "0123456789abcdef";
+        char              buf[sizeof(uintmax_t) * 3];
+        char*             p = buf + sizeof(buf);
+        do {
+            *--p = digits[v % base];
+            v /= base;
+        } while (v != 0);
+        append(p, static_cast<size_t>(buf + sizeof(buf) - p));
+    }
+
+    /**
+     * \brief Append integer.
+     *
+     * \tparam T Integer type.
+     * \param v Value.
+     */
+    template<class T>
+    void append_integer(T v, std::false_type /* enum */) noexcept {
+        if (is_negative(v, std::is_signed<T>())) {
+            append("-", 1);
+            append_unsigned(0 - static_cast<uintmax_t>(v), 10);
+        } else {
+            append_unsigned(static_cast<uintmax_t>(v), 10);
+        }
+    }
+
+    /**
+     * \brief Append enum as its underlying integer.
+     *
+     * \tparam T Enum type.
+     * \param v Value.
+     */
+    template<class T>
+    void append_integer(T v, std::true_type /* enum */) noexcept {
+        append_integer(static_cast<typename std::underlying_type<T>::type>(v),
+            std::false_type());
+    }
+
+    /**
+     * \tparam T Signed integer type.
+     * \param v Value.
+     * \return \c true if negative.
+     */
+    template<class T>
+    static bool is_negative(T v, std::true_type /* signed */) noexcept {
+        return v < 0;
+    }
+
+    /**
+     * \tparam T Unsigned integer type.
+     * \return \c false.
+     */
+    template<class T>
+    static bool is_negative(T /* v */, std::false_type /* signed */) noexcept {
+        return false;
+    }
+
+    /**
+     * \brief Append integer or enum.
+     *
+     * \tparam T Value type.
+     * \param v Value.
+     */
+    template<class T>
+    void append_value(const T& v) noexcept {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+            "l_signal_safe() only supports integers, enums, bools, "
+            "characters, pointers and C strings");
+        append_integer(v, std::is_enum<T>());
+    }
+
+    /**
+     * \brief Append pointer in hexadecimal.
+     *
+     * \tparam T Pointed to type.
+     * \param p Pointer.
+     */
+    template<class T>
+    void append_value(T* const& p) noexcept {
+        if (p == nullptr) {
+            append("nullptr");
+            return;
+        }
+        append("0x", 2);
+        append_unsigned(reinterpret_cast<uintptr_t>(p), 16);
+    }
+
+    /**
+     * \brief Append character array as string, up to its first null
+     * character.
+     *
+     * \tparam N Number of characters.
+     * \param s Characters.
+     */
+    template<size_t N>
+    void append_value(const char (&s)[N]) noexcept {
+        const void* end = std::memchr(s, '\0', N);
+        append_string(s, end == nullptr ?
+                             N :
+                             static_cast<size_t>(
+                                 static_cast<const char*>(end) - s));
+    }
+
+    /**
+     * \brief Append C string.
+     *
+     * \param s String.
+     */
+    void append_value(const char* const& s) noexcept {
+        if (s == nullptr) {
+            append("nullptr");
+        } else {
+            append_string(s, std::strlen(s));
+        }
+    }
+
+    /**
+     * \brief Append C string.
+     *
+     * \param s String.
+     */
+    void append_value(char* const& s) noexcept {
+        append_value(static_cast<const char* const&>(s));
+    }
+
+    /**
+     * \brief Append bool.
+     *
+     * \param b Value.
+     */
+    void append_value(const bool& b) noexcept {
+        append(b ? "true" : "false");
+    }
+
+    /**
+     * \brief Append character, quoted.
+     *
+     * \param c Character.
+     */
+    void append_value(const char& c) noexcept {
+        char q[] = {'\'', c, '\''};
+        append(q, sizeof(q));
+    }
+
+    char   m_buf[kSize]; /**< Message. */
+    size_t m_len;        /**< Number of characters. */
+    bool   m_truncated;  /**< \c true if characters did not fit. */
+};
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Set file descriptor which l_signal_safe() writes to.
+ *
+ * \param fd File descriptor, e.g. of an opened file.
+ *
+ * \note Defaults to stderr.
+ *
+ * \sa get_signal_safe_fd() \sa l_signal_safe()
+ *
+ */
+inline void set_signal_safe_fd(int fd) noexcept {
+    internal::signal_safe_fd().store(fd, std::memory_order_relaxed);
+}
+
+/**
+ *
+ * \return File descriptor which l_signal_safe() writes to.
+ *
+ * \sa set_signal_safe_fd()
+ *
+ */
+inline int get_signal_safe_fd() noexcept {
+    return internal::signal_safe_fd().load(std::memory_order_relaxed);
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_SIGNAL_SAFE_H_
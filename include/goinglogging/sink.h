@@ -0,0 +1,266 @@
+/** \file
+ *
+ * \brief Base of the sinks which std::cout is redirected to: a stream buffer
+ * which passes on whole lines, and the redirection of std::cout to it.
+ *
+ * Included by the sinks, such as goinglogging/batch_sink.h, and by
+ * goinglogging/structured.h, which passes each CBOR message on whole.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_SINK_H_
+#define INCLUDE_GOINGLOGGING_SINK_H_
+
+#include "core.h"
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Stream buffer which collects each line per thread and passes it on
+ * when complete, so that several threads may write to it at once.
+ *
+ * Base of sinks which std::cout can be redirected to. A line is also passed
+ * on when the stream is flushed. CBOR messages are binary, and may contain
+ * newline bytes, so they are instead collected whole and passed on at their
+ * end.
+ */
+class LineStreambuf : public std::streambuf {
+  public:
+    /**
+     * \brief End message of this thread. Passes on a CBOR message.
+     */
+    void message_end() {
+        std::string& pending = line();
+        if (message_format() == static_cast<uint32_t>(format::CBOR) &&
+            !pending.empty()) {
+            write_message(pending.data(), pending.size());
+            pending.clear();
+        }
+    }
+
+  protected:
+    /**
+     * \brief Write complete line.
+     *
+     * \param s Line without newline [\p n].
+     * \param n Number of characters.
+     */
+    virtual void write_line(const char* s, size_t n) = 0;
+
+    /**
+     * \brief Write complete CBOR message, which is not followed by a newline.
+     * Written as a line by default, for sinks which keep messages apart.
+     *
+     * \param s Message [\p n].
+     * \param n Number of bytes.
+     */
+    virtual void write_message(const char* s, size_t n) {
+        write_line(s, n);
+    }
+
+    /**
+     * \brief Write character.
+     *
+     * \param c Character.
+     * \return Not end of file.
+     */
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            char ch = traits_type::to_char_type(c);
+            xsputn(&ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    /**
+     * \brief Write characters. Write each line which ends, except in CBOR
+     * messages.
+     *
+     * \param s Characters.
+     * \param n Number of characters.
+     * \return \p n.
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::string& pending = line();
+        const char*  end     = s + n;
+        if (message_format() == static_cast<uint32_t>(format::CBOR)) {
+            pending.append(s, end);
+            return n;
+        }
+        while (s != end) {
+            const char* nl = static_cast<const char*>(
+                std::memchr(s, '\n', static_cast<size_t>(end - s)));
+            if (nl == nullptr) {
+                pending.append(s, end);
+                break;
+            }
+            pending.append(s, nl);
+            write_line(pending.data(), pending.size());
+            pending.clear();
+            s = nl + 1;
+        }
+        return n;
+    }
+
+    /**
+     * \brief Write unfinished line of this thread, if any. Unfinished CBOR
+     * messages are kept.
+     *
+     * \return 0.
+     */
+    int sync() override {
+        std::string& pending = line();
+        if (!pending.empty() &&
+            message_format() != static_cast<uint32_t>(format::CBOR)) {
+            write_line(pending.data(), pending.size());
+            pending.clear();
+        }
+        return 0;
+    }
+
+  private:
+    /**
+     * \return Unfinished line of this thread.
+     */
+    static std::string& line() {
+        static thread_local std::string pending;
+        return pending;
+    }
+};
+
+
+/**
+ * \brief Redirection of std::cout to a stream buffer.
+ *
+ * Redirections may be stopped in any order. Stopping one which another was
+ * started on top of passes its previous stream buffer on to that one, so
+ * that std::cout is never left on a stopped stream buffer.
+ */
+class CoutRedirection {
+  public:
+    CoutRedirection(const CoutRedirection&) = delete;
+    CoutRedirection& operator=(const CoutRedirection&) = delete;
+
+    /**
+     * \brief Redirect std::cout to the stream buffer, if not already.
+     */
+    void redirect() {
+        std::lock_guard<std::mutex> lock(mutex());
+        if (m_redirected) {
+            return;
+        }
+        m_previous   = std::cout.rdbuf(m_buf);
+        m_next       = head();
+        head()       = this;
+        m_redirected = true;
+    }
+
+    /**
+     * \brief Stop redirection, if redirected.
+     */
+    void restore() {
+        std::lock_guard<std::mutex> lock(mutex());
+        if (!m_redirected) {
+            return;
+        }
+        if (std::cout.rdbuf() == m_buf) {
+            std::cout.rdbuf(m_previous);
+        }
+        for (CoutRedirection** r = &head(); *r != nullptr;) {
+            if (*r == this) {
+                *r = m_next;
+                continue;
+            }
+            if ((*r)->m_previous == m_buf) {
+                (*r)->m_previous = m_previous;
+            }
+            r = &(*r)->m_next;
+        }
+        m_redirected = false;
+    }
+
+    /**
+     * \return \c true if redirected.
+     */
+    bool is_redirected() const noexcept {
+        return m_redirected;
+    }
+
+  protected:
+    /**
+     * \brief Constructor.
+     *
+     * \param buf Stream buffer to redirect to.
+     */
+    explicit CoutRedirection(std::streambuf* buf) :
+        m_buf(buf), m_previous(nullptr), m_next(nullptr), m_redirected(false) {
+        // Constructed before, and so destroyed after, any redirection
+        mutex();
+    }
+
+    /**
+     * \brief Destructor.
+     */
+    ~CoutRedirection() = default;
+
+  private:
+    /**
+     * \return Mutex of redirections.
+     */
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    /**
+     * \return Most recent redirection, linked to the earlier ones.
+     */
+    static CoutRedirection*& head() noexcept {
+        static CoutRedirection* r = nullptr;
+        return r;
+    }
+
+    std::streambuf*  m_buf;        /**< Stream buffer to redirect to. */
+    std::streambuf*  m_previous;   /**< Stream buffer of std::cout before. */
+    CoutRedirection* m_next;       /**< Earlier redirection. */
+    bool             m_redirected; /**< \c true if redirected. */
+};
+
+/**
+ * \brief Stream buffer which std::cout can be redirected to, e.g. of a sink.
+ *
+ * \tparam Streambuf Stream buffer type.
+ */
+template<class Streambuf>
+struct CoutRedirect : public CoutRedirection {
+    /**
+     * \brief Constructor.
+     */
+    CoutRedirect() : CoutRedirection(&buf), buf() {
+    }
+
+    /**
+     * \brief Destructor. Restore std::cout, which outlives the stream buffer.
+     */
+    ~CoutRedirect() {
+        restore();
+    }
+
+    Streambuf buf; /**< Stream buffer. */
+};
+
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_SINK_H_
@@ -0,0 +1,246 @@
+/** \file
+ *
+ * \brief Enable, disable and rate limit call sites of l(), l_arr() and
+ * l_mat() by pattern.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/sites.h"
+ *
+ * gl::set_sites_enabled("network.cpp:*", false);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_SITES_H_
+#define INCLUDE_GOINGLOGGING_SITES_H_
+
+#include "core.h"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Match text against a glob pattern.
+ *
+ * \param pattern Pattern, where '*' matches any characters and '?' matches
+ *                one character.
+ * \param text    Text.
+ * \return \c true if \p text matches \p pattern.
+ */
+inline bool glob_match(const char* pattern, const char* text) noexcept {
+    const char* star  = nullptr; /**< Position after last '*' in pattern. */
+    const char* retry = nullptr; /**< Text position to retry '*' from. */
+    while (*text != '\0') {
+        if (*pattern == '*') {
+            star  = ++pattern;
+            retry = text;
+        } else if (*pattern == '?' || *pattern == *text) {
+            ++pattern;
+            ++text;
+        } else if (star != nullptr) {
+            pattern = star;
+            text    = ++retry;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+/**
+ * \brief Check if pattern matches call site.
+ *
+ * \param site    Call site.
+ * \param pattern Glob pattern.
+ * \return \c true if \p pattern matches "file:line" or function name.
+ */
+inline bool site_matches(const LogSite& site, const std::string& pattern) {
+    std::string location = std::string(file_name(site.get_file_path())) +
+                           ':' + std::to_string(site.get_file_line_number());
+    return glob_match(pattern.c_str(), location.c_str()) ||
+           glob_match(pattern.c_str(), site.get_function_name());
+}
+
+/**
+ * \brief Rules which enable, disable and rate limit call sites, applied to
+ * the used call sites, and to each call site when it is used first.
+ */
+class SiteRules {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    SiteRules() : m_mutex(), m_rules() {}
+
+    SiteRules(const SiteRules&) = delete;
+    SiteRules& operator=(const SiteRules&) = delete;
+
+    /**
+     * \brief Enable or disable matching sites, including sites used later.
+     *
+     * \param pattern Glob pattern.
+     * \param e       \c true to enable.
+     */
+    void set_enabled(const std::string& pattern, bool e) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        log_sites().update(&apply, [&](LogSite* head) {
+            add_rule(pattern, false, e ? 1 : 0);
+            for (LogSite* s = head; s != nullptr; s = s->get_next()) {
+                if (site_matches(*s, pattern)) {
+                    s->set_enabled(e);
+                }
+            }
+        });
+#ifdef GL_INTERNAL_STATIC_KEYS
+        // Also sites never used, which are disabled before their first use
+        for (const StaticSite* s = __start_gl_static_sites;
+             s != __stop_gl_static_sites; ++s) {
+            if (site_matches(*s->log_site(), pattern)) {
+                patch_static_site(*s, e);
+            }
+        }
+#endif // GL_INTERNAL_STATIC_KEYS
+    }
+
+    /**
+     * \brief Rate limit matching sites, including sites used later.
+     *
+     * \param pattern          Glob pattern.
+     * \param lines_per_second Maximum number of lines per second, 0 if
+     *                         unlimited.
+     */
+    void set_rate_limit(const std::string& pattern, uint32_t lines_per_second) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        log_sites().update(&apply, [&](LogSite* head) {
+            add_rule(pattern, true, lines_per_second);
+            for (LogSite* s = head; s != nullptr; s = s->get_next()) {
+                if (site_matches(*s, pattern)) {
+                    s->set_rate_limit(lines_per_second);
+                }
+            }
+        });
+    }
+
+  private:
+    /**
+     * \brief Rule applied to matching sites, in order of addition.
+     */
+    struct Rule {
+        std::string pattern;  /**< Glob pattern. */
+        bool        is_limit; /**< \c true if rate limit, else enabled. */
+        uint32_t    value;    /**< Rate limit, or 1 if enabled. */
+    };
+
+    static void apply(LogSite& site);
+
+    /**
+     * \brief Add rule, replacing any earlier rule of the same kind and
+     * pattern.
+     *
+     * \param pattern  Glob pattern.
+     * \param is_limit \c true if rate limit, else enabled.
+     * \param value    Rate limit, or 1 if enabled.
+     */
+    void add_rule(const std::string& pattern, bool is_limit, uint32_t value) {
+        m_rules.erase(std::remove_if(m_rules.begin(), m_rules.end(),
+                          [&](const Rule& r) {
+                              return r.pattern == pattern &&
+                                     r.is_limit == is_limit;
+                          }),
+            m_rules.end());
+        m_rules.push_back({pattern, is_limit, value});
+    }
+
+    std::mutex        m_mutex; /**< Serializes changes of rules and sites. */
+    std::vector<Rule> m_rules; /**< Rules, used under the LogSites lock. */
+};
+
+/**
+ * \return Rules of all call sites.
+ */
+inline SiteRules& site_rules() {
+    static SiteRules rules;
+    return rules;
+}
+
+/**
+ * \brief Apply rules to site, which is used first.
+ *
+ * \param site Call site.
+ */
+inline void SiteRules::apply(LogSite& site) {
+    for (const Rule& r : site_rules().m_rules) {
+        if (site_matches(site, r.pattern)) {
+            if (r.is_limit) {
+                site.set_rate_limit(r.value);
+            } else {
+                site.set_enabled(r.value != 0);
+            }
+        }
+    }
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Enable or disable call sites of \ref l(), \ref l_arr() and
+ * \ref l_mat() by pattern.
+ *
+ * \param pattern Glob pattern matched against "file:line" and function name,
+ *                where '*' matches any characters and '?' matches one.
+ * \param e       \c true to enable.
+ *
+ * Used as:
+ * \code
+ * gl::set_sites_enabled("*", false);
+ * gl::set_sites_enabled("network.cpp:*", true);
+ * \endcode
+ * to only log from network.cpp.
+ *
+ * \note Also applies to matching call sites first used later. Later calls
+ * take precedence over earlier ones.
+ * \note Call sites are enabled by default.
+ *
+ * \sa set_rate_limit()
+ *
+ */
+inline void set_sites_enabled(const std::string& pattern, bool e) {
+    internal::site_rules().set_enabled(pattern, e);
+}
+
+/**
+ * \brief Limit the number of lines per second of call sites of \ref l(),
+ * \ref l_arr() and \ref l_mat() by pattern.
+ *
+ * \param pattern          Glob pattern, as for \ref set_sites_enabled().
+ * \param lines_per_second Maximum number of lines per second and call site,
+ *                         0 if unlimited.
+ *
+ * \note Lines over the limit are dropped.
+ * \note Call sites are unlimited by default.
+ *
+ * \sa set_sites_enabled()
+ *
+ */
+inline void set_rate_limit(
+    const std::string& pattern, uint32_t lines_per_second) {
+    internal::site_rules().set_rate_limit(pattern, lines_per_second);
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_SITES_H_
@@ -0,0 +1,282 @@
+/** \file
+ *
+ * \brief Call sites compiled to jumps, which are patched to no-ops while the
+ * call site is disabled.
+ *
+ * Included by goinglogging/core.h if \ref GL_STATIC_KEYS is defined and
+ * supported.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_STATIC_KEYS_H_
+#define INCLUDE_GOINGLOGGING_STATIC_KEYS_H_
+
+#include "core.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#ifdef GL_INTERNAL_STATIC_KEYS
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Jump of a call site, which is patched when the site is enabled or
+ * disabled. Placed in section gl_static_sites by the call site, and holds
+ * addresses relative to each member, so that it needs no relocation.
+ */
+struct StaticSite {
+    int64_t code;   /**< Jump or no-op instruction. */
+    int64_t target; /**< Code which checks the call site and logs. */
+    int64_t site;   /**< Call site. */
+
+    /**
+     * \return Address of instruction.
+     */
+    uintptr_t code_address() const noexcept {
+        return reinterpret_cast<uintptr_t>(&code) +
+               static_cast<uintptr_t>(code);
+    }
+
+    /**
+     * \return Address of jump target.
+     */
+    uintptr_t target_address() const noexcept {
+        return reinterpret_cast<uintptr_t>(&target) +
+               static_cast<uintptr_t>(target);
+    }
+
+    /**
+     * \return Call site.
+     */
+    LogSite* log_site() const noexcept {
+        return reinterpret_cast<LogSite*>(
+            reinterpret_cast<uintptr_t>(&site) + static_cast<uintptr_t>(site));
+    }
+};
+
+extern "C" {
+/** First jump of the executable, defined by the linker. */
+extern const StaticSite __start_gl_static_sites[]
+    __attribute__((weak, visibility("hidden")));
+/** End of jumps of the executable, defined by the linker. */
+extern const StaticSite __stop_gl_static_sites[]
+    __attribute__((weak, visibility("hidden")));
+}
+
+#if defined(__x86_64__)
+/**
+ * \brief Jump to label, recorded in section gl_static_sites. A 5 byte jmp,
+ * placed within an aligned 8 byte word, so that it is replaced by one
+ * atomic store.
+ */
+#define GL_INTERNAL_STATIC_JUMP(site, label)                             \
+    asm goto(".p2align 3,,4\n1:\n\t.byte 0xe9\n\t.long %l1 - 2f\n2:\n"    \
+             "\t.pushsection gl_static_sites,\"aw\"\n\t.balign 8\n"       \
+             "\t.quad 1b - ., %l1 - ., %c0 - .\n\t.popsection"            \
+             :                                                          \
+             : "i"(&(site))                                             \
+             :                                                          \
+             : label)
+#else
+/**
+ * \brief Jump to label, recorded in section gl_static_sites. A 4 byte b,
+ * which is replaced by one atomic store.
+ */
+#define GL_INTERNAL_STATIC_JUMP(site, label)                      \
+    asm goto("1:\n\tb %l1\n"                                       \
+             "\t.pushsection gl_static_sites,\"aw\"\n\t.balign 8\n" \
+             "\t.quad 1b - ., %l1 - ., %c0 - .\n\t.popsection"     \
+             :                                                   \
+             : "S"(&(site))                                      \
+             :                                                   \
+             : label)
+#endif // __x86_64__
+
+#if defined(__x86_64__)
+/**
+ * \brief State of patching of call sites.
+ */
+struct StaticPatchState {
+    /**
+     * \brief Constructor.
+     */
+    StaticPatchState() : patching(nullptr), previous() {}
+
+    /** First byte of instruction being patched, or none. */
+    std::atomic<unsigned char*> patching;
+    struct sigaction            previous; /**< Previous SIGTRAP action. */
+};
+
+/**
+ * \return State of patching of call sites.
+ */
+inline StaticPatchState& static_patch_state() noexcept {
+    static StaticPatchState state;
+    return state;
+}
+
+/**
+ * \brief Make all threads of the process serialize their instruction
+ * streams, so that they execute modified code from then on.
+ */
+inline void sync_cores() noexcept {
+    // MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE
+    syscall(__NR_membarrier, 1 << 5, 0);
+}
+
+/**
+ * \brief Handle SIGTRAP. A thread which ran into the int3 of a call site
+ * while it is patched waits, and then runs the patched instruction. Other
+ * traps are passed on to the previous handler.
+ *
+ * \param sig     Signal.
+ * \param info    Signal information.
+ * \param context User context.
+ */
+inline void static_trap_handler(int sig, siginfo_t* info, void* context) {
+    StaticPatchState& state = static_patch_state();
+    if (info->si_code == SI_KERNEL) {
+        greg_t&        rip = static_cast<ucontext_t*>(context)
+                          ->uc_mcontext.gregs[REG_RIP];
+        unsigned char* at  = reinterpret_cast<unsigned char*>(rip - 1);
+        while (at == state.patching.load(std::memory_order_acquire) &&
+               __atomic_load_n(at, __ATOMIC_ACQUIRE) == 0xcc) {
+            __builtin_ia32_pause();
+        }
+        // The int3 is replaced by a jmp or nopl
+        if (at[0] == 0xe9 || (at[0] == 0x0f && at[1] == 0x1f)) {
+            rip = reinterpret_cast<greg_t>(at);
+            return;
+        }
+    }
+    const struct sigaction& prev = state.previous;
+    if ((prev.sa_flags & SA_SIGINFO) != 0) {
+        prev.sa_sigaction(sig, info, context);
+    } else if (prev.sa_handler == SIG_DFL) {
+        sigaction(sig, &prev, nullptr);
+        raise(sig);
+    } else if (prev.sa_handler != SIG_IGN) {
+        prev.sa_handler(sig);
+    }
+}
+
+/**
+ * \brief Prepare patching once, by registering for sync_cores() and
+ * installing static_trap_handler().
+ *
+ * \return \c true if call sites may be patched.
+ */
+inline bool static_patch_ready() noexcept {
+    static const bool ready = []() {
+        // MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE
+        if (syscall(__NR_membarrier, 1 << 6, 0) != 0) {
+            return false;
+        }
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = static_trap_handler;
+        action.sa_flags     = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        return sigaction(
+                   SIGTRAP, &action, &static_patch_state().previous) == 0;
+    }();
+    return ready;
+}
+#endif // __x86_64__
+
+/**
+ * \brief Rewrite jump of call site to jump or no-op. Callers serialize, so
+ * that no page is made read-only while another thread writes to it.
+ *
+ * On x86-64, an instruction which other threads may be executing is only
+ * safely replaced in steps: an int3 replaces its first byte, then the other
+ * bytes are replaced, and then the first byte, with all threads serialized
+ * after each step. On AArch64, b and nop are replaced by one atomic store,
+ * and a thread executes either the old or the new instruction.
+ *
+ * \param s       Jump of call site.
+ * \param enabled \c true to jump.
+ * \return \c true if the instruction is as requested.
+ */
+inline bool patch_static_site(const StaticSite& s, bool enabled) noexcept {
+    const uintptr_t code   = s.code_address();
+    const uintptr_t target = s.target_address();
+#if defined(__x86_64__)
+    typedef uint64_t Word;
+    Word* word  = reinterpret_cast<Word*>(code & ~uintptr_t(7));
+    Word  value = __atomic_load_n(word, __ATOMIC_RELAXED);
+    unsigned char insn[sizeof(Word)];
+    std::memcpy(insn, &value, sizeof(insn));
+    unsigned char* p = insn + (code & 7);
+    if (enabled) {
+        int32_t rel = static_cast<int32_t>(target - (code + 5));
+        p[0]        = 0xe9;
+        std::memcpy(p + 1, &rel, sizeof(rel));
+    } else {
+        // Five byte no-op, nopl 0x0(%rax,%rax,1)
+        const unsigned char nop[5] = {0x0f, 0x1f, 0x44, 0x00, 0x00};
+        std::memcpy(p, nop, sizeof(nop));
+    }
+    Word patched = 0;
+    std::memcpy(&patched, insn, sizeof(patched));
+    if (patched == value) {
+        return true;
+    }
+    if (!static_patch_ready()) {
+        return false;
+    }
+#else
+    typedef uint32_t Word;
+    Word* word  = reinterpret_cast<Word*>(code);
+    Word  value = __atomic_load_n(word, __ATOMIC_RELAXED);
+    // b <target>, or nop
+    Word patched = enabled ? 0x14000000u | (static_cast<Word>(
+                                               (target - code) >> 2) &
+                                              0x03ffffffu) :
+                             0xd503201fu;
+    if (patched == value) {
+        return true;
+    }
+#endif // __x86_64__
+    static const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    void* start = reinterpret_cast<void*>(code & ~(page - 1));
+    if (mprotect(start, page, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+        return false;
+    }
+#if defined(__x86_64__)
+    StaticPatchState& state = static_patch_state();
+    unsigned char*    first = reinterpret_cast<unsigned char*>(code);
+    const unsigned char opcode = p[0];
+    state.patching.store(first, std::memory_order_release);
+    __atomic_store_n(first, static_cast<unsigned char>(0xcc), __ATOMIC_SEQ_CST);
+    sync_cores();
+    p[0] = 0xcc;
+    std::memcpy(&patched, insn, sizeof(patched));
+    __atomic_store_n(word, patched, __ATOMIC_SEQ_CST);
+    sync_cores();
+    __atomic_store_n(first, opcode, __ATOMIC_SEQ_CST);
+    sync_cores();
+    state.patching.store(nullptr, std::memory_order_release);
+#else
+    __atomic_store_n(word, patched, __ATOMIC_SEQ_CST);
+    __builtin___clear_cache(
+        reinterpret_cast<char*>(word), reinterpret_cast<char*>(word + 1));
+#endif // __x86_64__
+    return mprotect(start, page, PROT_READ | PROT_EXEC) == 0;
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+#endif // GL_INTERNAL_STATIC_KEYS
+
+#endif // INCLUDE_GOINGLOGGING_STATIC_KEYS_H_
@@ -0,0 +1,648 @@
+/** \file
+ *
+ * \brief JSON Lines and CBOR output formats, selected with gl::set_format().
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/structured.h"
+ *
+ * gl::set_format(gl::format::JSON);
+ * l(i);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_STRUCTURED_H_
+#define INCLUDE_GOINGLOGGING_STRUCTURED_H_
+
+#include "core.h"
+#include "sink.h"
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <streambuf>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Write CBOR data item head.
+ *
+ * \param os    Output stream.
+ * \param major Major type.
+ * \param v     Argument, e.g. value or length.
+ */
+inline void cbor_head(std::ostream& os, uint8_t major, uint64_t v) noexcept {
+    char   buf[9];
+    size_t n = 0;
+    if (v < 24) {
+        buf[n++] = static_cast<char>((major << 5) | v);
+    } else {
+        // Additional information 24, 25, 26 or 27 for 1, 2, 4 or 8 bytes
+        int     bytes = 1;
+        uint8_t info  = 24;
+        while (bytes < 8 && (v >> (8 * bytes)) != 0) {
+            bytes *= 2;
+            ++info;
+        }
+        buf[n++] = static_cast<char>((major << 5) | info);
+        for (int i = bytes - 1; i >= 0; --i) {
+            buf[n++] = static_cast<char>((v >> (8 * i)) & 0xff);
+        }
+    }
+    os.write(buf, static_cast<std::streamsize>(n));
+}
+
+/**
+ * \brief Get length of UTF-8 sequence.
+ *
+ * \param s Characters [\p n], starting with a byte of at least 0x80.
+ * \param n Number of characters.
+ * \return Length of the valid sequence at \p s. If invalid, the negated
+ *         length of its longest valid start, at least 1.
+ */
+inline int utf8_sequence(const unsigned char* s, size_t n) noexcept {
+    int           len = 0;
+    unsigned char lo  = 0x80; // Range of second byte
+    unsigned char hi  = 0xbf;
+    if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+        len = 2;
+    } else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+        // No overlong forms, nor surrogates
+        len = 3;
+        lo  = s[0] == 0xe0 ? 0xa0 : 0x80;
+        hi  = s[0] == 0xed ? 0x9f : 0xbf;
+    } else if (s[0] >= 0xf0 && s[0] <= 0xf4) {
+        // No overlong forms, nor code points above U+10FFFF
+        len = 4;
+        lo  = s[0] == 0xf0 ? 0x90 : 0x80;
+        hi  = s[0] == 0xf4 ? 0x8f : 0xbf;
+    } else {
+        return -1;
+    }
+    for (int k = 1; k < len; ++k) {
+        if (static_cast<size_t>(k) >= n || s[k] < lo || s[k] > hi) {
+            return -k;
+        }
+        lo = 0x80;
+        hi = 0xbf;
+    }
+    return len;
+}
+
+/**
+ * \brief Write characters which need no escape, with U+FFFD in place of each
+ * invalid UTF-8 sequence.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n].
+ * \param n  Number of characters.
+ */
+inline void write_utf8(std::ostream& os, const char* s, size_t n) noexcept {
+    const unsigned char* u   = reinterpret_cast<const unsigned char*>(s);
+    size_t               run = 0; // Start of characters not yet written
+    size_t               i   = 0;
+    while (i < n) {
+        if (u[i] < 0x80) {
+#ifdef GL_INTERNAL_SSE2
+            // Skip ASCII 16 characters at a time
+            while (i + 16 <= n &&
+                   _mm_movemask_epi8(_mm_loadu_si128(
+                       reinterpret_cast<const __m128i*>(s + i))) == 0) {
+                i += 16;
+            }
+            if (i == n || u[i] >= 0x80) {
+                continue;
+            }
+#endif // GL_INTERNAL_SSE2
+            ++i;
+            continue;
+        }
+        int len = utf8_sequence(u + i, n - i);
+        if (len > 0) {
+            i += static_cast<size_t>(len);
+            continue;
+        }
+        os.write(s + run, static_cast<std::streamsize>(i - run));
+        os.write("\xef\xbf\xbd", 3);
+        i += static_cast<size_t>(-len);
+        run = i;
+    }
+    os.write(s + run, static_cast<std::streamsize>(n - run));
+}
+
+/**
+ * \brief Write characters as the contents of a JSON string. Invalid UTF-8 is
+ * replaced by U+FFFD.
+ *
+ * \param os Output stream.
+ * \param s  Characters [\p n].
+ * \param n  Number of characters.
+ */
+inline void json_escape(std::ostream& os, const char* s, size_t n) noexcept {
+    static const char hex[] = "0123456789abcdef";
+    size_t            run   = 0; // Start of characters not needing escape
+    for (size_t i = find_escape(s, n); i < n;
+         i += 1 + find_escape(s + i + 1, n - i - 1)) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == 0x7f) {
+            continue;
+        }
+        write_utf8(os, s + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': os.write("\\\"", 2); break;
+            case '\\': os.write("\\\\", 2); break;
+            case '\n': os.write("\\n", 2); break;
+            case '\r': os.write("\\r", 2); break;
+            case '\t': os.write("\\t", 2); break;
+            case '\b': os.write("\\b", 2); break;
+            case '\f': os.write("\\f", 2); break;
+            default: {
+                char u[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                os.write(u, sizeof(u));
+            }
+        }
+    }
+    write_utf8(os, s + run, n - run);
+}
+
+/**
+ * \brief Stream buffer which writes its input as a string in the format of
+ * the message, directly into the output stream. Used for values without
+ * a structured representation.
+ *
+ * Writes a quoted and escaped string in JSON, and an indefinite length text
+ * string in CBOR.
+ */
+class StringStreambuf : public std::streambuf {
+  public:
+    /**
+     * \brief Constructor. Write start of string.
+     *
+     * \param os Output stream of message.
+     */
+    explicit StringStreambuf(std::ostream& os) noexcept :
+        m_os(os), m_buf() {
+        setp(m_buf, m_buf + sizeof(m_buf));
+        begin_string(m_os);
+    }
+
+    StringStreambuf(const StringStreambuf&) = delete;
+    StringStreambuf& operator=(const StringStreambuf&) = delete;
+
+    /**
+     * \brief Write buffered characters and end of string.
+     */
+    void finish() noexcept {
+        write_chunk(pptr() - pbase());
+        end_string(m_os);
+    }
+
+  protected:
+    /**
+     * \brief Write buffered characters, then buffer character.
+     *
+     * \param c Character.
+     * \return \p c.
+     */
+    int_type overflow(int_type c) override {
+        // Keep an incomplete UTF-8 sequence for the next CBOR chunk
+        std::ptrdiff_t n   = pptr() - pbase();
+        std::ptrdiff_t cut = n;
+        for (std::ptrdiff_t i = n - 1; i >= 0 && i >= n - 3; --i) {
+            unsigned char b = static_cast<unsigned char>(m_buf[i]);
+            if ((b & 0xc0) != 0x80) {
+                // Lead byte. Sequence length from leading ones.
+                std::ptrdiff_t len = b >= 0xf0 ? 4 : b >= 0xe0 ? 3 :
+                                                 b >= 0xc0 ? 2 : 1;
+                cut = i + len > n ? i : n;
+                break;
+            }
+        }
+        write_chunk(cut);
+        std::memmove(m_buf, m_buf + cut, static_cast<size_t>(n - cut));
+        setp(m_buf, m_buf + sizeof(m_buf));
+        pbump(static_cast<int>(n - cut));
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+  private:
+    /**
+     * \brief Write first buffered characters.
+     *
+     * \param n Number of characters.
+     */
+    void write_chunk(std::ptrdiff_t n) noexcept {
+        if (n > 0) {
+            string_chunk(m_os, m_buf, static_cast<size_t>(n));
+        }
+    }
+
+    std::ostream& m_os;      /**< Output stream of message. */
+    char          m_buf[128]; /**< Characters not yet written. */
+};
+
+/**
+ * \brief Write value as string of the encoder, using its operator<<.
+ *
+ * \param os    Output stream, not text.
+ * \param write Writer of value.
+ * \param value Value.
+ */
+inline void write_as_string(
+    std::ostream& os, TextWriter write, const void* value) noexcept {
+    StringStreambuf buf(os);
+    std::ostream    tmp(&buf);
+    tmp.flags(os.flags());
+    tmp.precision(os.precision());
+    write(tmp, value);
+    buf.finish();
+}
+
+/**
+ * \brief Encoder of JSON, one object per line.
+ */
+class JsonEncoder : public Encoder {
+  public:
+    /**
+     * \brief Write '['.
+     */
+    void begin_array(std::ostream& os) const noexcept override {
+        os << '[';
+    }
+
+    /**
+     * \brief Write ']'.
+     */
+    void end_array(std::ostream& os) const noexcept override {
+        os << ']';
+    }
+
+    /**
+     * \brief Write '{'.
+     */
+    void begin_map(std::ostream& os) const noexcept override {
+        os << '{';
+    }
+
+    /**
+     * \brief Write '}'.
+     */
+    void end_map(std::ostream& os) const noexcept override {
+        os << '}';
+    }
+
+    /**
+     * \brief Write ','.
+     */
+    void separator(std::ostream& os) const noexcept override {
+        os << ',';
+    }
+
+    /**
+     * \brief Write key as string, followed by ':'.
+     */
+    void key(
+        std::ostream& os, const char* key, size_t n) const noexcept override {
+        string(os, key, n, nullptr, 0);
+        os << ':';
+    }
+
+    /**
+     * \brief Write quoted and escaped string.
+     */
+    void string(std::ostream& os, const char* s, size_t n, const char* tail,
+        size_t tail_n) const noexcept override {
+        os << '"';
+        json_escape(os, s, n);
+        os.write(tail, static_cast<std::streamsize>(tail_n));
+        os << '"';
+    }
+
+    /**
+     * \brief Write '"'.
+     */
+    void begin_string(std::ostream& os) const noexcept override {
+        os << '"';
+    }
+
+    /**
+     * \brief Write escaped characters.
+     */
+    void string_chunk(
+        std::ostream& os, const char* s, size_t n) const noexcept override {
+        json_escape(os, s, n);
+    }
+
+    /**
+     * \brief Write '"'.
+     */
+    void end_string(std::ostream& os) const noexcept override {
+        os << '"';
+    }
+
+    /**
+     * \brief Write null.
+     */
+    void null(std::ostream& os) const noexcept override {
+        os << "null";
+    }
+
+    /**
+     * \brief Write true or false.
+     */
+    void boolean(std::ostream& os, bool b) const noexcept override {
+        os << (b ? "true" : "false");
+    }
+
+    /**
+     * \brief Write digits.
+     */
+    void unsigned_int(std::ostream& os, uint64_t v) const noexcept override {
+        char  buf[20];
+        char* p = buf + sizeof(buf);
+        do {
+            *--p = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        os.write(p, buf + sizeof(buf) - p);
+    }
+
+    /**
+     * \brief Write digits, with sign if negative.
+     */
+    void signed_int(std::ostream& os, int64_t v) const noexcept override {
+        if (v >= 0) {
+            unsigned_int(os, static_cast<uint64_t>(v));
+            return;
+        }
+        // Magnitude minus one, which does not overflow for the minimum value
+        uint64_t m = static_cast<uint64_t>(-(v + 1));
+        os << '-';
+        if (m == std::numeric_limits<uint64_t>::max()) {
+            os << "9223372036854775808";
+        } else {
+            unsigned_int(os, m + 1);
+        }
+    }
+
+    /**
+     * \brief Write number with the fewest digits which read back as the same
+     * value, up to max_digits10, or null if not finite.
+     */
+    void floating(
+        std::ostream& os, double v, bool single) const noexcept override {
+        if (!std::isfinite(v)) {
+            os << "null";
+            return;
+        }
+        char buf[32];
+        int  n = 0;
+        if (single) {
+            const float f = static_cast<float>(v);
+            n = std::snprintf(buf, sizeof(buf), "%.*g",
+                std::numeric_limits<float>::digits10, v);
+            if (std::strtof(buf, nullptr) != f) {
+                n = std::snprintf(buf, sizeof(buf), "%.*g",
+                    std::numeric_limits<float>::max_digits10, v);
+            }
+        } else {
+            n = std::snprintf(buf, sizeof(buf), "%.*g",
+                std::numeric_limits<double>::digits10, v);
+            if (std::strtod(buf, nullptr) != v) {
+                n = std::snprintf(buf, sizeof(buf), "%.*g",
+                    std::numeric_limits<double>::max_digits10, v);
+            }
+        }
+        os.write(buf, n);
+    }
+
+    /**
+     * \brief Write string.
+     */
+    void text(std::ostream& os, TextWriter write,
+        const void* value) const noexcept override {
+        write_as_string(os, write, value);
+    }
+
+    /**
+     * \brief Nothing, since the newline which follows ends the message.
+     */
+    void end_message(std::ostream&) const noexcept override {
+    }
+};
+
+/**
+ * \brief Encoder of CBOR, a sequence of maps. Containers and strings of
+ * unknown length are indefinite length items.
+ */
+class CborEncoder : public Encoder {
+  public:
+    /**
+     * \brief Write indefinite length array.
+     */
+    void begin_array(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0x9f));
+    }
+
+    /**
+     * \brief Write break.
+     */
+    void end_array(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0xff));
+    }
+
+    /**
+     * \brief Write indefinite length map.
+     */
+    void begin_map(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0xbf));
+    }
+
+    /**
+     * \brief Write break.
+     */
+    void end_map(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0xff));
+    }
+
+    /**
+     * \brief Write nothing.
+     */
+    void separator(std::ostream&) const noexcept override {
+    }
+
+    /**
+     * \brief Write key as text string.
+     */
+    void key(
+        std::ostream& os, const char* key, size_t n) const noexcept override {
+        string(os, key, n, nullptr, 0);
+    }
+
+    /**
+     * \brief Write text string.
+     */
+    void string(std::ostream& os, const char* s, size_t n, const char* tail,
+        size_t tail_n) const noexcept override {
+        cbor_head(os, 3, n + tail_n);
+        os.write(s, static_cast<std::streamsize>(n));
+        os.write(tail, static_cast<std::streamsize>(tail_n));
+    }
+
+    /**
+     * \brief Write indefinite length text string.
+     */
+    void begin_string(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0x7f));
+    }
+
+    /**
+     * \brief Write text string, unless empty.
+     */
+    void string_chunk(
+        std::ostream& os, const char* s, size_t n) const noexcept override {
+        if (n != 0) {
+            string(os, s, n, nullptr, 0);
+        }
+    }
+
+    /**
+     * \brief Write break.
+     */
+    void end_string(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0xff));
+    }
+
+    /**
+     * \brief Write null.
+     */
+    void null(std::ostream& os) const noexcept override {
+        os.put(static_cast<char>(0xf6));
+    }
+
+    /**
+     * \brief Write true or false.
+     */
+    void boolean(std::ostream& os, bool b) const noexcept override {
+        os.put(static_cast<char>(b ? 0xf5 : 0xf4));
+    }
+
+    /**
+     * \brief Write unsigned integer.
+     */
+    void unsigned_int(std::ostream& os, uint64_t v) const noexcept override {
+        cbor_head(os, 0, v);
+    }
+
+    /**
+     * \brief Write unsigned or negative integer.
+     */
+    void signed_int(std::ostream& os, int64_t v) const noexcept override {
+        if (v >= 0) {
+            cbor_head(os, 0, static_cast<uint64_t>(v));
+        } else {
+            // Magnitude minus one, which does not overflow for the minimum
+            // value
+            cbor_head(os, 1, static_cast<uint64_t>(-(v + 1)));
+        }
+    }
+
+    /**
+     * \brief Write single or double precision float.
+     */
+    void floating(
+        std::ostream& os, double v, bool single) const noexcept override {
+        char     buf[9];
+        uint64_t bits  = 0;
+        int      bytes = single ? 4 : 8;
+        if (single) {
+            float    f      = static_cast<float>(v);
+            uint32_t bits32 = 0;
+            std::memcpy(&bits32, &f, sizeof(f));
+            bits = bits32;
+        } else {
+            std::memcpy(&bits, &v, sizeof(v));
+        }
+        buf[0] = static_cast<char>(single ? 0xfa : 0xfb);
+        for (int i = 0; i < bytes; ++i) {
+            buf[1 + i] =
+                static_cast<char>((bits >> (8 * (bytes - 1 - i))) & 0xff);
+        }
+        os.write(buf, 1 + bytes);
+    }
+
+    /**
+     * \brief Write text string of chunks.
+     */
+    void text(std::ostream& os, TextWriter write,
+        const void* value) const noexcept override {
+        write_as_string(os, write, value);
+    }
+
+    /**
+     * \brief Pass message on whole to sinks which pass on lines, since no
+     * newline follows.
+     */
+    void end_message(std::ostream& os) const noexcept override {
+        LineStreambuf* buf = dynamic_cast<LineStreambuf*>(os.rdbuf());
+        if (buf != nullptr) {
+            buf->message_end();
+        }
+    }
+};
+
+/**
+ * \brief Register the JSON and CBOR encoders, before their format is first
+ * selected. The encoders are never destroyed, so that static destructors
+ * may still log.
+ */
+inline void register_encoders() {
+    static const Encoder* json = new JsonEncoder();
+    static const Encoder* cbor = new CborEncoder();
+    encoder_of(format::JSON).store(json, std::memory_order_release);
+    encoder_of(format::CBOR).store(cbor, std::memory_order_release);
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+/**
+ * \brief Set output format.
+ *
+ * Used as:
+ * \code
+ * gl::set_format(gl::format::JSON);
+ * \endcode
+ * to log one JSON object per line.
+ *
+ * \param f Format.
+ *
+ * \note Defaults to format::TEXT.
+ *
+ * \sa format \sa get_format()
+ *
+ */
+inline void set_format(format f) noexcept {
+    internal::register_encoders();
+    internal::curFormat.store(f, std::memory_order_release);
+}
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_STRUCTURED_H_
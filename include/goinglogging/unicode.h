@@ -0,0 +1,416 @@
+/** \file
+ *
+ * \brief Formatters of wide and Unicode strings, string streams and locales:
+ * std::wstring, std::u16string, std::u32string, std::stringbuf,
+ * std::ostringstream, std::stringstream, their wide versions and
+ * std::locale. Written as UTF-8.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/unicode.h"
+ *
+ * std::wstring s(L"s");
+ * l(s);
+ * \endcode
+ *
+ * UTF-16 and UTF-32 are transcoded to UTF-8 without allocation. wchar_t is
+ * UTF-16 if it has 16 bits, and UTF-32 otherwise. Unpaired surrogates and
+ * code units which are not code points are written as U+FFFD.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_UNICODE_H_
+#define INCLUDE_GOINGLOGGING_UNICODE_H_
+
+#include "core.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/** Number of bytes of UTF-8 transcoded before it is written. */
+constexpr size_t kUtf8Chunk = 256;
+
+/** Code point written for invalid code units. */
+constexpr uint32_t kReplacement = 0xFFFD;
+
+#ifdef GL_INTERNAL_SSE2
+/**
+ * \brief Copy ASCII from UTF-16, 8 code units at a time.
+ *
+ * \param s   Code units [\p n].
+ * \param n   Number of code units.
+ * \param out Characters [\p n]. Written to.
+ * \return Number of code units copied. Stops before a block which is not all
+ * ASCII.
+ */
+template<class C>
+size_t copy_ascii_simd(const C* s, size_t n, char* out,
+    std::integral_constant<size_t, 2> /* UTF-16 */) noexcept {
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    size_t        i    = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero)) !=
+            0xFFFF) {
+            break;
+        }
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, v));
+    }
+    return i;
+}
+
+/**
+ * \brief Copy ASCII from UTF-32, 8 code units at a time.
+ *
+ * \param s   Code units [\p n].
+ * \param n   Number of code units.
+ * \param out Characters [\p n]. Written to.
+ * \return Number of code units copied. Stops before a block which is not all
+ * ASCII.
+ */
+template<class C>
+size_t copy_ascii_simd(const C* s, size_t n, char* out,
+    std::integral_constant<size_t, 4> /* UTF-32 */) noexcept {
+    const __m128i high = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+    const __m128i zero = _mm_setzero_si128();
+    size_t        i    = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 4));
+        __m128i ascii = _mm_and_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(a, high), zero),
+            _mm_cmpeq_epi32(_mm_and_si128(b, high), zero));
+        if (_mm_movemask_epi8(ascii) != 0xFFFF) {
+            break;
+        }
+        __m128i v = _mm_packs_epi32(a, b);
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, v));
+    }
+    return i;
+}
+#endif // GL_INTERNAL_SSE2
+
+/**
+ * \brief Copy the ASCII code units at the start of UTF-16 or UTF-32.
+ *
+ * \param s   Code units [\p n].
+ * \param n   Number of code units.
+ * \param out Characters [\p n]. Written to.
+ * \return Number of code units copied.
+ */
+template<class C>
+size_t copy_ascii(const C* s, size_t n, char* out) noexcept {
+    size_t i = 0;
+#ifdef GL_INTERNAL_SSE2
+    i = copy_ascii_simd(s, n, out, std::integral_constant<size_t, sizeof(C)>());
+#endif // GL_INTERNAL_SSE2
+    for (; i < n && static_cast<uint32_t>(s[i]) < 0x80; ++i) {
+        out[i] = static_cast<char>(s[i]);
+    }
+    return i;
+}
+
+/**
+ * \brief Decode code point from UTF-16 or UTF-32.
+ *
+ * \param s   First code unit. Advanced past the code point.
+ * \param end End of code units.
+ * \return Code point, or kReplacement if invalid.
+ */
+template<class C>
+uint32_t decode_code_point(const C*& s, const C* end) noexcept {
+    uint32_t c = static_cast<uint32_t>(*s++);
+    if (sizeof(C) == 2) {
+        c &= 0xFFFF;
+        if (c >= 0xD800 && c < 0xDC00 && s != end) {
+            // Surrogate pair
+            uint32_t low = static_cast<uint32_t>(*s) & 0xFFFF;
+            if (low >= 0xDC00 && low < 0xE000) {
+                ++s;
+                return 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            }
+        }
+    }
+    return c > 0x10FFFF || (c >= 0xD800 && c < 0xE000) ? kReplacement : c;
+}
+
+/**
+ * \brief Encode code point as UTF-8.
+ *
+ * \param c   Code point.
+ * \param out Characters [4]. Written to.
+ * \return Number of characters written.
+ */
+inline size_t encode_utf8(uint32_t c, char* out) noexcept {
+    if (c < 0x80) {
+        out[0] = static_cast<char>(c);
+        return 1;
+    }
+    if (c < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (c >> 6));
+        out[1] = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+    }
+    if (c < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (c >> 12));
+        out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (c & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (c >> 18));
+    out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/**
+ * \brief Transcode UTF-16 or UTF-32 to UTF-8, until the end or until the
+ * output is full. Only whole code points are written.
+ *
+ * \param s   First code unit. Advanced past the transcoded code units.
+ * \param end End of code units.
+ * \param out Characters [\p n]. Written to.
+ * \param n   Size of \p out. At least 4.
+ * \return Number of characters written.
+ */
+template<class C>
+size_t to_utf8(const C*& s, const C* end, char* out, size_t n) noexcept {
+    size_t written = 0;
+    while (s != end) {
+        size_t ascii = copy_ascii(s,
+            std::min(static_cast<size_t>(end - s), n - written),
+            out + written);
+        s += ascii;
+        written += ascii;
+        if (s == end || n - written < 4) {
+            break;
+        }
+        written += encode_utf8(decode_code_point(s, end), out + written);
+    }
+    return written;
+}
+
+/**
+ * \brief Write UTF-16 or UTF-32 string as UTF-8. Quoted in text, escaped and
+ * truncated as encode_value_string().
+ *
+ * Transcodes in chunks on the stack. Strings longer than a chunk are
+ * indefinite length text strings in CBOR.
+ *
+ * \param os Output stream.
+ * \param s  Code units [\p n].
+ * \param n  Number of code units.
+ * \return Output stream.
+ */
+template<class C>
+std::ostream& encode_unicode(std::ostream& os, const C* s, size_t n) noexcept {
+    const C* end = s + n;
+    char     buf[kUtf8Chunk];
+    size_t   m = to_utf8(s, end, buf, sizeof(buf));
+    if (s == end) {
+        return encode_value_string(os, buf, m);
+    }
+    const size_t max   = maxStringLength.load(std::memory_order_relaxed);
+    size_t       total = 0; // Bytes transcoded
+    size_t       kept  = 0; // Bytes written, if truncated
+    bool         cut   = false;
+    begin_string(os);
+    for (;;) {
+        if (!cut && max != 0 && total + m > max) {
+            // Cut before the code point which does not fit
+            size_t w = max - total;
+            while (w > 0 && is_utf8_continuation(buf[w])) {
+                --w;
+            }
+            string_chunk(os, buf, w);
+            kept = total + w;
+            cut  = true;
+        } else if (!cut) {
+            string_chunk(os, buf, m);
+        }
+        total += m;
+        if (s == end) {
+            break;
+        }
+        m = to_utf8(s, end, buf, sizeof(buf));
+    }
+    if (cut) {
+        int marker = std::snprintf(buf, sizeof(buf), "...(+%llu bytes)",
+            static_cast<unsigned long long>(total - kept));
+        string_chunk(os, buf, marker < 0 ? 0 : static_cast<size_t>(marker));
+    }
+    end_string(os);
+    return os;
+}
+
+/**
+ * \brief Format std::stringbuf.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::stringbuf>& f) noexcept {
+    const std::string str = f.m_val.str();
+    return encode_value_string(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::ostringstream.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::ostringstream>& f) noexcept {
+    const std::string str = f.m_val.str();
+    return encode_value_string(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::stringstream.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::stringstream>& f) noexcept {
+    const std::string str = f.m_val.str();
+    return encode_value_string(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::locale.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::locale>& f) noexcept {
+    const std::string str = f.m_val.name();
+    return encode_string(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::wstringbuf.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::wstringbuf>& f) noexcept {
+    const std::wstring str = f.m_val.str();
+    return encode_unicode(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::wostringstream.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::wostringstream>& f) noexcept {
+    const std::wstring str = f.m_val.str();
+    return encode_unicode(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::wstringstream.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::wstringstream>& f) noexcept {
+    const std::wstring str = f.m_val.str();
+    return encode_unicode(os, str.data(), str.size());
+}
+
+/**
+ * \brief Format std::u16string.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::u16string>& f) noexcept {
+    return encode_unicode(os, f.m_val.data(), f.m_val.size());
+}
+
+/**
+ * \brief Format std::u32string.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::u32string>& f) noexcept {
+    return encode_unicode(os, f.m_val.data(), f.m_val.size());
+}
+
+/**
+ * \brief Format std::wstring.
+ *
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<>
+inline std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::wstring>& f) noexcept {
+    return encode_unicode(os, f.m_val.data(), f.m_val.size());
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_UNICODE_H_
@@ -0,0 +1,210 @@
+/** \file
+ *
+ * \brief USDT probes of call sites, for tracers such as bpftrace, perf and
+ * SystemTap.
+ *
+ * Included by goinglogging/core.h if \ref GL_USDT is defined and supported.
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_USDT_H_
+#define INCLUDE_GOINGLOGGING_USDT_H_
+
+#include "core.h"
+#include "sink.h"
+#include <iostream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#ifdef GL_INTERNAL_USDT
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Stream buffer which writes to another stream buffer, if any, and
+ * keeps a copy of what is written.
+ */
+class CopyStreambuf : public std::streambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CopyStreambuf() : m_target(nullptr), m_copy() {}
+
+    CopyStreambuf(const CopyStreambuf&) = delete;
+    CopyStreambuf& operator=(const CopyStreambuf&) = delete;
+
+    /**
+     * \brief Clear copy, and set stream buffer to write to.
+     *
+     * \param target Stream buffer, or none.
+     */
+    void reset(std::streambuf* target) noexcept {
+        m_target = target;
+        m_copy.clear();
+    }
+
+    /**
+     * \return Stream buffer written to, or none.
+     */
+    std::streambuf* target() const noexcept {
+        return m_target;
+    }
+
+    /**
+     * \return Copy of what is written since reset().
+     */
+    std::string& copy() noexcept {
+        return m_copy;
+    }
+
+  protected:
+    /**
+     * \brief Write character.
+     *
+     * \param c Character.
+     * \return Not end of file, unless the target fails.
+     */
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        m_copy.push_back(traits_type::to_char_type(c));
+        return m_target != nullptr ?
+                   m_target->sputc(traits_type::to_char_type(c)) :
+                   c;
+    }
+
+    /**
+     * \brief Write characters.
+     *
+     * \param s Characters.
+     * \param n Number of characters.
+     * \return Number of characters written.
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        m_copy.append(s, static_cast<size_t>(n));
+        return m_target != nullptr ? m_target->sputn(s, n) : n;
+    }
+
+    /**
+     * \brief Flush target.
+     *
+     * \return 0 if success.
+     */
+    int sync() override {
+        return m_target != nullptr ? m_target->pubsync() : 0;
+    }
+
+  private:
+    std::streambuf* m_target; /**< Stream buffer written to, or none. */
+    std::string     m_copy;   /**< Copy. */
+};
+
+
+extern "C" {
+/**
+ * \brief Semaphore of the goinglogging:log probes, which attached tracers
+ * increment. Weak, so that each file may define it, and in section .probes,
+ * where SystemTap expects it.
+ */
+__attribute__((weak, visibility("hidden"), section(".probes")))
+volatile unsigned short goinglogging_log_semaphore = 0;
+}
+
+/**
+ * \brief Format message of a call site once, for a USDT probe and, if
+ * enabled, for output.
+ *
+ * \param write   Writer of message.
+ * \param message Message.
+ * \param output  \c true to also write message to output.
+ * \return Message, without newline.
+ */
+GL_INTERNAL_COLD inline std::string usdt_message(
+    MessageWriter write, const void* message, bool output) noexcept {
+    static thread_local CopyStreambuf buf;
+    static thread_local std::ostream  os(&buf);
+    os.copyfmt(std::cout);
+    buf.reset(output ? std::cout.rdbuf() : nullptr);
+    write(os, message);
+    if (!output) {
+        // Not written to a stream buffer which attributes lines to call sites
+        message_site().file_path = nullptr;
+    } else {
+        // Sinks which pass on lines receive each CBOR message whole
+        LineStreambuf* line = dynamic_cast<LineStreambuf*>(buf.target());
+        if (line != nullptr) {
+            line->message_end();
+        }
+    }
+    std::string s;
+    s.swap(buf.copy());
+    if (!s.empty() && s.back() == '\n') {
+        s.pop_back();
+    }
+    return s;
+}
+
+/**
+ * \brief Probe goinglogging:log, described in section .note.stapsdt as
+ * sys/sdt.h does, with 5 arguments of 8 bytes each. The probe is a no-op
+ * until a tracer replaces it with a breakpoint.
+ */
+#define GL_INTERNAL_USDT_PROBE(a0, a1, a2, a3, a4)                       \
+    __asm__ __volatile__(                                               \
+        "990:\tnop\n"                                                    \
+        "\t.pushsection .note.stapsdt,\"?\",\"note\"\n"                  \
+        "\t.balign 4\n"                                                  \
+        "\t.4byte 992f-991f, 994f-993f, 3\n"                              \
+        "991:\t.asciz \"stapsdt\"\n"                                     \
+        "992:\t.balign 4\n"                                               \
+        "993:\t.8byte 990b\n"                                             \
+        "\t.8byte _.stapsdt.base\n"                                       \
+        "\t.8byte goinglogging_log_semaphore\n"                           \
+        "\t.asciz \"goinglogging\"\n"                                     \
+        "\t.asciz \"log\"\n"                                              \
+        "\t.asciz \"8@%0 -8@%1 8@%2 8@%3 8@%4\"\n"                        \
+        "994:\t.balign 4\n"                                               \
+        "\t.popsection\n"                                                 \
+        "\t.ifndef _.stapsdt.base\n"                                      \
+        "\t.pushsection .stapsdt.base,\"aG\",\"progbits\","               \
+        ".stapsdt.base,comdat\n"                                         \
+        "\t.weak _.stapsdt.base\n"                                        \
+        "\t.hidden _.stapsdt.base\n"                                      \
+        "_.stapsdt.base:\t.space 1\n"                                     \
+        "\t.size _.stapsdt.base, 1\n"                                     \
+        "\t.popsection\n"                                                 \
+        "\t.endif"                                                       \
+        :                                                               \
+        : "nor"(a0), "nor"(a1), "nor"(a2), "nor"(a3), "nor"(a4))
+
+/**
+ * \brief Check if a tracer is attached to the probes.
+ */
+#define GL_INTERNAL_USDT_ATTACHED() \
+    __builtin_expect(::gl::internal::goinglogging_log_semaphore != 0, 0)
+
+/**
+ * \brief Fire probe of call site, and write the message to output if
+ * \p output. The message is formatted once for both.
+ */
+#define GL_INTERNAL_USDT_SITE(message, output)                             \
+    do {                                                                   \
+        const std::string gl_internal_text = ::gl::internal::usdt_message( \
+            ::gl::internal::message_writer(message), &(message), (output)); \
+        GL_INTERNAL_USDT_PROBE(static_cast<const char*>(__FILE__),         \
+            static_cast<long>(__LINE__), static_cast<const char*>(__func__), \
+            gl_internal_text.data(), gl_internal_text.size());             \
+    } while (false)
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+#endif // GL_INTERNAL_USDT
+
+#endif // INCLUDE_GOINGLOGGING_USDT_H_
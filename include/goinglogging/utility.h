@@ -0,0 +1,119 @@
+/** \file
+ *
+ * \brief Formatters of std::pair, std::tuple and smart pointers.
+ *
+ * Included by goinglogging.h. Files which only include goinglogging/core.h
+ * opt in with:
+ * \code
+ * #include "goinglogging/core.h"
+ * #include "goinglogging/utility.h"
+ *
+ * std::pair<int, char> p(1, 'a');
+ * l(p);
+ * \endcode
+ *
+ */
+
+#ifndef INCLUDE_GOINGLOGGING_UTILITY_H_
+#define INCLUDE_GOINGLOGGING_UTILITY_H_
+
+#include "core.h"
+#include <memory>
+#include <ostream>
+#include <tuple>
+#include <utility>
+
+namespace gl {
+
+#ifndef DOXYGEN_HIDDEN
+namespace internal {
+
+/**
+ * \brief Format std::pair.
+ *
+ * \tparam U First type of pair.
+ * \tparam V Second type of pair.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::pair<U, V>>& f) noexcept {
+    begin_array(os) << format_value(f.get_value().first) << separator
+                    << format_value(f.get_value().second);
+    return end_array(os);
+}
+
+/**
+ * \brief Format std::tuple.
+ *
+ * \tparam U First type of tuple.
+ * \tparam V Second type of tuple.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U, class V>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::tuple<U, V>>& f) noexcept {
+    begin_array(os) << format_value(std::get<0>(f.get_value())) << separator
+                    << format_value(std::get<1>(f.get_value()));
+    return end_array(os);
+}
+
+/**
+ * \brief Format std::unique_ptr.
+ *
+ * \tparam U Pointer type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::unique_ptr<U>>& f) noexcept {
+    return encode_pointer(os, f.get_value().get());
+}
+
+/**
+ * \brief Format std::shared_ptr.
+ *
+ * \tparam U Pointer type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::shared_ptr<U>>& f) noexcept {
+    return encode_pointer(os, f.get_value().get());
+}
+
+/**
+ * \brief Format std::weak_ptr.
+ *
+ * \tparam U Pointer type.
+ * \param os Output stream.
+ * \param f  ValueFormatter.
+ * \return Output stream.
+ *
+ */
+template<class U>
+std::ostream& operator<<(
+    std::ostream& os, const ValueFormatter<std::weak_ptr<U>>& f) noexcept {
+    // Convert to temporary shared_ptr in order to get value.
+    std::shared_ptr<U> tmp = f.get_value().lock();
+    return encode_pointer(os, tmp.get());
+}
+
+} // namespace internal
+#endif // DOXYGEN_HIDDEN
+
+} // namespace gl
+
+#endif // INCLUDE_GOINGLOGGING_UTILITY_H_
@@ -0,0 +1,17 @@
+/** \file
+ *
+ * \brief Precompiled library. Instantiates the formatting of common types
+ * once, for all files which define GL_PRECOMPILED.
+ *
+ */
+
+#include "goinglogging.h"
+
+namespace gl {
+namespace internal {
+
+GL_INTERNAL_INSTANTIATE_CORE()
+GL_INTERNAL_INSTANTIATE_SEQUENCE()
+
+} // namespace internal
+} // namespace gl
@@ -0,0 +1,707 @@
+#include "goinglogging.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "goinglogging/lz4_sink.h"
+
+#ifdef __unix__
+#include "goinglogging/backtrace.h"
+#include "goinglogging/batch_sink.h"
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \file
+ * Microbenchmarks of the logging hot paths.
+ *
+ * Reports time and heap allocations per call for each benchmark, writes the
+ * results as CSV or JSON, and compares them to a saved baseline.
+ */
+
+/** Number of heap allocations since program start. */
+static std::atomic<uint64_t> allocations(0);
+
+/**
+ * \brief Free memory allocated by the operator new below.
+ *
+ * The pointer passes through a volatile variable, so that GCC does not match
+ * inlined new-expressions against std::free() and warn about a mismatch.
+ *
+ * \param p Memory.
+ */
+static void release(void* p) {
+    void* volatile q = p;
+    std::free(q);
+}
+
+/**
+ * \brief Allocate memory and count the allocation.
+ *
+ * \param size Number of bytes.
+ * \return Allocated memory.
+ */
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+/**
+ * \brief Free memory.
+ *
+ * \param p Memory allocated with operator new.
+ */
+void operator delete(void* p) noexcept {
+    release(p);
+}
+
+/**
+ * \brief Free memory.
+ *
+ * \param p Memory allocated with operator new.
+ */
+void operator delete(void* p, std::size_t) noexcept {
+    release(p);
+}
+
+namespace gl {
+namespace bench {
+
+/**
+ * \brief Stream buffer which discards all output.
+ */
+class NullStreambuf : public std::streambuf {
+  protected:
+    /**
+     * \brief Discard character.
+     *
+     * \param c Character.
+     * \return \p c.
+     */
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+
+    /**
+     * \brief Discard characters.
+     *
+     * \param n Number of characters.
+     * \return \p n.
+     */
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
+
+#ifdef __unix__
+/**
+ * \brief Stream buffer which writes each line with its own system call.
+ */
+class WriteStreambuf : public gl::internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param fd File descriptor.
+     */
+    explicit WriteStreambuf(int fd) : m_fd(fd), m_messages(0), m_calls(0) {
+    }
+
+    /**
+     * \return Number of messages written.
+     */
+    uint64_t messages() const noexcept {
+        return m_messages;
+    }
+
+    /**
+     * \return Number of system calls which wrote.
+     */
+    uint64_t system_calls() const noexcept {
+        return m_calls;
+    }
+
+  protected:
+    /**
+     * \brief Write line.
+     *
+     * \param s Line [\p n].
+     * \param n Number of characters.
+     */
+    void write_line(const char* s, size_t n) override {
+        char  nl     = '\n';
+        iovec iov[2] = {{const_cast<char*>(s), n}, {&nl, 1}};
+        ++m_messages;
+        ++m_calls;
+        if (::writev(m_fd, iov, 2) < 0) {
+            std::perror("writev");
+        }
+    }
+
+  private:
+    int      m_fd;       /**< File descriptor. */
+    uint64_t m_messages; /**< Number of messages written. */
+    uint64_t m_calls;    /**< Number of system calls which wrote. */
+};
+#endif
+
+/**
+ * \brief Result of one benchmark.
+ */
+struct Result {
+    std::string name;          /**< Name of benchmark. */
+    uint64_t    iterations;    /**< Number of calls measured. */
+    double      ns_per_call;   /**< Nanoseconds per call. */
+    double      calls_per_sec; /**< Calls per second. */
+    double      allocs_per_call; /**< Heap allocations per call. */
+};
+
+/**
+ * \brief Benchmark.
+ */
+struct Benchmark {
+    /**
+     * \brief Constructor.
+     *
+     * \param n Name of benchmark.
+     * \param c One call of the measured code.
+     * \param s Called before the measurement, if set.
+     * \param t Called after the measurement, if set.
+     */
+    Benchmark(std::string n, std::function<void()> c,
+        std::function<void()> s = nullptr, std::function<void()> t = nullptr) :
+        name(std::move(n)),
+        call(std::move(c)), setup(std::move(s)), teardown(std::move(t)) {
+    }
+
+    std::string           name;     /**< Name of benchmark. */
+    std::function<void()> call;     /**< One call of the measured code. */
+    std::function<void()> setup;    /**< Called before, if set. */
+    std::function<void()> teardown; /**< Called after, if set. */
+};
+
+/**
+ * \brief Measure benchmark.
+ *
+ * Doubles the number of iterations until the measurement takes at least
+ * \p min_time.
+ *
+ * \param b        Benchmark.
+ * \param min_time Minimum measurement time.
+ * \return Result.
+ */
+Result run(const Benchmark& b, std::chrono::nanoseconds min_time) {
+    if (b.setup) {
+        b.setup();
+    }
+
+    // Warm up caches and lazily initialized state
+    for (int i = 0; i < 16; ++i) {
+        b.call();
+    }
+
+    uint64_t                 n = 1;
+    std::chrono::nanoseconds elapsed(0);
+    uint64_t                 allocs = 0;
+    while (true) {
+        uint64_t a0 = allocations.load(std::memory_order_relaxed);
+        auto     t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; ++i) {
+            b.call();
+        }
+        elapsed = std::chrono::steady_clock::now() - t0;
+        allocs  = allocations.load(std::memory_order_relaxed) - a0;
+        if (elapsed >= min_time || n >= (uint64_t(1) << 40)) {
+            break;
+        }
+        n *= 2;
+    }
+    if (b.teardown) {
+        b.teardown();
+    }
+
+    double ns = static_cast<double>(elapsed.count()) / static_cast<double>(n);
+    return {b.name, n, ns, ns > 0.0 ? 1e9 / ns : 0.0,
+        static_cast<double>(allocs) / static_cast<double>(n)};
+}
+
+/** File written by the file destination benchmark. */
+static const char* const outputFile = "bench_output.txt";
+
+/** Stream buffer of all benchmarks, unless they measure destinations. */
+static NullStreambuf nullBuf;
+
+/**
+ * \brief Add benchmarks of l() with 1, 4 and 16 arguments of one type.
+ *
+ * \tparam T Argument type.
+ * \param bs     Benchmarks to add to.
+ * \param family Name of type family.
+ * \param v      Argument value.
+ */
+template<class T>
+void add_arguments(
+    std::vector<Benchmark>& bs, const std::string& family, T v) {
+    bs.push_back({"l/" + family + "/1", [v]() mutable { l(v); }});
+    bs.push_back({"l/" + family + "/4", [v]() mutable { l(v, v, v, v); }});
+    bs.push_back({"l/" + family + "/16", [v]() mutable {
+                      l(v, v, v, v, v, v, v, v, v, v, v, v, v, v, v, v);
+                  }});
+}
+
+/**
+ * \brief Get name of prefix combination.
+ *
+ * \param p Prefixes.
+ * \return Names separated by '|'.
+ */
+std::string prefix_name(gl::prefix p) {
+    static const std::pair<gl::prefix, const char*> names[] = {
+        {gl::prefix::FILE, "FILE"}, {gl::prefix::LINE, "LINE"},
+        {gl::prefix::FUNCTION, "FUNCTION"}, {gl::prefix::TIME, "TIME"},
+        {gl::prefix::THREAD, "THREAD"}, {gl::prefix::TYPE_NAME, "TYPE_NAME"}};
+    std::string s;
+    for (const auto& n : names) {
+        if ((p & n.first) != gl::prefix::NONE) {
+            s += (s.empty() ? "" : "|") + std::string(n.second);
+        }
+    }
+    return s.empty() ? "NONE" : s;
+}
+
+/**
+ * \brief Benchmark that redirects std::cout while it runs.
+ *
+ * \param name Name of benchmark.
+ * \param buf  Stream buffer to redirect to.
+ * \return Benchmark.
+ */
+Benchmark destination(const std::string& name, std::streambuf* buf) {
+    return {name, [buf]() {
+                std::streambuf* prev = std::cout.rdbuf(buf);
+                int             i    = 1;
+                l(i);
+                std::cout.rdbuf(prev);
+            }};
+}
+
+#ifdef __unix__
+/**
+ * \return Stream buffer which writes each line to /dev/null with its own
+ *         system call.
+ */
+WriteStreambuf& writeBuf() {
+    static WriteStreambuf buf(open("/dev/null", O_WRONLY));
+    return buf;
+}
+
+/**
+ * \brief Get stream buffer which writes lines to /dev/null in batches.
+ *
+ * \param io_uring \c true to write with io_uring if available.
+ * \return Stream buffer.
+ */
+gl::BatchStreambuf& batchBuf(bool io_uring) {
+    static gl::BatchStreambuf bufs[2];
+    gl::BatchStreambuf&       buf = bufs[io_uring ? 1 : 0];
+    if (!buf.is_open() && buf.messages() == 0) {
+        buf.open(open("/dev/null", O_WRONLY), 256,
+            std::chrono::milliseconds(5), io_uring);
+    }
+    return buf;
+}
+#endif
+
+/**
+ * \return Stream buffer which compresses lines to LZ4 and discards them.
+ */
+gl::Lz4Streambuf& lz4Buf() {
+    static std::ostream     os(&nullBuf);
+    static gl::Lz4Streambuf buf;
+    if (!buf.is_open() && buf.input_bytes() == 0) {
+        buf.open(os);
+    }
+    return buf;
+}
+
+/**
+ * \return All benchmarks.
+ */
+std::vector<Benchmark> all_benchmarks() {
+    std::vector<Benchmark> bs;
+
+    // Argument type families
+    add_arguments(bs, "int", 123456);
+    add_arguments(bs, "double", 3.14159);
+    add_arguments(bs, "bool", true);
+    add_arguments(bs, "char", 'c');
+    add_arguments(bs, "const_char_ptr", "const char*");
+    add_arguments(bs, "string", std::string("std::string"));
+    add_arguments(bs, "wstring", std::wstring(L"std::wstring"));
+    add_arguments(bs, "u16string", std::u16string(u"std::u16string"));
+    add_arguments(bs, "vector", std::vector<int>{0, 1, 2, 3});
+    add_arguments(bs, "map", std::map<int, int>{{0, 1}, {2, 3}});
+
+    // Escaping of a 1 kB string without characters to escape
+    static const std::string text(1024, 't');
+    for (bool e : {false, true}) {
+        bs.push_back({std::string("escape/") + (e ? "on" : "off"),
+            []() { l(text); }, [e]() { gl::set_escape_enabled(e); },
+            []() { gl::set_escape_enabled(false); }});
+    }
+
+    // Prefix combinations
+    const uint32_t all = static_cast<uint32_t>(gl::prefix::TYPE_NAME) * 2;
+    for (uint32_t u = 0; u < all; ++u) {
+        gl::prefix p = static_cast<gl::prefix>(u);
+        // Prefixes are set outside of the measurement, as in programs
+        static gl::prefix prev = gl::prefix::NONE;
+        bs.push_back({"prefix/" + prefix_name(p),
+            []() {
+                int i = 1;
+                l(i);
+            },
+            [p]() {
+                prev = gl::get_prefixes();
+                gl::set_prefixes(p);
+            },
+            []() { gl::set_prefixes(prev); }});
+    }
+
+    // Arrays and matrices
+    static int arr[4096] = {0};
+    for (size_t n : {1, 16, 256, 4096}) {
+        bs.push_back({"l_arr/" + std::to_string(n), [n]() { l_arr(arr, n); }});
+    }
+    static int mat[64][64] = {{0}};
+    for (size_t n : {1, 4, 16, 64}) {
+        bs.push_back(
+            {"l_mat/" + std::to_string(n) + "x" + std::to_string(n),
+                [n]() { l_mat(mat, n, n); }});
+    }
+
+    // Disabled output
+    auto disable = []() { gl::set_output_enabled(false); };
+    auto enable  = []() { gl::set_output_enabled(true); };
+    bs.push_back({"disabled/l",
+        []() {
+            int i = 1;
+            l(i);
+        },
+        disable, enable});
+    bs.push_back({"disabled/l_arr", []() { l_arr(arr, 16); }, disable, enable});
+
+    // Statistics
+    bs.push_back({"l_hist", []() {
+                      static double d = 0.0;
+                      d += 1.0;
+                      l_hist(d);
+                  }});
+    bs.push_back({"l_count", []() { l_count(event); }});
+    bs.push_back({"l_time_scope", []() { l_time_scope(scope); }});
+#ifdef __unix__
+    // Capture of return addresses alone, and with cached names
+    bs.push_back({"l_backtrace/capture", []() {
+                      const gl::internal::Backtrace bt;
+                      static_cast<void>(bt);
+                  }});
+    bs.push_back({"l_backtrace", []() {
+                      int i = 1;
+                      l_backtrace(i);
+                  }});
+#endif
+
+    // Output destinations
+    static std::ostringstream oss;
+    static std::ofstream      devNull("/dev/null");
+    static std::ofstream      file(outputFile);
+    bs.push_back(destination("destination/null", &nullBuf));
+    bs.push_back({"destination/ostringstream", []() {
+                      // Keep memory bounded without resetting on every call
+                      if (oss.tellp() > (1 << 20)) {
+                          oss.str("");
+                      }
+                      std::streambuf* prev = std::cout.rdbuf(oss.rdbuf());
+                      int             i    = 1;
+                      l(i);
+                      std::cout.rdbuf(prev);
+                  }});
+    bs.push_back(destination("destination/dev_null", devNull.rdbuf()));
+    bs.push_back(destination("destination/file", file.rdbuf()));
+    bs.push_back({"destination/lz4/vector", []() {
+                      static std::vector<int> v(64, 0);
+                      static size_t           k = 0;
+                      v[k++ % v.size()] += 1;
+                      std::streambuf* prev = std::cout.rdbuf(&lz4Buf());
+                      l(v);
+                      std::cout.rdbuf(prev);
+                  }});
+#ifdef __unix__
+    bs.push_back(destination("destination/write", &writeBuf()));
+    bs.push_back(destination("destination/batch_writev", &batchBuf(false)));
+    bs.push_back(destination("destination/batch_io_uring", &batchBuf(true)));
+#endif
+
+    return bs;
+}
+
+/**
+ * \brief Print compression ratio and throughput of the LZ4 destination.
+ */
+void print_compression() {
+    gl::Lz4Streambuf& buf = lz4Buf();
+    // Compress remaining lines
+    buf.close();
+    if (buf.input_bytes() == 0) {
+        return;
+    }
+    std::printf("%-48s %12.2f compression ratio %10.1f MB/s\n",
+        "destination/lz4/vector", buf.compression_ratio(),
+        buf.throughput() / 1e6);
+}
+
+#ifdef __unix__
+/**
+ * \brief Print system calls per 1000 messages of the destinations which
+ * write to file descriptors.
+ */
+void print_system_calls() {
+    if (writeBuf().messages() != 0) {
+        std::printf("%-48s %12.1f syscalls/1000 messages\n",
+            "destination/write",
+            1000.0 * static_cast<double>(writeBuf().system_calls()) /
+                static_cast<double>(writeBuf().messages()));
+    }
+    for (bool io_uring : {false, true}) {
+        gl::BatchStreambuf& buf  = batchBuf(io_uring);
+        bool                used = buf.uses_io_uring();
+        // Write remaining messages, so that all system calls are counted
+        buf.close();
+        if (buf.messages() == 0) {
+            continue;
+        }
+        std::printf("%-48s %12.1f syscalls/1000 messages%s\n",
+            io_uring ? "destination/batch_io_uring"
+                     : "destination/batch_writev",
+            1000.0 * static_cast<double>(buf.system_calls()) /
+                static_cast<double>(buf.messages()),
+            io_uring && !used ? " (io_uring unavailable, writev)" : "");
+    }
+}
+#endif
+
+/**
+ * \brief Write results as CSV.
+ *
+ * \param os      Output stream.
+ * \param results Results.
+ */
+void write_csv(std::ostream& os, const std::vector<Result>& results) {
+    os << "name,iterations,ns_per_call,calls_per_sec,allocs_per_call\n";
+    for (const Result& r : results) {
+        os << r.name << ',' << r.iterations << ',' << r.ns_per_call << ','
+           << r.calls_per_sec << ',' << r.allocs_per_call << '\n';
+    }
+}
+
+/**
+ * \brief Write results as JSON.
+ *
+ * \param os      Output stream.
+ * \param results Results.
+ */
+void write_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "  {\"name\": \"" << r.name
+           << "\", \"iterations\": " << r.iterations
+           << ", \"ns_per_call\": " << r.ns_per_call
+           << ", \"calls_per_sec\": " << r.calls_per_sec
+           << ", \"allocs_per_call\": " << r.allocs_per_call << '}'
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "]\n";
+}
+
+/**
+ * \brief Read results written by write_csv().
+ *
+ * \param path File path.
+ * \return Nanoseconds and allocations per call, by benchmark name.
+ */
+std::map<std::string, std::pair<double, double>> read_csv(
+    const std::string& path) {
+    std::map<std::string, std::pair<double, double>> rv;
+    std::ifstream                                    f(path);
+    if (!f.is_open()) {
+        throw std::runtime_error("Failed to open baseline '" + path + "'");
+    }
+    std::string line;
+    std::getline(f, line); // Header
+    while (std::getline(f, line)) {
+        std::stringstream        ss(line);
+        std::vector<std::string> cols;
+        std::string              col;
+        while (std::getline(ss, col, ',')) {
+            cols.push_back(col);
+        }
+        if (cols.size() == 5) {
+            rv[cols[0]] = {std::stod(cols[2]), std::stod(cols[4])};
+        }
+    }
+    return rv;
+}
+
+/**
+ * \brief Compare results to baseline and print regressions.
+ *
+ * \param results   Results.
+ * \param baseline  Baseline results.
+ * \param threshold Allowed slowdown in percent.
+ * \return Number of regressions.
+ */
+int compare(const std::vector<Result>&                         results,
+    const std::map<std::string, std::pair<double, double>>& baseline,
+    double                                                   threshold) {
+    int regressions = 0;
+    for (const Result& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) {
+            continue;
+        }
+        double base   = it->second.first;
+        double change = base > 0.0 ? (r.ns_per_call / base - 1.0) * 100.0 : 0.0;
+        bool   slower = change > threshold;
+        bool   allocs = r.allocs_per_call > it->second.second + 0.01;
+        if (slower || allocs) {
+            ++regressions;
+            std::printf("REGRESSION %-48s %10.1f ns -> %10.1f ns (%+.1f%%), "
+                        "%.2f -> %.2f allocs\n",
+                r.name.c_str(), base, r.ns_per_call, change, it->second.second,
+                r.allocs_per_call);
+        }
+    }
+    return regressions;
+}
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --filter <text>      Only run benchmarks whose name contains text\n"
+        "  --min-time <ms>      Minimum time per benchmark (default 200)\n"
+        "  --csv <file>         Write results as CSV\n"
+        "  --json <file>        Write results as JSON\n"
+        "  --baseline <file>    Compare to CSV written by an earlier run\n"
+        "  --threshold <pct>    Allowed slowdown against baseline (default "
+        "10)\n",
+        name);
+}
+
+} // namespace bench
+} // namespace gl
+
+using namespace gl::bench;
+
+/**
+ * \brief Benchmark entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success and no regressions.
+ */
+int main(int argc, const char** argv) {
+    std::string filter;
+    std::string csv;
+    std::string json;
+    std::string baseline;
+    double      threshold = 10.0;
+    long        min_ms    = 200;
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string val(argv[++i]);
+        if (arg == "--filter") {
+            filter = val;
+        } else if (arg == "--min-time") {
+            min_ms = std::stol(val);
+        } else if (arg == "--csv") {
+            csv = val;
+        } else if (arg == "--json") {
+            json = val;
+        } else if (arg == "--baseline") {
+            baseline = val;
+        } else if (arg == "--threshold") {
+            threshold = std::stod(val);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Run benchmarks with output discarded
+    std::streambuf* out = std::cout.rdbuf(&nullBuf);
+    gl::set_prefixes(gl::prefix::FILE | gl::prefix::LINE);
+    std::vector<Result> results;
+    for (const Benchmark& b : all_benchmarks()) {
+        if (b.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(run(b, std::chrono::milliseconds(min_ms)));
+        const Result& r = results.back();
+        std::printf("%-48s %12.1f ns/call %14.0f calls/s %8.2f allocs/call\n",
+            r.name.c_str(), r.ns_per_call, r.calls_per_sec, r.allocs_per_call);
+        std::fflush(stdout);
+    }
+    std::cout.rdbuf(out);
+    std::remove(outputFile);
+    print_compression();
+#ifdef __unix__
+    print_system_calls();
+#endif
+
+    // Write results
+    if (!csv.empty()) {
+        std::ofstream f(csv);
+        write_csv(f, results);
+    }
+    if (!json.empty()) {
+        std::ofstream f(json);
+        write_json(f, results);
+    }
+
+    // Compare to baseline
+    if (!baseline.empty()) {
+        int n = compare(results, read_csv(baseline), threshold);
+        std::printf("%d regression(s) against '%s'\n", n, baseline.c_str());
+        return n == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+
+/**
+ * \file
+ * Report of the bytes of code added per call site of l().
+ *
+ * Writes files with many functions which each contain one call site, and a
+ * file with the same functions without call sites, and compiles them with
+ * the compiler which built the report. Reads the sizes of the functions and
+ * of the code sections from the ELF object files. Reports the bytes inlined
+ * in the function of each call site, which are executed even if output is
+ * disabled, and the bytes of hot and cold code added by each additional call
+ * site. Code shared by all call sites, such as the formatters, is measured
+ * once and reported separately.
+ */
+
+#ifndef GL_BENCH_CXX
+/** Compiler. */
+#define GL_BENCH_CXX "c++"
+#endif // GL_BENCH_CXX
+
+#ifndef GL_BENCH_INCLUDE
+/** Include directory of goinglogging. */
+#define GL_BENCH_INCLUDE "../include"
+#endif // GL_BENCH_INCLUDE
+
+namespace gl {
+namespace bench {
+
+/**
+ * \brief Call site to measure.
+ */
+struct Case {
+    const char* name;      /**< Name. */
+    const char* statement; /**< Statement in each function. */
+};
+
+/** Cases. */
+const Case cases[] = {
+    {"l(i)", "l(i);"},
+    {"l(i, d, s)", "l(i, d, s);"},
+    {"l(v)", "l(v);"},
+    {"l_arr(a, 4)", "l_arr(a, 4);"},
+};
+
+/**
+ * \brief Code sizes of an object file.
+ */
+struct CodeSize {
+    double   function; /**< Mean size of the functions with call sites. */
+    uint64_t hot;      /**< Size of code sections, except cold and startup. */
+    uint64_t cold;     /**< Size of cold code sections. */
+};
+
+/**
+ * \brief Check if string starts with prefix.
+ *
+ * \param s      String.
+ * \param prefix Prefix.
+ * \return \c true if \p s starts with \p prefix.
+ */
+bool starts_with(const char* s, const char* prefix) {
+    return std::strncmp(s, prefix, std::strlen(prefix)) == 0;
+}
+
+/**
+ * \brief Read code sizes of 64-bit ELF object file.
+ *
+ * \param path Path to object file.
+ * \param size Code sizes. Written to.
+ * \return \c false if the file is not a 64-bit ELF object file.
+ */
+bool read_code_size(const char* path, CodeSize& size) {
+    std::ifstream     f(path, std::ios::binary);
+    std::vector<char> obj(
+        (std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (obj.size() < sizeof(Elf64_Ehdr) ||
+        std::memcmp(obj.data(), ELFMAG, SELFMAG) != 0 ||
+        obj[EI_CLASS] != ELFCLASS64) {
+        return false;
+    }
+    Elf64_Ehdr eh;
+    std::memcpy(&eh, obj.data(), sizeof(eh));
+    if (eh.e_shoff + static_cast<uint64_t>(eh.e_shnum) * sizeof(Elf64_Shdr) >
+        obj.size()) {
+        return false;
+    }
+    std::vector<Elf64_Shdr> sh(eh.e_shnum);
+    std::memcpy(sh.data(), obj.data() + eh.e_shoff,
+        sh.size() * sizeof(Elf64_Shdr));
+    const char* names = obj.data() + sh[eh.e_shstrndx].sh_offset;
+
+    // Sections
+    size.hot  = 0;
+    size.cold = 0;
+    for (const Elf64_Shdr& s : sh) {
+        const char* name = names + s.sh_name;
+        if ((s.sh_flags & SHF_EXECINSTR) == 0 ||
+            starts_with(name, ".text.startup")) {
+            continue;
+        }
+        (starts_with(name, ".text.unlikely") ? size.cold : size.hot) +=
+            s.sh_size;
+    }
+
+    // Functions gl_site_<n>
+    uint64_t total = 0;
+    unsigned n     = 0;
+    for (const Elf64_Shdr& s : sh) {
+        if (s.sh_type != SHT_SYMTAB) {
+            continue;
+        }
+        const char* strings = obj.data() + sh[s.sh_link].sh_offset;
+        for (uint64_t off = 0; off + sizeof(Elf64_Sym) <= s.sh_size;
+             off += sizeof(Elf64_Sym)) {
+            Elf64_Sym sym;
+            std::memcpy(&sym, obj.data() + s.sh_offset + off, sizeof(sym));
+            if (starts_with(strings + sym.st_name, "gl_site_")) {
+                total += sym.st_size;
+                ++n;
+            }
+        }
+    }
+    size.function = n == 0 ? 0.0 : static_cast<double>(total) / n;
+    return n != 0;
+}
+
+/**
+ * \brief Compile file with functions, and read its code sizes.
+ *
+ * \param command   Compiler command, without source and output.
+ * \param statement Statement in each function.
+ * \param sites     Number of functions.
+ * \param size      Code sizes. Written to.
+ * \return \c false if compilation or reading failed.
+ */
+bool measure(const std::string& command, const char* statement,
+    unsigned sites, CodeSize& size) {
+    const char*        src = "code_size_tu.cpp";
+    const char*        obj = "code_size_tu.o";
+    std::ostringstream ss;
+    ss << "#include \"goinglogging.h\"\n";
+    for (unsigned i = 0; i < sites; ++i) {
+        ss << "extern \"C\" void gl_site_" << i
+           << "(int i, double d, const std::string& s, std::vector<int>& v, "
+              "int* a) {\n"
+           << "    (void)i; (void)d; (void)s; (void)v; (void)a;\n"
+           << "    " << statement << "\n}\n";
+    }
+    std::ofstream(src) << ss.str();
+    bool ok = std::system((command + ' ' + src + " -o " + obj).c_str()) == 0 &&
+              read_code_size(obj, size);
+    std::remove(src);
+    std::remove(obj);
+    return ok;
+}
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --sites <n>          Call sites per file (default 64)\n"
+        "  --flags <flags>      Compiler flags (default -O2)\n"
+        "  --cxx <compiler>     Compiler (default the one which built this)\n"
+        "  --include <dir>      Include directory of goinglogging\n",
+        name);
+}
+
+} // namespace bench
+} // namespace gl
+
+using namespace gl::bench;
+
+/**
+ * \brief Code size report entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if all cases were measured.
+ */
+int main(int argc, const char** argv) {
+    unsigned    sites   = 64;
+    std::string flags   = "-O2";
+    std::string cxx     = GL_BENCH_CXX;
+    std::string include = GL_BENCH_INCLUDE;
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string val(argv[++i]);
+        if (arg == "--sites") {
+            sites = static_cast<unsigned>(std::stoul(val));
+        } else if (arg == "--flags") {
+            flags = val;
+        } else if (arg == "--cxx") {
+            cxx = val;
+        } else if (arg == "--include") {
+            include = val;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (sites == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Functions without call sites
+    const std::string command =
+        cxx + " -std=c++11 " + flags + " -I\"" + include + "\" -c";
+    CodeSize base;
+    if (!measure(command, "", sites, base)) {
+        std::fprintf(stderr, "Failed to measure: %s\n", command.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Bytes of code per call site, with %s\n", flags.c_str());
+    std::printf("%-16s %10s %10s %10s %10s\n", "call site", "inlined", "hot",
+        "cold", "shared");
+    for (const Case& c : cases) {
+        // Difference between 2 * sites and sites is the size of sites
+        CodeSize size;
+        CodeSize size2;
+        if (!measure(command, c.statement, sites, size) ||
+            !measure(command, c.statement, 2 * sites, size2)) {
+            std::fprintf(stderr, "Failed to measure %s\n", c.name);
+            return EXIT_FAILURE;
+        }
+        double hot  = static_cast<double>(size2.hot - size.hot) / sites;
+        double cold = static_cast<double>(size2.cold - size.cold) / sites;
+        double shared =
+            static_cast<double>(size.hot + size.cold - base.hot - base.cold) -
+            (hot + cold) * sites;
+        std::printf("%-16s %10.0f %10.0f %10.0f %10.0f\n", c.name,
+            size.function - base.function, hot, cold, shared);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Benchmark of the compile time of a file which logs, per included header.
+ *
+ * Writes a small file for each case and compiles it several times with the
+ * compiler which built the benchmark. Reports the minimum and mean compile
+ * time per file, and the compile time relative to a file which only uses
+ * iostream.
+ */
+
+#ifndef GL_BENCH_CXX
+/** Compiler. */
+#define GL_BENCH_CXX "c++"
+#endif // GL_BENCH_CXX
+
+#ifndef GL_BENCH_INCLUDE
+/** Include directory of goinglogging. */
+#define GL_BENCH_INCLUDE "../include"
+#endif // GL_BENCH_INCLUDE
+
+namespace gl {
+namespace bench {
+
+/**
+ * \brief File to compile.
+ */
+struct Case {
+    const char* name;   /**< Name. */
+    const char* flags;  /**< Extra compiler flags. */
+    const char* source; /**< Source code. */
+};
+
+/** Function which logs, shared by all cases which use goinglogging. */
+#define GL_BENCH_LOG                                                       \
+    "void f(int i, double d, const std::string& s) {\n"                    \
+    "    l(i, d, s);\n"                                                    \
+    "}\n"
+
+/** Function which logs a vector. */
+#define GL_BENCH_LOG_VECTOR                                                \
+    "void g(std::vector<int>& v) {\n"                                      \
+    "    l(v);\n"                                                          \
+    "}\n"
+
+/** Cases, with iostream first as reference. */
+const Case cases[] = {
+    {"iostream", "",
+        "#include <iostream>\n"
+        "#include <string>\n"
+        "#include <vector>\n"
+        "void f(int i, double d, const std::string& s) {\n"
+        "    std::cout << i << d << s << '\\n';\n"
+        "}\n"},
+    {"core", "",
+        "#include \"goinglogging/core.h\"\n" GL_BENCH_LOG},
+    {"core + sequence", "",
+        "#include \"goinglogging/core.h\"\n"
+        "#include \"goinglogging/sequence.h\"\n" GL_BENCH_LOG
+            GL_BENCH_LOG_VECTOR},
+    {"goinglogging", "",
+        "#include \"goinglogging.h\"\n" GL_BENCH_LOG GL_BENCH_LOG_VECTOR},
+    {"goinglogging, precompiled", "-DGL_PRECOMPILED",
+        "#include \"goinglogging.h\"\n" GL_BENCH_LOG GL_BENCH_LOG_VECTOR},
+};
+
+/**
+ * \brief Compile file and measure the time.
+ *
+ * \param command Compiler command.
+ * \return Time in ms, or a negative number if compilation failed.
+ */
+double compile(const std::string& command) {
+    auto start = std::chrono::steady_clock::now();
+    int  ret   = std::system(command.c_str());
+    auto stop  = std::chrono::steady_clock::now();
+    if (ret != 0) {
+        return -1.0;
+    }
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --runs <n>           Compilations per case (default 5)\n"
+        "  --flags <flags>      Compiler flags (default -O2)\n"
+        "  --cxx <compiler>     Compiler (default the one which built this)\n"
+        "  --include <dir>      Include directory of goinglogging\n",
+        name);
+}
+
+} // namespace bench
+} // namespace gl
+
+using namespace gl::bench;
+
+/**
+ * \brief Compile time benchmark entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if all cases compiled.
+ */
+int main(int argc, const char** argv) {
+    int         runs    = 5;
+    std::string flags   = "-O2";
+    std::string cxx     = GL_BENCH_CXX;
+    std::string include = GL_BENCH_INCLUDE;
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string val(argv[++i]);
+        if (arg == "--runs") {
+            runs = std::stoi(val);
+        } else if (arg == "--flags") {
+            flags = val;
+        } else if (arg == "--cxx") {
+            cxx = val;
+        } else if (arg == "--include") {
+            include = val;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (runs <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%-28s %10s %10s %10s\n", "header", "min (ms)", "mean (ms)",
+        "relative");
+    double reference = 0.0;
+    for (const Case& c : cases) {
+        // Write source
+        const std::string src = "compile_time_tu.cpp";
+        std::ofstream(src) << c.source;
+        const std::string command = cxx + " -std=c++11 " + flags + ' ' +
+                                    c.flags + " -I\"" + include + "\" -c " +
+                                    src + " -o compile_time_tu.o";
+
+        // Compile, once without measuring to warm up caches
+        std::vector<double> times;
+        bool                ok = compile(command) >= 0.0;
+        for (int i = 0; ok && i < runs; ++i) {
+            double t = compile(command);
+            ok       = t >= 0.0;
+            times.push_back(t);
+        }
+        std::remove(src.c_str());
+        std::remove("compile_time_tu.o");
+        if (!ok) {
+            std::fprintf(stderr, "Failed to compile: %s\n", command.c_str());
+            return EXIT_FAILURE;
+        }
+
+        double min  = *std::min_element(times.begin(), times.end());
+        double mean = 0.0;
+        for (double t : times) {
+            mean += t / static_cast<double>(times.size());
+        }
+        if (reference == 0.0) {
+            reference = min;
+        }
+        std::printf("%-28s %10.0f %10.0f %9.2fx\n", c.name, min, mean,
+            min / reference);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+#include "goinglogging.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * Stress test of many threads logging at once.
+ *
+ * Each thread calls l() at a controlled rate and records the latency of every
+ * call. Reports latency percentiles, throughput and whether lines from
+ * different threads were interleaved.
+ */
+
+namespace gl {
+namespace bench {
+
+/**
+ * \brief Stream buffer which checks that every line is intact.
+ *
+ * Locks a mutex around each write, like the C stdio stream behind std::cout
+ * does, so that lines are only interleaved if the library writes a line in
+ * several pieces. Expects lines ending with "tid = <thread>, seq = <number>".
+ */
+class CheckingStreambuf : public std::streambuf {
+  public:
+    /**
+     * \brief Constructor.
+     *
+     * \param threads Number of threads.
+     */
+    explicit CheckingStreambuf(size_t threads) :
+        m_mutex(), m_line(), m_next(threads, 0), m_lines(0), m_interleaved(0),
+        m_reordered(0) {}
+
+    /**
+     * \return Number of lines.
+     */
+    uint64_t get_lines() const noexcept {
+        return m_lines;
+    }
+
+    /**
+     * \return Number of lines mixed with other lines.
+     */
+    uint64_t get_interleaved() const noexcept {
+        return m_interleaved;
+    }
+
+    /**
+     * \return Number of lines lost, duplicated or out of order.
+     */
+    uint64_t get_reordered() const noexcept {
+        return m_reordered;
+    }
+
+  protected:
+    /**
+     * \brief Write character.
+     *
+     * \param c Character.
+     * \return \p c.
+     */
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            put(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    /**
+     * \brief Write characters.
+     *
+     * \param s Characters.
+     * \param n Number of characters.
+     * \return \p n.
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::streamsize i = 0; i < n; ++i) {
+            put(s[i]);
+        }
+        return n;
+    }
+
+  private:
+    /**
+     * \brief Append character to line and check line when complete.
+     *
+     * \param c Character.
+     */
+    void put(char c) {
+        if (c != '\n') {
+            m_line.push_back(c);
+            return;
+        }
+        check(m_line);
+        m_line.clear();
+    }
+
+    /**
+     * \brief Check line.
+     *
+     * \param line Line without newline.
+     */
+    void check(const std::string& line) {
+        ++m_lines;
+        size_t t = line.find("tid = ");
+        size_t s = line.find("seq = ");
+        if (t == std::string::npos || s == std::string::npos || s < t ||
+            line.find("tid = ", t + 1) != std::string::npos ||
+            line.find("seq = ", s + 1) != std::string::npos) {
+            ++m_interleaved;
+            return;
+        }
+
+        // Parse numbers and require that the line ends after sequence number
+        char*         end = nullptr;
+        unsigned long tid = std::strtoul(line.c_str() + t + 6, &end, 10);
+        unsigned long long seq =
+            std::strtoull(line.c_str() + s + 6, &end, 10);
+        if (*end != '\0' || tid >= m_next.size()) {
+            ++m_interleaved;
+            return;
+        }
+        if (seq != m_next[tid]) {
+            ++m_reordered;
+        }
+        m_next[tid] = seq + 1;
+    }
+
+    std::mutex            m_mutex;       /**< Guards all members. */
+    std::string           m_line;        /**< Current line. */
+    std::vector<uint64_t> m_next;        /**< Next sequence number per thread. */
+    uint64_t              m_lines;       /**< Number of lines. */
+    uint64_t              m_interleaved; /**< Number of mixed lines. */
+    uint64_t              m_reordered;   /**< Number of lines out of order. */
+};
+
+/**
+ * \brief Parse prefix names.
+ *
+ * \param s Names separated by '|', e.g. "THREAD|TIME".
+ * \return Prefixes.
+ */
+gl::prefix parse_prefixes(const std::string& s) {
+    static const std::pair<const char*, gl::prefix> names[] = {
+        {"NONE", gl::prefix::NONE}, {"FILE", gl::prefix::FILE},
+        {"LINE", gl::prefix::LINE}, {"FUNCTION", gl::prefix::FUNCTION},
+        {"TIME", gl::prefix::TIME}, {"THREAD", gl::prefix::THREAD},
+        {"TYPE_NAME", gl::prefix::TYPE_NAME}};
+    gl::prefix p     = gl::prefix::NONE;
+    size_t     begin = 0;
+    while (begin <= s.size()) {
+        size_t      end  = std::min(s.find('|', begin), s.size());
+        std::string name = s.substr(begin, end - begin);
+        bool        found = false;
+        for (const auto& n : names) {
+            if (name == n.first) {
+                p     = p | n.second;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::invalid_argument("Unknown prefix '" + name + "'");
+        }
+        begin = end + 1;
+    }
+    return p;
+}
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --threads <n>        Number of logging threads (default 8)\n"
+        "  --rate <n>           Calls per second per thread, 0 for no limit "
+        "(default 0)\n"
+        "  --duration <ms>      Duration of test (default 1000)\n"
+        "  --prefixes <names>   Prefixes, e.g. THREAD|TIME (default "
+        "THREAD|TIME)\n"
+        "  --output <dest>      check or stdout (default check)\n",
+        name);
+}
+
+} // namespace bench
+} // namespace gl
+
+using namespace gl::bench;
+
+/**
+ * \brief Stress test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if no lines were interleaved.
+ */
+int main(int argc, const char** argv) {
+    size_t      threads  = 8;
+    double      rate     = 0.0;
+    long        duration = 1000;
+    std::string prefixes = "THREAD|TIME";
+    std::string output   = "check";
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string val(argv[++i]);
+        if (arg == "--threads") {
+            threads = std::stoul(val);
+        } else if (arg == "--rate") {
+            rate = std::stod(val);
+        } else if (arg == "--duration") {
+            duration = std::stol(val);
+        } else if (arg == "--prefixes") {
+            prefixes = val;
+        } else if (arg == "--output") {
+            output = val;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (threads == 0 ||
+        (output != "check" && output != "stdout")) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Redirect output
+    CheckingStreambuf checker(threads);
+    std::streambuf*   out = std::cout.rdbuf();
+    if (output == "check") {
+        std::cout.rdbuf(&checker);
+    }
+    gl::set_prefixes(parse_prefixes(prefixes));
+
+    // Run threads
+    gl::internal::Histogram  latency;
+    std::atomic<bool>        go(false);
+    std::atomic<uint64_t>    calls(0);
+    std::vector<std::thread> workers;
+    auto                     stop_time = std::chrono::steady_clock::time_point();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            using clock      = std::chrono::steady_clock;
+            const auto start = clock::now();
+            const auto interval =
+                std::chrono::duration<double, std::nano>(
+                    rate > 0.0 ? 1e9 / rate : 0.0);
+            unsigned long      tid = t;
+            unsigned long long seq = 0;
+            while (true) {
+                // Open loop, so that a slow call does not lower the rate
+                auto next = start + std::chrono::duration_cast<clock::duration>(
+                                        interval * static_cast<double>(seq));
+                if (rate > 0.0) {
+                    std::this_thread::sleep_until(next);
+                }
+                auto t0 = clock::now();
+                if (t0 >= stop_time) {
+                    break;
+                }
+                l(tid, seq);
+                auto t1 = clock::now();
+                latency.record(static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        t1 - t0)
+                        .count()));
+                ++seq;
+            }
+            calls.fetch_add(seq, std::memory_order_relaxed);
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    stop_time  = start + std::chrono::milliseconds(duration);
+    go.store(true, std::memory_order_release);
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout.flush();
+    std::cout.rdbuf(out);
+
+    // Report, on stderr if logging goes to stdout
+    std::FILE* report = output == "stdout" ? stderr : stdout;
+    gl::internal::HistogramSnapshot s = latency.snapshot(false);
+    std::fprintf(report, "threads = %zu, rate = ", threads);
+    if (rate > 0.0) {
+        std::fprintf(report, "%.0f/s per thread", rate);
+    } else {
+        std::fprintf(report, "unlimited");
+    }
+    std::fprintf(report, ", duration = %ld ms, prefixes = %s, output = %s\n", duration,
+        prefixes.c_str(), output.c_str());
+    std::fprintf(report, "calls = %llu, throughput = %.0f calls/s\n",
+        static_cast<unsigned long long>(calls.load()),
+        static_cast<double>(calls.load()) / seconds);
+    std::fprintf(report, "latency: p50 = %.0f ns, p90 = %.0f ns, p99 = %.0f ns, "
+                "p99.9 = %.0f ns, p99.99 = %.0f ns, max = %.0f ns\n",
+        s.percentile(0.5), s.percentile(0.9), s.percentile(0.99),
+        s.percentile(0.999), s.percentile(0.9999), s.get_max());
+    if (output != "check") {
+        std::fprintf(report, "interleaving: not checked\n");
+        return EXIT_SUCCESS;
+    }
+    std::fprintf(report, "lines = %llu, interleaved = %llu, out of order = %llu\n",
+        static_cast<unsigned long long>(checker.get_lines()),
+        static_cast<unsigned long long>(checker.get_interleaved()),
+        static_cast<unsigned long long>(checker.get_reordered()));
+
+    return checker.get_interleaved() == 0 && checker.get_reordered() == 0 ?
+               EXIT_SUCCESS :
+               EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <functional>
+#include <iostream>
+#include <list>
+#include <queue>
+#include <stack>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Test traversal of container adaptors.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // All elements, with default and other underlying containers
+    std::stack<int>                                   st;
+    std::stack<std::string, std::vector<std::string>> stv;
+    std::queue<int>                                   que;
+    std::queue<std::string, std::list<std::string>>   qul;
+    std::priority_queue<int>                          pq;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> pqg;
+    std::stack<int>                                               empty;
+    for (int i : {5, 1, 4, 2, 3}) {
+        st.push(i);
+        stv.push(std::to_string(i));
+        que.push(i);
+        qul.push(std::to_string(i));
+        pq.push(i);
+        pqg.push(i);
+    }
+    l(st, stv, empty);
+    l(que, qul);
+    l(pq, pqg);
+
+    // Priority queues sorted, with and without the rest
+    gl::set_priority_queue_sorted(3);
+    std::cout << gl::get_priority_queue_sorted() << std::endl;
+    l(pq, pqg);
+    gl::set_priority_queue_sorted(5);
+    l(pq, pqg);
+
+    // String budget applies to elements
+    gl::set_max_string_length(1);
+    stv.push("long");
+    l(stv);
+    gl::set_max_string_length(0);
+
+    // JSON
+    gl::set_format(gl::format::JSON);
+    l(st, que, pq);
+    gl::set_priority_queue_sorted(0);
+    l(pq);
+    gl::set_format(gl::format::TEXT);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
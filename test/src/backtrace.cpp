@@ -0,0 +1,136 @@
+#include "goinglogging.h"
+#include "goinglogging/backtrace.h"
+#include "goinglogging/capture.h"
+#include "test/test.h"
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+/**
+ * \file
+ * Test logging of backtraces. Linked with exported symbols, so that
+ * functions of the executable are named.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Log backtrace to string.
+ *
+ * \param i   Value to log.
+ * \param out Output.
+ */
+GL_INTERNAL_NOINLINE void inner_function(int i, std::string& out) {
+    std::ostringstream ss;
+    std::streambuf*    prev = std::cout.rdbuf(ss.rdbuf());
+    l_backtrace(i);
+    std::cout.rdbuf(prev);
+    out = ss.str();
+}
+
+/**
+ * \brief Call inner_function(), not as a tail call.
+ *
+ * \param i Value to log.
+ * \return Output.
+ */
+GL_INTERNAL_NOINLINE std::string outer_function(int i) {
+    std::string s;
+    inner_function(i, s);
+    return s;
+}
+
+/**
+ * \brief Log backtrace without variables to string.
+ *
+ * \return Output.
+ */
+GL_INTERNAL_NOINLINE std::string log_without_variables() {
+    std::ostringstream ss;
+    std::streambuf*    prev = std::cout.rdbuf(ss.rdbuf());
+    l_backtrace();
+    std::cout.rdbuf(prev);
+    return ss.str();
+}
+
+/**
+ * \brief Print start of output, and whether functions are written from the
+ * innermost.
+ *
+ * \param s Output.
+ */
+void print_backtrace(const std::string& s) {
+    size_t inner = s.find("\"inner_function(");
+    size_t outer = s.find("\"outer_function");
+    size_t main  = s.find("\"main+0x");
+    std::cout << s.substr(0, s.find("backtrace") + 13) << ' '
+              << (inner != std::string::npos && inner < outer &&
+                     outer != std::string::npos && outer < main &&
+                     main != std::string::npos)
+              << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Innermost first, and the same after the names are cached
+    std::string output[2];
+    for (std::string& o : output) {
+        o = outer_function(1);
+    }
+    print_backtrace(output[0]);
+    std::cout << (output[1] == output[0]) << std::endl;
+
+    // Number of frames is limited
+    gl::internal::Backtrace bt;
+    std::cout << (bt.size() > 0 &&
+                     bt.size() <= gl::internal::Backtrace::kMaxFrames)
+              << std::endl;
+
+    // JSON, and with prefixes
+    gl::set_format(gl::format::JSON);
+    print_backtrace(outer_function(2));
+    gl::set_format(gl::format::TEXT);
+    gl::set_prefixes(gl::prefix::FUNCTION);
+    print_backtrace(outer_function(3));
+    gl::set_prefixes(gl::prefix::NONE);
+
+    // Without variables, from the function which logs
+    std::string none = log_without_variables();
+    std::cout << none.substr(0, 13) << ' '
+              << (none.find("{\"log_without_variables") !=
+                     std::string::npos)
+              << std::endl;
+
+    // Disabled
+    gl::set_output_enabled(false);
+    std::cout << outer_function(4).empty() << std::endl;
+    gl::set_output_enabled(true);
+
+    // Only the variables are captured
+    gl::set_capture_enabled(true);
+    std::cout << outer_function(5).empty() << std::endl;
+    gl::set_capture_enabled(false);
+    gl::clear_capture();
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,173 @@
+#include "goinglogging.h"
+#include "goinglogging/batch_sink.h"
+#include "goinglogging/flight_recorder.h"
+#include "test/test.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * Test writing in batches, with writev() and with io_uring if available.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Read and clear everything written to file.
+ *
+ * \param fd File descriptor.
+ * \return Contents.
+ */
+std::string take_file(int fd) {
+    std::string s;
+    char        buf[4096];
+    ssize_t     n = 0;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        s.append(buf, static_cast<size_t>(n));
+    }
+    if (ftruncate(fd, 0) != 0) {
+        s += "ftruncate failed\n";
+    }
+    lseek(fd, 0, SEEK_SET);
+    return s;
+}
+
+/**
+ * \brief Log in batches, from one and from several threads.
+ *
+ * \param fd       File descriptor.
+ * \param io_uring \c true to use io_uring if available.
+ */
+void log_batches(int fd, bool io_uring) {
+    // Batches of 4, with a latency bound which is never reached
+    const gl::BatchStreambuf& buf = gl::internal::batch_sink().buf;
+    uint64_t messages = buf.messages();
+    uint64_t calls    = buf.system_calls();
+    gl::start_batch_sink(fd, 4, std::chrono::hours(1), io_uring);
+    for (int i = 0; i < 10; ++i) {
+        l(i);
+    }
+    std::string s(100000, 's');
+    l(s);
+    gl::stop_batch_sink();
+    std::string written = take_file(fd);
+    std::cout << written.substr(0, 40) << "...\n"
+              << written.size() << ' ' << buf.messages() - messages << ' '
+              << (buf.system_calls() - calls <= 4) << std::endl;
+
+    // Latency bound
+    gl::start_batch_sink(fd, 1000, std::chrono::milliseconds(1), io_uring);
+    int j = 1;
+    l(j);
+    for (int wait = 0; wait < 5000 && buf.messages() == messages + 11;
+         ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout.flush();
+    std::string early = take_file(fd);
+    gl::stop_batch_sink();
+    std::cout << early;
+
+    // Lines from several threads are kept whole and in order
+    gl::start_batch_sink(fd, 64, std::chrono::milliseconds(1), io_uring);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i]() {
+            for (int seq = 0; seq < 1000; ++seq) {
+                l(i, seq);
+            }
+        });
+    }
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    gl::stop_batch_sink();
+    std::istringstream lines(take_file(fd));
+    std::vector<int>   next(4, 0);
+    std::string        line;
+    int                n       = 0;
+    bool               ordered = true;
+    while (std::getline(lines, line)) {
+        int i   = -1;
+        int seq = -1;
+        if (std::sscanf(line.c_str(), "i = %d, seq = %d", &i, &seq) != 2 ||
+            i < 0 || i >= 4 || seq != next[i]++) {
+            ordered = false;
+        }
+        ++n;
+    }
+    std::cout << n << ' ' << ordered << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    char path[] = "tmp_batch_sink_XXXXXX";
+    int  fd     = mkstemp(path);
+    unlink(path);
+
+    log_batches(fd, false);
+    log_batches(fd, true);
+
+    // CBOR messages are written whole, even with newline bytes, and without
+    // newlines between them
+    std::ostringstream cbor;
+    std::streambuf*    prev = std::cout.rdbuf(cbor.rdbuf());
+    gl::set_format(gl::format::CBOR);
+    int ten = 10;
+    l(ten);
+    std::cout.rdbuf(prev);
+    gl::start_batch_sink(fd, 1);
+    l(ten);
+    l(ten);
+    gl::stop_batch_sink();
+    gl::set_format(gl::format::TEXT);
+    std::cout << cbor.str().size() << ' '
+              << (take_file(fd) == cbor.str() + cbor.str()) << std::endl;
+
+    // Sinks stopped in another order than started leave std::cout on the
+    // remaining sink, and then on its previous stream buffer
+    gl::start_batch_sink(fd, 1);
+    gl::start_flight_recorder(fd);
+    gl::stop_batch_sink();
+    int k = 1;
+    l(k);
+    gl::stop_flight_recorder();
+    std::cout << (std::cout.rdbuf() == prev) << ' ' << take_file(fd).empty()
+              << std::endl;
+    gl::dump_recent();
+    std::string dump = take_file(fd);
+    std::cout << (dump.find("\nk = 1\n") != std::string::npos) << std::endl;
+    close(fd);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,92 @@
+#include "goinglogging.h"
+#include "goinglogging/capture.h"
+#include "test/test.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+
+/**
+ * \file
+ * Test capture of numbers into compressed columns.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Log integers, and variables which are not captured.
+ */
+void log_integers() {
+    for (int i = 0; i < 5; ++i) {
+        unsigned long long u = 18446744073709551615ULL - i * i;
+        bool               b = i % 2 == 0;
+        char               c = 'c';
+        std::string        s = "s";
+        l(i, u, b, c, s);
+    }
+}
+
+/**
+ * \brief Log floating point numbers.
+ */
+void log_floats() {
+    float  f = 0.25f;
+    double d = -1e300;
+    for (int i = 0; i < 5; ++i) {
+        l(f, d);
+        f *= 3.0f;
+        d = i == 2 ? 0.1 : d / 7.0;
+    }
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Capture, which writes nothing
+    gl::set_capture_enabled(true);
+    log_integers();
+    log_floats();
+    gl::set_capture_enabled(false);
+    int j = 1;
+    l(j);
+
+    // Write and read back
+    const std::string path = "tmp_capture.bin";
+    std::cout << gl::write_capture(path) << std::endl;
+    std::ifstream is(path, std::ios::binary);
+    std::cout << gl::export_capture_csv(is, std::cout) << std::endl;
+    is.close();
+
+    // Only one site, after clearing and capturing again
+    gl::clear_capture();
+    gl::set_capture_enabled(true);
+    log_floats();
+    gl::set_capture_enabled(false);
+    gl::write_capture(path);
+    is.open(path, std::ios::binary);
+    std::cout << gl::export_capture_csv(is, std::cout, "log_floats")
+              << std::endl;
+    is.close();
+    std::remove(path.c_str());
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::REGEX);
+}
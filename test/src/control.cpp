@@ -0,0 +1,181 @@
+#include "goinglogging.h"
+#include "goinglogging/control.h"
+#include "test/test.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * Test runtime control of sites, prefixes and output.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Log from a function of its own.
+ *
+ * \param i Value to log.
+ */
+void other(int i) {
+    l(i);
+}
+
+/**
+ * \brief Wait until prefixes have been changed by the control thread.
+ *
+ * \param p Expected prefixes.
+ * \return \c true if changed within a second.
+ */
+bool wait_for_prefixes(gl::prefix p) {
+    for (int i = 0; i < 100 && gl::get_prefixes() != p; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return gl::get_prefixes() == p;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Disable and enable sites by function name and location
+    for (int i = 0; i < 2; ++i) {
+        other(i);
+        l(i);
+        std::cout << gl::execute_command("disable other") << std::endl;
+    }
+    std::cout << gl::execute_command("disable control.cpp:*") << std::endl;
+    other(2);
+    std::cout << gl::execute_command("enable *") << std::endl;
+    other(3);
+
+    // Rate limit
+    std::cout << gl::execute_command("rate other 2") << std::endl;
+    for (int i = 4; i < 8; ++i) {
+        other(i);
+    }
+    std::cout << gl::execute_command("rate * 0") << std::endl;
+
+    // Configuration
+    std::cout << gl::execute_command("prefixes LINE") << std::endl;
+    other(8);
+    std::cout << gl::execute_command("prefixes NONE") << std::endl;
+    std::cout << gl::execute_command("output off") << std::endl;
+    other(9);
+    std::cout << gl::execute_command("output on") << std::endl;
+    std::cout << gl::execute_command("format json") << std::endl;
+    other(9);
+    std::cout << gl::execute_command("format text") << std::endl;
+    std::cout << gl::execute_command("escape on") << std::endl;
+    std::cout << gl::execute_command("truncate 4") << std::endl;
+    std::string s("ab\ncdef");
+    l(s);
+    std::cout << gl::execute_command("truncate 0") << std::endl;
+    std::cout << gl::execute_command("escape off") << std::endl;
+    std::cout << gl::execute_command("flush") << std::endl;
+
+    // Errors
+    std::cout << gl::execute_command("enable") << std::endl;
+    std::cout << gl::execute_command("rate * x") << std::endl;
+    std::cout << gl::execute_command("prefixes FILE|BAD") << std::endl;
+    std::cout << gl::execute_command("color maybe") << std::endl;
+    std::cout << gl::execute_command("format xml") << std::endl;
+    std::cout << gl::execute_command("truncate -1") << std::endl;
+    std::cout << gl::execute_command("restart") << std::endl;
+
+    // Named FIFO
+    std::string fifo =
+        "/tmp/goinglogging_control_" + std::to_string(getpid()) + ".fifo";
+    std::cout << gl::start_control(fifo) << std::endl;
+    int fd = open(fifo.c_str(), O_WRONLY);
+    std::string cmd = "prefixes FUNCTION\n";
+    std::cout << (write(fd, cmd.data(), cmd.size()) > 0) << std::endl;
+    close(fd);
+    std::cout << wait_for_prefixes(gl::prefix::FUNCTION) << std::endl;
+    other(10);
+    gl::stop_control();
+    std::cout << (access(fifo.c_str(), F_OK) != 0) << std::endl;
+
+    // Unix domain socket, which answers
+    std::string sock =
+        "/tmp/goinglogging_control_" + std::to_string(getpid()) + ".sock";
+    std::cout << gl::start_control(sock, gl::control_channel::SOCKET)
+              << std::endl;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    sock.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    std::cout << (connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                      sizeof(addr)) == 0)
+              << std::endl;
+    cmd = "prefixes NONE\nbogus\n";
+    std::cout << (write(fd, cmd.data(), cmd.size()) > 0) << std::endl;
+    std::string reply;
+    char        c = 0;
+    while (std::count(reply.begin(), reply.end(), '\n') < 2 &&
+           read(fd, &c, 1) == 1) {
+        reply += c;
+    }
+    close(fd);
+    std::cout << reply;
+    std::cout << wait_for_prefixes(gl::prefix::NONE) << std::endl;
+    other(11);
+
+    // Only the owner may connect
+    struct stat st;
+    std::cout << (stat(sock.c_str(), &st) == 0 && (st.st_mode & 0777) == 0600)
+              << std::endl;
+
+    // Client which sends a too long line is answered and disconnected
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    std::cout << (connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                      sizeof(addr)) == 0)
+              << std::endl;
+    cmd = "enable " + std::string(8192, '*');
+    std::cout << (write(fd, cmd.data(), cmd.size()) > 0) << std::endl;
+    reply.clear();
+    while (read(fd, &c, 1) == 1) {
+        reply += c;
+    }
+    close(fd);
+    std::cout << reply;
+    gl::stop_control();
+
+    // Other files are neither read as commands, nor removed
+    std::string file =
+        "/tmp/goinglogging_control_" + std::to_string(getpid()) + ".txt";
+    std::ofstream(file.c_str()) << "output off\n";
+    std::cout << gl::start_control(file) << ' '
+              << gl::start_control(file, gl::control_channel::SOCKET) << ' '
+              << (access(file.c_str(), F_OK) == 0) << std::endl;
+    std::remove(file.c_str());
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
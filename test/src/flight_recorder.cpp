@@ -0,0 +1,131 @@
+#include "goinglogging.h"
+#include "goinglogging/flight_recorder.h"
+#include "test/test.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * Test flight recorder, dumped on request and on crashes.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Print and clear everything written to file.
+ *
+ * \param fd File descriptor.
+ */
+void print_dump(int fd) {
+    std::string s;
+    char        buf[256];
+    ssize_t     n = 0;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        s.append(buf, static_cast<size_t>(n));
+    }
+    std::cout << s;
+    if (ftruncate(fd, 0) != 0) {
+        std::cout << "ftruncate failed" << std::endl;
+    }
+    lseek(fd, 0, SEEK_SET);
+}
+
+/**
+ * \brief Log in a child process which then crashes. Print how it ended and
+ * what it dumped.
+ *
+ * \param fd  File descriptor of dump.
+ * \param how 0 for abort(), 1 for SIGSEGV and 2 for an uncaught exception.
+ */
+void crash(int fd, int how) {
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        gl::start_flight_recorder(fd, 4);
+        l(how);
+        if (how == 0) {
+            std::abort();
+        } else if (how == 1) {
+            std::raise(SIGSEGV);
+        } else {
+            throw std::runtime_error("uncaught");
+        }
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    std::cout << "signaled = " << WIFSIGNALED(status)
+              << ", signal = " << WTERMSIG(status) << std::endl;
+    print_dump(fd);
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    char path[] = "tmp_flight_recorder_XXXXXX";
+    int  fd     = mkstemp(path);
+    unlink(path);
+
+    // Nothing written until dumped, and only the last 4 messages kept
+    std::cout << gl::start_flight_recorder(fd, 4) << std::endl;
+    for (int i = 0; i < 6; ++i) {
+        l(i);
+    }
+    gl::stop_flight_recorder();
+    std::cout << "size = " << lseek(fd, 0, SEEK_END) << std::endl;
+    gl::dump_recent();
+    print_dump(fd);
+
+    // Long message in two slots, and messages of several threads in order
+    gl::start_flight_recorder(fd, 4);
+    std::string s(200, 's');
+    l(s);
+    std::thread([]() {
+        int j = 1;
+        l(j);
+    }).join();
+    int k = 2;
+    l(k);
+    std::thread([]() {
+        int j = 3;
+        l(j);
+    }).join();
+    gl::stop_flight_recorder();
+    gl::dump_recent();
+    print_dump(fd);
+
+    // Crashes
+    crash(fd, 0);
+    crash(fd, 1);
+    crash(fd, 2);
+    close(fd);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
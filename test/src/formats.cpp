@@ -0,0 +1,130 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Test JSON and CBOR output formats.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Log scalars, strings and containers.
+ */
+void log_values() {
+    int                        i   = -1;
+    unsigned                   u   = 2;
+    double                     d   = 0.5;
+    float                      nan = std::numeric_limits<float>::quiet_NaN();
+    bool                       b   = true;
+    char                       c   = 'c';
+    const char*                s   = "a\"b\\c\n\td\x01";
+    const char*                np  = nullptr;
+    std::string                str = "str";
+    std::vector<int>           v   = {1, 2, 3};
+    std::map<std::string, int> m   = {{"one", 1}, {"two", 2}};
+    std::map<int, float>       mi  = {{1, 1.5f}};
+    std::pair<int, std::string> pr(1, "p");
+
+    l(i, u, d);
+    l(nan, b, c);
+    l(s, np, str);
+    l(v, m, mi, pr);
+}
+
+/**
+ * \brief Log floating point numbers, which read back as the same value.
+ */
+void log_floats() {
+    double third = 1.0 / 3.0;
+    double tenth = 0.1;
+    float  ften  = 0.1f;
+    float  fbig  = 16777215.0f;
+    double big   = 1e300;
+
+    l(third, tenth, ften, fbig, big);
+}
+
+/**
+ * \brief Log array and matrix.
+ */
+void log_arrays() {
+    int a[] = {0, 1, 2};
+    int mat[2][2] = {{0, 1}, {2, 3}};
+
+    l_arr(a, 3);
+    l_mat(mat, 2, 2);
+}
+
+/**
+ * \brief Write bytes as hexadecimal.
+ *
+ * \param s Bytes.
+ */
+void print_hex(const std::string& s) {
+    char buf[4];
+    for (size_t i = 0; i < s.size(); ++i) {
+        std::snprintf(buf, sizeof(buf), "%02x",
+            static_cast<unsigned>(static_cast<unsigned char>(s[i])));
+        std::cout << buf << (i + 1 < s.size() ? " " : "\n");
+    }
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // JSON Lines
+    gl::set_format(gl::format::JSON);
+    log_values();
+    log_floats();
+    log_arrays();
+
+    // Prefixes as fields and type names
+    gl::set_prefixes(gl::prefix::FUNCTION | gl::prefix::TYPE_NAME);
+    int i = 1;
+    l(i);
+    gl::set_prefixes(gl::prefix::NONE);
+
+    // CBOR, written as hexadecimal
+    gl::set_format(gl::format::CBOR);
+    std::ostringstream ss;
+    std::streambuf*    out = std::cout.rdbuf(ss.rdbuf());
+    int                j   = 1;
+    std::string        s   = "s";
+    std::vector<int>   v   = {-1, 24};
+    l(j, s, v);
+    std::cout.rdbuf(out);
+    gl::set_format(gl::format::TEXT);
+    print_hex(ss.str());
+
+    // Text is unchanged
+    l(j, s, v);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,70 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <iostream>
+#include <ostream>
+
+/**
+ * \file
+ * Test output of l_hist(), l_count() and report().
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Count events.
+ *
+ * \param n Number of events.
+ */
+void count(int n) {
+    for (int i = 0; i < n; ++i) {
+        l_count(event);
+    }
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Integers
+    for (int i = 1; i <= 100; ++i) {
+        l_hist(i);
+    }
+
+    // Floating point, with same value in all samples
+    for (int i = 0; i < 10; ++i) {
+        double d = -0.25;
+        l_hist(d);
+    }
+
+    count(5);
+    gl::report();
+
+    // Statistics are reset after each report
+    count(2);
+    gl::report();
+
+    // Nothing is recorded while output is disabled
+    gl::set_output_enabled(false);
+    count(3);
+    gl::set_output_enabled(true);
+    gl::report();
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::REGEX);
+}
@@ -0,0 +1,76 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <iostream>
+#include <ostream>
+
+/**
+ * \file
+ * Test output of l_time_scope() and l_time_scope_log().
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Measured function.
+ *
+ * \param n Number of iterations.
+ * \return Sum.
+ */
+int work(int n) {
+    l_time_scope(work);
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += i;
+    }
+    return sum;
+}
+
+/**
+ * \brief Measured and logged function.
+ */
+void logged() {
+    l_time_scope_log(logged);
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    for (int i = 0; i < 10; ++i) {
+        work(i * 100);
+    }
+    logged();
+    logged();
+
+    // Nothing is measured while output is disabled
+    gl::set_output_enabled(false);
+    work(10);
+    logged();
+    gl::set_output_enabled(true);
+
+    // Durations of a disabled call site are recorded, but not logged
+    gl::set_sites_enabled("logged", false);
+    logged();
+    gl::set_sites_enabled("logged", true);
+
+    gl::report();
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::REGEX);
+}
@@ -0,0 +1,169 @@
+#include "goinglogging.h"
+#include "goinglogging/log_index.h"
+#include "test/test.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/**
+ * \file
+ * Test writing of log files with an index, and reading of the index.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Read file.
+ *
+ * \param path Path of file.
+ * \return Contents.
+ */
+std::string read_file(const std::string& path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+}
+
+/**
+ * \brief Log from a function, to have a call site with its own name.
+ *
+ * \param i Value to log.
+ */
+void log_from_function(int i) {
+    l(i);
+}
+
+/**
+ * \brief Print sites, and whether checkpoints describe the whole file.
+ *
+ * \param index Index.
+ * \param log   Log file.
+ */
+void print_index(const gl::LogIndex& index, const std::string& log) {
+    for (const gl::IndexSite& s : index.sites()) {
+        std::cout << s.file << ' ' << s.func << std::endl;
+    }
+    uint64_t offset = 0;
+    uint64_t lines  = 0;
+    bool     ok     = true;
+    for (const gl::IndexCheckpoint& c : index.checkpoints()) {
+        uint64_t n = 0;
+        for (const auto& sc : c.counts) {
+            n += sc.second;
+        }
+        ok = ok && c.offset == offset && c.first_ns <= c.last_ns &&
+             n == c.lines && log[c.offset + c.bytes - 1] == '\n';
+        offset += c.bytes;
+        lines += c.lines;
+    }
+    std::cout << index.checkpoints().size() << ' ' << lines << ' ' << ok
+              << ' ' << (offset == log.size()) << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Chunks end after 64 bytes. Lines without call site, and messages of
+    // several lines, are counted once
+    const std::string path = "log_index_" + std::to_string(getpid()) + ".log";
+    bool started = gl::start_indexed_file(path, 64);
+    for (int i = 0; i < 10; ++i) {
+        l(i);
+        log_from_function(i);
+    }
+    std::cout << "no call site" << std::endl;
+    std::string two_lines = "a\nb";
+    l(two_lines);
+    gl::stop_indexed_file();
+    std::string log = read_file(path);
+    std::cout << started << ' ' << log.substr(0, log.find('\n')) << std::endl;
+
+    // Read index
+    gl::LogIndex index;
+    std::cout << index.open(path + ".idx") << std::endl;
+    print_index(index, log);
+    std::cout << index.matches(0, "log_index.cpp:*") << ' '
+              << index.matches(1, "log_from_*") << ' '
+              << index.matches(1, "main") << std::endl;
+
+    // Select by site and time
+    std::vector<size_t> all = index.select(INT64_MIN, INT64_MAX, "");
+    std::vector<size_t> fn = index.select(INT64_MIN, INT64_MAX, "log_from_*");
+    std::vector<size_t> none =
+        index.select(index.checkpoints().back().last_ns + 1, INT64_MAX, "");
+    size_t with_fn = 0;
+    for (const gl::IndexCheckpoint& c : index.checkpoints()) {
+        for (const auto& sc : c.counts) {
+            with_fn += sc.first == 1;
+        }
+    }
+    std::cout << all.size() << ' ' << fn.size() << ' ' << with_fn << ' '
+              << none.size() << std::endl;
+
+    // Chunks also end after an interval
+    gl::start_indexed_file(path, 1 << 20, std::chrono::milliseconds(0));
+    l(path);
+    l(path);
+    gl::stop_indexed_file();
+    index.open(path + ".idx");
+    print_index(index, read_file(path));
+
+    // Record cut short is ignored
+    std::string idx = read_file(path + ".idx");
+    std::ofstream(path + ".idx", std::ios::binary)
+        << idx.substr(0, idx.size() - 3);
+    std::cout << index.open(path + ".idx") << ' '
+              << index.checkpoints().size() << std::endl;
+    std::cout << index.open("no_such_file.idx") << std::endl;
+
+    // Lines are attributed to their call sites whatever the prefixes, and not
+    // by their text
+    gl::set_prefixes(gl::prefix::FUNCTION);
+    gl::start_indexed_file(path, 64);
+    for (int i = 0; i < 3; ++i) {
+        log_from_function(i);
+    }
+    std::string text = "log_from_function(): i = 3";
+    l(text);
+    gl::stop_indexed_file();
+    gl::set_prefixes(gl::prefix::NONE);
+    index.open(path + ".idx");
+    log                     = read_file(path);
+    std::vector<bool> match = index.matching("log_from_*");
+    for (size_t c : index.select(INT64_MIN, INT64_MAX, "log_from_*")) {
+        const gl::IndexCheckpoint& cp = index.checkpoints()[c];
+        gl::LogIndex::for_each_line(log.data() + cp.offset, cp,
+            [&match](const char* s, size_t n, uint32_t id) {
+                if (id < match.size() && match[id]) {
+                    std::cout << std::string(s, n) << std::endl;
+                }
+            });
+    }
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,198 @@
+#include "goinglogging.h"
+#include "goinglogging/lz4_sink.h"
+#include "test/test.h"
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * Test compression to the LZ4 frame format.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Decompress LZ4 block.
+ *
+ * \param src Compressed bytes [\p n].
+ * \param n   Number of bytes.
+ * \param out Decompressed bytes. Appended to.
+ * \return \c false if invalid.
+ */
+bool decompress_block(const unsigned char* src, size_t n, std::string& out) {
+    const unsigned char* end   = src + n;
+    size_t               start = out.size();
+    while (src < end) {
+        unsigned token  = *src++;
+        size_t   n_lit  = token >> 4;
+        size_t   n_copy = (token & 15) + 4;
+        if (n_lit == 15) {
+            while (src < end && *src == 255) {
+                n_lit += *src++;
+            }
+            n_lit += src < end ? *src++ : 0;
+        }
+        if (static_cast<size_t>(end - src) < n_lit) {
+            return false;
+        }
+        out.append(reinterpret_cast<const char*>(src), n_lit);
+        src += n_lit;
+        if (src == end) {
+            return true;
+        }
+        if (end - src < 2) {
+            return false;
+        }
+        size_t offset = src[0] | static_cast<size_t>(src[1]) << 8;
+        src += 2;
+        if ((token & 15) == 15) {
+            while (src < end && *src == 255) {
+                n_copy += *src++;
+            }
+            n_copy += src < end ? *src++ : 0;
+        }
+        if (offset == 0 || offset > out.size() - start) {
+            return false;
+        }
+        for (size_t i = 0; i < n_copy; ++i) {
+            out.push_back(out[out.size() - offset]);
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Decompress LZ4 frame as written by gl::Lz4Streambuf.
+ *
+ * \param frame Frame.
+ * \param out   Decompressed bytes.
+ * \return Number of blocks, or -1 if invalid.
+ */
+int decompress_frame(const std::string& frame, std::string& out) {
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(frame.data());
+    const unsigned char* end = p + frame.size();
+    if (frame.size() < 11 || gl::internal::read_le32(p) != 0x184D2204U ||
+        p[6] != ((gl::internal::xxh32(p + 4, 2, 0) >> 8) & 0xFF)) {
+        return -1;
+    }
+    p += 7;
+    int blocks = 0;
+    while (end - p >= 4) {
+        uint32_t size = gl::internal::read_le32(p);
+        p += 4;
+        if (size == 0) {
+            return p == end ? blocks : -1;
+        }
+        uint32_t n = size & 0x7FFFFFFFU;
+        if (static_cast<uint32_t>(end - p) < n) {
+            return -1;
+        }
+        if ((size & 0x80000000U) != 0) {
+            out.append(reinterpret_cast<const char*>(p), n);
+        } else if (!decompress_block(p, n, out)) {
+            return -1;
+        }
+        p += n;
+        ++blocks;
+    }
+    return -1;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Known xxHash32 values
+    const unsigned char abc[] = "abc";
+    const unsigned char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::cout << std::hex << gl::internal::xxh32(abc, 0, 0) << ' '
+              << gl::internal::xxh32(abc, 3, 0) << ' '
+              << gl::internal::xxh32(alphabet, 36, 0) << std::dec
+              << std::endl;
+
+    // Empty frame
+    std::ostringstream empty;
+    gl::start_lz4_sink(empty);
+    gl::stop_lz4_sink();
+    std::string out;
+    std::cout << empty.str().size() << ' '
+              << decompress_frame(empty.str(), out) << std::endl;
+
+    // Container dumps over several blocks, from several threads, with an
+    // incompressible line and a line longer than a block
+    std::ostringstream compressed;
+    std::ostringstream expected;
+    std::string        noise(1000, ' ');
+    uint32_t           x = 1;
+    for (char& c : noise) {
+        x = x * 1664525U + 1013904223U;
+        c = static_cast<char>('!' + (x >> 24) % 90);
+    }
+    std::string long_line(100000, 'a');
+    for (size_t i = 0; i < long_line.size(); i += 7) {
+        long_line[i] = 'b';
+    }
+    gl::start_lz4_sink(compressed);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i]() {
+            std::vector<int> v(16, i);
+            for (int j = 0; j < 1000; ++j) {
+                v[static_cast<size_t>(j % 16)] = j;
+                l(v);
+            }
+        });
+    }
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    l(noise, long_line);
+    gl::stop_lz4_sink();
+
+    // Expected number of lines
+    out.clear();
+    int blocks = decompress_frame(compressed.str(), out);
+    std::istringstream lines(out);
+    std::string        line;
+    int                n = 0;
+    while (std::getline(lines, line)) {
+        ++n;
+    }
+    expected << "noise = \"" << noise << "\", long_line = \"" << long_line
+             << "\"\n";
+    const gl::Lz4Streambuf& stats = gl::lz4_sink_stats();
+    std::cout << (blocks > 2) << ' ' << n << ' '
+              << (out.size() >= expected.str().size() &&
+                     out.compare(out.size() - expected.str().size(),
+                         std::string::npos, expected.str()) == 0)
+              << ' ' << (stats.input_bytes() == out.size()) << ' '
+              << (stats.output_bytes() ==
+                     empty.str().size() + compressed.str().size())
+              << ' ' << (stats.compression_ratio() > 3.0) << ' '
+              << (stats.throughput() > 0.0) << std::endl;
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,143 @@
+#include "goinglogging.h"
+#include "goinglogging/npy.h"
+#include "test/test.h"
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Test dumping of arrays and matrices to .npy files.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Struct with array member.
+ */
+struct Holder {
+    float v[2]; /**< Values. */
+};
+
+/**
+ * \brief Get path of .npy file of this file.
+ *
+ * \param name Variable name.
+ * \param line Line of call site.
+ * \param seq  Sequence number.
+ * \return Path.
+ */
+std::string npy_path(const char* name, int line, int seq) {
+    return gl::get_npy_directory() + name + ".npy.cpp." +
+           std::to_string(line) + '.' + std::to_string(seq) + ".npy";
+}
+
+/**
+ * \brief Print header of .npy file, check that its data equals the bytes
+ * given, and remove it.
+ *
+ * \param path Path of file.
+ * \param data Expected data.
+ * \param n    Number of bytes of \p data.
+ */
+void check_file(const std::string& path, const void* data, size_t n) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::string   s((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path.c_str());
+    if (s.size() < 10 || s.compare(0, 8, "\x93NUMPY\x01\x00", 8) != 0) {
+        std::cout << path << ": no header" << std::endl;
+        return;
+    }
+    size_t len = static_cast<unsigned char>(s[8]) |
+                 static_cast<size_t>(static_cast<unsigned char>(s[9])) << 8;
+    std::string dict = s.substr(10, len);
+    dict.erase(dict.find_last_not_of(" \n") + 1);
+    std::cout << dict << ' ' << ((10 + len) % 64 == 0) << ' '
+              << (s.size() == 10 + len + n &&
+                     std::memcmp(s.data() + 10 + len, data, n) == 0)
+              << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Arrays, with type from element
+    double a[] = {0.5, 1.5, 2.5};
+    l_npy(a, 3);
+    check_file(npy_path("a", __LINE__ - 1, 0), a, sizeof(a));
+    bool b[] = {true, false};
+    l_npy(b, 2);
+    check_file(npy_path("b", __LINE__ - 1, 1), b, sizeof(b));
+    std::vector<std::complex<float>> c = {{1, 2}, {3, 4}};
+    l_npy(c, 2);
+    check_file(npy_path("c", __LINE__ - 1, 2), c.data(), 2 * sizeof(c[0]));
+    Holder h = {{1.0f, 2.0f}};
+    l_npy(h.v, 2);
+    check_file(npy_path("h_v", __LINE__ - 1, 3), h.v, sizeof(h.v));
+
+    // Elements not adjacent in memory
+    std::deque<uint16_t> dq(5000);
+    for (size_t i = 0; i < dq.size(); ++i) {
+        dq[i] = static_cast<uint16_t>(i);
+    }
+    std::vector<uint16_t> flat(dq.begin(), dq.end());
+    l_npy(dq, 5000);
+    check_file(npy_path("dq", __LINE__ - 1, 4), flat.data(), 2 * flat.size());
+
+    // Matrices, contiguous and by rows
+    int m[2][3] = {{11, 12, 13}, {21, 22, 23}};
+    l_npy_mat(m, 3, 2);
+    check_file(npy_path("m", __LINE__ - 1, 5), m, sizeof(m));
+    int8_t  r0[] = {1, 2};
+    int8_t  r1[] = {3, 4};
+    int8_t* r[]  = {r1, r0};
+    int8_t  rf[] = {3, 4, 1, 2};
+    l_npy_mat(r, 2, 2);
+    check_file(npy_path("r", __LINE__ - 1, 6), rf, sizeof(rf));
+    l_npy(a, 0);
+    check_file(npy_path("a", __LINE__ - 1, 7), a, 0);
+
+    // Directory, and failure
+    gl::set_npy_directory("./");
+    std::cout << gl::get_npy_directory() << std::endl;
+    l_npy(a, 1);
+    check_file(npy_path("a", __LINE__ - 1, 8), a, sizeof(a[0]));
+    gl::set_npy_directory("no_such_directory");
+    l_npy(a, 1);
+    gl::set_npy_directory("");
+
+    // JSON
+    gl::set_format(gl::format::JSON);
+    l_npy_mat(m, 3, 2);
+    gl::set_format(gl::format::TEXT);
+    check_file(npy_path("m", __LINE__ - 2, 10), m, sizeof(m));
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,62 @@
+#include "goinglogging/core.h"
+#include "goinglogging/sequence.h"
+#include "goinglogging/structured.h"
+#include "test/test.h"
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Test the core header with opt-in sequence formatters, linked to the
+ * precompiled library.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Instantiated by the library
+    bool                     b  = true;
+    int                      i  = -1;
+    const unsigned long      ul = 2;
+    double                   d  = 0.5;
+    std::string              s("s");
+    std::vector<int>         vi{1, 2, 3};
+    std::vector<double>      vd{0.25};
+    std::vector<std::string> vs{"a", "b"};
+    l(b, i, ul, d, s);
+    l(vi, vd, vs);
+
+    // Instantiated here
+    std::vector<char>   vc{'c'};
+    std::vector<size_t> vz{4, 5};
+    l(vc, vz);
+
+    // Formats and settings are shared with the library
+    gl::set_format(gl::format::JSON);
+    l(i, vi);
+    gl::set_format(gl::format::TEXT);
+    gl::set_prefixes(gl::prefix::TYPE_NAME);
+    l(i, vi);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
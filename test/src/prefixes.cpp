@@ -21,6 +21,14 @@ using namespace gl::test;
          (v)           = static_cast<gl::prefix>(      \
              static_cast<uint32_t>((v)) + static_cast<uint32_t>((p))))
 
+/**
+ * \brief Log with a function name too long to be cached.
+ */
+void log_from_a_function_with_a_name_which_is_longer_than_the_cache_of_rendered_prefixes_of_each_call_site_so_that_its_prefix_is_always_rendered() {
+    int j = 1;
+    l(j);
+}
+
 /**
  * \brief Test entry point.
  *
@@ -67,6 +75,12 @@ int main(int argc, const char** argv) {
         }
     }
 
+    // Uncached prefix
+    gl::set_prefixes(gl::prefix::FUNCTION | gl::prefix::THREAD);
+    for (int k = 0; k < 2; ++k) {
+        log_from_a_function_with_a_name_which_is_longer_than_the_cache_of_rendered_prefixes_of_each_call_site_so_that_its_prefix_is_always_rendered();
+    }
+
     // Compare output
     return t.compare_output(Test::ComparisonMode::REGEX);
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#define GL_PROFILE
+#include "goinglogging.h"
+#include "test/test.h"
+#include <iostream>
+#include <ostream>
+
+/**
+ * \file
+ * Test profiling of call sites with GL_PROFILE.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Expensive call site
+    int a[1000] = {0};
+    for (int i = 0; i < 10; ++i) {
+        l_arr(a, 1000);
+    }
+
+    // Call site which is suppressed once
+    int i = 5;
+    for (int j = 0; j < 3; ++j) {
+        gl::set_output_enabled(j != 1);
+        l(i);
+    }
+
+    gl::print_profile(std::cout);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::REGEX);
+}
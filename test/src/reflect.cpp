@@ -0,0 +1,112 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * Test formatting of types declared with GL_REFLECT.
+ */
+
+using namespace gl::test;
+
+namespace geo {
+
+/**
+ * \brief Point with fields of several types.
+ */
+struct Point {
+    int                 x;       /**< X coordinate. */
+    double              y;       /**< Y coordinate. */
+    std::string         label;   /**< Label. */
+    std::vector<double> weights; /**< Weights. */
+};
+GL_REFLECT(Point, x, y, label, weights)
+
+/**
+ * \brief Line, with reflected fields.
+ */
+class Line {
+  public:
+    Point from; /**< Start. */
+    Point to;   /**< End. */
+    bool  bold; /**< Drawn in bold. */
+};
+GL_REFLECT(Line, from, to, bold)
+
+/**
+ * \brief Type which is both reflected and has a stream insertion operator.
+ */
+struct Both {
+    int i; /**< Value. */
+};
+GL_REFLECT(Both, i)
+
+/**
+ * \brief Insert into stream.
+ *
+ * \param os Output stream.
+ * \return Output stream.
+ */
+std::ostream& operator<<(std::ostream& os, const Both&) {
+    return os << "<Both>";
+}
+
+} // namespace geo
+
+/**
+ * \brief Type in the global namespace, with 16 fields.
+ */
+struct Wide {
+    char a, b, c, d, e, f, g, h, i, j, k, m, n, o, p, q; /**< Fields. */
+};
+GL_REFLECT(Wide, a, b, c, d, e, f, g, h, i, j, k, m, n, o, p, q)
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Fields, nested types and containers
+    geo::Point       p  = {1, 2.5, "p", {0.5, 1.5}};
+    const geo::Point cp = {-1, 0.0, "", {}};
+    geo::Line        ln = {p, cp, true};
+    l(p, cp, ln);
+    std::vector<geo::Point>            v = {p, cp};
+    std::map<std::string, geo::Point>  m = {{"origin", cp}};
+    geo::Point                         a[] = {p, cp};
+    l(v, m);
+    l_arr(a, 2);
+
+    // Reflection before stream insertion operator, and many fields
+    geo::Both b = {3};
+    Wide      w = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'm',
+        'n', 'o', 'p', 'q'};
+    l(b, w);
+
+    // JSON
+    gl::set_format(gl::format::JSON);
+    l(ln, m);
+    gl::set_format(gl::format::TEXT);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,134 @@
+#include "goinglogging.h"
+#include "goinglogging/shm_bus.h"
+#include "test/test.h"
+#include <cstdio>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * Test logging to a shared memory log bus from several processes.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Read and print all messages not read yet, with writer process.
+ *
+ * \param reader Reader.
+ * \param parent Process ID of this process.
+ */
+void print_messages(gl::internal::ShmBusReader& reader, uint32_t parent) {
+    std::string msg;
+    uint32_t    pid = 0;
+    while (reader.next(msg, pid) ==
+           gl::internal::ShmBusReader::result::MESSAGE) {
+        std::cout << (pid == parent ? "parent: " : "child: ") << msg
+                  << std::endl;
+    }
+    std::cout << "lost = " << reader.take_lost() << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    const std::string name =
+        "/goinglogging_test_" + std::to_string(getpid());
+    const uint32_t parent = static_cast<uint32_t>(getpid());
+    shm_unlink(name.c_str());
+
+    // Small bus with 16 slots of 48 bytes of data each
+    bool started = gl::start_shm_bus(name, 16, 64);
+    for (int i = 0; i < 2; ++i) {
+        l(i);
+    }
+    std::string s(100, 's');
+    l(s);
+
+    // From another process
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        int c = 1;
+        l(c);
+        std::cout.flush();
+        _exit(0);
+    }
+    waitpid(child, nullptr, 0);
+    gl::stop_shm_bus();
+
+    gl::internal::ShmBusReader reader;
+    std::cout << started << ' ' << reader.open(name) << std::endl;
+    print_messages(reader, parent);
+
+    // Overrun, with 20 messages in 16 slots
+    gl::start_shm_bus(name);
+    for (int i = 0; i < 20; ++i) {
+        l(i);
+    }
+    gl::stop_shm_bus();
+    print_messages(reader, parent);
+
+    // Several threads
+    shm_unlink(name.c_str());
+    gl::start_shm_bus(name, 8192);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i]() {
+            for (int seq = 0; seq < 1000; ++seq) {
+                l(i, seq);
+            }
+        });
+    }
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    gl::stop_shm_bus();
+    gl::internal::ShmBusReader reader2;
+    reader2.open(name);
+    std::vector<int> next(4, 0);
+    std::string      msg;
+    uint32_t         pid     = 0;
+    int              n       = 0;
+    bool             ordered = true;
+    while (reader2.next(msg, pid) ==
+           gl::internal::ShmBusReader::result::MESSAGE) {
+        int i   = -1;
+        int seq = -1;
+        if (std::sscanf(msg.c_str(), "i = %d, seq = %d", &i, &seq) != 2 ||
+            i < 0 || i >= 4 || seq != next[i]++) {
+            ordered = false;
+        }
+        ++n;
+    }
+    std::cout << n << ' ' << ordered << ' ' << reader2.take_lost()
+              << std::endl;
+    shm_unlink(name.c_str());
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
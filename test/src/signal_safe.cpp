@@ -0,0 +1,192 @@
+#include "goinglogging.h"
+#include "goinglogging/signal_safe.h"
+#include "test/test.h"
+#include <atomic>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * Test async-signal-safe logging, also from signal handlers which interrupt
+ * heavy logging.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Enum to log.
+ */
+enum class Color { RED = 1, GREEN = -2 };
+
+/** Number of signals handled. */
+static std::atomic<int> handled(0);
+
+/**
+ * \brief Signal handler which logs.
+ *
+ * \param sig Signal.
+ */
+void on_signal(int sig) {
+    int n = handled.fetch_add(1) + 1;
+    l_signal_safe(sig, n);
+}
+
+/**
+ * \brief Stream buffer which discards everything.
+ */
+class NullStreambuf : public std::streambuf {
+  protected:
+    /**
+     * \param c Character.
+     * \return \p c.
+     */
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+};
+
+/**
+ * \brief Print and clear everything written to file.
+ *
+ * \param fd File descriptor.
+ */
+void print_written(int fd) {
+    std::string s;
+    char        buf[256];
+    ssize_t     n = 0;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        s.append(buf, static_cast<size_t>(n));
+    }
+    std::cout << s;
+    if (ftruncate(fd, 0) != 0) {
+        std::cout << "ftruncate failed" << std::endl;
+    }
+    lseek(fd, 0, SEEK_SET);
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    char path[] = "tmp_signal_safe_XXXXXX";
+    int  fd     = mkstemp(path);
+    unlink(path);
+    gl::set_signal_safe_fd(fd);
+    std::cout << (gl::get_signal_safe_fd() == fd) << std::endl;
+
+    // Supported types
+    int                i   = -12;
+    long long          ll  = LLONG_MIN;
+    unsigned long long ull = ULLONG_MAX;
+    bool               b   = true;
+    char               c   = 'c';
+    Color              col = Color::GREEN;
+    const char*        s   = "s";
+    char*              np  = nullptr;
+    char               arr[8] = "arr";
+    int*               p   = reinterpret_cast<int*>(0x1f00);
+    l_signal_safe(i, ll, ull);
+    l_signal_safe(b, c, col, s, np, arr, p);
+
+    // Prefixes other than FILE, LINE and FUNCTION are not written
+    gl::set_prefixes(gl::prefix::LINE | gl::prefix::FUNCTION |
+                     gl::prefix::TIME | gl::prefix::THREAD);
+    l_signal_safe(i);
+    gl::set_prefixes(gl::prefix::NONE);
+
+    // Truncated, and disabled
+    std::string long_str(600, 'x');
+    const char* ls = long_str.c_str();
+    l_signal_safe(ls);
+    gl::set_output_enabled(false);
+    l_signal_safe(i);
+    gl::set_output_enabled(true);
+    print_written(fd);
+
+    // Signals to threads which log heavily. Each signal must be logged once,
+    // and nothing may deadlock.
+    NullStreambuf   null_buf;
+    std::streambuf* out = std::cout.rdbuf(&null_buf);
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, nullptr);
+    alarm(60); // Kill the test if it deadlocks
+    std::atomic<bool>        stop(false);
+    std::vector<std::thread> threads;
+    for (int j = 0; j < 2; ++j) {
+        threads.emplace_back([&stop]() {
+            std::vector<int> v(32, 1);
+            std::string      str("logging");
+            while (!stop.load()) {
+                l(v, str);
+            }
+        });
+    }
+    const int signals = 200;
+    int       sent    = 0;
+    while (sent < signals) {
+        for (std::thread& th : threads) {
+            int before = handled.load();
+            pthread_kill(th.native_handle(), SIGUSR1);
+            ++sent;
+            while (handled.load() == before) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    stop.store(true);
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    alarm(0);
+    std::cout.rdbuf(out);
+
+    // Count the lines written by the signal handlers
+    std::string written;
+    char        buf[4096];
+    ssize_t     n = 0;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        written.append(buf, static_cast<size_t>(n));
+    }
+    size_t lines = 0;
+    for (char ch : written) {
+        lines += ch == '\n' ? 1 : 0;
+    }
+    std::cout << (handled.load() == signals) << ' '
+              << (lines == static_cast<size_t>(signals)) << std::endl;
+    close(fd);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,174 @@
+#define GL_STATIC_KEYS
+#include "goinglogging.h"
+#include "goinglogging/sink.h"
+#include "test/test.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * Test enabling and disabling call sites compiled to patchable jumps, while
+ * other threads run them.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Stream buffer which counts lines.
+ */
+class CountingStreambuf : public gl::internal::LineStreambuf {
+  public:
+    /**
+     * \brief Constructor.
+     */
+    CountingStreambuf() : lines(0) {}
+
+    std::atomic<uint64_t> lines; /**< Number of lines. */
+
+  protected:
+    /**
+     * \brief Count line.
+     */
+    void write_line(const char*, size_t) override {
+        lines.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * \brief Log from a function, to have a call site with its own name.
+ *
+ * \param i Value to log.
+ */
+GL_INTERNAL_NOINLINE void hot_function(int i) {
+    l(i);
+}
+
+/**
+ * \brief Log from a function which is first called after its site is
+ * disabled.
+ *
+ * \param j Value to log.
+ */
+GL_INTERNAL_NOINLINE void cold_function(int j) {
+    l(j);
+}
+
+/**
+ * \brief Get instruction of the call sites of a function.
+ *
+ * \param func Function name.
+ * \return "jump", "nop", "mixed", or "jump" if not patchable.
+ */
+std::string instruction(const char* func) {
+    std::string s;
+#ifdef GL_INTERNAL_STATIC_KEYS
+    for (const gl::internal::StaticSite* p =
+             gl::internal::__start_gl_static_sites;
+         p != gl::internal::__stop_gl_static_sites; ++p) {
+        if (std::strcmp(p->log_site()->prefix().get_function_name(), func) !=
+            0) {
+            continue;
+        }
+        uint32_t insn = 0;
+        std::memcpy(&insn, reinterpret_cast<const void*>(p->code_address()),
+            sizeof(insn));
+#if defined(__x86_64__)
+        bool jump = (insn & 0xff) == 0xe9;
+#else
+        bool jump = (insn & 0xfc000000u) == 0x14000000u;
+#endif // __x86_64__
+        std::string i = jump ? "jump" : "nop";
+        s             = s.empty() || s == i ? i : "mixed";
+    }
+#else
+    (void)func;
+    s = "jump";
+#endif // GL_INTERNAL_STATIC_KEYS
+    return s;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Sites compile to jumps, and log as usual
+    std::cout << instruction("hot_function") << std::endl;
+    int i = 1;
+    l(i);
+
+    // Enable and disable while other threads run the site
+    CountingStreambuf        counter;
+    std::streambuf*          prev = std::cout.rdbuf(&counter);
+    std::atomic<bool>        stop(false);
+    std::vector<std::thread> threads;
+    for (int n = 0; n < 4; ++n) {
+        threads.emplace_back([&stop, n]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                hot_function(n);
+            }
+        });
+    }
+    for (int n = 0; n < 2000; ++n) {
+        gl::set_sites_enabled("hot_function", n % 2 == 0);
+    }
+    stop = true;
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    std::cout.rdbuf(prev);
+    std::cout << instruction("hot_function") << std::endl;
+
+    // Disabled sites write nothing, and enabled sites everything
+    std::cout.rdbuf(&counter);
+    uint64_t before = counter.lines;
+    for (int n = 0; n < 100; ++n) {
+        hot_function(n);
+    }
+    uint64_t disabled = counter.lines - before;
+    gl::set_sites_enabled("hot_*", true);
+    for (int n = 0; n < 100; ++n) {
+        hot_function(n);
+    }
+    uint64_t enabled = counter.lines - before - disabled;
+    std::cout.rdbuf(prev);
+    std::cout << disabled << ' ' << enabled << ' '
+              << instruction("hot_function") << std::endl;
+
+    // Sites disabled before their first use
+    gl::set_sites_enabled("cold_function", false);
+    std::cout << instruction("cold_function") << std::endl;
+    cold_function(1);
+    gl::set_sites_enabled("cold_function", true);
+    cold_function(2);
+
+    // Rate limits still apply
+    gl::set_rate_limit("main", 1);
+    for (int n = 0; n < 3; ++n) {
+        l(n);
+    }
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,106 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/**
+ * \file
+ * Test escaping and truncation of strings.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Write bytes as hexadecimal.
+ *
+ * \param s Bytes.
+ */
+void print_hex(const std::string& s) {
+    char buf[4];
+    for (size_t i = 0; i < s.size(); ++i) {
+        std::snprintf(buf, sizeof(buf), "%02x",
+            static_cast<unsigned>(static_cast<unsigned char>(s[i])));
+        std::cout << buf << (i + 1 < s.size() ? " " : "\n");
+    }
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Escaped in text if enabled, including a null character
+    std::string                s  = std::string("a\"b\\c\nd\te\r\x01\x7f", 13);
+    const char*                cs = "x\ny";
+    char                       ca[] = "\x1b[0m";
+    char*                      cp = ca;
+    const char*                np = nullptr;
+    std::map<const char*, int> m  = {{"k\n", 1}};
+    l(cs, np, m);
+    gl::set_escape_enabled(true);
+    std::cout << gl::is_escape_enabled() << std::endl;
+    l(s, cs, cp, np, m);
+
+    // Characters to escape at every position of SIMD blocks
+    std::string clean(40, '.');
+    for (size_t i = 0; i < clean.size(); i += 7) {
+        std::string e = clean;
+        e[i]          = '\n';
+        l(e);
+    }
+    l(clean);
+
+    // Not escaped if disabled
+    gl::set_escape_enabled(false);
+    std::string raw("r\n", 2);
+    l(raw);
+
+    // Truncated, not inside a UTF-8 sequence
+    gl::set_max_string_length(4);
+    std::cout << gl::get_max_string_length() << std::endl;
+    std::string    fits("abcd");
+    std::string    longer("abcdefgh");
+    std::string    utf8("abc\xc3\xa9");
+    std::u16string u16(300, u'x');
+    std::wstring   w(300, L'\x20ac');
+    l(fits, longer, utf8, u16, w);
+    gl::set_escape_enabled(true);
+    std::string esc("\n\n\n\n\n");
+    l(esc);
+    gl::set_escape_enabled(false);
+
+    // Truncated in JSON and CBOR
+    gl::set_format(gl::format::JSON);
+    l(longer, u16);
+    gl::set_format(gl::format::CBOR);
+    std::ostringstream ss;
+    std::streambuf*    out = std::cout.rdbuf(ss.rdbuf());
+    l(longer);
+    std::cout.rdbuf(out);
+    gl::set_format(gl::format::TEXT);
+    print_hex(ss.str());
+    gl::set_max_string_length(0);
+    l(longer);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
@@ -0,0 +1,131 @@
+#include "goinglogging.h"
+#include "test/test.h"
+#include <cstdio>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/**
+ * \file
+ * Test transcoding of wide and Unicode strings to UTF-8.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Write bytes as hexadecimal.
+ *
+ * \param s Bytes.
+ */
+void print_hex(const std::string& s) {
+    char buf[4];
+    for (size_t i = 0; i < s.size(); ++i) {
+        std::snprintf(buf, sizeof(buf), "%02x",
+            static_cast<unsigned>(static_cast<unsigned char>(s[i])));
+        std::cout << buf << (i + 1 < s.size() ? " " : "\n");
+    }
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // One, two, three and four bytes, and a surrogate pair
+    std::u16string u16 = u"aé€\U0001F600";
+    std::u32string u32 = U"aé€\U0001F600";
+    std::wstring   w   = L"aé€\U0001F600";
+    l(u16, u32, w);
+
+    // Unpaired surrogates and code units which are not code points
+    std::u16string bad16;
+    bad16 += static_cast<char16_t>(0xD800);
+    bad16 += u"a";
+    bad16 += static_cast<char16_t>(0xDC00);
+    bad16 += static_cast<char16_t>(0xD83D);
+    std::u32string bad32;
+    bad32 += static_cast<char32_t>(0xD800);
+    bad32 += static_cast<char32_t>(0x110000);
+    bad32 += U"b";
+    l(bad16, bad32);
+
+    // Longer than a transcoding chunk, with non-ASCII inside SIMD blocks
+    std::u16string long16(1000, u'x');
+    std::u32string long32(1000, U'y');
+    std::string    expected16(1000, 'x');
+    std::string    expected32(1000, 'y');
+    for (size_t i = 13; i < 1000; i += 97) {
+        long16[i] = u'é';
+        long32[i] = U'\U0001F600';
+        expected16.replace(i + (i / 97) * 1, 1, "\xc3\xa9");
+        expected32.replace(i + (i / 97) * 3, 1, "\xf0\x9f\x98\x80");
+    }
+    std::ostringstream ss;
+    std::streambuf*    out = std::cout.rdbuf(ss.rdbuf());
+    l(long16, long32);
+    std::cout.rdbuf(out);
+    std::cout << (ss.str() == "long16 = \"" + expected16 +
+                                  "\", long32 = \"" + expected32 + "\"\n")
+              << std::endl;
+
+    // Streams
+    std::wstringbuf     wsb(L"wsbé");
+    std::wostringstream woss(L"wossé");
+    std::wstringstream  wss(L"wssé");
+    l(wsb, woss, wss);
+
+    // JSON escapes, also in a long string
+    gl::set_format(gl::format::JSON);
+    std::u16string esc = u"\"\\\né";
+    l(esc);
+    // Invalid UTF-8 replaced by U+FFFD: an invalid byte, a truncated
+    // sequence and an encoded surrogate
+    std::string bad = "a\xff"
+                      "b\xe2\x82"
+                      "c\xed\xa0\x80"
+                      "d";
+    l(bad);
+    ss.str("");
+    out = std::cout.rdbuf(ss.rdbuf());
+    l(long16);
+    std::cout.rdbuf(out);
+    std::cout << (ss.str() == "{\"values\":{\"long16\":\"" + expected16 +
+                                  "\"}}\n")
+              << std::endl;
+
+    // CBOR, definite length if short and indefinite length if long
+    gl::set_format(gl::format::CBOR);
+    ss.str("");
+    out = std::cout.rdbuf(ss.rdbuf());
+    l(u16);
+    std::cout.rdbuf(out);
+    print_hex(ss.str());
+    ss.str("");
+    out = std::cout.rdbuf(ss.rdbuf());
+    l(long32);
+    std::cout.rdbuf(out);
+    gl::set_format(gl::format::TEXT);
+    const std::string cbor = ss.str();
+    size_t            pos  = cbor.find(static_cast<char>(0x7f));
+    print_hex(cbor.substr(pos, 4));
+    print_hex(cbor.substr(cbor.size() - 3));
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
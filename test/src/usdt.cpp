@@ -0,0 +1,176 @@
+#define GL_STATIC_KEYS
+#define GL_USDT
+#include "goinglogging.h"
+#include "test/test.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+
+/**
+ * \file
+ * Test that call sites are USDT probes, by reading the ELF notes of the
+ * executable, and that messages are only formatted while a tracer is
+ * attached, and then once, also for call sites patched to no-ops.
+ */
+
+using namespace gl::test;
+
+/**
+ * \brief Type which counts how many times it is formatted.
+ */
+struct Counted {
+    int formatted; /**< Number of times formatted. */
+};
+
+/**
+ * \brief Insert into stream, and count.
+ *
+ * \param os Output stream.
+ * \param c  Counted.
+ * \return Output stream.
+ */
+std::ostream& operator<<(std::ostream& os, Counted& c) {
+    return os << ++c.formatted;
+}
+
+/**
+ * \brief Print probes of provider goinglogging in notes of ELF file.
+ *
+ * \param path Path of ELF file.
+ */
+void print_probes(const char* path) {
+    std::ifstream     f(path, std::ios::binary);
+    std::vector<char> obj(
+        (std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (obj.size() < sizeof(Elf64_Ehdr) ||
+        std::memcmp(obj.data(), ELFMAG, SELFMAG) != 0 ||
+        obj[EI_CLASS] != ELFCLASS64) {
+        std::cout << "not a 64-bit ELF file" << std::endl;
+        return;
+    }
+    Elf64_Ehdr eh;
+    std::memcpy(&eh, obj.data(), sizeof(eh));
+    std::vector<Elf64_Shdr> sh(eh.e_shnum);
+    std::memcpy(sh.data(), obj.data() + eh.e_shoff,
+        sh.size() * sizeof(Elf64_Shdr));
+    const char* names = obj.data() + sh[eh.e_shstrndx].sh_offset;
+
+    // Notes of type 3 in .note.stapsdt, with descriptor of probe address,
+    // base address, semaphore address, provider, name and arguments
+    unsigned                 probes = 0;
+    std::vector<std::string> args;
+    std::vector<uint64_t>    semaphores;
+    uint64_t                 probes_section = 0;
+    for (const Elf64_Shdr& s : sh) {
+        if (std::strcmp(names + s.sh_name, ".probes") == 0) {
+            probes_section = s.sh_addr;
+        }
+        if (s.sh_type != SHT_NOTE ||
+            std::strcmp(names + s.sh_name, ".note.stapsdt") != 0) {
+            continue;
+        }
+        const char* p   = obj.data() + s.sh_offset;
+        const char* end = p + s.sh_size;
+        while (p + sizeof(Elf64_Nhdr) <= end) {
+            Elf64_Nhdr nh;
+            std::memcpy(&nh, p, sizeof(nh));
+            const char* name = p + sizeof(nh);
+            const char* desc = name + ((nh.n_namesz + 3) & ~3u);
+            p                = desc + ((nh.n_descsz + 3) & ~3u);
+            if (nh.n_type != 3 || std::strcmp(name, "stapsdt") != 0) {
+                continue;
+            }
+            uint64_t sem = 0;
+            std::memcpy(&sem, desc + 16, sizeof(sem));
+            const char* provider = desc + 24;
+            const char* probe    = provider + std::strlen(provider) + 1;
+            const char* arg      = probe + std::strlen(probe) + 1;
+            if (std::strcmp(provider, "goinglogging") == 0 &&
+                std::strcmp(probe, "log") == 0) {
+                ++probes;
+                args.push_back(arg);
+                semaphores.push_back(sem);
+            }
+        }
+    }
+
+    // Every site has a probe, with five arguments of 8 bytes, the line being
+    // signed, and all share one semaphore in section .probes
+    bool ok = !args.empty();
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        size_t             n = 0;
+        for (size_t pos = 0; (pos = a.find('@', pos)) != std::string::npos;
+             ++pos) {
+            ++n;
+        }
+        ok = ok && n == 5 && a.compare(0, 2, "8@") == 0 &&
+             a.find(" -8@") != std::string::npos &&
+             semaphores[i] == semaphores[0];
+    }
+    std::cout << (probes >= 4) << ' ' << ok << ' '
+              << (ok && probes_section != 0 &&
+                     semaphores[0] >= probes_section)
+              << std::endl;
+}
+
+/**
+ * \brief Test entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if success.
+ */
+int main(int argc, const char** argv) {
+    // Check number of arguments
+    if (argc != 1) {
+        std::cout << "Usage: " << *argv << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Disable prefixes for easier output comparison.
+    gl::set_prefixes(gl::prefix::NONE);
+
+    Test t;
+    t.setup(__FILE__);
+
+    // Probes in the executable
+    print_probes("/proc/self/exe");
+
+    // Logs as usual
+    Counted c = {0};
+    l(c);
+    int a[] = {1, 2};
+    l_arr(a, 2);
+    int m[1][2] = {{3, 4}};
+    l_mat(m, 2, 1);
+
+    // Message only formatted while a tracer is attached, even if output or
+    // the call site is disabled
+    gl::set_output_enabled(false);
+    l(c);
+    gl::internal::goinglogging_log_semaphore = 1;
+    l(c);
+    gl::set_sites_enabled("main", false);
+    l(c);
+    gl::internal::goinglogging_log_semaphore = 0;
+    gl::set_sites_enabled("main", true);
+    gl::set_output_enabled(true);
+    l(c);
+
+    // Message formatted once for both output and tracer
+    gl::internal::goinglogging_log_semaphore = 1;
+    l(c);
+    gl::internal::goinglogging_log_semaphore = 0;
+    l(c);
+
+    // Compare output
+    return t.compare_output(Test::ComparisonMode::EXACT);
+}
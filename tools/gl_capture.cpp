@@ -0,0 +1,47 @@
+#include "goinglogging.h"
+#include "goinglogging/capture.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * \file
+ * Export a file written by gl::write_capture() as CSV.
+ */
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::cerr << "Usage: " << name << " <capture file> [site pattern]\n"
+              << "  Writes each call site as CSV to stdout. The pattern is "
+                 "matched against\n"
+              << "  file:line and function name, e.g. 'main.cpp:*'.\n";
+}
+
+/**
+ * \brief Entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if the file was exported.
+ */
+int main(int argc, const char** argv) {
+    if (argc != 2 && argc != 3) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::ifstream is(argv[1], std::ios::binary);
+    if (!is) {
+        std::cerr << "Failed to open '" << argv[1] << "'\n";
+        return EXIT_FAILURE;
+    }
+    if (!gl::export_capture_csv(is, std::cout, argc == 3 ? argv[2] : "*")) {
+        std::cerr << "Invalid capture file '" << argv[1] << "'\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
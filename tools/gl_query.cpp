@@ -0,0 +1,260 @@
+#include "goinglogging.h"
+#include "goinglogging/log_index.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * Print lines of a log file written with gl::start_indexed_file(), using its
+ * index to only read the chunks of a time range or call site.
+ */
+
+/**
+ * \brief Part of log file to scan.
+ */
+struct Range {
+    uint64_t                   offset;     /**< Byte offset. */
+    uint64_t                   bytes;      /**< Bytes. */
+    const gl::IndexCheckpoint* checkpoint; /**< Checkpoint, or none. */
+    std::string                out;        /**< Matching lines. */
+};
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::cerr << "Usage: " << name << " [options] <log file>\n"
+              << "  Prints lines of a log file, using its index <log "
+                 "file>.idx.\n"
+              << "  --from <time>  Only chunks with lines at or after time\n"
+              << "  --to <time>    Only chunks with lines at or before time\n"
+              << "  --site <glob>  Only lines of call sites where file:line "
+                 "or\n"
+              << "                 function matches glob\n"
+              << "  --grep <text>  Only lines which contain text\n"
+              << "  --count        Print lines of each call site, from the "
+                 "index\n"
+              << "  -j <threads>   Scan chunks with this many threads\n"
+              << "  Times are 'YYYY-MM-DD HH:MM:SS' in local time, or "
+                 "seconds since\n"
+              << "  epoch. Chunks, not lines, are selected by time. Lines "
+                 "after the\n"
+              << "  last checkpoint are scanned as a chunk from the last "
+                 "checkpoint to\n"
+              << "  the modification time of the log file, unless --site is "
+                 "given,\n"
+              << "  since their call sites are unknown.\n";
+}
+
+/**
+ * \brief Parse time.
+ *
+ * \param s  'YYYY-MM-DD HH:MM:SS' in local time, or seconds since epoch.
+ * \param ns Time in ns since epoch.
+ * \return \c true if success.
+ */
+bool parse_time(const std::string& s, int64_t& ns) {
+    char*     end  = nullptr;
+    long long secs = std::strtoll(s.c_str(), &end, 10);
+    if (end != s.c_str() && *end == '\0') {
+        ns = secs * 1000000000LL;
+        return true;
+    }
+    std::tm tm;
+    std::memset(&tm, 0, sizeof(tm));
+    const char* rest = strptime(s.c_str(), "%Y-%m-%d %H:%M:%S", &tm);
+    if (rest == nullptr || *rest != '\0') {
+        return false;
+    }
+    tm.tm_isdst = -1;
+    ns          = static_cast<int64_t>(std::mktime(&tm)) * 1000000000LL;
+    return true;
+}
+
+/**
+ * \brief Copy lines of range which match.
+ *
+ * \param data  Log file.
+ * \param r     Range.
+ * \param match Whether each call site matches, by index, or empty for lines
+ *              of any call site.
+ * \param grep  Text to find, or empty.
+ */
+void scan(const char* data, Range& r, const std::vector<bool>& match,
+    const std::string& grep) {
+    gl::IndexCheckpoint unindexed;
+    unindexed.bytes = r.bytes;
+    gl::LogIndex::for_each_line(data + r.offset,
+        r.checkpoint != nullptr ? *r.checkpoint : unindexed,
+        [&](const char* line, size_t n, uint32_t id) {
+            if (!match.empty() && (id >= match.size() || !match[id])) {
+                return;
+            }
+            if (grep.empty() ||
+                std::search(line, line + n, grep.begin(), grep.end()) !=
+                    line + n) {
+                r.out.append(line, n);
+                r.out += '\n';
+            }
+        });
+}
+
+/**
+ * \brief Entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if the log file was read.
+ */
+int main(int argc, const char** argv) {
+    int64_t     from    = std::numeric_limits<int64_t>::min();
+    int64_t     to      = std::numeric_limits<int64_t>::max();
+    std::string site;
+    std::string grep;
+    bool        count   = false;
+    unsigned    threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool        has_value = i + 1 < argc;
+        if (arg == "--from" && has_value && parse_time(argv[i + 1], from)) {
+            ++i;
+        } else if (arg == "--to" && has_value && parse_time(argv[i + 1], to)) {
+            ++i;
+        } else if (arg == "--site" && has_value) {
+            site = argv[++i];
+        } else if (arg == "--grep" && has_value) {
+            grep = argv[++i];
+        } else if (arg == "--count") {
+            count = true;
+        } else if (arg == "-j" && has_value && std::atoi(argv[i + 1]) > 0) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (path.empty() && !arg.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (path.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gl::LogIndex index;
+    if (!index.open(path + ".idx")) {
+        std::cerr << "Failed to read index '" << path << ".idx'\n";
+        return EXIT_FAILURE;
+    }
+    std::vector<size_t> chunks = index.select(from, to, site);
+
+    // Sum lines of each call site, without reading the log file
+    if (count) {
+        std::vector<uint64_t> lines(index.sites().size() + 1, 0);
+        for (size_t c : chunks) {
+            for (const auto& sc : index.checkpoints()[c].counts) {
+                lines[sc.first < index.sites().size() ? sc.first + 1 : 0] +=
+                    sc.second;
+            }
+        }
+        for (uint32_t id = 0; id < index.sites().size(); ++id) {
+            const gl::IndexSite& s = index.sites()[id];
+            if (lines[id + 1] != 0 &&
+                (site.empty() || index.matches(id, site))) {
+                std::cout << lines[id + 1] << ' ' << s.file << ':' << s.line
+                          << ' ' << s.func << '\n';
+            }
+        }
+        if (lines[0] != 0 && site.empty()) {
+            std::cout << lines[0] << " -\n";
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Map log file
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open '" << path << "'\n";
+        return EXIT_FAILURE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        std::cerr << "Failed to read '" << path << "'\n";
+        return EXIT_FAILURE;
+    }
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    void*          map  = size == 0 ? nullptr :
+                                      mmap(nullptr, size, PROT_READ,
+                                          MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Failed to map '" << path << "'\n";
+        return EXIT_FAILURE;
+    }
+    const char* data = static_cast<const char*>(map);
+
+    // Selected chunks, and the unindexed end of the file
+    std::vector<Range> ranges;
+    for (size_t c : chunks) {
+        const gl::IndexCheckpoint& cp = index.checkpoints()[c];
+        if (cp.offset + cp.bytes <= size) {
+            ranges.push_back(Range{cp.offset, cp.bytes, &cp, std::string()});
+        }
+    }
+    // Lines of the end were written after the last checkpoint, and before
+    // the log file was last modified
+    const int64_t tail_first = index.checkpoints().empty() ?
+                                   std::numeric_limits<int64_t>::min() :
+                                   index.checkpoints().back().last_ns;
+    const int64_t tail_last =
+        static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+        st.st_mtim.tv_nsec;
+    if (index.indexed_bytes() < size && site.empty() && tail_last >= from &&
+        tail_first <= to) {
+        ranges.push_back(Range{index.indexed_bytes(),
+            size - index.indexed_bytes(), nullptr, std::string()});
+    }
+    std::vector<bool> match;
+    if (!site.empty()) {
+        match = index.matching(site);
+    }
+
+    // Scan batches of ranges in parallel, each thread taking every n:th
+    // range, and print each batch in file order
+    const size_t n     = std::min<size_t>(threads, ranges.size());
+    const size_t batch = 4 * n;
+    for (size_t first = 0; first < ranges.size(); first += batch) {
+        const size_t             last = std::min(first + batch, ranges.size());
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < n; ++t) {
+            workers.emplace_back([&, t]() {
+                for (size_t i = first + t; i < last; i += n) {
+                    scan(data, ranges[i], match, grep);
+                }
+            });
+        }
+        for (std::thread& w : workers) {
+            w.join();
+        }
+        for (size_t i = first; i < last; ++i) {
+            std::cout << ranges[i].out;
+            std::string().swap(ranges[i].out);
+        }
+    }
+    if (map != nullptr) {
+        munmap(map, size);
+    }
+    return EXIT_SUCCESS;
+}
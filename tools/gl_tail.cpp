@@ -0,0 +1,107 @@
+#include "goinglogging.h"
+#include "goinglogging/shm_bus.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * \file
+ * Print messages of a shared memory log bus, written with
+ * gl::start_shm_bus().
+ */
+
+/**
+ * \brief Print usage.
+ *
+ * \param name Name of executable.
+ */
+void usage(const char* name) {
+    std::cerr << "Usage: " << name << " [-f] [-p] <bus name>\n"
+              << "  Prints all messages in the bus, oldest first.\n"
+              << "  -f  Follow, and print new messages as they are written. "
+                 "Waits for\n"
+              << "      the bus to be created\n"
+              << "  -p  Prefix each message with the process ID of its "
+                 "writer\n";
+}
+
+/**
+ * \brief Entry point.
+ *
+ * \param argc Number of arguments.
+ * \param argv Arguments.
+ * \return EXIT_SUCCESS if the bus was read.
+ */
+int main(int argc, const char** argv) {
+    bool        follow = false;
+    bool        pids   = false;
+    std::string name;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-f") {
+            follow = true;
+        } else if (arg == "-p") {
+            pids = true;
+        } else if (name.empty() && !arg.empty() && arg[0] != '-') {
+            name = arg;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (name.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // When following, wait for the bus to be created
+    gl::internal::ShmBusReader reader;
+    while (!reader.open(name)) {
+        if (!follow) {
+            std::cerr << "Failed to open bus '" << name << "'\n";
+            return EXIT_FAILURE;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // Slots which stay incomplete this long were abandoned by a crash
+    using clock                 = std::chrono::steady_clock;
+    const clock::duration stale = std::chrono::milliseconds(200);
+    clock::time_point     pending_since;
+    bool                  pending = false;
+    std::string           msg;
+    uint32_t              pid = 0;
+    while (true) {
+        using result = gl::internal::ShmBusReader::result;
+        result r     = reader.next(msg, pid);
+        if (uint64_t lost = reader.take_lost()) {
+            std::cout.flush();
+            std::cerr << "gl_tail: overrun, " << lost << " slots lost\n";
+        }
+        if (r == result::MESSAGE) {
+            pending = false;
+            if (pids) {
+                std::cout << '[' << pid << "] ";
+            }
+            std::cout << msg << '\n';
+            continue;
+        }
+        if (r == result::PENDING) {
+            if (!pending) {
+                pending       = true;
+                pending_since = clock::now();
+            } else if (clock::now() - pending_since > stale) {
+                pending = false;
+                reader.skip();
+                continue;
+            }
+        } else if (!follow) {
+            break;
+        }
+        std::cout.flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return EXIT_SUCCESS;
+}